@@ -1,13 +1,19 @@
 #include "algorithm.h"
+#include "allocator.h"
 #include "dary_heap.h"
 #include "distance_map.h"
 #include "graph.h"
+#include "monotonic_clock.h"
 #include "parent_map.h"
+#include "query_metrics.h"
+#include "query_trace.h"
+#include "scc_index.h"
 #include "util.h"
 #include "vertex_list.h"
 #include "vertex_set.h"
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define TRY_REPORT_RETURN_STATUS(RETURN_STATUS) \
 if (p_return_status) {                          \
@@ -21,6 +27,207 @@ static const size_t INITIAL_MAP_CAPACITY = 1024;
 static const float LOAD_FACTOR = 1.3f;
 static const size_t DARY_HEAP_DEGREE = 4;
 
+static const search_options DEFAULT_SEARCH_OPTIONS = {
+    WEIGHT_MAX, 0, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+void search_options_init(search_options* p_options) {
+    *p_options = DEFAULT_SEARCH_OPTIONS;
+}
+
+/* Charges the time between two phase switches to the phase being left: */
+typedef struct search_clock {
+    double* p_phase_seconds; /* NULL if nobody asked for the times. */
+    double  phase_start;
+} search_clock;
+
+static void search_clock_switch(search_clock* p_clock,
+                                double* p_next_phase_seconds) {
+    double now;
+
+    if (!p_clock->p_phase_seconds) {
+        return;
+    }
+
+    now = monotonic_clock_seconds();
+    *p_clock->p_phase_seconds += now - p_clock->phase_start;
+    p_clock->p_phase_seconds = p_next_phase_seconds;
+    p_clock->phase_start = now;
+}
+
+/*******************************************************************************
+* Returns the stats to fill in: the caller's, or 'p_ignored_stats' if there   *
+* are none, so that the hot loops can count without checking for NULL.        *
+*******************************************************************************/
+static search_stats* search_stats_start(search_stats* p_stats,
+                                        search_stats* p_ignored_stats,
+                                        search_clock* p_clock) {
+    if (p_stats) {
+        p_clock->p_phase_seconds = &p_stats->setup_seconds;
+        p_clock->phase_start = monotonic_clock_seconds();
+    } else {
+        p_clock->p_phase_seconds = NULL;
+        p_stats = p_ignored_stats;
+    }
+
+    memset(p_stats, 0, sizeof(*p_stats));
+    return p_stats;
+}
+
+/* The hash tables start at INITIAL_MAP_CAPACITY and double on each rehash: */
+static size_t count_rehashes(size_t table_capacity) {
+    size_t rehashes = 0;
+
+    while (table_capacity > INITIAL_MAP_CAPACITY) {
+        table_capacity /= 2;
+        ++rehashes;
+    }
+
+    return rehashes;
+}
+
+static void account_heap(search_stats* p_stats, dary_heap* p_heap) {
+    p_stats->rehashes += count_rehashes(p_heap->node_map->table_capacity);
+    p_stats->heap_bytes += dary_heap_memory_usage(p_heap);
+}
+
+static void account_set(search_stats* p_stats, vertex_set* p_set) {
+    p_stats->rehashes += count_rehashes(p_set->table_capacity);
+    p_stats->closed_bytes += vertex_set_memory_usage(p_set);
+}
+
+static void account_distance_map(search_stats* p_stats, distance_map* p_map) {
+    p_stats->rehashes += count_rehashes(p_map->table_capacity);
+    p_stats->distance_bytes += distance_map_memory_usage(p_map);
+}
+
+static void account_parent_map(search_stats* p_stats, parent_map* p_map) {
+    p_stats->rehashes += count_rehashes(p_map->table_capacity);
+    p_stats->parent_bytes += parent_map_memory_usage(p_map);
+}
+
+/*******************************************************************************
+* The maps and the sets never shrink during a search, so what they hold at    *
+* the end is their peak. The heaps do: they free a node on every extraction,  *
+* while their tables stay at the size of the peak. Adds the nodes that        *
+* 'open_now' vertices short of 'heap_peak' cost and totals the peak.          *
+*******************************************************************************/
+static void account_peak(search_stats* p_stats, size_t open_now) {
+    if (p_stats->heap_peak > open_now) {
+        p_stats->heap_bytes += (p_stats->heap_peak - open_now) *
+                               (sizeof(dary_heap_node) +
+                                sizeof(dary_heap_node_map_entry));
+    }
+
+    p_stats->bytes_allocated = p_stats->heap_bytes +
+                               p_stats->distance_bytes +
+                               p_stats->parent_bytes +
+                               p_stats->closed_bytes;
+}
+
+/* Index 0 holds the forward containers, index 1 the backward ones: */
+struct search_workspace {
+    dary_heap*    p_open[2];
+    vertex_set*   p_closed[2];
+    distance_map* p_distance[2];
+    parent_map*   p_parent[2];
+};
+
+search_workspace* search_workspace_alloc(void) {
+    search_workspace* p_workspace =
+            allocator_calloc(1, sizeof(search_workspace));
+    size_t i;
+
+    if (!p_workspace) {
+        return NULL;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        p_workspace->p_open[i] = dary_heap_alloc(DARY_HEAP_DEGREE,
+                                                 INITIAL_MAP_CAPACITY,
+                                                 LOAD_FACTOR);
+        p_workspace->p_closed[i] = vertex_set_alloc(INITIAL_MAP_CAPACITY,
+                                                    LOAD_FACTOR);
+        p_workspace->p_distance[i] = distance_map_alloc(INITIAL_MAP_CAPACITY,
+                                                        LOAD_FACTOR);
+        p_workspace->p_parent[i] = parent_map_alloc(INITIAL_MAP_CAPACITY,
+                                                    LOAD_FACTOR);
+
+        if (!p_workspace->p_open[i] ||
+            !p_workspace->p_closed[i] ||
+            !p_workspace->p_distance[i] ||
+            !p_workspace->p_parent[i]) {
+            search_workspace_free(p_workspace);
+            return NULL;
+        }
+    }
+
+    return p_workspace;
+}
+
+void search_workspace_free(search_workspace* p_workspace) {
+    size_t i;
+
+    if (!p_workspace) {
+        return;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        if (p_workspace->p_open[i]) {
+            dary_heap_free(p_workspace->p_open[i]);
+        }
+
+        if (p_workspace->p_closed[i]) {
+            vertex_set_free(p_workspace->p_closed[i]);
+        }
+
+        if (p_workspace->p_distance[i]) {
+            distance_map_free(p_workspace->p_distance[i]);
+        }
+
+        if (p_workspace->p_parent[i]) {
+            parent_map_free(p_workspace->p_parent[i]);
+        }
+    }
+
+    allocator_free(p_workspace);
+}
+
+/* Empties the containers of a workspace for the next query, frees others: */
+static void release_heap(dary_heap* p_heap, search_workspace* p_workspace) {
+    if (p_workspace) {
+        dary_heap_clear(p_heap);
+    } else {
+        dary_heap_free(p_heap);
+    }
+}
+
+static void release_set(vertex_set* p_set, search_workspace* p_workspace) {
+    if (p_workspace) {
+        vertex_set_clear(p_set);
+    } else {
+        vertex_set_free(p_set);
+    }
+}
+
+static void release_distance_map(distance_map* p_map,
+                                 search_workspace* p_workspace) {
+    if (p_workspace) {
+        distance_map_clear(p_map);
+    } else {
+        distance_map_free(p_map);
+    }
+}
+
+static void release_parent_map(parent_map* p_map,
+                               search_workspace* p_workspace) {
+    if (p_workspace) {
+        parent_map_clear(p_map);
+    } else {
+        parent_map_free(p_map);
+    }
+}
+
 typedef struct search_state {
     dary_heap* p_open_forward;
     dary_heap* p_open_backward;
@@ -30,9 +237,47 @@ typedef struct search_state {
     distance_map*   p_distance_backward;
     parent_map*     p_parent_forward;
     parent_map*     p_parent_backward;
+    search_stats*   p_stats;
+    search_stats    ignored_stats;
+    search_clock    clock;
+    search_workspace* p_workspace;
+
+    /* The timeline, if traced: */
+    query_trace*    p_trace;
+    double          batch_start;
+    size_t          batch_forward;
+    size_t          batch_backward;
+    int             terminated;
 } search_state;
 
-static void search_state_init(search_state* p_state) {
+static void search_state_init(search_state* p_state,
+                              const search_options* p_options) {
+    search_workspace* p_workspace = p_options->p_workspace;
+    query_trace* p_trace = p_options->p_trace;
+
+    p_state->p_stats = search_stats_start(p_options->p_stats,
+                                          &p_state->ignored_stats,
+                                          &p_state->clock);
+
+    p_state->p_trace = p_trace;
+    p_state->batch_start = p_trace ? monotonic_clock_seconds() : 0.0;
+    p_state->batch_forward = 0;
+    p_state->batch_backward = 0;
+    p_state->terminated = FALSE;
+    p_state->p_workspace = p_workspace;
+
+    if (p_workspace) {
+        p_state->p_open_forward      = p_workspace->p_open[0];
+        p_state->p_open_backward     = p_workspace->p_open[1];
+        p_state->p_closed_forward    = p_workspace->p_closed[0];
+        p_state->p_closed_backward   = p_workspace->p_closed[1];
+        p_state->p_distance_forward  = p_workspace->p_distance[0];
+        p_state->p_distance_backward = p_workspace->p_distance[1];
+        p_state->p_parent_forward    = p_workspace->p_parent[0];
+        p_state->p_parent_backward   = p_workspace->p_parent[1];
+        return;
+    }
+
     p_state->p_open_forward =
             dary_heap_alloc(
                     DARY_HEAP_DEGREE,
@@ -87,47 +332,215 @@ static int search_state_ok(search_state* p_search_state) {
            p_search_state->p_parent_backward;
 }
 
+/* Ends the setup span once both searches have their first vertex: */
+static void trace_setup_done(search_state* p_state) {
+    double now = monotonic_clock_seconds();
+
+    query_trace_span(p_state->p_trace, "setup", p_state->batch_start, now);
+    p_state->batch_start = now;
+}
+
+/* Records the expansions since the previous batch and both frontiers: */
+static void trace_batch(search_state* p_state) {
+    query_trace_event* p_event;
+    double now;
+
+    if (p_state->batch_forward + p_state->batch_backward == 0) {
+        return;
+    }
+
+    now = monotonic_clock_seconds();
+    p_event = query_trace_span(p_state->p_trace,
+                               "expand",
+                               p_state->batch_start,
+                               now);
+
+    query_trace_event_arg(p_event,
+                          "settled_forward",
+                          (double) p_state->batch_forward);
+    query_trace_event_arg(p_event,
+                          "settled_backward",
+                          (double) p_state->batch_backward);
+    query_trace_event_arg(p_event,
+                          "edges_relaxed",
+                          (double) p_state->p_stats->edges_relaxed);
+
+    p_event = query_trace_counter(p_state->p_trace, "frontier", now);
+
+    query_trace_event_arg(p_event,
+                          "open_forward",
+                          (double) dary_heap_size(p_state->p_open_forward));
+    query_trace_event_arg(p_event,
+                          "open_backward",
+                          (double) dary_heap_size(p_state->p_open_backward));
+    query_trace_event_arg(
+            p_event,
+            "closed_forward",
+            (double) vertex_set_size(p_state->p_closed_forward));
+    query_trace_event_arg(
+            p_event,
+            "closed_backward",
+            (double) vertex_set_size(p_state->p_closed_backward));
+
+    p_state->batch_start = now;
+    p_state->batch_forward = 0;
+    p_state->batch_backward = 0;
+}
+
+static void trace_settled(search_state* p_state, int forward) {
+    if (forward) {
+        ++p_state->batch_forward;
+    } else {
+        ++p_state->batch_backward;
+    }
+
+    if (p_state->batch_forward + p_state->batch_backward ==
+        p_state->p_trace->batch_size) {
+        trace_batch(p_state);
+    }
+}
+
+static void trace_meeting_point(search_state* p_state,
+                                vertex_id_t vertex_id,
+                                weight_t path_length) {
+    query_trace_event* p_event =
+            query_trace_instant(p_state->p_trace,
+                                "meeting point",
+                                monotonic_clock_seconds());
+
+    query_trace_event_arg(p_event, "vertex", (double) vertex_id);
+    query_trace_event_arg(p_event, "path_length", (double) path_length);
+}
+
+/* Closes the last batch; called once the search knows its outcome. */
+static void trace_terminate(search_state* p_state) {
+    query_trace_event* p_event;
+
+    if (p_state->terminated) {
+        return;
+    }
+
+    p_state->terminated = TRUE;
+    trace_batch(p_state);
+
+    p_event = query_trace_instant(p_state->p_trace,
+                                  "terminate",
+                                  monotonic_clock_seconds());
+
+    query_trace_event_arg(p_event,
+                          "settled_forward",
+                          (double) p_state->p_stats->settled_forward);
+    query_trace_event_arg(p_event,
+                          "settled_backward",
+                          (double) p_state->p_stats->settled_backward);
+    query_trace_event_arg(p_event,
+                          "edges_scanned",
+                          (double) p_state->p_stats->edges_scanned);
+}
+
 static void search_state_free(search_state* p_search_state) {
+    search_stats* p_stats = p_search_state->p_stats;
+    size_t open_now = 0;
+    double cleanup_start = 0.0;
+
+    search_clock_switch(&p_search_state->clock, &p_stats->cleanup_seconds);
+
+    if (p_search_state->p_trace) {
+        trace_terminate(p_search_state);
+        cleanup_start = monotonic_clock_seconds();
+    }
+
     if (p_search_state->p_open_forward) {
-        dary_heap_free(p_search_state->p_open_forward);
+        open_now += dary_heap_size(p_search_state->p_open_forward);
+        account_heap(p_stats, p_search_state->p_open_forward);
+        release_heap(p_search_state->p_open_forward,
+                     p_search_state->p_workspace);
     }
 
     if (p_search_state->p_open_backward) {
-        dary_heap_free(p_search_state->p_open_backward);
+        open_now += dary_heap_size(p_search_state->p_open_backward);
+        account_heap(p_stats, p_search_state->p_open_backward);
+        release_heap(p_search_state->p_open_backward,
+                     p_search_state->p_workspace);
     }
 
     if (p_search_state->p_closed_forward) {
-        vertex_set_free(p_search_state->p_closed_forward);
+        account_set(p_stats, p_search_state->p_closed_forward);
+        release_set(p_search_state->p_closed_forward,
+                    p_search_state->p_workspace);
     }
 
     if (p_search_state->p_closed_backward) {
-        vertex_set_free(p_search_state->p_closed_backward);
+        account_set(p_stats, p_search_state->p_closed_backward);
+        release_set(p_search_state->p_closed_backward,
+                    p_search_state->p_workspace);
     }
 
     if (p_search_state->p_distance_forward) {
-        distance_map_free(p_search_state->p_distance_forward);
+        account_distance_map(p_stats, p_search_state->p_distance_forward);
+        release_distance_map(p_search_state->p_distance_forward,
+                             p_search_state->p_workspace);
     }
 
     if (p_search_state->p_distance_backward) {
-        distance_map_free(p_search_state->p_distance_backward);
+        account_distance_map(p_stats, p_search_state->p_distance_backward);
+        release_distance_map(p_search_state->p_distance_backward,
+                             p_search_state->p_workspace);
     }
 
     if (p_search_state->p_parent_forward) {
-        parent_map_free(p_search_state->p_parent_forward);
+        account_parent_map(p_stats, p_search_state->p_parent_forward);
+        release_parent_map(p_search_state->p_parent_forward,
+                           p_search_state->p_workspace);
     }
 
     if (p_search_state->p_parent_backward) {
-        parent_map_free(p_search_state->p_parent_backward);
+        account_parent_map(p_stats, p_search_state->p_parent_backward);
+        release_parent_map(p_search_state->p_parent_backward,
+                           p_search_state->p_workspace);
+    }
+
+    account_peak(p_stats, open_now);
+
+    if (p_search_state->p_trace) {
+        query_trace_span(p_search_state->p_trace,
+                         "cleanup",
+                         cleanup_start,
+                         monotonic_clock_seconds());
     }
+
+    search_clock_switch(&p_search_state->clock, NULL);
 }
+
 typedef struct search_state_2 {
     dary_heap* p_open;
     vertex_set*     p_closed;
     distance_map*   p_distance;
     parent_map*     p_parent;
+    search_stats*   p_stats;
+    search_stats    ignored_stats;
+    search_clock    clock;
+    search_workspace* p_workspace;
 } search_state_2;
 
-static void search_state_2_init(search_state_2* p_state) {
+static void search_state_2_init(search_state_2* p_state,
+                                const search_options* p_options) {
+    search_workspace* p_workspace = p_options->p_workspace;
+
+    p_state->p_stats = search_stats_start(p_options->p_stats,
+                                          &p_state->ignored_stats,
+                                          &p_state->clock);
+
+    p_state->p_workspace = p_workspace;
+
+    if (p_workspace) {
+        p_state->p_open     = p_workspace->p_open[0];
+        p_state->p_closed   = p_workspace->p_closed[0];
+        p_state->p_distance = p_workspace->p_distance[0];
+        p_state->p_parent   = p_workspace->p_parent[0];
+        return;
+    }
+
     p_state->p_open =
             dary_heap_alloc(
                     DARY_HEAP_DEGREE,
@@ -158,31 +571,47 @@ static int search_state_2_ok(search_state_2* p_search_state) {
 }
 
 static void search_state_2_free(search_state_2* p_search_state) {
+    search_stats* p_stats = p_search_state->p_stats;
+    size_t open_now = 0;
+
+    search_clock_switch(&p_search_state->clock, &p_stats->cleanup_seconds);
+
     if (p_search_state->p_open) {
-        dary_heap_free(p_search_state->p_open);
+        open_now = dary_heap_size(p_search_state->p_open);
+        account_heap(p_stats, p_search_state->p_open);
+        release_heap(p_search_state->p_open, p_search_state->p_workspace);
     }
 
     if (p_search_state->p_closed) {
-        vertex_set_free(p_search_state->p_closed);
+        account_set(p_stats, p_search_state->p_closed);
+        release_set(p_search_state->p_closed, p_search_state->p_workspace);
     }
 
     if (p_search_state->p_distance) {
-        distance_map_free(p_search_state->p_distance);
+        account_distance_map(p_stats, p_search_state->p_distance);
+        release_distance_map(p_search_state->p_distance,
+                             p_search_state->p_workspace);
     }
 
     if (p_search_state->p_parent) {
-        parent_map_free(p_search_state->p_parent);
+        account_parent_map(p_stats, p_search_state->p_parent);
+        release_parent_map(p_search_state->p_parent,
+                           p_search_state->p_workspace);
     }
+
+    account_peak(p_stats, open_now);
+
+    search_clock_switch(&p_search_state->clock, NULL);
 }
 
-static vertex_list* traceback_path(size_t touch_vertex_id,
+static vertex_list* traceback_path(vertex_id_t touch_vertex_id,
                                    parent_map * parent_forward,
                                    parent_map * parent_backward) {
 
     vertex_list* path = vertex_list_alloc(100);
     int rs; /* result status */
-    size_t vertex_id = touch_vertex_id;
-    size_t previous_vertex_id =
+    vertex_id_t vertex_id = touch_vertex_id;
+    vertex_id_t previous_vertex_id =
             parent_map_get(parent_forward,
                            touch_vertex_id);
 
@@ -216,25 +645,40 @@ static vertex_list* traceback_path(size_t touch_vertex_id,
     return path;
 }
 
-vertex_list* find_shortest_path(Graph * p_graph,
-                                size_t source_vertex_id,
-                                size_t target_vertex_id,
+vertex_list* find_shortest_path(Graph* p_graph,
+                                vertex_id_t source_vertex_id,
+                                vertex_id_t target_vertex_id,
                                 int* p_return_status) {
+    return find_shortest_path_ex(p_graph,
+                                 source_vertex_id,
+                                 target_vertex_id,
+                                 NULL,
+                                 p_return_status);
+}
+
+static vertex_list* bidirectional_search(Graph* p_graph,
+                                         vertex_id_t source_vertex_id,
+                                         vertex_id_t target_vertex_id,
+                                         const search_options* p_options,
+                                         int* p_return_status) {
 
     search_state search_state_;
-    double best_path_length = DBL_MAX;
-    double temporary_path_length;
-    double tentative_length;
-    double weight;
-    size_t* p_touch_vertex_id = NULL;
+    weight_t best_path_length = WEIGHT_MAX;
+    weight_t temporary_path_length;
+    weight_t tentative_length;
+    weight_t weight;
+    vertex_id_t* p_touch_vertex_id = NULL;
     int rs; /* return status */
     int updated;
-    size_t current_vertex_id;
-    size_t child_vertex_id;
-    size_t parent_vertex_id;
-    GraphVertex* p_graph_vertex;
+    vertex_id_t current_vertex_id;
+    vertex_id_t child_vertex_id;
+    vertex_id_t parent_vertex_id;
+    graph_edge_cursor cursor;
+    size_t settled = 0;
+    double traceback_start = 0.0;
 
     vertex_list*    p_path;
+    query_trace*    p_trace;
     dary_heap*      p_open_forward;
     dary_heap*      p_open_backward;
     vertex_set*     p_closed_forward;
@@ -243,15 +687,17 @@ vertex_list* find_shortest_path(Graph * p_graph,
     distance_map*   p_distance_backward;
     parent_map*     p_parent_forward;
     parent_map*     p_parent_backward;
-
-    weight_map_iterator* p_weight_map_children_iterator;
-    weight_map_iterator* p_weight_map_parents_iterator;
+    search_stats*   p_stats;
 
     if (!p_graph) {
         TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_GRAPH);
         return NULL;
     }
 
+    if (!p_options) {
+        p_options = &DEFAULT_SEARCH_OPTIONS;
+    }
+
     rs = 0;
 
     if (!hasVertex(p_graph, source_vertex_id)) {
@@ -263,7 +709,6 @@ vertex_list* find_shortest_path(Graph * p_graph,
     }
 
     if (rs) {
-        CLEAN_SEARCH_STATE;
         TRY_REPORT_RETURN_STATUS(rs);
         return NULL;
     }
@@ -284,11 +729,24 @@ vertex_list* find_shortest_path(Graph * p_graph,
             return NULL;
         }
 
+        if (p_options->p_distance) {
+            *p_options->p_distance = 0;
+        }
+
         TRY_REPORT_RETURN_STATUS(RETURN_STATUS_OK);
         return p_path;
     }
 
-    search_state_init(&search_state_);
+    /* The component index rejects most unreachable targets in O(log V): */
+    if (graph_scc_index(p_graph) &&
+        !scc_index_may_reach(graph_scc_index(p_graph),
+                             source_vertex_id,
+                             target_vertex_id)) {
+        TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_PATH);
+        return NULL;
+    }
+
+    search_state_init(&search_state_, p_options);
 
     if (!search_state_ok(&search_state_)) {
         CLEAN_SEARCH_STATE;
@@ -304,6 +762,8 @@ vertex_list* find_shortest_path(Graph * p_graph,
     p_distance_backward = search_state_.p_distance_backward;
     p_parent_forward    = search_state_.p_parent_forward;
     p_parent_backward   = search_state_.p_parent_backward;
+    p_stats             = search_state_.p_stats;
+    p_trace             = search_state_.p_trace;
 
     /* Initialize the state: */
     if (dary_heap_add(p_open_forward,
@@ -356,10 +816,18 @@ vertex_list* find_shortest_path(Graph * p_graph,
         return NULL;
     }
 
+    search_clock_switch(&search_state_.clock, &p_stats->search_seconds);
+
+    if (p_trace) {
+        trace_setup_done(&search_state_);
+    }
+
     while (dary_heap_size(p_open_forward) > 0 &&
            dary_heap_size(p_open_backward) > 0) {
 
-        if (p_touch_vertex_id) {
+        if (p_touch_vertex_id ||
+            p_options->max_distance != WEIGHT_MAX) {
+            /* No path left to find is shorter than this: */
             temporary_path_length =
                     distance_map_get(
                             p_distance_forward,
@@ -369,23 +837,72 @@ vertex_list* find_shortest_path(Graph * p_graph,
                             p_distance_backward,
                             dary_heap_min(p_open_backward));
 
-            if (temporary_path_length > best_path_length) {
+            if (temporary_path_length > p_options->max_distance &&
+                best_path_length > p_options->max_distance) {
+                CLEAN_SEARCH_STATE;
+                TRY_REPORT_RETURN_STATUS(RETURN_STATUS_BOUND_EXCEEDED);
+                allocator_free(p_touch_vertex_id);
+                return NULL;
+            }
+
+            if (p_touch_vertex_id &&
+                temporary_path_length > best_path_length) {
+                search_clock_switch(&search_state_.clock,
+                                    &p_stats->traceback_seconds);
+
+                if (p_trace) {
+                    trace_terminate(&search_state_);
+                    traceback_start = monotonic_clock_seconds();
+                }
+
                 p_path = traceback_path(*p_touch_vertex_id,
                                         p_parent_forward,
                                         p_parent_backward);
 
+                if (p_trace) {
+                    query_trace_event_arg(
+                            query_trace_span(p_trace,
+                                             "traceback",
+                                             traceback_start,
+                                             monotonic_clock_seconds()),
+                            "vertices",
+                            p_path ? (double) vertex_list_size(p_path) : 0.0);
+                }
+
                 if (p_path) {
                     TRY_REPORT_RETURN_STATUS(RETURN_STATUS_OK);
+
+                    if (p_options->p_distance) {
+                        *p_options->p_distance = best_path_length;
+                    }
                 } else {
                     TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_MEMORY);
                 }
 
                 CLEAN_SEARCH_STATE;
-                free(p_touch_vertex_id);
+                allocator_free(p_touch_vertex_id);
                 return p_path;
             }
         }
 
+        if (p_options->max_settled && settled == p_options->max_settled) {
+            CLEAN_SEARCH_STATE;
+            TRY_REPORT_RETURN_STATUS(RETURN_STATUS_BOUND_EXCEEDED);
+            allocator_free(p_touch_vertex_id);
+            return NULL;
+        }
+
+        if (p_options->p_context &&
+            (rs = query_context_poll(p_options->p_context, settled)) !=
+            RETURN_STATUS_OK) {
+            CLEAN_SEARCH_STATE;
+            TRY_REPORT_RETURN_STATUS(rs);
+            allocator_free(p_touch_vertex_id);
+            return NULL;
+        }
+
+        ++settled;
+
         if (dary_heap_size(p_open_forward) +
             vertex_set_size(p_closed_forward)
             <=
@@ -393,6 +910,11 @@ vertex_list* find_shortest_path(Graph * p_graph,
             vertex_set_size(p_closed_backward)) {
 
             current_vertex_id = dary_heap_extract_min(p_open_forward);
+            ++p_stats->settled_forward;
+
+            if (p_trace) {
+                trace_settled(&search_state_, TRUE);
+            }
 
             if ((rs = vertex_set_add(p_closed_forward, current_vertex_id)) !=
                 RETURN_STATUS_OK) {
@@ -401,35 +923,14 @@ vertex_list* find_shortest_path(Graph * p_graph,
                 return NULL;
             }
 
-            p_graph_vertex =
-                    graph_vertex_map_get(p_graph->p_nodes,
-                                         current_vertex_id);
-
-            p_weight_map_children_iterator =
-                    weight_map_iterator_alloc(
-                            p_graph_vertex->p_children);
-
-            if (!p_weight_map_children_iterator) {
-                CLEAN_SEARCH_STATE;
-                TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_MEMORY);
-
-                if (p_touch_vertex_id) {
-                    free(p_touch_vertex_id);
-                }
-
-                return NULL;
-            }
-
-            while (weight_map_iterator_has_next(
-                    p_weight_map_children_iterator)) {
-
-                updated = 0;
+            graph_children_cursor(p_graph, current_vertex_id, &cursor);
 
-                weight_map_iterator_visit(p_weight_map_children_iterator,
+            while (graph_edge_cursor_next(&cursor,
                                           &child_vertex_id,
-                                          &weight);
+                                          &weight)) {
 
-                weight_map_iterator_next(p_weight_map_children_iterator);
+                updated = 0;
+                ++p_stats->edges_scanned;
 
                 if (vertex_set_contains(p_closed_forward, child_vertex_id)) {
                     continue;
@@ -451,7 +952,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
                         TRY_REPORT_RETURN_STATUS(rs);
 
                         if (p_touch_vertex_id) {
-                            free(p_touch_vertex_id);
+                            allocator_free(p_touch_vertex_id);
                         }
 
                         return NULL;
@@ -462,6 +963,8 @@ vertex_list* find_shortest_path(Graph * p_graph,
                 else if (distance_map_get(p_distance_forward, child_vertex_id) >
                          tentative_length) {
 
+                    ++p_stats->decrease_keys;
+
                     dary_heap_decrease_key(
                             p_open_forward,
                             child_vertex_id,
@@ -471,6 +974,13 @@ vertex_list* find_shortest_path(Graph * p_graph,
                 }
 
                 if (updated) {
+                    ++p_stats->edges_relaxed;
+
+                    if (p_stats->heap_peak < dary_heap_size(p_open_forward) +
+                                             dary_heap_size(p_open_backward)) {
+                        p_stats->heap_peak = dary_heap_size(p_open_forward) +
+                                             dary_heap_size(p_open_backward);
+                    }
 
                     if ((rs = distance_map_put(
                             p_distance_forward,
@@ -479,8 +989,8 @@ vertex_list* find_shortest_path(Graph * p_graph,
 
                         CLEAN_SEARCH_STATE;
                         TRY_REPORT_RETURN_STATUS(rs);
-                        free(NULL);
-                        free(p_touch_vertex_id);
+                        allocator_free(NULL);
+                        allocator_free(p_touch_vertex_id);
                         return NULL;
                     }
 
@@ -491,7 +1001,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
 
                         CLEAN_SEARCH_STATE;
                         TRY_REPORT_RETURN_STATUS(rs);
-                        free(p_touch_vertex_id);
+                        allocator_free(p_touch_vertex_id);
                         return NULL;
                     }
 
@@ -507,10 +1017,17 @@ vertex_list* find_shortest_path(Graph * p_graph,
                             best_path_length = temporary_path_length;
 
                             if (!p_touch_vertex_id) {
-                                p_touch_vertex_id = malloc(sizeof(size_t));
+                                p_touch_vertex_id =
+                                        allocator_malloc(sizeof(vertex_id_t));
                             }
 
                             *p_touch_vertex_id = child_vertex_id;
+
+                            if (p_trace) {
+                                trace_meeting_point(&search_state_,
+                                                    child_vertex_id,
+                                                    best_path_length);
+                            }
                         }
                     }
                 }
@@ -518,27 +1035,21 @@ vertex_list* find_shortest_path(Graph * p_graph,
         }
         else {
             current_vertex_id = dary_heap_extract_min(p_open_backward);
+            ++p_stats->settled_backward;
             vertex_set_add(p_closed_backward, current_vertex_id);
 
-            p_graph_vertex =
-                    graph_vertex_map_get(p_graph->p_nodes,
-                                         current_vertex_id);
+            if (p_trace) {
+                trace_settled(&search_state_, FALSE);
+            }
 
-            p_weight_map_parents_iterator =
-                    weight_map_iterator_alloc(
-                            p_graph_vertex->p_parents);
+            graph_parents_cursor(p_graph, current_vertex_id, &cursor);
 
-            while (weight_map_iterator_has_next(
-                    p_weight_map_parents_iterator)) {
+            while (graph_edge_cursor_next(&cursor,
+                                          &parent_vertex_id,
+                                          &weight)) {
 
                 updated = 0;
-
-                weight_map_iterator_visit(
-                        p_weight_map_parents_iterator,
-                        &parent_vertex_id,
-                        &weight);
-
-                weight_map_iterator_next(p_weight_map_parents_iterator);
+                ++p_stats->edges_scanned;
 
                 if (vertex_set_contains(p_closed_backward,
                                         parent_vertex_id)) {
@@ -559,7 +1070,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
 
                         CLEAN_SEARCH_STATE;
                         TRY_REPORT_RETURN_STATUS(rs);
-                        free(p_touch_vertex_id);
+                        allocator_free(p_touch_vertex_id);
                         return NULL;
                     }
 
@@ -570,6 +1081,8 @@ vertex_list* find_shortest_path(Graph * p_graph,
                          >
                          tentative_length) {
 
+                    ++p_stats->decrease_keys;
+
                     dary_heap_decrease_key(
                             p_open_backward,
                             parent_vertex_id,
@@ -579,6 +1092,13 @@ vertex_list* find_shortest_path(Graph * p_graph,
                 }
 
                 if (updated) {
+                    ++p_stats->edges_relaxed;
+
+                    if (p_stats->heap_peak < dary_heap_size(p_open_forward) +
+                                             dary_heap_size(p_open_backward)) {
+                        p_stats->heap_peak = dary_heap_size(p_open_forward) +
+                                             dary_heap_size(p_open_backward);
+                    }
 
                     if ((rs = distance_map_put(
                             p_distance_backward,
@@ -587,7 +1107,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
 
                         CLEAN_SEARCH_STATE;
                         TRY_REPORT_RETURN_STATUS(rs);
-                        free(p_touch_vertex_id);
+                        allocator_free(p_touch_vertex_id);
                         return NULL;
                     }
 
@@ -598,7 +1118,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
 
                         CLEAN_SEARCH_STATE;
                         TRY_REPORT_RETURN_STATUS(rs);
-                        free(p_touch_vertex_id);
+                        allocator_free(p_touch_vertex_id);
                         return NULL;
                     }
 
@@ -614,10 +1134,17 @@ vertex_list* find_shortest_path(Graph * p_graph,
                             best_path_length = temporary_path_length;
 
                             if (!p_touch_vertex_id) {
-                                p_touch_vertex_id = malloc(sizeof(size_t));
+                                p_touch_vertex_id =
+                                        allocator_malloc(sizeof(vertex_id_t));
                             }
 
                             *p_touch_vertex_id = parent_vertex_id;
+
+                            if (p_trace) {
+                                trace_meeting_point(&search_state_,
+                                                    parent_vertex_id,
+                                                    best_path_length);
+                            }
                         }
                     }
                 }
@@ -626,7 +1153,7 @@ vertex_list* find_shortest_path(Graph * p_graph,
     }
 
     if (p_touch_vertex_id) {
-        free(p_touch_vertex_id);
+        allocator_free(p_touch_vertex_id);
     }
 
     CLEAN_SEARCH_STATE;
@@ -634,13 +1161,87 @@ vertex_list* find_shortest_path(Graph * p_graph,
     return NULL;
 }
 
-static vertex_list* traceback_path_2(size_t target_vertex_id,
+typedef vertex_list* (*search_function)(Graph* p_graph,
+                                        vertex_id_t source_vertex_id,
+                                        vertex_id_t target_vertex_id,
+                                        const search_options* p_options,
+                                        int* p_return_status);
+
+/*******************************************************************************
+* Runs 'search' and records the latency and the status of the query in the    *
+* metrics shard of the options, if there is one, and the query as a span      *
+* called 'name' in the trace of the options, if there is one.                 *
+*******************************************************************************/
+static vertex_list* measured_search(search_function search,
+                                    const char* name,
+                                    Graph* p_graph,
+                                    vertex_id_t source_vertex_id,
+                                    vertex_id_t target_vertex_id,
+                                    const search_options* p_options,
+                                    int* p_return_status) {
+    vertex_list* p_path;
+    query_trace_event* p_event;
+    double start;
+    double end;
+    int return_status = RETURN_STATUS_OK;
+
+    if (!p_options || (!p_options->p_metrics && !p_options->p_trace)) {
+        return search(p_graph,
+                      source_vertex_id,
+                      target_vertex_id,
+                      p_options,
+                      p_return_status);
+    }
+
+    start = monotonic_clock_seconds();
+    p_path = search(p_graph,
+                    source_vertex_id,
+                    target_vertex_id,
+                    p_options,
+                    &return_status);
+
+    end = monotonic_clock_seconds();
+
+    if (p_options->p_metrics) {
+        query_metrics_record(p_options->p_metrics, end - start, return_status);
+    }
+
+    if (p_options->p_trace) {
+        p_event = query_trace_span(p_options->p_trace, name, start, end);
+        query_trace_event_arg(p_event, "source", (double) source_vertex_id);
+        query_trace_event_arg(p_event, "target", (double) target_vertex_id);
+        query_trace_event_arg(p_event, "status", (double) return_status);
+        query_trace_event_arg(p_event,
+                              "path_vertices",
+                              p_path ? (double) vertex_list_size(p_path) :
+                                       0.0);
+    }
+
+    TRY_REPORT_RETURN_STATUS(return_status);
+    return p_path;
+}
+
+vertex_list* find_shortest_path_ex(Graph* p_graph,
+                                   vertex_id_t source_vertex_id,
+                                   vertex_id_t target_vertex_id,
+                                   const search_options* p_options,
+                                   int* p_return_status) {
+    return measured_search(bidirectional_search,
+                           "find_shortest_path",
+                           p_graph,
+                           source_vertex_id,
+                           target_vertex_id,
+                           p_options,
+                           p_return_status);
+}
+
+static vertex_list* traceback_path_2(vertex_id_t target_vertex_id,
                                      parent_map* parent) {
 
     vertex_list* path = vertex_list_alloc(100);
     int rs; /* result status */
-    size_t vertex_id = target_vertex_id;
-    size_t previous_vertex_id =
+    vertex_id_t vertex_id = target_vertex_id;
+    vertex_id_t previous_vertex_id =
             parent_map_get(parent,
                            target_vertex_id);
 
@@ -660,16 +1261,29 @@ static vertex_list* traceback_path_2(size_t target_vertex_id,
 }
 
 vertex_list* find_shortest_path_2(Graph* p_graph,
-                                  size_t source_vertex_id,
-                                  size_t target_vertex_id,
+                                  vertex_id_t source_vertex_id,
+                                  vertex_id_t target_vertex_id,
                                   int* p_return_status) {
+    return find_shortest_path_2_ex(p_graph,
+                                   source_vertex_id,
+                                   target_vertex_id,
+                                   NULL,
+                                   p_return_status);
+}
+
+static vertex_list* unidirectional_search(Graph* p_graph,
+                                          vertex_id_t source_vertex_id,
+                                          vertex_id_t target_vertex_id,
+                                          const search_options* p_options,
+                                          int* p_return_status) {
 
     search_state_2 search_state_2_;
-    size_t current_vertex_id;
-    size_t child_vertex_id;
-    double weight;
-    double tentative_length;
-    GraphVertex* p_graph_vertex;
+    vertex_id_t current_vertex_id;
+    vertex_id_t child_vertex_id;
+    weight_t weight;
+    weight_t tentative_length;
+    graph_edge_cursor cursor;
+    size_t settled = 0;
     int rs; /* return status */
     int updated;
 
@@ -678,14 +1292,17 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
     vertex_set*   p_closed;
     distance_map* p_distance;
     parent_map*   p_parent;
-
-    weight_map_iterator* p_weight_map_children_iterator;
+    search_stats* p_stats;
 
     if (!p_graph) {
         TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_GRAPH);
         return NULL;
     }
 
+    if (!p_options) {
+        p_options = &DEFAULT_SEARCH_OPTIONS;
+    }
+
     rs = 0;
 
     if (!hasVertex(p_graph, source_vertex_id)) {
@@ -697,12 +1314,20 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
     }
 
     if (rs) {
-        CLEAN_SEARCH_STATE_2;
         TRY_REPORT_RETURN_STATUS(rs);
         return NULL;
     }
 
-    search_state_2_init(&search_state_2_);
+    /* The component index rejects most unreachable targets in O(log V): */
+    if (graph_scc_index(p_graph) &&
+        !scc_index_may_reach(graph_scc_index(p_graph),
+                             source_vertex_id,
+                             target_vertex_id)) {
+        TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_PATH);
+        return NULL;
+    }
+
+    search_state_2_init(&search_state_2_, p_options);
 
     if (!search_state_2_ok(&search_state_2_)) {
         CLEAN_SEARCH_STATE_2;
@@ -714,6 +1339,7 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
     p_closed   = search_state_2_.p_closed;
     p_distance = search_state_2_.p_distance;
     p_parent   = search_state_2_.p_parent;
+    p_stats    = search_state_2_.p_stats;
 
     /* Initialize the state: */
     if ((rs = dary_heap_add(p_open,
@@ -741,12 +1367,29 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
         return NULL;
     }
 
+    search_clock_switch(&search_state_2_.clock, &p_stats->search_seconds);
+
     while (dary_heap_size(p_open) > 0) {
         current_vertex_id = dary_heap_extract_min(p_open);
 
+        if (distance_map_get(p_distance, current_vertex_id) >
+            p_options->max_distance) {
+            CLEAN_SEARCH_STATE_2;
+            TRY_REPORT_RETURN_STATUS(RETURN_STATUS_BOUND_EXCEEDED);
+            return NULL;
+        }
+
         if (current_vertex_id == target_vertex_id) {
+            search_clock_switch(&search_state_2_.clock,
+                                &p_stats->traceback_seconds);
+
             p_path = traceback_path_2(target_vertex_id, p_parent);
 
+            if (p_path && p_options->p_distance) {
+                *p_options->p_distance = distance_map_get(p_distance,
+                                                          target_vertex_id);
+            }
+
             CLEAN_SEARCH_STATE_2;
 
             if (p_path) {
@@ -763,37 +1406,36 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
             continue;
         }
 
-        if ((rs = vertex_set_add(p_closed, current_vertex_id))
-            != RETURN_STATUS_OK) {
+        if (p_options->max_settled && settled == p_options->max_settled) {
             CLEAN_SEARCH_STATE_2;
-            TRY_REPORT_RETURN_STATUS(rs);
+            TRY_REPORT_RETURN_STATUS(RETURN_STATUS_BOUND_EXCEEDED);
             return NULL;
         }
 
-        p_graph_vertex =
-                graph_vertex_map_get(p_graph->p_nodes,
-                                     current_vertex_id);
+        if (p_options->p_context &&
+            (rs = query_context_poll(p_options->p_context, settled)) !=
+            RETURN_STATUS_OK) {
+            CLEAN_SEARCH_STATE_2;
+            TRY_REPORT_RETURN_STATUS(rs);
+            return NULL;
+        }
 
-        p_weight_map_children_iterator =
-                weight_map_iterator_alloc(
-                        p_graph_vertex->p_children);
+        ++settled;
+        ++p_stats->settled_forward;
 
-        if (!p_weight_map_children_iterator) {
+        if ((rs = vertex_set_add(p_closed, current_vertex_id))
+            != RETURN_STATUS_OK) {
             CLEAN_SEARCH_STATE_2;
-            TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_MEMORY);
+            TRY_REPORT_RETURN_STATUS(rs);
             return NULL;
         }
 
-        while (weight_map_iterator_has_next(
-                p_weight_map_children_iterator)) {
+        graph_children_cursor(p_graph, current_vertex_id, &cursor);
 
-            updated = FALSE;
+        while (graph_edge_cursor_next(&cursor, &child_vertex_id, &weight)) {
 
-            weight_map_iterator_visit(p_weight_map_children_iterator,
-                                      &child_vertex_id,
-                                      &weight);
-
-            weight_map_iterator_next(p_weight_map_children_iterator);
+            updated = FALSE;
+            ++p_stats->edges_scanned;
 
             if (vertex_set_contains(p_closed, child_vertex_id)) {
                 continue;
@@ -822,6 +1464,8 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
 
                 updated = TRUE;
 
+                ++p_stats->decrease_keys;
+
                 dary_heap_decrease_key(
                         p_open,
                         child_vertex_id,
@@ -829,6 +1473,12 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
             }
 
             if (updated) {
+                ++p_stats->edges_relaxed;
+
+                if (p_stats->heap_peak < dary_heap_size(p_open)) {
+                    p_stats->heap_peak = dary_heap_size(p_open);
+                }
+
                 if ((rs = distance_map_put(
                         p_distance,
                         child_vertex_id,
@@ -856,4 +1506,102 @@ vertex_list* find_shortest_path_2(Graph* p_graph,
     CLEAN_SEARCH_STATE_2;
     TRY_REPORT_RETURN_STATUS(RETURN_STATUS_NO_PATH);
     return NULL;
-}
\ No newline at end of file
+}
+
+vertex_list* find_shortest_path_2_ex(Graph* p_graph,
+                                     vertex_id_t source_vertex_id,
+                                     vertex_id_t target_vertex_id,
+                                     const search_options* p_options,
+                                     int* p_return_status) {
+    return measured_search(unidirectional_search,
+                           "find_shortest_path_2",
+                           p_graph,
+                           source_vertex_id,
+                           target_vertex_id,
+                           p_options,
+                           p_return_status);
+}
+
+/*******************************************************************************
+* Returns TRUE if 'target_vertex_id' is reachable from 'source_vertex_id' and *
+* FALSE otherwise, including when either vertex is missing. Answers from the  *
+* component index when it is current, otherwise by a breadth-first search.    *
+* If the search cannot allocate, returns FALSE with RETURN_STATUS_NO_MEMORY   *
+* in '*p_return_status', which is RETURN_STATUS_OK otherwise and may be NULL. *
+*******************************************************************************/
+int graph_reachable(Graph* p_graph,
+                    vertex_id_t source_vertex_id,
+                    vertex_id_t target_vertex_id,
+                    int* p_return_status) {
+    vertex_list* p_queue;
+    vertex_set* p_visited;
+    graph_edge_cursor cursor;
+    vertex_id_t child_vertex_id;
+    weight_t weight;
+    size_t head;
+    int found = FALSE;
+    int rs = RETURN_STATUS_OK;
+
+    TRY_REPORT_RETURN_STATUS(RETURN_STATUS_OK);
+
+    if (!p_graph ||
+        !hasVertex(p_graph, source_vertex_id) ||
+        !hasVertex(p_graph, target_vertex_id)) {
+        return FALSE;
+    }
+
+    if (source_vertex_id == target_vertex_id) {
+        return TRUE;
+    }
+
+    if (graph_scc_index(p_graph)) {
+        return scc_index_reachable(graph_scc_index(p_graph),
+                                   source_vertex_id,
+                                   target_vertex_id,
+                                   p_return_status);
+    }
+
+    p_queue = vertex_list_alloc(INITIAL_MAP_CAPACITY);
+    p_visited = vertex_set_alloc(INITIAL_MAP_CAPACITY, LOAD_FACTOR);
+
+    if (!p_queue || !p_visited ||
+        vertex_list_push_back(p_queue, source_vertex_id) != RETURN_STATUS_OK ||
+        vertex_set_add(p_visited, source_vertex_id) != RETURN_STATUS_OK) {
+        rs = RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (head = 0;
+         !found && rs == RETURN_STATUS_OK && head < vertex_list_size(p_queue);
+         ++head) {
+        graph_children_cursor(p_graph,
+                              vertex_list_get(p_queue, head),
+                              &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &child_vertex_id, &weight)) {
+            if (child_vertex_id == target_vertex_id) {
+                found = TRUE;
+                break;
+            }
+
+            if (vertex_set_contains(p_visited, child_vertex_id)) {
+                continue;
+            }
+
+            if (vertex_set_add(p_visited, child_vertex_id) !=
+                RETURN_STATUS_OK ||
+                vertex_list_push_back(p_queue, child_vertex_id) !=
+                RETURN_STATUS_OK) {
+                rs = RETURN_STATUS_NO_MEMORY;
+                break;
+            }
+        }
+    }
+
+    if (p_queue) {
+        vertex_list_free(p_queue);
+    }
+
+    vertex_set_free(p_visited);
+    TRY_REPORT_RETURN_STATUS(rs);
+    return found;
+}
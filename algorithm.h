@@ -2,16 +2,111 @@
 #define COM_GITHUB_CODERODDE_PERL_ALGORITHM_H
 
 #include "graph.h"
+#include "query_context.h"
+#include "query_metrics.h"
+#include "query_trace.h"
 #include "vertex_list.h"
 
+/*******************************************************************************
+* What a search did. Settled counts are per direction; the unidirectional     *
+* search settles forward only. 'rehashes' counts the doublings of the search  *
+* hash tables. The byte counts are the most memory the search containers held *
+* at once, by structure and summed over both directions; 'bytes_allocated' is *
+* their total. The phase times add up to the whole call.                      *
+*******************************************************************************/
+typedef struct search_stats {
+    size_t settled_forward;
+    size_t settled_backward;
+    size_t edges_scanned;
+    size_t edges_relaxed;
+    size_t decrease_keys;
+    size_t heap_peak;        /* Most vertices in the open heaps at once. */
+    size_t rehashes;
+    size_t heap_bytes;       /* The open heaps. */
+    size_t distance_bytes;   /* The distance maps. */
+    size_t parent_bytes;     /* The parent maps. */
+    size_t closed_bytes;     /* The closed sets. */
+    size_t bytes_allocated;
+    double setup_seconds;
+    double search_seconds;
+    double traceback_seconds;
+    double cleanup_seconds;
+} search_stats;
+
+/*******************************************************************************
+* The containers of a search, kept from one query to the next, so that a      *
+* thread running many queries neither allocates them again nor regrows their  *
+* tables. Serves one search at a time. Since the tables stay grown, the       *
+* 'rehashes' of the stats count from the first query of the workspace.        *
+*******************************************************************************/
+typedef struct search_workspace search_workspace;
+
+search_workspace* search_workspace_alloc(void);
+
+void search_workspace_free(search_workspace* p_workspace);
+
+/*******************************************************************************
+* Optional limits for a search. A search that cannot finish within them       *
+* stops with RETURN_STATUS_BOUND_EXCEEDED, RETURN_STATUS_CANCELLED or         *
+* RETURN_STATUS_DEADLINE_EXCEEDED.                                            *
+*******************************************************************************/
+typedef struct search_options {
+    /* Give up once the path is known to be longer; WEIGHT_MAX for none: */
+    weight_t       max_distance;
+
+    /* Give up after settling this many vertices; 0 for no limit: */
+    size_t         max_settled;
+
+    /* Deadline and cancellation of the query; NULL for none: */
+    query_context* p_context;
+
+    /* Filled in by the search if not NULL: */
+    search_stats*  p_stats;
+
+    /* The latency and status of the query are recorded here if not NULL. */
+    /* The shard must belong to the calling thread.                        */
+    query_metrics_shard* p_metrics;
+
+    /* The timeline of the query is appended here if not NULL. The trace */
+    /* must belong to the calling thread.                                */
+    query_trace*   p_trace;
+
+    /* The search reuses these containers if not NULL. The workspace must */
+    /* belong to the calling thread.                                      */
+    search_workspace* p_workspace;
+
+    /* Gets the length of the path found if not NULL, so that callers that */
+    /* want only the distance need not walk the path to add it up.         */
+    weight_t*      p_distance;
+} search_options;
+
+void search_options_init(search_options* p_options);
+
 vertex_list* find_shortest_path(Graph* p_graph,
-                                size_t source_vertex_id,
-                                size_t target_vertex_id,
+                                vertex_id_t source_vertex_id,
+                                vertex_id_t target_vertex_id,
                                 int* p_return_status);
 
 vertex_list* find_shortest_path_2(Graph* p_graph,
-                                  size_t source_vertex_id,
-                                  size_t target_vertex_id,
+                                  vertex_id_t source_vertex_id,
+                                  vertex_id_t target_vertex_id,
                                   int* p_return_status);
 
+vertex_list* find_shortest_path_ex(Graph* p_graph,
+                                   vertex_id_t source_vertex_id,
+                                   vertex_id_t target_vertex_id,
+                                   const search_options* p_options,
+                                   int* p_return_status);
+
+vertex_list* find_shortest_path_2_ex(Graph* p_graph,
+                                     vertex_id_t source_vertex_id,
+                                     vertex_id_t target_vertex_id,
+                                     const search_options* p_options,
+                                     int* p_return_status);
+
+int graph_reachable(Graph* p_graph,
+                    vertex_id_t source_vertex_id,
+                    vertex_id_t target_vertex_id,
+                    int* p_return_status);
+
 #endif /* COM_GITHUB_CODERODDE_PERL_ALGORITHM_H */
\ No newline at end of file
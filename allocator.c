@@ -0,0 +1,82 @@
+#include "allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* libc_malloc(void* p_context, size_t size)
+{
+    (void) p_context;
+    return malloc(size);
+}
+
+static void* libc_realloc(void* p_context, void* p_memory, size_t size)
+{
+    (void) p_context;
+    return realloc(p_memory, size);
+}
+
+static void libc_free(void* p_context, void* p_memory)
+{
+    (void) p_context;
+    free(p_memory);
+}
+
+static allocator current_allocator = {
+    libc_malloc,
+    libc_realloc,
+    libc_free,
+    NULL
+};
+
+void allocator_set(const allocator* p_allocator)
+{
+    if (p_allocator)
+    {
+        current_allocator = *p_allocator;
+    }
+    else
+    {
+        current_allocator.p_malloc = libc_malloc;
+        current_allocator.p_realloc = libc_realloc;
+        current_allocator.p_free = libc_free;
+        current_allocator.p_context = NULL;
+    }
+}
+
+void* allocator_malloc(size_t size)
+{
+    return current_allocator.p_malloc(current_allocator.p_context, size);
+}
+
+void* allocator_calloc(size_t count, size_t size)
+{
+    void* p_memory;
+
+    if (size && count > (size_t) -1 / size)
+    {
+        return NULL;
+    }
+
+    p_memory = allocator_malloc(count * size);
+
+    if (p_memory)
+    {
+        memset(p_memory, 0, count * size);
+    }
+
+    return p_memory;
+}
+
+void* allocator_realloc(void* p_memory, size_t size)
+{
+    return current_allocator.p_realloc(current_allocator.p_context,
+                                       p_memory,
+                                       size);
+}
+
+void allocator_free(void* p_memory)
+{
+    if (p_memory)
+    {
+        current_allocator.p_free(current_allocator.p_context, p_memory);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_ALLOCATOR_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_ALLOCATOR_H
+
+#include <stdlib.h>
+
+/*******************************************************************************
+* The memory hooks used by every container and by the graph. 'p_context' is  *
+* passed back verbatim to each hook; use it for an arena, a pool or an        *
+* interpreter handle. Install the hooks before the first allocation and keep  *
+* them until the last block is freed.                                          *
+*******************************************************************************/
+typedef struct allocator {
+    void* (*p_malloc)  (void* p_context, size_t size);
+    void* (*p_realloc) (void* p_context, void* p_memory, size_t size);
+    void  (*p_free)    (void* p_context, void* p_memory);
+    void*  p_context;
+} allocator;
+
+/* Passing NULL restores the C library allocator: */
+void  allocator_set     (const allocator* p_allocator);
+
+void* allocator_malloc  (size_t size);
+void* allocator_calloc  (size_t count, size_t size);
+void* allocator_realloc (void* p_memory, size_t size);
+void  allocator_free    (void* p_memory);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_ALLOCATOR_H */
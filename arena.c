@@ -0,0 +1,166 @@
+#include "allocator.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t MINIMUM_BLOCK_SIZE = 64 * 1024;
+static const size_t ALIGNMENT = 16;
+static const size_t SMALL_CLASSES = 16; /* 16, 32, ..., 256 bytes. */
+
+/*******************************************************************************
+* Maps 'size' to its size class and stores the rounded size of the class in   *
+* '*p_class_size'. Small requests are rounded to a multiple of 16 bytes,      *
+* larger ones to a power of two.                                              *
+*******************************************************************************/
+static size_t size_class(size_t size, size_t* p_class_size)
+{
+    size_t class_size;
+    size_t index;
+
+    if (size == 0)
+    {
+        size = 1;
+    }
+
+    if (size <= SMALL_CLASSES * ALIGNMENT)
+    {
+        index = (size + ALIGNMENT - 1) / ALIGNMENT - 1;
+        *p_class_size = (index + 1) * ALIGNMENT;
+        return index;
+    }
+
+    class_size = 2 * SMALL_CLASSES * ALIGNMENT;
+    index = SMALL_CLASSES;
+
+    while (class_size < size)
+    {
+        class_size <<= 1;
+        ++index;
+    }
+
+    *p_class_size = class_size;
+    return index;
+}
+
+arena* arena_alloc(size_t block_size)
+{
+    arena* p_arena = allocator_malloc(sizeof(*p_arena));
+
+    if (!p_arena)
+    {
+        return NULL;
+    }
+
+    memset(p_arena, 0, sizeof(*p_arena));
+    p_arena->block_size = block_size < MINIMUM_BLOCK_SIZE ?
+                          MINIMUM_BLOCK_SIZE :
+                          block_size;
+
+    return p_arena;
+}
+
+/*******************************************************************************
+* Allocates a new block of at least 'size' usable bytes. Requests larger than *
+* a quarter of the block size get a block of their own so that the current    *
+* bump region is not abandoned.                                               *
+*******************************************************************************/
+static void* arena_new_block(arena* p_arena, size_t size)
+{
+    size_t header_size = (sizeof(arena_block) + ALIGNMENT - 1) &
+                         ~(ALIGNMENT - 1);
+    size_t payload_size = size > p_arena->block_size / 4 ?
+                          size :
+                          p_arena->block_size;
+    arena_block* p_block = allocator_malloc(header_size + payload_size);
+    unsigned char* p_payload;
+
+    if (!p_block)
+    {
+        return NULL;
+    }
+
+    p_block->next = p_arena->blocks;
+    p_arena->blocks = p_block;
+    p_arena->bytes_reserved += header_size + payload_size;
+    p_payload = (unsigned char*) p_block + header_size;
+
+    if (payload_size == size)
+    {
+        return p_payload;
+    }
+
+    p_arena->cursor = p_payload + size;
+    p_arena->end = p_payload + payload_size;
+    return p_payload;
+}
+
+void* arena_malloc(arena* p_arena, size_t size)
+{
+    size_t class_size;
+    size_t index = size_class(size, &class_size);
+    void* p_memory = p_arena->free_lists[index];
+
+    if (p_memory)
+    {
+        p_arena->free_lists[index] = *(void**) p_memory;
+        return p_memory;
+    }
+
+    if ((size_t)(p_arena->end - p_arena->cursor) >= class_size)
+    {
+        p_memory = p_arena->cursor;
+        p_arena->cursor += class_size;
+        return p_memory;
+    }
+
+    return arena_new_block(p_arena, class_size);
+}
+
+void* arena_calloc(arena* p_arena, size_t count, size_t size)
+{
+    void* p_memory = arena_malloc(p_arena, count * size);
+
+    if (p_memory)
+    {
+        memset(p_memory, 0, count * size);
+    }
+
+    return p_memory;
+}
+
+/*******************************************************************************
+* Puts a chunk obtained with the same 'size' back for reuse.                  *
+*******************************************************************************/
+void arena_release(arena* p_arena, void* p_memory, size_t size)
+{
+    size_t class_size;
+    size_t index;
+
+    if (!p_memory)
+    {
+        return;
+    }
+
+    index = size_class(size, &class_size);
+    *(void**) p_memory = p_arena->free_lists[index];
+    p_arena->free_lists[index] = p_memory;
+}
+
+void arena_free(arena* p_arena)
+{
+    arena_block* p_block;
+    arena_block* p_next_block;
+
+    if (!p_arena)
+    {
+        return;
+    }
+
+    for (p_block = p_arena->blocks; p_block; p_block = p_next_block)
+    {
+        p_next_block = p_block->next;
+        allocator_free(p_block);
+    }
+
+    allocator_free(p_arena);
+}
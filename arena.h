@@ -0,0 +1,32 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_ARENA_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_ARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_SIZE_CLASSES 64
+
+typedef struct arena_block {
+    struct arena_block* next;
+} arena_block;
+
+/*******************************************************************************
+* A region allocator. Memory is carved out of large blocks by bumping a       *
+* cursor, released chunks are kept on per size class free lists for reuse,   *
+* and arena_free() returns all the blocks to the system at once.              *
+*******************************************************************************/
+typedef struct arena {
+    arena_block*   blocks;
+    unsigned char* cursor;
+    unsigned char* end;
+    void*          free_lists[ARENA_SIZE_CLASSES];
+    size_t         block_size;
+    size_t         bytes_reserved;
+} arena;
+
+arena* arena_alloc   (size_t block_size);
+void*  arena_malloc  (arena* p_arena, size_t size);
+void*  arena_calloc  (arena* p_arena, size_t count, size_t size);
+void   arena_release (arena* p_arena, void* p_memory, size_t size);
+void   arena_free    (arena* p_arena);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_ARENA_H */
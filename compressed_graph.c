@@ -0,0 +1,631 @@
+#include "allocator.h"
+#include "compressed_graph.h"
+#include "graph.h"
+#include "graph_image.h"
+#include "graph_vertex_map.h"
+#include "util.h"
+#include "weight_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXIMUM_VARINT_LENGTH 10
+
+/*******************************************************************************
+* graph_update_weights() rewrites weights under running queries, so both      *
+* sides access them with relaxed atomics; that keeps a query from reading a   *
+* torn weight, and orders nothing else. The generic builtins are used since   *
+* the weights are floats. Compilers without the GCC atomics fall back to      *
+* volatile accesses, as in query_metrics.c.                                   *
+*******************************************************************************/
+#if defined(__GNUC__)
+#define LOAD_WEIGHT(P_WEIGHT, P_VALUE) \
+        __atomic_load((P_WEIGHT), (P_VALUE), __ATOMIC_RELAXED)
+#define STORE_WEIGHT(P_WEIGHT, P_VALUE) \
+        __atomic_store((P_WEIGHT), (P_VALUE), __ATOMIC_RELAXED)
+#else
+#define LOAD_WEIGHT(P_WEIGHT, P_VALUE) \
+        (*(P_VALUE) = *(const volatile float*)(P_WEIGHT))
+#define STORE_WEIGHT(P_WEIGHT, P_VALUE) \
+        (*(volatile float*)(P_WEIGHT) = *(P_VALUE))
+#endif
+
+typedef struct compressed_edge {
+    vertex_id_t vertex_id;
+    weight_t weight;
+} compressed_edge;
+
+static int compare_vertex_ids(const void* p_a, const void* p_b)
+{
+    vertex_id_t a = *(const vertex_id_t*) p_a;
+    vertex_id_t b = *(const vertex_id_t*) p_b;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int compare_edges(const void* p_a, const void* p_b)
+{
+    return compare_vertex_ids(&((const compressed_edge*) p_a)->vertex_id,
+                              &((const compressed_edge*) p_b)->vertex_id);
+}
+
+/*******************************************************************************
+* Writes 'value' as a LEB128 varint and returns the number of bytes written.  *
+*******************************************************************************/
+static size_t encode_varint(unsigned char* p_out, size_t value)
+{
+    size_t length = 0;
+
+    while (value >= 0x80)
+    {
+        p_out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    p_out[length++] = (unsigned char) value;
+    return length;
+}
+
+static size_t decode_varint(const unsigned char** pp_in)
+{
+    const unsigned char* p_in = *pp_in;
+    size_t value = 0;
+    size_t shift = 0;
+
+    while (*p_in & 0x80)
+    {
+        value |= (size_t)(*p_in++ & 0x7f) << shift;
+        shift += 7;
+    }
+
+    value |= (size_t)(*p_in++) << shift;
+    *pp_in = p_in;
+    return value;
+}
+
+static void compressed_adjacency_free(compressed_adjacency* p_adjacency)
+{
+    allocator_free(p_adjacency->byte_offsets);
+    allocator_free(p_adjacency->edge_offsets);
+    allocator_free(p_adjacency->bytes);
+    allocator_free(p_adjacency->weights);
+}
+
+static GraphVertex* get_graph_vertex(Graph* p_graph,
+                                     compressed_graph* p_compressed,
+                                     size_t index)
+{
+    vertex_id_t vertex_id = p_compressed->vertex_ids ?
+                            p_compressed->vertex_ids[index] :
+                            (vertex_id_t) index;
+
+    return graph_vertex_map_get(p_graph->p_nodes, vertex_id);
+}
+
+/*******************************************************************************
+* Encodes either the children (when 'children' is TRUE) or the parents of     *
+* every vertex in 'p_graph' into 'p_adjacency'.                               *
+*******************************************************************************/
+static int compressed_adjacency_build(Graph* p_graph,
+                                      compressed_graph* p_compressed,
+                                      compressed_adjacency* p_adjacency,
+                                      int children)
+{
+    size_t n = p_compressed->vertex_count;
+    size_t i;
+    size_t j;
+    size_t edge_count = 0;
+    size_t max_degree = 0;
+    size_t byte_capacity;
+    vertex_id_t previous_vertex_id;
+    unsigned char* p_new_bytes;
+    compressed_edge* p_edges;
+    weight_map* p_map;
+    weight_map_entry* p_entry;
+
+    p_adjacency->byte_offsets = allocator_malloc(sizeof(size_t) * (n + 1));
+    p_adjacency->edge_offsets = allocator_malloc(sizeof(size_t) * (n + 1));
+    p_adjacency->bytes = NULL;
+    p_adjacency->weights = NULL;
+    p_adjacency->byte_count = 0;
+
+    if (!p_adjacency->byte_offsets || !p_adjacency->edge_offsets)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        p_map = children ?
+                get_graph_vertex(p_graph, p_compressed, i)->p_children :
+                get_graph_vertex(p_graph, p_compressed, i)->p_parents;
+
+        p_adjacency->edge_offsets[i] = edge_count;
+        edge_count += p_map->size;
+
+        if (max_degree < p_map->size)
+        {
+            max_degree = p_map->size;
+        }
+    }
+
+    p_adjacency->edge_offsets[n] = edge_count;
+    p_compressed->edge_count = edge_count;
+
+    /* Most gaps fit in a byte or two; grow the stream on demand. */
+    byte_capacity = 2 * edge_count + MAXIMUM_VARINT_LENGTH;
+    p_adjacency->bytes = allocator_malloc(byte_capacity);
+    p_adjacency->weights = allocator_malloc(sizeof(float) * (edge_count + 1));
+    p_edges = allocator_malloc(sizeof(compressed_edge) * (max_degree + 1));
+
+    if (!p_adjacency->bytes || !p_adjacency->weights || !p_edges)
+    {
+        allocator_free(p_edges);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        p_map = children ?
+                get_graph_vertex(p_graph, p_compressed, i)->p_children :
+                get_graph_vertex(p_graph, p_compressed, i)->p_parents;
+
+        j = 0;
+
+        for (p_entry = p_map->head; p_entry; p_entry = p_entry->next)
+        {
+            p_edges[j].vertex_id = p_entry->vertex_id;
+            p_edges[j].weight = p_entry->weight;
+            ++j;
+        }
+
+        qsort(p_edges, j, sizeof(compressed_edge), compare_edges);
+        p_adjacency->byte_offsets[i] = p_adjacency->byte_count;
+        previous_vertex_id = 0;
+
+        for (j = 0; j < p_map->size; ++j)
+        {
+            if (p_adjacency->byte_count + MAXIMUM_VARINT_LENGTH >
+                byte_capacity)
+            {
+                byte_capacity *= 2;
+                p_new_bytes = allocator_realloc(p_adjacency->bytes,
+                                                byte_capacity);
+
+                if (!p_new_bytes)
+                {
+                    allocator_free(p_edges);
+                    return RETURN_STATUS_NO_MEMORY;
+                }
+
+                p_adjacency->bytes = p_new_bytes;
+            }
+
+            p_adjacency->byte_count +=
+                    encode_varint(p_adjacency->bytes +
+                                  p_adjacency->byte_count,
+                                  p_edges[j].vertex_id - previous_vertex_id);
+
+            p_adjacency->weights[p_adjacency->edge_offsets[i] + j] =
+                    (float) p_edges[j].weight;
+
+            previous_vertex_id = p_edges[j].vertex_id;
+        }
+    }
+
+    p_adjacency->byte_offsets[n] = p_adjacency->byte_count;
+    allocator_free(p_edges);
+
+    /* Give back the slack of the byte stream. */
+    p_new_bytes = allocator_realloc(p_adjacency->bytes,
+                                    p_adjacency->byte_count + 1);
+
+    if (p_new_bytes)
+    {
+        p_adjacency->bytes = p_new_bytes;
+    }
+
+    return RETURN_STATUS_OK;
+}
+
+compressed_graph* compressed_graph_alloc(Graph* p_graph)
+{
+    compressed_graph* p_compressed;
+    graph_vertex_map_entry* p_entry;
+    size_t i;
+    int dense;
+
+    if (!p_graph || !p_graph->p_nodes)
+    {
+        return NULL;
+    }
+
+    p_compressed = allocator_calloc(1, sizeof(*p_compressed));
+
+    if (!p_compressed)
+    {
+        return NULL;
+    }
+
+    p_compressed->vertex_count = p_graph->p_nodes->size;
+    p_compressed->vertex_ids =
+            allocator_malloc(sizeof(vertex_id_t) *
+                             (p_compressed->vertex_count + 1));
+
+    if (!p_compressed->vertex_ids)
+    {
+        allocator_free(p_compressed);
+        return NULL;
+    }
+
+    i = 0;
+
+    for (p_entry = p_graph->p_nodes->head; p_entry; p_entry = p_entry->next)
+    {
+        p_compressed->vertex_ids[i++] = p_entry->vertex_id;
+    }
+
+    qsort(p_compressed->vertex_ids,
+          p_compressed->vertex_count,
+          sizeof(vertex_id_t),
+          compare_vertex_ids);
+
+    dense = TRUE;
+
+    for (i = 0; i < p_compressed->vertex_count; ++i)
+    {
+        if (p_compressed->vertex_ids[i] != i)
+        {
+            dense = FALSE;
+            break;
+        }
+    }
+
+    /* Vertex IDs 0, 1, ..., n - 1 are their own indices. */
+    if (dense)
+    {
+        allocator_free(p_compressed->vertex_ids);
+        p_compressed->vertex_ids = NULL;
+    }
+
+    if (compressed_adjacency_build(p_graph,
+                                   p_compressed,
+                                   &p_compressed->children,
+                                   TRUE) != RETURN_STATUS_OK ||
+        compressed_adjacency_build(p_graph,
+                                   p_compressed,
+                                   &p_compressed->parents,
+                                   FALSE) != RETURN_STATUS_OK)
+    {
+        compressed_graph_free(p_compressed);
+        return NULL;
+    }
+
+    return p_compressed;
+}
+
+static void* clone_array(const void* p_source, size_t size)
+{
+    void* p_copy = allocator_malloc(size);
+
+    if (p_copy)
+    {
+        memcpy(p_copy, p_source, size);
+    }
+
+    return p_copy;
+}
+
+static int compressed_adjacency_clone(compressed_adjacency* p_source,
+                                      compressed_adjacency* p_copy,
+                                      size_t vertex_count,
+                                      size_t edge_count)
+{
+    size_t offsets_size = sizeof(size_t) * (vertex_count + 1);
+
+    p_copy->byte_count = p_source->byte_count;
+    p_copy->byte_offsets = clone_array(p_source->byte_offsets, offsets_size);
+    p_copy->edge_offsets = clone_array(p_source->edge_offsets, offsets_size);
+    p_copy->bytes = clone_array(p_source->bytes, p_source->byte_count + 1);
+    p_copy->weights = clone_array(p_source->weights,
+                                  sizeof(float) * (edge_count + 1));
+
+    return p_copy->byte_offsets &&
+           p_copy->edge_offsets &&
+           p_copy->bytes &&
+           p_copy->weights;
+}
+
+compressed_graph* compressed_graph_clone(compressed_graph* p_graph)
+{
+    compressed_graph* p_copy = allocator_calloc(1, sizeof(*p_copy));
+
+    if (!p_copy)
+    {
+        return NULL;
+    }
+
+    p_copy->vertex_count = p_graph->vertex_count;
+    p_copy->edge_count = p_graph->edge_count;
+
+    if (p_graph->vertex_ids)
+    {
+        p_copy->vertex_ids =
+                clone_array(p_graph->vertex_ids,
+                            sizeof(vertex_id_t) * p_graph->vertex_count);
+
+        if (!p_copy->vertex_ids)
+        {
+            compressed_graph_free(p_copy);
+            return NULL;
+        }
+    }
+
+    if (!compressed_adjacency_clone(&p_graph->children,
+                                    &p_copy->children,
+                                    p_graph->vertex_count,
+                                    p_graph->edge_count) ||
+        !compressed_adjacency_clone(&p_graph->parents,
+                                    &p_copy->parents,
+                                    p_graph->vertex_count,
+                                    p_graph->edge_count))
+    {
+        compressed_graph_free(p_copy);
+        return NULL;
+    }
+
+    return p_copy;
+}
+
+void compressed_graph_free(compressed_graph* p_graph)
+{
+    if (!p_graph)
+    {
+        return;
+    }
+
+    if (p_graph->p_mapping)
+    {
+        graph_image_unmap(p_graph->p_mapping, p_graph->mapping_size);
+        allocator_free(p_graph);
+        return;
+    }
+
+    compressed_adjacency_free(&p_graph->children);
+    compressed_adjacency_free(&p_graph->parents);
+    allocator_free(p_graph->vertex_ids);
+    allocator_free(p_graph);
+}
+
+/*******************************************************************************
+* Returns the index of the vertex 'vertex_id' or COMPRESSED_GRAPH_NO_VERTEX.  *
+*******************************************************************************/
+size_t compressed_graph_find(compressed_graph* p_graph,
+                             vertex_id_t vertex_id)
+{
+    size_t low;
+    size_t high;
+    size_t middle;
+
+    if (!p_graph->vertex_ids)
+    {
+        return vertex_id < p_graph->vertex_count ?
+               vertex_id :
+               COMPRESSED_GRAPH_NO_VERTEX;
+    }
+
+    low = 0;
+    high = p_graph->vertex_count;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+
+        if (p_graph->vertex_ids[middle] < vertex_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low < p_graph->vertex_count && p_graph->vertex_ids[low] == vertex_id)
+    {
+        return low;
+    }
+
+    return COMPRESSED_GRAPH_NO_VERTEX;
+}
+
+static void compressed_adjacency_cursor(compressed_adjacency* p_adjacency,
+                                        size_t vertex_index,
+                                        compressed_graph_cursor* p_cursor)
+{
+    size_t edge_offset = p_adjacency->edge_offsets[vertex_index];
+
+    p_cursor->p_bytes =
+            p_adjacency->bytes + p_adjacency->byte_offsets[vertex_index];
+
+    p_cursor->p_weights = p_adjacency->weights + edge_offset;
+    p_cursor->remaining =
+            p_adjacency->edge_offsets[vertex_index + 1] - edge_offset;
+
+    p_cursor->vertex_id = 0;
+}
+
+void compressed_graph_children(compressed_graph* p_graph,
+                               size_t vertex_index,
+                               compressed_graph_cursor* p_cursor)
+{
+    compressed_adjacency_cursor(&p_graph->children, vertex_index, p_cursor);
+}
+
+void compressed_graph_parents(compressed_graph* p_graph,
+                              size_t vertex_index,
+                              compressed_graph_cursor* p_cursor)
+{
+    compressed_adjacency_cursor(&p_graph->parents, vertex_index, p_cursor);
+}
+
+int compressed_graph_cursor_next(compressed_graph_cursor* p_cursor,
+                                 vertex_id_t* p_vertex_id,
+                                 weight_t* p_weight)
+{
+    float weight;
+
+    if (p_cursor->remaining == 0)
+    {
+        return FALSE;
+    }
+
+    p_cursor->vertex_id += (vertex_id_t) decode_varint(&p_cursor->p_bytes);
+    p_cursor->remaining--;
+
+    *p_vertex_id = p_cursor->vertex_id;
+    LOAD_WEIGHT(p_cursor->p_weights, &weight);
+    p_cursor->p_weights++;
+    *p_weight = weight;
+    return TRUE;
+}
+
+/*******************************************************************************
+* Returns the position of 'vertex_id' in the neighbor list of the vertex at   *
+* 'vertex_index', or COMPRESSED_GRAPH_NO_EDGE.                                *
+*******************************************************************************/
+static size_t compressed_adjacency_position(compressed_adjacency* p_adjacency,
+                                            size_t vertex_index,
+                                            vertex_id_t vertex_id)
+{
+    compressed_graph_cursor cursor;
+    vertex_id_t neighbor_id;
+    weight_t weight;
+    size_t position = 0;
+
+    compressed_adjacency_cursor(p_adjacency, vertex_index, &cursor);
+
+    while (compressed_graph_cursor_next(&cursor, &neighbor_id, &weight))
+    {
+        if (neighbor_id == vertex_id)
+        {
+            return position;
+        }
+
+        /* The lists are sorted; no need to decode past 'vertex_id'. */
+        if (neighbor_id > vertex_id)
+        {
+            break;
+        }
+
+        ++position;
+    }
+
+    return COMPRESSED_GRAPH_NO_EDGE;
+}
+
+size_t compressed_graph_edge_id(compressed_graph* p_graph,
+                                size_t tail_index,
+                                vertex_id_t head_vertex_id)
+{
+    size_t position = compressed_adjacency_position(&p_graph->children,
+                                                    tail_index,
+                                                    head_vertex_id);
+
+    return position == COMPRESSED_GRAPH_NO_EDGE ?
+           COMPRESSED_GRAPH_NO_EDGE :
+           p_graph->children.edge_offsets[tail_index] + position;
+}
+
+/*******************************************************************************
+* Finds the index of the vertex whose children contain the edge 'edge_id'.    *
+*******************************************************************************/
+static size_t find_tail_index(compressed_graph* p_graph, size_t edge_id)
+{
+    size_t* edge_offsets = p_graph->children.edge_offsets;
+    size_t low = 0;
+    size_t high = p_graph->vertex_count;
+    size_t middle;
+
+    /* Last index 'i' with edge_offsets[i] <= edge_id: */
+    while (high - low > 1)
+    {
+        middle = low + (high - low) / 2;
+
+        if (edge_offsets[middle] <= edge_id)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+int compressed_graph_update_weight(compressed_graph* p_graph,
+                                   size_t edge_id,
+                                   weight_t weight)
+{
+    compressed_graph_cursor cursor;
+    size_t tail_index;
+    size_t head_index;
+    size_t position;
+    vertex_id_t tail_vertex_id;
+    vertex_id_t head_vertex_id = 0;
+    weight_t old_weight;
+    float new_weight = (float) weight;
+
+    if (edge_id >= p_graph->edge_count)
+    {
+        return FALSE;
+    }
+
+    tail_index = find_tail_index(p_graph, edge_id);
+    tail_vertex_id = p_graph->vertex_ids ?
+                     p_graph->vertex_ids[tail_index] :
+                     (vertex_id_t) tail_index;
+
+    /* Decode the head vertex of the edge: */
+    compressed_graph_children(p_graph, tail_index, &cursor);
+    position = edge_id - p_graph->children.edge_offsets[tail_index];
+
+    do
+    {
+        compressed_graph_cursor_next(&cursor, &head_vertex_id, &old_weight);
+    }
+    while (position--);
+
+    head_index = compressed_graph_find(p_graph, head_vertex_id);
+    position = compressed_adjacency_position(&p_graph->parents,
+                                             head_index,
+                                             tail_vertex_id);
+
+    /* A query running now may see one of these stores and not the other: */
+    position += p_graph->parents.edge_offsets[head_index];
+    STORE_WEIGHT(&p_graph->children.weights[edge_id], &new_weight);
+    STORE_WEIGHT(&p_graph->parents.weights[position], &new_weight);
+    return TRUE;
+}
+
+/*******************************************************************************
+* Returns the bytes of 'p_graph' in private memory; an image mapping is       *
+* shared and not counted.                                                     *
+*******************************************************************************/
+size_t compressed_graph_memory_usage(compressed_graph* p_graph)
+{
+    size_t offsets = 4 * sizeof(size_t) * (p_graph->vertex_count + 1);
+    size_t bytes = p_graph->children.byte_count +
+                   p_graph->parents.byte_count;
+    size_t weights = 2 * sizeof(float) * p_graph->edge_count;
+    size_t ids = p_graph->vertex_ids ?
+                 sizeof(vertex_id_t) * p_graph->vertex_count :
+                 0;
+
+    if (p_graph->p_mapping)
+    {
+        return sizeof(*p_graph);
+    }
+
+    return sizeof(*p_graph) + offsets + bytes + weights + ids;
+}
@@ -0,0 +1,78 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_COMPRESSED_GRAPH_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_COMPRESSED_GRAPH_H
+
+#include "util.h"
+#include <stdlib.h>
+
+#define COMPRESSED_GRAPH_NO_VERTEX ((size_t) -1)
+#define COMPRESSED_GRAPH_NO_EDGE   ((size_t) -1)
+
+struct Graph;
+
+/*******************************************************************************
+* One direction (children or parents) of the compressed adjacency. The        *
+* neighbors of the vertex at index 'i' are stored sorted by ID as LEB128      *
+* varints of the gaps between consecutive IDs in                              *
+* 'bytes[byte_offsets[i] .. byte_offsets[i + 1])'. The matching weights live  *
+* in a separate stream 'weights[edge_offsets[i] .. edge_offsets[i + 1])'.     *
+*******************************************************************************/
+typedef struct compressed_adjacency {
+    size_t*        byte_offsets;
+    size_t*        edge_offsets;
+    unsigned char* bytes;
+    float*         weights;
+    size_t         byte_count;
+} compressed_adjacency;
+
+typedef struct compressed_graph {
+    vertex_id_t*         vertex_ids; /* Sorted, NULL if the IDs are dense. */
+    size_t               vertex_count;
+    size_t               edge_count;
+    compressed_adjacency children;
+    compressed_adjacency parents;
+
+    /* The read-only graph image the arrays point into, or NULL if they */
+    /* are allocated:                                                   */
+    void*                p_mapping;
+    size_t               mapping_size;
+} compressed_graph;
+
+typedef struct compressed_graph_cursor {
+    const unsigned char* p_bytes;
+    const float*         p_weights;
+    size_t               remaining;
+    vertex_id_t          vertex_id;
+} compressed_graph_cursor;
+
+compressed_graph* compressed_graph_alloc(struct Graph* p_graph);
+
+compressed_graph* compressed_graph_clone(compressed_graph* p_graph);
+
+void compressed_graph_free(compressed_graph* p_graph);
+
+size_t compressed_graph_find(compressed_graph* p_graph,
+                             vertex_id_t vertex_id);
+
+void compressed_graph_children(compressed_graph* p_graph,
+                               size_t vertex_index,
+                               compressed_graph_cursor* p_cursor);
+
+void compressed_graph_parents(compressed_graph* p_graph,
+                              size_t vertex_index,
+                              compressed_graph_cursor* p_cursor);
+
+int compressed_graph_cursor_next(compressed_graph_cursor* p_cursor,
+                                 vertex_id_t* p_vertex_id,
+                                 weight_t* p_weight);
+
+size_t compressed_graph_edge_id(compressed_graph* p_graph,
+                                size_t tail_index,
+                                vertex_id_t head_vertex_id);
+
+int compressed_graph_update_weight(compressed_graph* p_graph,
+                                   size_t edge_id,
+                                   weight_t weight);
+
+size_t compressed_graph_memory_usage(compressed_graph* p_graph);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_COMPRESSED_GRAPH_H */
@@ -1,4 +1,5 @@
 #include "dary_heap.h"
+#include "allocator.h"
 #include "util.h"
 #include <stdbool.h>
 
@@ -26,7 +27,7 @@ static dary_heap_node_map* dary_heap_node_map_alloc(
         size_t initial_capacity,
         float load_factor) {
 
-    dary_heap_node_map* map = malloc(sizeof(*map));
+    dary_heap_node_map* map = allocator_malloc(sizeof(*map));
 
     if (!map) {
         return NULL;
@@ -40,8 +41,8 @@ static dary_heap_node_map* dary_heap_node_map_alloc(
     map->size = 0;
     map->head = NULL;
     map->tail = NULL;
-    map->table = calloc(initial_capacity,
-                        sizeof(dary_heap_node_map_entry*));
+    map->table = allocator_calloc(initial_capacity,
+                                  sizeof(dary_heap_node_map_entry*));
 
     map->mask = initial_capacity - 1;
     map->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -50,10 +51,10 @@ static dary_heap_node_map* dary_heap_node_map_alloc(
 }
 
 static dary_heap_node_map_entry*
-dary_heap_node_map_entry_alloc(size_t vertex_id,
+dary_heap_node_map_entry_alloc(vertex_id_t vertex_id,
                                dary_heap_node* heap_node)
 {
-    dary_heap_node_map_entry* p_ret = malloc(sizeof(*p_ret));
+    dary_heap_node_map_entry* p_ret = allocator_malloc(sizeof(*p_ret));
 
     if (!p_ret)
     {
@@ -83,8 +84,8 @@ static int ensure_capacity(dary_heap_node_map* map)
 
     new_capacity = 2 * map->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity,
-                       sizeof(dary_heap_node_map_entry*));
+    new_table = allocator_calloc(new_capacity,
+                                 sizeof(dary_heap_node_map_entry*));
 
     if (!new_table)
     {
@@ -99,7 +100,7 @@ static int ensure_capacity(dary_heap_node_map* map)
         new_table[index] = entry;
     }
 
-    free(map->table);
+    allocator_free(map->table);
 
     map->table = new_table;
     map->table_capacity = new_capacity;
@@ -111,7 +112,7 @@ static int ensure_capacity(dary_heap_node_map* map)
 
 static int dary_heap_node_map_put(
         dary_heap_node_map* map,
-        size_t vertex_id,
+        vertex_id_t vertex_id,
         dary_heap_node* heap_node)
 {
     size_t index;
@@ -164,7 +165,7 @@ static int dary_heap_node_map_put(
 
 static int dary_heap_node_map_contains_vertex(
         dary_heap_node_map* map,
-        size_t vertex_id)
+        vertex_id_t vertex_id)
 {
     size_t index;
     dary_heap_node_map_entry* entry;
@@ -183,9 +184,9 @@ static int dary_heap_node_map_contains_vertex(
 }
 
 static dary_heap_node*
-dary_heap_node_alloc(size_t vertex_id,
-                     double priority) {
-    dary_heap_node* node = malloc(sizeof(*node));
+dary_heap_node_alloc(vertex_id_t vertex_id,
+                     weight_t priority) {
+    dary_heap_node* node = allocator_malloc(sizeof(*node));
 
     if (!node)
     {
@@ -200,7 +201,7 @@ dary_heap_node_alloc(size_t vertex_id,
 
 static dary_heap_node*
 dary_heap_node_map_get(dary_heap_node_map* map,
-                       size_t vertex_id)
+                       vertex_id_t vertex_id)
 {
     size_t index;
     dary_heap_node_map_entry* p_entry;
@@ -230,7 +231,7 @@ static void dary_heap_node_map_clear(dary_heap_node_map* map)
     {
         index = entry->vertex_id & map->mask;
         next_entry = entry->next;
-        free(entry);
+        allocator_free(entry);
         entry = next_entry;
         map->table[index] = NULL;
     }
@@ -241,7 +242,7 @@ static void dary_heap_node_map_clear(dary_heap_node_map* map)
 }
 
 void dary_heap_node_map_remove(dary_heap_node_map* map,
-                               size_t vertex_id)
+                               vertex_id_t vertex_id)
 {
     size_t index;
     dary_heap_node_map_entry* prev_entry;
@@ -286,7 +287,7 @@ void dary_heap_node_map_remove(dary_heap_node_map* map,
             }
 
             map->size--;
-            free(current_entry);
+            allocator_free(current_entry);
             return;
         }
 
@@ -297,8 +298,8 @@ void dary_heap_node_map_remove(dary_heap_node_map* map,
 void dary_heap_node_map_free(dary_heap_node_map* map)
 {
     dary_heap_node_map_clear(map);
-    free(map->table);
-    free(map);
+    allocator_free(map->table);
+    allocator_free(map);
 }
 
 dary_heap* dary_heap_alloc(size_t degree,
@@ -308,7 +309,7 @@ dary_heap* dary_heap_alloc(size_t degree,
     dary_heap* my_heap;
     dary_heap_node_map* p_map;
 
-    my_heap = malloc(sizeof(*my_heap));
+    my_heap = allocator_malloc(sizeof(*my_heap));
 
     if (!my_heap)
     {
@@ -320,29 +321,30 @@ dary_heap* dary_heap_alloc(size_t degree,
 
     if (!p_map)
     {
-        free(my_heap);
+        allocator_free(my_heap);
         return NULL;
     }
 
     degree = fix_degree(degree);
     initial_capacity = fix_initial_capacity(initial_capacity);
 
-    my_heap->table = malloc(sizeof(dary_heap_node*) * initial_capacity);
+    my_heap->table =
+            allocator_malloc(sizeof(dary_heap_node*) * initial_capacity);
 
     if (!my_heap->table)
     {
         dary_heap_node_map_free(p_map);
-        free(my_heap);
+        allocator_free(my_heap);
         return NULL;
     }
 
-    my_heap->indices = malloc(sizeof(size_t) * degree);
+    my_heap->indices = allocator_malloc(sizeof(size_t) * degree);
 
     if (!my_heap->indices)
     {
         dary_heap_node_map_free(p_map);
-        free(my_heap->table);
-        free(my_heap);
+        allocator_free(my_heap->table);
+        allocator_free(my_heap);
         return NULL;
     }
 
@@ -418,9 +420,9 @@ static void compute_children_indices(dary_heap* my_heap, size_t index)
 static void sift_down_root(dary_heap* my_heap)
 {
     dary_heap_node* target = my_heap->table[0];
-    double priority = target->priority;
-    double min_child_priority;
-    double tentative_priority;
+    weight_t priority = target->priority;
+    weight_t min_child_priority;
+    weight_t tentative_priority;
     size_t     min_child_index;
     size_t     i;
     size_t     degree = my_heap->degree;
@@ -474,7 +476,7 @@ static int ensure_capacity_before_add(dary_heap* my_heap)
     }
 
     new_capacity = 3 * my_heap->capacity / 2;
-    new_table = malloc(sizeof(dary_heap_node*) * new_capacity);
+    new_table = allocator_malloc(sizeof(dary_heap_node*) * new_capacity);
 
     if (!new_table) {
         return FALSE;
@@ -485,13 +487,15 @@ static int ensure_capacity_before_add(dary_heap* my_heap)
         new_table[i] = my_heap->table[i];
     }
 
-    free(my_heap->table);
+    allocator_free(my_heap->table);
     my_heap->table = new_table;
     my_heap->capacity = new_capacity;
     return TRUE;
 }
 
-int dary_heap_add(dary_heap* my_heap, size_t vertex_id, double priority)
+int dary_heap_add(dary_heap* my_heap,
+                  vertex_id_t vertex_id,
+                  weight_t priority)
 {
     dary_heap_node* node;
 
@@ -515,7 +519,7 @@ int dary_heap_add(dary_heap* my_heap, size_t vertex_id, double priority)
     my_heap->table[my_heap->size] = node;
 
     if (!dary_heap_node_map_put(my_heap->node_map, vertex_id, node)) {
-        free(node);
+        allocator_free(node);
         return RETURN_STATUS_NO_MEMORY;
     }
 
@@ -525,8 +529,8 @@ int dary_heap_add(dary_heap* my_heap, size_t vertex_id, double priority)
 }
 
 void dary_heap_decrease_key(dary_heap* my_heap,
-                            size_t vertex_id,
-                            double priority)
+                            vertex_id_t vertex_id,
+                            weight_t priority)
 {
     dary_heap_node* node =
             dary_heap_node_map_get(
@@ -540,20 +544,20 @@ void dary_heap_decrease_key(dary_heap* my_heap,
     }
 }
 
-size_t dary_heap_extract_min(dary_heap* my_heap)
+vertex_id_t dary_heap_extract_min(dary_heap* my_heap)
 {
-    size_t vertex_id;
+    vertex_id_t vertex_id;
     dary_heap_node* node = my_heap->table[0];
     vertex_id = node->vertex_id;
     my_heap->size--;
     my_heap->table[0] = my_heap->table[my_heap->size];
     dary_heap_node_map_remove(my_heap->node_map, vertex_id);
     sift_down_root(my_heap);
-    free(node);
+    allocator_free(node);
     return vertex_id;
 }
 
-size_t dary_heap_min(dary_heap* my_heap)
+vertex_id_t dary_heap_min(dary_heap* my_heap)
 {
     return my_heap->table[0]->vertex_id;
 }
@@ -563,6 +567,22 @@ size_t dary_heap_size(dary_heap* my_heap)
     return my_heap->size;
 }
 
+/*******************************************************************************
+* Counts the heap, its node table, one node per element and the node map.     *
+*******************************************************************************/
+size_t dary_heap_memory_usage(dary_heap* my_heap)
+{
+    dary_heap_node_map* p_map = my_heap->node_map;
+
+    return sizeof(*my_heap) +
+           sizeof(dary_heap_node*) * my_heap->capacity +
+           sizeof(size_t) * my_heap->degree +
+           sizeof(dary_heap_node) * my_heap->size +
+           sizeof(*p_map) +
+           sizeof(dary_heap_node_map_entry*) * p_map->table_capacity +
+           sizeof(dary_heap_node_map_entry) * p_map->size;
+}
+
 void dary_heap_clear(dary_heap* my_heap)
 {
     size_t i;
@@ -571,7 +591,7 @@ void dary_heap_clear(dary_heap* my_heap)
 
     for (i = 0; i < my_heap->size; ++i)
     {
-        free(my_heap->table[i]);
+        allocator_free(my_heap->table[i]);
     }
 
     my_heap->size = 0;
@@ -580,6 +600,8 @@ void dary_heap_clear(dary_heap* my_heap)
 void dary_heap_free(dary_heap* my_heap)
 {
     dary_heap_clear(my_heap);
-    free(my_heap->indices);
-    free(my_heap->table);
+    dary_heap_node_map_free(my_heap->node_map);
+    allocator_free(my_heap->indices);
+    allocator_free(my_heap->table);
+    allocator_free(my_heap);
 }
\ No newline at end of file
@@ -1,16 +1,17 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_DARY_HEAP_H
 #define	COM_GITHUB_CODERODDE_BIDIR_SEARCH_DARY_HEAP_H
 
+#include "util.h"
 #include <stdlib.h>
 
 typedef struct dary_heap_node {
-    size_t vertex_id;
-    double priority;
-    size_t index;
+    vertex_id_t vertex_id;
+    weight_t    priority;
+    size_t      index;
 } dary_heap_node;
 
 typedef struct dary_heap_node_map_entry {
-    size_t                    vertex_id;
+    vertex_id_t               vertex_id;
     dary_heap_node*           heap_node; /* ptr to the actual heap node */
     struct dary_heap_node_map_entry* chain_next;
     struct dary_heap_node_map_entry* prev;
@@ -42,17 +43,18 @@ dary_heap* dary_heap_alloc(size_t degree,
                            float  load_factor);
 
 int dary_heap_add (dary_heap* heap,
-                   size_t vertex_id,
-                   double priority);
+                   vertex_id_t vertex_id,
+                   weight_t priority);
 
 void   dary_heap_decrease_key (dary_heap* heap,
-                               size_t vertex_id,
-                               double priority);
-
-size_t dary_heap_extract_min  (dary_heap* heap);
-size_t dary_heap_min          (dary_heap* heap);
-size_t dary_heap_size         (dary_heap* heap);
-void   dary_heap_clear        (dary_heap* heap);
-void   dary_heap_free         (dary_heap* heap);
+                               vertex_id_t vertex_id,
+                               weight_t priority);
+
+vertex_id_t dary_heap_extract_min (dary_heap* heap);
+vertex_id_t dary_heap_min         (dary_heap* heap);
+size_t      dary_heap_size        (dary_heap* heap);
+size_t      dary_heap_memory_usage(dary_heap* heap);
+void        dary_heap_clear       (dary_heap* heap);
+void        dary_heap_free        (dary_heap* heap);
 
 #endif	/* COM_GITHUB_CODERODDE_BIDIR_SEARCH_DARY_HEAP_H */
\ No newline at end of file
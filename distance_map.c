@@ -1,12 +1,13 @@
 #include "distance_map.h"
+#include "allocator.h"
 #include "util.h"
 #include <stdlib.h>
 
 static distance_map_entry*
-distance_map_entry_alloc(size_t vertex_id,
-                         double distance)
+distance_map_entry_alloc(vertex_id_t vertex_id,
+                         weight_t distance)
 {
-    distance_map_entry* entry = malloc(sizeof(*entry));
+    distance_map_entry* entry = allocator_malloc(sizeof(*entry));
 
     if (!entry)
     {
@@ -58,7 +59,7 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 distance_map* distance_map_alloc(size_t initial_capacity,
                                  float load_factor)
 {
-    distance_map* map = malloc(sizeof(*map));
+    distance_map* map = allocator_malloc(sizeof(*map));
 
     if (!map)
     {
@@ -73,8 +74,8 @@ distance_map* distance_map_alloc(size_t initial_capacity,
     map->size = 0;
     map->head = NULL;
     map->tail = NULL;
-    map->table = calloc(initial_capacity,
-                        sizeof(distance_map_entry*));
+    map->table = allocator_calloc(initial_capacity,
+                                  sizeof(distance_map_entry*));
 
     map->mask = initial_capacity - 1;
     map->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -97,7 +98,7 @@ static int ensure_capacity(distance_map* map)
 
     new_capacity = 2 * map->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(distance_map_entry*));
+    new_table = allocator_calloc(new_capacity, sizeof(distance_map_entry*));
 
     if (!new_table)
     {
@@ -112,7 +113,7 @@ static int ensure_capacity(distance_map* map)
         new_table[index] = entry;
     }
 
-    free(map->table);
+    allocator_free(map->table);
 
     map->table = new_table;
     map->table_capacity = new_capacity;
@@ -123,8 +124,8 @@ static int ensure_capacity(distance_map* map)
 }
 
 int distance_map_put(distance_map* map,
-                     size_t vertex_id,
-                     double distance)
+                     vertex_id_t vertex_id,
+                     weight_t distance)
 {
     size_t index;
     size_t hash_value;
@@ -180,7 +181,7 @@ int distance_map_put(distance_map* map,
 }
 
 int distance_map_contains_vertex_id(distance_map* map,
-                                    size_t vertex_id)
+                                    vertex_id_t vertex_id)
 {
     size_t index;
     distance_map_entry* entry;
@@ -203,7 +204,7 @@ int distance_map_contains_vertex_id(distance_map* map,
     return 0;
 }
 
-double distance_map_get(distance_map* map, size_t vertex_id)
+weight_t distance_map_get(distance_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     distance_map_entry* p_entry;
@@ -227,7 +228,14 @@ double distance_map_get(distance_map* map, size_t vertex_id)
     return 0.0; /* Compiler, shut up! */
 }
 
-static void distance_map_clear(distance_map* map)
+size_t distance_map_memory_usage(distance_map* map)
+{
+    return sizeof(*map) +
+           sizeof(distance_map_entry*) * map->table_capacity +
+           sizeof(distance_map_entry) * map->size;
+}
+
+void distance_map_clear(distance_map* map)
 {
     distance_map_entry* entry;
     distance_map_entry* next_entry;
@@ -244,7 +252,7 @@ static void distance_map_clear(distance_map* map)
     {
         index = entry->vertex_id & map->mask;
         next_entry = entry->next;
-        free(entry);
+        allocator_free(entry);
         entry = next_entry;
         map->table[index] = NULL;
     }
@@ -262,6 +270,6 @@ void distance_map_free(distance_map* map)
     }
 
     distance_map_clear(map);
-    free(map->table);
-    free(map);
+    allocator_free(map->table);
+    allocator_free(map);
 }
\ No newline at end of file
@@ -1,11 +1,12 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_DISTANCE_MAP_H
 #define	COM_GITHUB_CODERODDE_BIDIR_SEARCH_DISTANCE_MAP_H
 
+#include "util.h"
 #include <stdlib.h>
 
 typedef struct distance_map_entry {
-    size_t                     vertex_id;
-    double                     distance;
+    vertex_id_t                vertex_id;
+    weight_t                   distance;
     struct distance_map_entry* chain_next;
     struct distance_map_entry* prev;
     struct distance_map_entry* next;
@@ -26,12 +27,16 @@ distance_map* distance_map_alloc(size_t initial_capacity,
                                  float load_factor);
 
 int distance_map_put(distance_map* map,
-                     size_t vertex_id,
-                     double distance);
+                     vertex_id_t vertex_id,
+                     weight_t distance);
 
 int distance_map_contains_vertex_id(distance_map* map,
-                                    size_t vertex_id);
-double distance_map_get(distance_map* map, size_t vertex_id);
+                                    vertex_id_t vertex_id);
+weight_t distance_map_get(distance_map* map, vertex_id_t vertex_id);
+
+size_t distance_map_memory_usage(distance_map* map);
+
+void distance_map_clear(distance_map* map);
 
 void distance_map_free(distance_map* map);
 
@@ -1,31 +1,42 @@
+#include "allocator.h"
+#include "compressed_graph.h"
 #include "graph.h"
 #include "graph_vertex_map.h"
+#include "scc_index.h"
 #include "util.h"
 #include "weight_map.h"
+#include <string.h>
 
 static const size_t initial_capacity = 1024;
+/* Most vertices have a handful of arcs; the maps grow when needed: */
+static const size_t adjacency_initial_capacity = 16;
 static const float load_factor = 1.3f;
+static const size_t arena_block_size = 4 * 1024 * 1024;
 
 Graph* allocGraph()
 {
-    Graph* p_graph = malloc(sizeof(Graph));
+    Graph* p_graph = allocator_malloc(sizeof(Graph));
     initGraph(p_graph);
     return p_graph;
 }
 
-int initGraphVertex(GraphVertex* p_graph_vertex, size_t id)
+int initGraphVertex(GraphVertex* p_graph_vertex,
+                    vertex_id_t id,
+                    arena* p_arena)
 {
     p_graph_vertex->p_children =
-            weight_map_alloc(initial_capacity,
-                             load_factor);
+            weight_map_alloc(adjacency_initial_capacity,
+                             load_factor,
+                             p_arena);
 
     if (!p_graph_vertex->p_children) {
         return RETURN_STATUS_NO_MEMORY;
     }
 
     p_graph_vertex->p_parents =
-            weight_map_alloc(initial_capacity,
-                             load_factor);
+            weight_map_alloc(adjacency_initial_capacity,
+                             load_factor,
+                             p_arena);
 
     if (!p_graph_vertex->p_parents) {
         weight_map_free(p_graph_vertex->p_children);
@@ -44,48 +55,137 @@ void freeGraphVertex(GraphVertex* p_graph_vertex)
 
 int initGraph(Graph* p_graph)
 {
+    p_graph->p_compressed = NULL;
+    p_graph->p_nodes = NULL;
+    p_graph->mod_count = 0;
+    p_graph->p_scc_index = NULL;
+    p_graph->p_arena = arena_alloc(arena_block_size);
+
+    if (!p_graph->p_arena) {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
     p_graph->p_nodes =
             graph_vertex_map_alloc(initial_capacity,
-                                   load_factor);
+                                   load_factor,
+                                   p_graph->p_arena);
 
     return p_graph->p_nodes ? RETURN_STATUS_OK : RETURN_STATUS_NO_MEMORY;
 }
 
+/*******************************************************************************
+* All vertices, their weight maps and the vertex map live in the arena of the *
+* graph, so there is no need to visit them one by one.                        *
+*******************************************************************************/
 void freeGraph(Graph* p_graph)
 {
-    size_t p_vertex_id;
-    GraphVertex* p_graph_vertex;
+    if (p_graph->p_compressed) {
+        compressed_graph_free(p_graph->p_compressed);
+        p_graph->p_compressed = NULL;
+    }
 
-	graph_vertex_map_iterator* p_iterator =
-		graph_vertex_map_iterator_alloc(p_graph->p_nodes);
+    scc_index_free(p_graph->p_scc_index);
+    p_graph->p_scc_index = NULL;
+    arena_free(p_graph->p_arena);
+    p_graph->p_arena = NULL;
+    p_graph->p_nodes = NULL;
+}
+
+/*******************************************************************************
+* Returns a deep copy of 'p_graph' that shares no memory with it. The SCC     *
+* index is not copied; call graph_build_scc_index() on the copy if needed.    *
+*******************************************************************************/
+Graph* cloneGraph(Graph* p_graph)
+{
+    Graph* p_copy;
+    graph_vertex_map_entry* p_vertex_entry;
+    weight_map_entry* p_edge_entry;
 
-	while (graph_vertex_map_iterator_has_next(p_iterator))
-	{
-		graph_vertex_map_iterator_next(
-			p_iterator,
-			&p_vertex_id,
-			&p_graph_vertex);
+    p_copy = allocator_malloc(sizeof(Graph));
 
-		freeGraphVertex(p_graph_vertex);
-	}
+    if (!p_copy) {
+        return NULL;
+    }
+
+    if (initGraph(p_copy) != RETURN_STATUS_OK) {
+        freeGraph(p_copy);
+        allocator_free(p_copy);
+        return NULL;
+    }
+
+    if (p_graph->p_compressed) {
+        arena_free(p_copy->p_arena);
+        p_copy->p_arena = NULL;
+        p_copy->p_nodes = NULL;
+        p_copy->p_compressed =
+                compressed_graph_clone(p_graph->p_compressed);
+
+        if (!p_copy->p_compressed) {
+            allocator_free(p_copy);
+            return NULL;
+        }
+
+        return p_copy;
+    }
+
+    for (p_vertex_entry = p_graph->p_nodes->head;
+         p_vertex_entry;
+         p_vertex_entry = p_vertex_entry->next) {
+
+        if (!addVertex(p_copy, p_vertex_entry->vertex_id)) {
+            freeGraph(p_copy);
+            allocator_free(p_copy);
+            return NULL;
+        }
+    }
 
-	graph_vertex_map_free(p_graph->p_nodes);
-	p_graph->p_nodes = NULL;
+    for (p_vertex_entry = p_graph->p_nodes->head;
+         p_vertex_entry;
+         p_vertex_entry = p_vertex_entry->next) {
+
+        for (p_edge_entry = p_vertex_entry->vertex->p_children->head;
+             p_edge_entry;
+             p_edge_entry = p_edge_entry->next) {
+
+            if (addEdge(p_copy,
+                        p_vertex_entry->vertex_id,
+                        p_edge_entry->vertex_id,
+                        p_edge_entry->weight) != RETURN_STATUS_OK) {
+                freeGraph(p_copy);
+                allocator_free(p_copy);
+                return NULL;
+            }
+        }
+    }
+
+    return p_copy;
 }
 
-GraphVertex* addVertex(Graph* p_graph, size_t vertex_id)
+GraphVertex* addVertex(Graph* p_graph, vertex_id_t vertex_id)
 {
-    GraphVertex* p_graph_vertex =
-            graph_vertex_map_get(p_graph->p_nodes, vertex_id);
+    GraphVertex* p_graph_vertex;
+
+    if (p_graph->p_compressed)
+    {
+        return NULL;
+    }
+
+    p_graph_vertex = graph_vertex_map_get(p_graph->p_nodes, vertex_id);
 
     if (p_graph_vertex)
     {
         return p_graph_vertex;
     }
 
-    p_graph_vertex = malloc(sizeof(GraphVertex));
+    p_graph_vertex = arena_malloc(p_graph->p_arena, sizeof(GraphVertex));
 
-    initGraphVertex(p_graph_vertex, vertex_id);
+    if (!p_graph_vertex ||
+        initGraphVertex(p_graph_vertex,
+                        vertex_id,
+                        p_graph->p_arena) != RETURN_STATUS_OK)
+    {
+        return NULL;
+    }
 
     if (graph_vertex_map_put(p_graph->p_nodes,
                              vertex_id,
@@ -93,22 +193,23 @@ GraphVertex* addVertex(Graph* p_graph, size_t vertex_id)
         return NULL;
     }
 
+    ++p_graph->mod_count;
     return p_graph_vertex;
 }
 
-void removeVertex(Graph* p_graph, size_t vertex_id)
+void removeVertex(Graph* p_graph, vertex_id_t vertex_id)
 {
     GraphVertex* p_graph_vertex;
     GraphVertex* p_child_vertex;
     GraphVertex* p_parent_vertex;
 
-    size_t child_vertex_id;
-    size_t parent_vertex_id;
+    vertex_id_t child_vertex_id;
+    vertex_id_t parent_vertex_id;
 
     weight_map_iterator* p_child_iterator;
     weight_map_iterator* p_parent_iterator;
 
-    double weight;
+    weight_t weight;
 
     p_graph_vertex = graph_vertex_map_get(p_graph->p_nodes, vertex_id);
 
@@ -159,16 +260,23 @@ void removeVertex(Graph* p_graph, size_t vertex_id)
 
     /* Free the children/parents maps: */
     freeGraphVertex(p_graph_vertex);
+    arena_release(p_graph->p_arena, p_graph_vertex, sizeof(GraphVertex));
+    ++p_graph->mod_count;
 }
 
-int hasVertex(Graph* p_graph, size_t vertex_id)
+int hasVertex(Graph* p_graph, vertex_id_t vertex_id)
 {
+    if (p_graph->p_compressed) {
+        return compressed_graph_find(p_graph->p_compressed, vertex_id) !=
+               COMPRESSED_GRAPH_NO_VERTEX;
+    }
+
     return graph_vertex_map_contains_key(
             p_graph->p_nodes,
             vertex_id);
 }
 
-GraphVertex* getVertex(Graph* p_graph, size_t vertex_id)
+GraphVertex* getVertex(Graph* p_graph, vertex_id_t vertex_id)
 {
     GraphVertex* p_graph_vertex =
             graph_vertex_map_get(p_graph->p_nodes,
@@ -178,14 +286,18 @@ GraphVertex* getVertex(Graph* p_graph, size_t vertex_id)
 }
 
 int addEdge(Graph* p_graph,
-            size_t tail_vertex_id,
-            size_t head_vertex_id,
-            double weight)
+            vertex_id_t tail_vertex_id,
+            vertex_id_t head_vertex_id,
+            weight_t weight)
 {
     GraphVertex* p_head_vertex;
     GraphVertex* p_tail_vertex;
     GraphVertex* p_temp_vertex;
 
+    if (p_graph->p_compressed) {
+        return RETURN_STATUS_READ_ONLY_GRAPH;
+    }
+
     if (hasEdge(p_graph, tail_vertex_id, head_vertex_id)) {
         /* Update weight: */
         p_temp_vertex =
@@ -195,6 +307,15 @@ int addEdge(Graph* p_graph,
         weight_map_put(p_temp_vertex->p_children,
                        head_vertex_id,
                        weight);
+
+        /* The backward search reads the weight from the head vertex: */
+        p_temp_vertex =
+                graph_vertex_map_get(p_graph->p_nodes,
+                                     head_vertex_id);
+
+        weight_map_put(p_temp_vertex->p_parents,
+                       tail_vertex_id,
+                       weight);
         return RETURN_STATUS_OK;
     }
 
@@ -222,12 +343,13 @@ int addEdge(Graph* p_graph,
         return RETURN_STATUS_NO_MEMORY;
     }
 
+    ++p_graph->mod_count;
     return RETURN_STATUS_OK;
 }
 
 void removeEdge(Graph* p_graph,
-                size_t tail_vertex_id,
-                size_t head_vertex_id)
+                vertex_id_t tail_vertex_id,
+                vertex_id_t head_vertex_id)
 {
     GraphVertex* p_tail_vertex;
     GraphVertex* p_head_vertex;
@@ -241,14 +363,31 @@ void removeEdge(Graph* p_graph,
 
     weight_map_remove(p_head_vertex->p_parents,  tail_vertex_id);
     weight_map_remove(p_tail_vertex->p_children, head_vertex_id);
+    ++p_graph->mod_count;
 }
 
 int hasEdge(Graph* p_graph,
-            size_t tail_vertex_id,
-            size_t head_vertex_id)
+            vertex_id_t tail_vertex_id,
+            vertex_id_t head_vertex_id)
 {
-    GraphVertex* p_graph_vertex =
-            graph_vertex_map_get(p_graph->p_nodes, tail_vertex_id);
+    GraphVertex* p_graph_vertex;
+    graph_edge_cursor cursor;
+    vertex_id_t vertex_id;
+    weight_t weight;
+
+    if (p_graph->p_compressed) {
+        graph_children_cursor(p_graph, tail_vertex_id, &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &vertex_id, &weight)) {
+            if (vertex_id == head_vertex_id) {
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    p_graph_vertex = graph_vertex_map_get(p_graph->p_nodes, tail_vertex_id);
 
     if (!p_graph_vertex) {
         return 0;
@@ -258,13 +397,29 @@ int hasEdge(Graph* p_graph,
                                    head_vertex_id);
 }
 
-double getEdgeWeight(
+weight_t getEdgeWeight(
         Graph* p_graph,
-        size_t tail_vertex_id,
-        size_t head_vertex_id)
+        vertex_id_t tail_vertex_id,
+        vertex_id_t head_vertex_id)
 {
-    GraphVertex* p_graph_vertex =
-            graph_vertex_map_get(p_graph->p_nodes, tail_vertex_id);
+    GraphVertex* p_graph_vertex;
+    graph_edge_cursor cursor;
+    vertex_id_t vertex_id;
+    weight_t weight;
+
+    if (p_graph->p_compressed) {
+        graph_children_cursor(p_graph, tail_vertex_id, &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &vertex_id, &weight)) {
+            if (vertex_id == head_vertex_id) {
+                return weight;
+            }
+        }
+
+        abort();
+    }
+
+    p_graph_vertex = graph_vertex_map_get(p_graph->p_nodes, tail_vertex_id);
 
     if (!p_graph_vertex) {
         abort();
@@ -272,4 +427,288 @@ double getEdgeWeight(
 
     return weight_map_get(p_graph_vertex->p_children,
                           head_vertex_id);
+}
+
+/*******************************************************************************
+* Replaces the hash map adjacency of 'p_graph' with the read-only compressed  *
+* adjacency. After this, the graph may be queried but not modified.           *
+*******************************************************************************/
+int compressGraph(Graph* p_graph)
+{
+    compressed_graph* p_compressed;
+    scc_index* p_scc_index;
+
+    if (!p_graph) {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    if (p_graph->p_compressed) {
+        return RETURN_STATUS_OK;
+    }
+
+    p_compressed = compressed_graph_alloc(p_graph);
+
+    if (!p_compressed) {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    /* The topology does not change, so the index stays valid: */
+    p_scc_index = p_graph->p_scc_index;
+    p_graph->p_scc_index = NULL;
+    freeGraph(p_graph);
+    p_graph->p_compressed = p_compressed;
+    p_graph->p_scc_index = p_scc_index;
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* (Re)computes the strongly connected components of 'p_graph'. Searches use   *
+* them to reject unreachable targets before expanding a single vertex, until  *
+* the next change to the vertices or the edges makes the index stale.         *
+*******************************************************************************/
+int graph_build_scc_index(Graph* p_graph)
+{
+    scc_index* p_scc_index;
+
+    if (!p_graph) {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    p_scc_index = scc_index_alloc(p_graph);
+
+    if (!p_scc_index) {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    scc_index_free(p_graph->p_scc_index);
+    p_graph->p_scc_index = p_scc_index;
+    return RETURN_STATUS_OK;
+}
+
+static void add_weight_map_memory(graph_memory* p_memory, weight_map* p_map)
+{
+    size_t table = sizeof(weight_map_entry*) * p_map->table_capacity;
+
+    p_memory->adjacency_tables += table;
+    p_memory->adjacency_entries += weight_map_memory_usage(p_map) - table;
+
+    if (p_map->table_capacity > p_map->size) {
+        p_memory->adjacency_slack += sizeof(weight_map_entry*) *
+                                     (p_map->table_capacity - p_map->size);
+    }
+}
+
+/*******************************************************************************
+* Returns the bytes held by 'p_graph' and, if 'p_memory' is not NULL, breaks  *
+* them down by structure. Takes time linear in the number of vertices.        *
+*******************************************************************************/
+size_t graph_memory_usage(Graph* p_graph, graph_memory* p_memory)
+{
+    graph_memory memory;
+    graph_vertex_map_entry* p_entry;
+
+    if (!p_memory) {
+        p_memory = &memory;
+    }
+
+    memset(p_memory, 0, sizeof(*p_memory));
+    p_memory->total = sizeof(*p_graph);
+
+    if (p_graph->p_nodes) {
+        p_memory->vertex_map = graph_vertex_map_memory_usage(p_graph->p_nodes);
+
+        for (p_entry = p_graph->p_nodes->head;
+             p_entry;
+             p_entry = p_entry->next) {
+            p_memory->vertices += sizeof(GraphVertex);
+            add_weight_map_memory(p_memory, p_entry->vertex->p_children);
+            add_weight_map_memory(p_memory, p_entry->vertex->p_parents);
+        }
+    }
+
+    if (p_graph->p_arena) {
+        p_memory->arena_reserved = sizeof(arena) +
+                                   p_graph->p_arena->bytes_reserved;
+        p_memory->total += p_memory->arena_reserved;
+    }
+
+    if (p_graph->p_compressed) {
+        p_memory->compressed =
+                compressed_graph_memory_usage(p_graph->p_compressed);
+        p_memory->total += p_memory->compressed;
+        p_memory->shared = p_graph->p_compressed->mapping_size;
+    }
+
+    if (p_graph->p_scc_index) {
+        p_memory->scc_index = scc_index_memory_usage(p_graph->p_scc_index);
+        p_memory->total += p_memory->scc_index;
+    }
+
+    return p_memory->total;
+}
+
+/*******************************************************************************
+* Returns the component index of 'p_graph', or NULL if there is none or it no *
+* longer matches the graph.                                                   *
+*******************************************************************************/
+scc_index* graph_scc_index(Graph* p_graph)
+{
+    if (!p_graph->p_scc_index ||
+        p_graph->p_scc_index->mod_count != p_graph->mod_count) {
+        return NULL;
+    }
+
+    return p_graph->p_scc_index;
+}
+
+/*******************************************************************************
+* Looks up the stable ID of the edge (tail, head). Edge IDs are defined only  *
+* for compressed graphs, where they index the edge in the weight stream.      *
+*******************************************************************************/
+int graph_edge_id(Graph* p_graph,
+                  vertex_id_t tail_vertex_id,
+                  vertex_id_t head_vertex_id,
+                  size_t* p_edge_id)
+{
+    size_t tail_index;
+
+    if (!p_graph) {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    if (!p_graph->p_compressed) {
+        return RETURN_STATUS_NO_EDGE;
+    }
+
+    tail_index = compressed_graph_find(p_graph->p_compressed, tail_vertex_id);
+
+    if (tail_index == COMPRESSED_GRAPH_NO_VERTEX) {
+        return RETURN_STATUS_NO_EDGE;
+    }
+
+    *p_edge_id = compressed_graph_edge_id(p_graph->p_compressed,
+                                          tail_index,
+                                          head_vertex_id);
+
+    return *p_edge_id == COMPRESSED_GRAPH_NO_EDGE ?
+           RETURN_STATUS_NO_EDGE :
+           RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Sets the weight of each edge 'edge_ids[i]' to 'weights[i]' in both the      *
+* forward and the backward adjacency, without touching the topology, while    *
+* queries may run. Each weight is written with a relaxed atomic store and     *
+* read with a relaxed atomic load, so a query never sees a torn weight; that  *
+* is all it guarantees. The two copies of an edge are stored one after the    *
+* other, so a running query may see the new weight in its forward search and  *
+* the old one in its backward search, and any mix of old and new weights      *
+* across the batch; its path is then shortest under neither. Publish a new    *
+* version through versioned_graph when queries need one consistent set of     *
+* weights. Stops at the first unknown ID.                                     *
+*                                                                             *
+* Only compressed graphs have edge IDs and take updates. For any other graph  *
+* this returns RETURN_STATUS_NO_EDGE, like graph_edge_id(), and changes       *
+* nothing; change the weights of such a graph with addEdge().                 *
+*******************************************************************************/
+int graph_update_weights(Graph* p_graph,
+                         const size_t* edge_ids,
+                         const weight_t* weights,
+                         size_t count)
+{
+    size_t i;
+
+    if (!p_graph) {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    if (!p_graph->p_compressed) {
+        return RETURN_STATUS_NO_EDGE;
+    }
+
+    /* The pages of a graph image are mapped read-only: */
+    if (p_graph->p_compressed->p_mapping) {
+        return RETURN_STATUS_READ_ONLY_GRAPH;
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (!compressed_graph_update_weight(p_graph->p_compressed,
+                                            edge_ids[i],
+                                            weights[i])) {
+            return RETURN_STATUS_NO_EDGE;
+        }
+    }
+
+    return RETURN_STATUS_OK;
+}
+
+static void graph_cursor(Graph* p_graph,
+                         vertex_id_t vertex_id,
+                         graph_edge_cursor* p_cursor,
+                         int children)
+{
+    GraphVertex* p_graph_vertex;
+    size_t vertex_index;
+
+    p_cursor->p_entry = NULL;
+    p_cursor->compressed.remaining = 0;
+
+    if (p_graph->p_compressed) {
+        vertex_index = compressed_graph_find(p_graph->p_compressed,
+                                             vertex_id);
+
+        if (vertex_index == COMPRESSED_GRAPH_NO_VERTEX) {
+            return;
+        }
+
+        if (children) {
+            compressed_graph_children(p_graph->p_compressed,
+                                      vertex_index,
+                                      &p_cursor->compressed);
+        } else {
+            compressed_graph_parents(p_graph->p_compressed,
+                                     vertex_index,
+                                     &p_cursor->compressed);
+        }
+
+        return;
+    }
+
+    p_graph_vertex = graph_vertex_map_get(p_graph->p_nodes, vertex_id);
+
+    if (p_graph_vertex) {
+        p_cursor->p_entry = children ?
+                            p_graph_vertex->p_children->head :
+                            p_graph_vertex->p_parents->head;
+    }
+}
+
+void graph_children_cursor(Graph* p_graph,
+                           vertex_id_t vertex_id,
+                           graph_edge_cursor* p_cursor)
+{
+    graph_cursor(p_graph, vertex_id, p_cursor, TRUE);
+}
+
+void graph_parents_cursor(Graph* p_graph,
+                          vertex_id_t vertex_id,
+                          graph_edge_cursor* p_cursor)
+{
+    graph_cursor(p_graph, vertex_id, p_cursor, FALSE);
+}
+
+int graph_edge_cursor_next(graph_edge_cursor* p_cursor,
+                           vertex_id_t* p_vertex_id,
+                           weight_t* p_weight)
+{
+    if (p_cursor->p_entry) {
+        *p_vertex_id = p_cursor->p_entry->vertex_id;
+        *p_weight = p_cursor->p_entry->weight;
+        p_cursor->p_entry = p_cursor->p_entry->next;
+        return TRUE;
+    }
+
+    return compressed_graph_cursor_next(&p_cursor->compressed,
+                                        p_vertex_id,
+                                        p_weight);
 }
\ No newline at end of file
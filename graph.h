@@ -1,12 +1,14 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_H
 #define COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_H
 
+#include "arena.h"
+#include "compressed_graph.h"
 #include "graph_vertex_map.h"
 #include "weight_map.h"
 #include <stdlib.h>
 
 typedef struct GraphVertex {
-    size_t id;
+    vertex_id_t id;
     weight_map* p_children; /* Maps a child to the edge weight. */
     weight_map* p_parents;  /* Maps a parent to the edge weight. */
 } GraphVertex;
@@ -14,37 +16,109 @@ typedef struct GraphVertex {
 typedef struct Graph {
     /* Maps each node ID to a vertex: */
     struct graph_vertex_map* p_nodes;
+
+    /* Owns the vertices, their weight maps and the vertex map: */
+    arena* p_arena;
+
+    /* Read-only adjacency; replaces 'p_nodes' after compressGraph(): */
+    struct compressed_graph* p_compressed;
+
+    /* Bumped by every change to the vertices or the edges (not weights): */
+    size_t mod_count;
+
+    /* Built by graph_build_scc_index(); stale once 'mod_count' moves on: */
+    struct scc_index* p_scc_index;
 } Graph;
 
-int initGraphVertex(GraphVertex* p_graph_vertex, size_t id);
+/*******************************************************************************
+* The bytes a graph holds, by structure. The hash map figures count the       *
+* tables and the entries in use; the arena holds them all, so the arena       *
+* figure minus their sum is the slack of its blocks and size classes.         *
+* 'adjacency_slack' is the part of 'adjacency_tables' that has more bucket    *
+* slots than its map has entries, which is mostly empty buckets. A graph      *
+* mapped from an image counts the image in 'shared', not in 'total'.          *
+*******************************************************************************/
+typedef struct graph_memory {
+    size_t vertex_map;
+    size_t vertices;          /* The GraphVertex structs. */
+    size_t adjacency_tables;  /* Bucket arrays of the weight maps. */
+    size_t adjacency_entries; /* Weight map headers and entries. */
+    size_t adjacency_slack;
+    size_t arena_reserved;
+    size_t compressed;
+    size_t scc_index;
+    size_t shared;            /* Mapped image pages, shared by processes. */
+    size_t total;
+} graph_memory;
+
+/* Iterates over the children or the parents of a vertex: */
+typedef struct graph_edge_cursor {
+    weight_map_entry*       p_entry;
+    compressed_graph_cursor compressed;
+} graph_edge_cursor;
+
+int initGraphVertex(GraphVertex* p_graph_vertex,
+                    vertex_id_t id,
+                    arena* p_arena);
 void freeGraphVertex(GraphVertex* p_graph_vertex);
 
 Graph* allocGraph();
 
 int initGraph(Graph* p_graph);
 void freeGraph(Graph* p_graph);
+Graph* cloneGraph(Graph* p_graph);
 
-GraphVertex* addVertex (Graph* p_graph, size_t vertex_id);
-void removeVertex      (Graph* p_graph, size_t vertex_id);
-int hasVertex          (Graph* p_graph, size_t vertex_id);
-GraphVertex* getVertex (Graph* p_graph, size_t vertex_id);
+GraphVertex* addVertex (Graph* p_graph, vertex_id_t vertex_id);
+void removeVertex      (Graph* p_graph, vertex_id_t vertex_id);
+int hasVertex          (Graph* p_graph, vertex_id_t vertex_id);
+GraphVertex* getVertex (Graph* p_graph, vertex_id_t vertex_id);
 
 int addEdge(
         Graph* p_graph,
-        size_t tail_vertex_id,
-        size_t head_vertex_id,
-        double weight);
+        vertex_id_t tail_vertex_id,
+        vertex_id_t head_vertex_id,
+        weight_t weight);
 
 void removeEdge(Graph* graph,
-                size_t tail_vertex_id,
-                size_t head_vertex_id);
+                vertex_id_t tail_vertex_id,
+                vertex_id_t head_vertex_id);
 
 int hasEdge(Graph* p_graph,
-            size_t tail_vertex_id,
-            size_t head_vertex_id);
+            vertex_id_t tail_vertex_id,
+            vertex_id_t head_vertex_id);
+
+weight_t getEdgeWeight(Graph* p_graph,
+                       vertex_id_t tail_vertex_id,
+                       vertex_id_t head_vertex_id);
+
+int compressGraph(Graph* p_graph);
+
+int graph_build_scc_index(Graph* p_graph);
+
+struct scc_index* graph_scc_index(Graph* p_graph);
+
+size_t graph_memory_usage(Graph* p_graph, graph_memory* p_memory);
+
+int graph_edge_id(Graph* p_graph,
+                  vertex_id_t tail_vertex_id,
+                  vertex_id_t head_vertex_id,
+                  size_t* p_edge_id);
+
+int graph_update_weights(Graph* p_graph,
+                         const size_t* edge_ids,
+                         const weight_t* weights,
+                         size_t count);
+
+void graph_children_cursor(Graph* p_graph,
+                           vertex_id_t vertex_id,
+                           graph_edge_cursor* p_cursor);
+
+void graph_parents_cursor(Graph* p_graph,
+                          vertex_id_t vertex_id,
+                          graph_edge_cursor* p_cursor);
 
-double getEdgeWeight(Graph* p_graph,
-                     size_t tail_vertex_id,
-                     size_t head_vertex_id);
+int graph_edge_cursor_next(graph_edge_cursor* p_cursor,
+                           vertex_id_t* p_vertex_id,
+                           weight_t* p_weight);
 
 #endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_H */
\ No newline at end of file
@@ -0,0 +1,879 @@
+#include "graph_generator.h"
+#include "allocator.h"
+#include "graph.h"
+#include "util.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UNKNOWN_ARC_COUNT ((size_t) -1)
+
+/* The largest R-MAT scale whose vertex IDs fit in every vertex_id_t: */
+#define MAXIMUM_RMAT_SCALE 31
+
+typedef struct generator_parameters {
+    size_t        vertex_count;
+    size_t        arc_count;
+    size_t        width;
+    size_t        height;
+    size_t        scale;
+    double        probability;
+    double        radius;
+    double        a;
+    double        b;
+    double        c;
+    double        max_weight;
+    unsigned long seed;
+} generator_parameters;
+
+typedef int (*emit_function)(const generator_parameters* p_parameters,
+                             graph_generator_sink* p_sink);
+
+/*******************************************************************************
+* Marsaglia's xorshift on 32 bits, which 'unsigned long' always holds.        *
+*******************************************************************************/
+unsigned long graph_generator_random(unsigned long* p_state)
+{
+    unsigned long x = *p_state & 0xffffffffUL;
+
+    if (x == 0)
+    {
+        x = 0x9e3779b9UL;
+    }
+
+    x ^= (x << 13) & 0xffffffffUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xffffffffUL;
+    *p_state = x;
+    return x;
+}
+
+double graph_generator_uniform_real(unsigned long* p_state)
+{
+    return (double) graph_generator_random(p_state) / 4294967296.0;
+}
+
+/*******************************************************************************
+* Scrambles the seed so that nearby seeds do not give correlated streams.     *
+*******************************************************************************/
+static unsigned long initial_state(unsigned long seed)
+{
+    unsigned long x = (seed ^ 0x5bd1e995UL) & 0xffffffffUL;
+
+    x = ((x ^ (x >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+    x = ((x ^ (x >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+    x ^= x >> 16;
+    return x ? x : 1;
+}
+
+static weight_t random_weight(unsigned long* p_state, double max_weight)
+{
+    return (weight_t)(1.0 + graph_generator_uniform_real(p_state) *
+                            (max_weight - 1.0));
+}
+
+static int emit_vertex(graph_generator_sink* p_sink,
+                       vertex_id_t vertex_id,
+                       double x,
+                       double y)
+{
+    return p_sink->vertex ?
+           p_sink->vertex(p_sink->p_context, vertex_id, x, y) :
+           RETURN_STATUS_OK;
+}
+
+static int emit_arc(graph_generator_sink* p_sink,
+                    vertex_id_t tail_vertex_id,
+                    vertex_id_t head_vertex_id,
+                    weight_t weight)
+{
+    return p_sink->arc ?
+           p_sink->arc(p_sink->p_context,
+                       tail_vertex_id,
+                       head_vertex_id,
+                       weight) :
+           RETURN_STATUS_OK;
+}
+
+static int emit_plain_vertices(size_t vertex_count,
+                               graph_generator_sink* p_sink)
+{
+    size_t i;
+    int return_status;
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        return_status = emit_vertex(p_sink, (vertex_id_t) i, 0.0, 0.0);
+
+        if (return_status != RETURN_STATUS_OK)
+        {
+            return return_status;
+        }
+    }
+
+    return RETURN_STATUS_OK;
+}
+
+static int count_arc(void* p_context,
+                     vertex_id_t tail_vertex_id,
+                     vertex_id_t head_vertex_id,
+                     weight_t weight)
+{
+    ++*(size_t*) p_context;
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Runs 'emit' into 'p_sink'. If the sink wants the counts up front and they   *
+* are not known, a first run into a counting sink finds them; the generators  *
+* are deterministic, so both runs produce the same arcs.                      *
+*******************************************************************************/
+static int generate(emit_function emit,
+                    const generator_parameters* p_parameters,
+                    size_t arc_count,
+                    graph_generator_sink* p_sink)
+{
+    graph_generator_sink counting_sink;
+    int return_status;
+
+    if (p_sink->begin)
+    {
+        if (arc_count == UNKNOWN_ARC_COUNT)
+        {
+            arc_count = 0;
+            counting_sink.begin = NULL;
+            counting_sink.vertex = NULL;
+            counting_sink.arc = count_arc;
+            counting_sink.p_context = &arc_count;
+            return_status = emit(p_parameters, &counting_sink);
+
+            if (return_status != RETURN_STATUS_OK)
+            {
+                return return_status;
+            }
+        }
+
+        return_status = p_sink->begin(p_sink->p_context,
+                                      p_parameters->vertex_count,
+                                      arc_count);
+
+        if (return_status != RETURN_STATUS_OK)
+        {
+            return return_status;
+        }
+    }
+
+    return emit(p_parameters, p_sink);
+}
+
+/*******************************************************************************
+* Places the grid vertices with some jitter, so that the lengths of the links *
+* vary the way the lengths of road segments do.                               *
+*******************************************************************************/
+static int emit_grid(const generator_parameters* p_parameters,
+                     graph_generator_sink* p_sink)
+{
+    size_t width = p_parameters->width;
+    size_t height = p_parameters->height;
+    size_t i;
+    size_t x;
+    size_t y;
+    size_t neighbour;
+    size_t direction;
+    unsigned long state = initial_state(p_parameters->seed);
+    double* coordinates;
+    double dx;
+    double dy;
+    weight_t weight;
+    int return_status = RETURN_STATUS_OK;
+
+    coordinates = allocator_malloc(sizeof(double) * 2 * width * height);
+
+    if (!coordinates)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < width * height; ++i)
+    {
+        coordinates[2 * i] = (double)(i % width) +
+                             0.6 * graph_generator_uniform_real(&state) - 0.3;
+        coordinates[2 * i + 1] = (double)(i / width) +
+                                 0.6 * graph_generator_uniform_real(&state) -
+                                 0.3;
+
+        return_status = emit_vertex(p_sink,
+                                    (vertex_id_t) i,
+                                    coordinates[2 * i],
+                                    coordinates[2 * i + 1]);
+
+        if (return_status != RETURN_STATUS_OK)
+        {
+            allocator_free(coordinates);
+            return return_status;
+        }
+    }
+
+    for (y = 0; y < height && return_status == RETURN_STATUS_OK; ++y)
+    {
+        for (x = 0; x < width && return_status == RETURN_STATUS_OK; ++x)
+        {
+            i = y * width + x;
+
+            /* Direction 0 links to the right, direction 1 downwards: */
+            for (direction = 0; direction < 2; ++direction)
+            {
+                if (direction == 0 ? x + 1 == width : y + 1 == height)
+                {
+                    continue;
+                }
+
+                neighbour = direction == 0 ? i + 1 : i + width;
+
+                if (graph_generator_uniform_real(&state) <
+                    p_parameters->probability)
+                {
+                    continue;
+                }
+
+                dx = coordinates[2 * neighbour] - coordinates[2 * i];
+                dy = coordinates[2 * neighbour + 1] - coordinates[2 * i + 1];
+                weight = (weight_t)(sqrt(dx * dx + dy * dy) *
+                                    (1.0 + 0.5 *
+                                     graph_generator_uniform_real(&state)));
+
+                return_status = emit_arc(p_sink,
+                                         (vertex_id_t) i,
+                                         (vertex_id_t) neighbour,
+                                         weight);
+
+                if (return_status != RETURN_STATUS_OK)
+                {
+                    break;
+                }
+
+                return_status = emit_arc(p_sink,
+                                         (vertex_id_t) neighbour,
+                                         (vertex_id_t) i,
+                                         weight);
+
+                if (return_status != RETURN_STATUS_OK)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    allocator_free(coordinates);
+    return return_status;
+}
+
+/*******************************************************************************
+* The R-MAT arcs drawn so far, in an open-addressed table of (tail, head)     *
+* pairs. A free slot has tail NO_ARC, which no vertex ID below 2^31 equals.   *
+*******************************************************************************/
+#define NO_ARC ((size_t) -1)
+
+typedef struct rmat_arc_set {
+    size_t* slots;
+    size_t  mask;
+} rmat_arc_set;
+
+static int rmat_arc_set_init(rmat_arc_set* p_set, size_t arc_count)
+{
+    size_t capacity = 1;
+    size_t i;
+
+    /* Keep the table at most half full: */
+    while (capacity / 2 < arc_count)
+    {
+        if (capacity > ((size_t) -1) / (4 * sizeof(size_t)))
+        {
+            return RETURN_STATUS_NO_MEMORY;
+        }
+
+        capacity <<= 1;
+    }
+
+    p_set->slots = allocator_malloc(sizeof(size_t) * 2 * capacity);
+
+    if (!p_set->slots)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < capacity; ++i)
+    {
+        p_set->slots[2 * i] = NO_ARC;
+    }
+
+    p_set->mask = capacity - 1;
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Adds the arc unless it is already there. Returns TRUE if it was new.        *
+*******************************************************************************/
+static int rmat_arc_set_add(rmat_arc_set* p_set, size_t tail, size_t head)
+{
+    unsigned long x = ((unsigned long) tail * 0x9e3779b1UL) ^ head;
+    size_t i;
+
+    /* Mix the high bits down; the mask keeps only the low ones: */
+    x &= 0xffffffffUL;
+    x = ((x ^ (x >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+    x ^= x >> 16;
+    i = (size_t) x & p_set->mask;
+
+    while (p_set->slots[2 * i] != NO_ARC)
+    {
+        if (p_set->slots[2 * i] == tail && p_set->slots[2 * i + 1] == head)
+        {
+            return FALSE;
+        }
+
+        i = (i + 1) & p_set->mask;
+    }
+
+    p_set->slots[2 * i] = tail;
+    p_set->slots[2 * i + 1] = head;
+    return TRUE;
+}
+
+/*******************************************************************************
+* Draws 'arc_count' arcs and emits the distinct ones that are not self-loops; *
+* a graph holds one arc per pair, so the skewed quadrants would otherwise     *
+* declare arcs that loading collapses. The count comes from a counting run.   *
+*******************************************************************************/
+static int emit_rmat(const generator_parameters* p_parameters,
+                     graph_generator_sink* p_sink)
+{
+    size_t i;
+    size_t level;
+    size_t tail;
+    size_t head;
+    size_t bit;
+    unsigned long state = initial_state(p_parameters->seed);
+    double r;
+    weight_t weight;
+    rmat_arc_set arcs;
+    int return_status;
+
+    return_status = rmat_arc_set_init(&arcs, p_parameters->arc_count);
+
+    if (return_status != RETURN_STATUS_OK)
+    {
+        return return_status;
+    }
+
+    return_status = emit_plain_vertices(p_parameters->vertex_count, p_sink);
+
+    for (i = 0;
+         i < p_parameters->arc_count && return_status == RETURN_STATUS_OK;
+         ++i)
+    {
+        tail = 0;
+        head = 0;
+
+        /* Descend one quadrant of the adjacency matrix per level: */
+        for (level = 0; level < p_parameters->scale; ++level)
+        {
+            bit = (size_t) 1 << level;
+            r = graph_generator_uniform_real(&state);
+
+            if (r < p_parameters->a)
+            {
+                continue;
+            }
+
+            if (r < p_parameters->a + p_parameters->b)
+            {
+                head |= bit;
+            }
+            else if (r < p_parameters->a + p_parameters->b + p_parameters->c)
+            {
+                tail |= bit;
+            }
+            else
+            {
+                tail |= bit;
+                head |= bit;
+            }
+        }
+
+        /* Draw the weight either way, so that the stream stays the same: */
+        weight = random_weight(&state, p_parameters->max_weight);
+
+        if (tail == head || !rmat_arc_set_add(&arcs, tail, head))
+        {
+            continue;
+        }
+
+        return_status = emit_arc(p_sink,
+                                 (vertex_id_t) tail,
+                                 (vertex_id_t) head,
+                                 weight);
+    }
+
+    allocator_free(arcs.slots);
+    return return_status;
+}
+
+/*******************************************************************************
+* Buckets the points into square cells no narrower than the radius, so that   *
+* only the points in the 3 x 3 cells around a point need to be compared.      *
+*******************************************************************************/
+static int emit_geometric(const generator_parameters* p_parameters,
+                          graph_generator_sink* p_sink)
+{
+    size_t vertex_count = p_parameters->vertex_count;
+    size_t cells_per_side;
+    size_t cell_count;
+    size_t* cell_offsets;
+    size_t* cell_points;
+    size_t* cells;
+    size_t i;
+    size_t j;
+    size_t k;
+    size_t cell_x;
+    size_t cell_y;
+    size_t x;
+    size_t y;
+    unsigned long state = initial_state(p_parameters->seed);
+    double radius = p_parameters->radius;
+    double* coordinates;
+    double dx;
+    double dy;
+    double distance;
+    int return_status = RETURN_STATUS_OK;
+
+    cells_per_side = (size_t)(1.0 / radius);
+
+    /* More cells than points would only cost memory: */
+    while (cells_per_side > 1 &&
+           cells_per_side * cells_per_side > vertex_count)
+    {
+        cells_per_side /= 2;
+    }
+
+    if (cells_per_side == 0)
+    {
+        cells_per_side = 1;
+    }
+
+    cell_count = cells_per_side * cells_per_side;
+    coordinates = allocator_malloc(sizeof(double) * 2 * vertex_count);
+    cell_offsets = allocator_calloc(cell_count + 1, sizeof(size_t));
+    cell_points = allocator_malloc(sizeof(size_t) * vertex_count);
+    cells = allocator_malloc(sizeof(size_t) * vertex_count);
+
+    if (!coordinates || !cell_offsets || !cell_points || !cells)
+    {
+        allocator_free(coordinates);
+        allocator_free(cell_offsets);
+        allocator_free(cell_points);
+        allocator_free(cells);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        coordinates[2 * i] = graph_generator_uniform_real(&state);
+        coordinates[2 * i + 1] = graph_generator_uniform_real(&state);
+        cells[i] = (size_t)(coordinates[2 * i + 1] * cells_per_side) *
+                   cells_per_side +
+                   (size_t)(coordinates[2 * i] * cells_per_side);
+        ++cell_offsets[cells[i]];
+
+        if (return_status == RETURN_STATUS_OK)
+        {
+            return_status = emit_vertex(p_sink,
+                                        (vertex_id_t) i,
+                                        coordinates[2 * i],
+                                        coordinates[2 * i + 1]);
+        }
+    }
+
+    /* Turn the counts into the ends of the cells... */
+    for (i = 1; i < cell_count; ++i)
+    {
+        cell_offsets[i] += cell_offsets[i - 1];
+    }
+
+    cell_offsets[cell_count] = vertex_count;
+
+    /* ...and fill the cells back to front, which leaves their starts: */
+    for (i = vertex_count; i > 0; --i)
+    {
+        cell_points[--cell_offsets[cells[i - 1]]] = i - 1;
+    }
+
+    for (i = 0; i < vertex_count && return_status == RETURN_STATUS_OK; ++i)
+    {
+        cell_x = cells[i] % cells_per_side;
+        cell_y = cells[i] / cells_per_side;
+
+        for (y = cell_y > 0 ? cell_y - 1 : 0;
+             y <= cell_y + 1 && y < cells_per_side;
+             ++y)
+        {
+            for (x = cell_x > 0 ? cell_x - 1 : 0;
+                 x <= cell_x + 1 && x < cells_per_side;
+                 ++x)
+            {
+                for (k = cell_offsets[y * cells_per_side + x];
+                     k < cell_offsets[y * cells_per_side + x + 1] &&
+                     return_status == RETURN_STATUS_OK;
+                     ++k)
+                {
+                    j = cell_points[k];
+                    dx = coordinates[2 * j] - coordinates[2 * i];
+                    dy = coordinates[2 * j + 1] - coordinates[2 * i + 1];
+                    distance = sqrt(dx * dx + dy * dy);
+
+                    if (j != i && distance <= radius)
+                    {
+                        return_status = emit_arc(p_sink,
+                                                 (vertex_id_t) i,
+                                                 (vertex_id_t) j,
+                                                 (weight_t) distance);
+                    }
+                }
+            }
+        }
+    }
+
+    allocator_free(coordinates);
+    allocator_free(cell_offsets);
+    allocator_free(cell_points);
+    allocator_free(cells);
+    return return_status;
+}
+
+/*******************************************************************************
+* Skips over the absent arcs of each row with geometrically distributed gaps, *
+* which takes time linear in the arcs produced rather than in n^2.            *
+*******************************************************************************/
+static int emit_erdos_renyi(const generator_parameters* p_parameters,
+                            graph_generator_sink* p_sink)
+{
+    size_t vertex_count = p_parameters->vertex_count;
+    size_t tail;
+    size_t head;
+    unsigned long state = initial_state(p_parameters->seed);
+    double column;
+    double log_absent;
+    int return_status;
+
+    return_status = emit_plain_vertices(vertex_count, p_sink);
+
+    if (p_parameters->probability <= 0.0 || vertex_count < 2)
+    {
+        return return_status;
+    }
+
+    log_absent = log(1.0 - p_parameters->probability);
+
+    for (tail = 0;
+         tail < vertex_count && return_status == RETURN_STATUS_OK;
+         ++tail)
+    {
+        column = -1.0;
+
+        for (;;)
+        {
+            column += 1.0;
+
+            if (p_parameters->probability < 1.0)
+            {
+                column += floor(log(1.0 -
+                                    graph_generator_uniform_real(&state)) /
+                                log_absent);
+            }
+
+            if (column >= (double)(vertex_count - 1))
+            {
+                break;
+            }
+
+            /* Column 'k' of row 'tail' is the k-th vertex other than it: */
+            head = (size_t) column;
+            head += head >= tail ? 1 : 0;
+
+            return_status = emit_arc(p_sink,
+                                     (vertex_id_t) tail,
+                                     (vertex_id_t) head,
+                                     random_weight(&state,
+                                                   p_parameters->max_weight));
+
+            if (return_status != RETURN_STATUS_OK)
+            {
+                break;
+            }
+        }
+    }
+
+    return return_status;
+}
+
+static int emit_uniform(const generator_parameters* p_parameters,
+                        graph_generator_sink* p_sink)
+{
+    size_t vertex_count = p_parameters->vertex_count;
+    size_t tail;
+    size_t head;
+    size_t i;
+    unsigned long state = initial_state(p_parameters->seed);
+    int return_status;
+
+    return_status = emit_plain_vertices(vertex_count, p_sink);
+
+    for (i = 0;
+         i < p_parameters->arc_count && return_status == RETURN_STATUS_OK;
+         ++i)
+    {
+        tail = graph_generator_random(&state) % vertex_count;
+        head = graph_generator_random(&state) % vertex_count;
+        return_status = emit_arc(p_sink,
+                                 (vertex_id_t) tail,
+                                 (vertex_id_t) head,
+                                 random_weight(&state,
+                                               p_parameters->max_weight));
+    }
+
+    return return_status;
+}
+
+static void clear_parameters(generator_parameters* p_parameters,
+                             size_t vertex_count,
+                             unsigned long seed)
+{
+    p_parameters->vertex_count = vertex_count;
+    p_parameters->arc_count = 0;
+    p_parameters->width = 0;
+    p_parameters->height = 0;
+    p_parameters->scale = 0;
+    p_parameters->probability = 0.0;
+    p_parameters->radius = 0.0;
+    p_parameters->a = 0.0;
+    p_parameters->b = 0.0;
+    p_parameters->c = 0.0;
+    p_parameters->max_weight = 1.0;
+    p_parameters->seed = seed;
+}
+
+int graph_generator_grid(size_t width,
+                         size_t height,
+                         double drop_probability,
+                         unsigned long seed,
+                         graph_generator_sink* p_sink)
+{
+    generator_parameters parameters;
+
+    if (width == 0 || height == 0)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    clear_parameters(&parameters, width * height, seed);
+    parameters.width = width;
+    parameters.height = height;
+    parameters.probability = drop_probability;
+    return generate(emit_grid, &parameters, UNKNOWN_ARC_COUNT, p_sink);
+}
+
+int graph_generator_rmat(size_t scale,
+                         size_t arc_count,
+                         double a,
+                         double b,
+                         double c,
+                         double max_weight,
+                         unsigned long seed,
+                         graph_generator_sink* p_sink)
+{
+    generator_parameters parameters;
+
+    if (scale == 0 ||
+        scale > MAXIMUM_RMAT_SCALE ||
+        scale >= sizeof(size_t) * 8 ||
+        a < 0.0 || b < 0.0 || c < 0.0 || a + b + c > 1.0)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    clear_parameters(&parameters, (size_t) 1 << scale, seed);
+    parameters.arc_count = arc_count;
+    parameters.scale = scale;
+    parameters.a = a;
+    parameters.b = b;
+    parameters.c = c;
+    parameters.max_weight = max_weight;
+    return generate(emit_rmat, &parameters, UNKNOWN_ARC_COUNT, p_sink);
+}
+
+int graph_generator_geometric(size_t vertex_count,
+                              double radius,
+                              unsigned long seed,
+                              graph_generator_sink* p_sink)
+{
+    generator_parameters parameters;
+
+    if (vertex_count == 0 || radius <= 0.0)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    clear_parameters(&parameters, vertex_count, seed);
+    parameters.radius = radius;
+    return generate(emit_geometric, &parameters, UNKNOWN_ARC_COUNT, p_sink);
+}
+
+int graph_generator_erdos_renyi(size_t vertex_count,
+                                double arc_probability,
+                                double max_weight,
+                                unsigned long seed,
+                                graph_generator_sink* p_sink)
+{
+    generator_parameters parameters;
+
+    if (vertex_count == 0 || arc_probability > 1.0)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    clear_parameters(&parameters, vertex_count, seed);
+    parameters.probability = arc_probability;
+    parameters.max_weight = max_weight;
+    return generate(emit_erdos_renyi,
+                    &parameters,
+                    UNKNOWN_ARC_COUNT,
+                    p_sink);
+}
+
+int graph_generator_uniform(size_t vertex_count,
+                            size_t arc_count,
+                            double max_weight,
+                            unsigned long seed,
+                            graph_generator_sink* p_sink)
+{
+    generator_parameters parameters;
+
+    if (vertex_count == 0)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    clear_parameters(&parameters, vertex_count, seed);
+    parameters.arc_count = arc_count;
+    parameters.max_weight = max_weight;
+    return generate(emit_uniform, &parameters, arc_count, p_sink);
+}
+
+static int graph_vertex(void* p_context,
+                        vertex_id_t vertex_id,
+                        double x,
+                        double y)
+{
+    Graph* p_graph = p_context;
+
+    if (p_graph->p_compressed)
+    {
+        return RETURN_STATUS_READ_ONLY_GRAPH;
+    }
+
+    return addVertex(p_graph, vertex_id) ?
+           RETURN_STATUS_OK :
+           RETURN_STATUS_NO_MEMORY;
+}
+
+static int graph_arc(void* p_context,
+                     vertex_id_t tail_vertex_id,
+                     vertex_id_t head_vertex_id,
+                     weight_t weight)
+{
+    return addEdge(p_context, tail_vertex_id, head_vertex_id, weight);
+}
+
+/*******************************************************************************
+* Makes 'p_sink' add the generated vertices and arcs to 'p_graph'. A repeated *
+* arc keeps the last weight, as addEdge() does.                               *
+*******************************************************************************/
+void graph_generator_graph_sink(Graph* p_graph, graph_generator_sink* p_sink)
+{
+    p_sink->begin = NULL;
+    p_sink->vertex = graph_vertex;
+    p_sink->arc = graph_arc;
+    p_sink->p_context = p_graph;
+}
+
+static int dimacs_begin(void* p_context, size_t vertex_count, size_t arc_count)
+{
+    graph_generator_dimacs* p_dimacs = p_context;
+
+    fprintf(p_dimacs->p_graph_file,
+            "p sp %lu %lu\n",
+            (unsigned long) vertex_count,
+            (unsigned long) arc_count);
+
+    if (p_dimacs->p_coordinate_file)
+    {
+        fprintf(p_dimacs->p_coordinate_file,
+                "p aux sp co %lu\n",
+                (unsigned long) vertex_count);
+    }
+
+    return ferror(p_dimacs->p_graph_file) ?
+           RETURN_STATUS_NO_GRAPH :
+           RETURN_STATUS_OK;
+}
+
+static int dimacs_vertex(void* p_context,
+                         vertex_id_t vertex_id,
+                         double x,
+                         double y)
+{
+    graph_generator_dimacs* p_dimacs = p_context;
+
+    if (!p_dimacs->p_coordinate_file)
+    {
+        return RETURN_STATUS_OK;
+    }
+
+    fprintf(p_dimacs->p_coordinate_file,
+            "v %lu %.9g %.9g\n",
+            (unsigned long) vertex_id + 1,
+            x,
+            y);
+
+    return ferror(p_dimacs->p_coordinate_file) ?
+           RETURN_STATUS_NO_GRAPH :
+           RETURN_STATUS_OK;
+}
+
+static int dimacs_arc(void* p_context,
+                      vertex_id_t tail_vertex_id,
+                      vertex_id_t head_vertex_id,
+                      weight_t weight)
+{
+    graph_generator_dimacs* p_dimacs = p_context;
+
+    fprintf(p_dimacs->p_graph_file,
+            "a %lu %lu %.9g\n",
+            (unsigned long) tail_vertex_id + 1,
+            (unsigned long) head_vertex_id + 1,
+            (double) weight);
+
+    return ferror(p_dimacs->p_graph_file) ?
+           RETURN_STATUS_NO_GRAPH :
+           RETURN_STATUS_OK;
+}
+
+void graph_generator_dimacs_sink(graph_generator_dimacs* p_dimacs,
+                                 graph_generator_sink* p_sink)
+{
+    p_sink->begin = dimacs_begin;
+    p_sink->vertex = dimacs_vertex;
+    p_sink->arc = dimacs_arc;
+    p_sink->p_context = p_dimacs;
+}
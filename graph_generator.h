@@ -0,0 +1,101 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_GENERATOR_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_GENERATOR_H
+
+#include "graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* Receives what a generator produces. 'begin' is called once with the exact   *
+* vertex and arc counts before any vertex or arc, then 'vertex' for each      *
+* vertex 0, 1, ..., n - 1 with its coordinates and 'arc' for each arc. Any    *
+* callback may be NULL. A callback returning anything but RETURN_STATUS_OK    *
+* stops the generator, which returns that status.                             *
+*******************************************************************************/
+typedef struct graph_generator_sink {
+    int (*begin) (void* p_context, size_t vertex_count, size_t arc_count);
+    int (*vertex)(void* p_context, vertex_id_t vertex_id, double x, double y);
+    int (*arc)   (void* p_context,
+                  vertex_id_t tail_vertex_id,
+                  vertex_id_t head_vertex_id,
+                  weight_t weight);
+    void* p_context;
+} graph_generator_sink;
+
+/*******************************************************************************
+* Writes a generated graph as DIMACS. DIMACS numbers vertices from 1, so      *
+* every ID is written plus one. The coordinates go to 'p_coordinate_file' as  *
+* "v <id> <x> <y>" lines unless it is NULL.                                   *
+*******************************************************************************/
+typedef struct graph_generator_dimacs {
+    FILE* p_graph_file;
+    FILE* p_coordinate_file;
+} graph_generator_dimacs;
+
+void graph_generator_graph_sink(Graph* p_graph, graph_generator_sink* p_sink);
+
+void graph_generator_dimacs_sink(graph_generator_dimacs* p_dimacs,
+                                 graph_generator_sink* p_sink);
+
+/*******************************************************************************
+* The generators. All of them are deterministic in 'seed'.                    *
+*                                                                             *
+* grid:      a 'width' x 'height' road-like lattice. Each vertex sits near    *
+*            its lattice point and is joined both ways to its right and lower *
+*            neighbours; each link is left out with 'drop_probability'. The   *
+*            weight is the Euclidean length times a detour factor in [1, 1.5).*
+* rmat:      2^'scale' vertices and 'arc_count' R-MAT draws; 'a', 'b' and     *
+*            'c' are the quadrant probabilities, the fourth is 1 - a - b - c. *
+*            Self-loops and repeated arcs are dropped, so fewer arcs may be   *
+*            emitted; 'begin' gets the number actually emitted. Weights are   *
+*            uniform in [1, 'max_weight'].                                    *
+* geometric: 'vertex_count' points in the unit square joined both ways when   *
+*            they are at most 'radius' apart; the weight is the distance.     *
+* erdos_renyi: G(n, p); each of the n (n - 1) possible arcs is present with   *
+*            'arc_probability'. Weights are uniform in [1, 'max_weight'].     *
+* uniform:   'arc_count' arcs with uniformly random ends and weights in       *
+*            [1, 'max_weight'], like the demo graph.                          *
+*******************************************************************************/
+int graph_generator_grid(size_t width,
+                         size_t height,
+                         double drop_probability,
+                         unsigned long seed,
+                         graph_generator_sink* p_sink);
+
+int graph_generator_rmat(size_t scale,
+                         size_t arc_count,
+                         double a,
+                         double b,
+                         double c,
+                         double max_weight,
+                         unsigned long seed,
+                         graph_generator_sink* p_sink);
+
+int graph_generator_geometric(size_t vertex_count,
+                              double radius,
+                              unsigned long seed,
+                              graph_generator_sink* p_sink);
+
+int graph_generator_erdos_renyi(size_t vertex_count,
+                                double arc_probability,
+                                double max_weight,
+                                unsigned long seed,
+                                graph_generator_sink* p_sink);
+
+int graph_generator_uniform(size_t vertex_count,
+                            size_t arc_count,
+                            double max_weight,
+                            unsigned long seed,
+                            graph_generator_sink* p_sink);
+
+/*******************************************************************************
+* The 32-bit xorshift generator behind the generators, for tools that want    *
+* reproducible random numbers of their own. '*p_state' may start at any       *
+* value.                                                                      *
+*******************************************************************************/
+unsigned long graph_generator_random(unsigned long* p_state);
+
+/* Returns a uniform number in [0, 1): */
+double graph_generator_uniform_real(unsigned long* p_state);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_GENERATOR_H */
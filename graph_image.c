@@ -0,0 +1,528 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "graph_image.h"
+#include "allocator.h"
+#include "compressed_graph.h"
+#include "graph.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define IMAGE_VERSION 1
+
+/* Every section starts at a multiple of this: */
+#define IMAGE_ALIGNMENT 8
+
+/* Reads back as another value on a machine of the other byte order: */
+#define IMAGE_BYTE_ORDER ((size_t) 0x01020304)
+
+static const char IMAGE_MAGIC[8] = "BDGRAPH";
+
+/* The arrays of a compressed graph, in the order they follow the header: */
+enum {
+    SECTION_VERTEX_IDS,
+    SECTION_CHILD_BYTE_OFFSETS,
+    SECTION_CHILD_EDGE_OFFSETS,
+    SECTION_PARENT_BYTE_OFFSETS,
+    SECTION_PARENT_EDGE_OFFSETS,
+    SECTION_CHILD_WEIGHTS,
+    SECTION_PARENT_WEIGHTS,
+    SECTION_CHILD_BYTES,
+    SECTION_PARENT_BYTES,
+    SECTION_COUNT
+};
+
+typedef struct graph_image_header {
+    char   magic[8];
+    size_t version;
+    size_t byte_order;
+    size_t offset_size;    /* sizeof(size_t) of the writer. */
+    size_t vertex_id_size; /* sizeof(vertex_id_t) of the writer. */
+    size_t vertex_count;
+    size_t edge_count;
+    size_t dense;          /* No vertex ID section; IDs are indices. */
+    size_t child_byte_count;
+    size_t parent_byte_count;
+    size_t image_size;
+} graph_image_header;
+
+static size_t align(size_t offset)
+{
+    return (offset + IMAGE_ALIGNMENT - 1) & ~((size_t) IMAGE_ALIGNMENT - 1);
+}
+
+/*******************************************************************************
+* Computes the size and the offset of every section of the image described by *
+* 'p_header' and returns the size of the whole image.                         *
+*******************************************************************************/
+static size_t image_layout(const graph_image_header* p_header,
+                           size_t* sizes,
+                           size_t* offsets)
+{
+    size_t offset_array = sizeof(size_t) * (p_header->vertex_count + 1);
+    size_t weight_array = sizeof(float) * (p_header->edge_count + 1);
+    size_t offset = align(sizeof(*p_header));
+    size_t i;
+
+    sizes[SECTION_VERTEX_IDS] = p_header->dense ?
+                                0 :
+                                sizeof(vertex_id_t) * p_header->vertex_count;
+
+    sizes[SECTION_CHILD_BYTE_OFFSETS] = offset_array;
+    sizes[SECTION_CHILD_EDGE_OFFSETS] = offset_array;
+    sizes[SECTION_PARENT_BYTE_OFFSETS] = offset_array;
+    sizes[SECTION_PARENT_EDGE_OFFSETS] = offset_array;
+    sizes[SECTION_CHILD_WEIGHTS] = weight_array;
+    sizes[SECTION_PARENT_WEIGHTS] = weight_array;
+    sizes[SECTION_CHILD_BYTES] = p_header->child_byte_count + 1;
+    sizes[SECTION_PARENT_BYTES] = p_header->parent_byte_count + 1;
+
+    for (i = 0; i < SECTION_COUNT; ++i)
+    {
+        offsets[i] = offset;
+        offset = align(offset + sizes[i]);
+    }
+
+    return offset;
+}
+
+static void describe_graph(compressed_graph* p_compressed,
+                           graph_image_header* p_header)
+{
+    memset(p_header, 0, sizeof(*p_header));
+    memcpy(p_header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    p_header->version = IMAGE_VERSION;
+    p_header->byte_order = IMAGE_BYTE_ORDER;
+    p_header->offset_size = sizeof(size_t);
+    p_header->vertex_id_size = sizeof(vertex_id_t);
+    p_header->vertex_count = p_compressed->vertex_count;
+    p_header->edge_count = p_compressed->edge_count;
+    p_header->dense = p_compressed->vertex_ids == NULL;
+    p_header->child_byte_count = p_compressed->children.byte_count;
+    p_header->parent_byte_count = p_compressed->parents.byte_count;
+}
+
+static int write_padding(FILE* p_file, size_t count)
+{
+    static const char zeros[IMAGE_ALIGNMENT] = { 0 };
+
+    return fwrite(zeros, 1, count, p_file) == count;
+}
+
+static int write_image(compressed_graph* p_compressed, FILE* p_file)
+{
+    graph_image_header header;
+    const void* sections[SECTION_COUNT];
+    size_t sizes[SECTION_COUNT];
+    size_t offsets[SECTION_COUNT];
+    size_t written;
+    size_t i;
+
+    describe_graph(p_compressed, &header);
+    header.image_size = image_layout(&header, sizes, offsets);
+
+    sections[SECTION_VERTEX_IDS] = p_compressed->vertex_ids;
+    sections[SECTION_CHILD_BYTE_OFFSETS] =
+            p_compressed->children.byte_offsets;
+    sections[SECTION_CHILD_EDGE_OFFSETS] =
+            p_compressed->children.edge_offsets;
+    sections[SECTION_PARENT_BYTE_OFFSETS] =
+            p_compressed->parents.byte_offsets;
+    sections[SECTION_PARENT_EDGE_OFFSETS] =
+            p_compressed->parents.edge_offsets;
+    sections[SECTION_CHILD_WEIGHTS] = p_compressed->children.weights;
+    sections[SECTION_PARENT_WEIGHTS] = p_compressed->parents.weights;
+    sections[SECTION_CHILD_BYTES] = p_compressed->children.bytes;
+    sections[SECTION_PARENT_BYTES] = p_compressed->parents.bytes;
+
+    if (fwrite(&header, sizeof(header), 1, p_file) != 1)
+    {
+        return FALSE;
+    }
+
+    written = sizeof(header);
+
+    for (i = 0; i < SECTION_COUNT; ++i)
+    {
+        if (!write_padding(p_file, offsets[i] - written) ||
+            fwrite(sections[i], 1, sizes[i], p_file) != sizes[i])
+        {
+            return FALSE;
+        }
+
+        written = offsets[i] + sizes[i];
+    }
+
+    return write_padding(p_file, header.image_size - written);
+}
+
+static int replace_file(const char* source_name, const char* target_name)
+{
+#ifdef _WIN32
+    return MoveFileExA(source_name,
+                       target_name,
+                       MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(source_name, target_name) == 0;
+#endif
+}
+
+int graph_image_save(Graph* p_graph, const char* file_name)
+{
+    compressed_graph* p_compressed;
+    char* temporary_name;
+    FILE* p_file;
+    int written;
+
+    if (!p_graph)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    p_compressed = p_graph->p_compressed ?
+                   p_graph->p_compressed :
+                   compressed_graph_alloc(p_graph);
+
+    temporary_name = allocator_malloc(strlen(file_name) + 5);
+
+    if (!p_compressed || !temporary_name)
+    {
+        if (p_compressed != p_graph->p_compressed)
+        {
+            compressed_graph_free(p_compressed);
+        }
+
+        allocator_free(temporary_name);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    strcpy(temporary_name, file_name);
+    strcat(temporary_name, ".tmp");
+    p_file = fopen(temporary_name, "wb");
+    written = p_file && write_image(p_compressed, p_file);
+
+    if (p_file && fclose(p_file) != 0)
+    {
+        written = FALSE;
+    }
+
+    if (written)
+    {
+        written = replace_file(temporary_name, file_name);
+    }
+
+    if (!written && p_file)
+    {
+        remove(temporary_name);
+    }
+
+    if (p_compressed != p_graph->p_compressed)
+    {
+        compressed_graph_free(p_compressed);
+    }
+
+    allocator_free(temporary_name);
+    return written ? RETURN_STATUS_OK : RETURN_STATUS_IO_ERROR;
+}
+
+/*******************************************************************************
+* Maps all of 'file_name' read-only and shared. Returns NULL on failure.      *
+*******************************************************************************/
+#ifdef _WIN32
+static void* map_file(const char* file_name, size_t* p_mapping_size)
+{
+    HANDLE file;
+    HANDLE mapping;
+    LARGE_INTEGER size;
+    void* p_mapping = NULL;
+
+    file = CreateFileA(file_name,
+                       GENERIC_READ,
+                       FILE_SHARE_READ | FILE_SHARE_DELETE,
+                       NULL,
+                       OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        /* The view keeps the mapping and the file open: */
+        if (mapping)
+        {
+            p_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+
+        *p_mapping_size = (size_t) size.QuadPart;
+    }
+
+    CloseHandle(file);
+    return p_mapping;
+}
+
+void graph_image_unmap(void* p_mapping, size_t mapping_size)
+{
+    (void) mapping_size;
+    UnmapViewOfFile(p_mapping);
+}
+#else
+static void* map_file(const char* file_name, size_t* p_mapping_size)
+{
+    struct stat status;
+    void* p_mapping;
+    int file = open(file_name, O_RDONLY);
+
+    if (file < 0)
+    {
+        return NULL;
+    }
+
+    if (fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+        close(file);
+        return NULL;
+    }
+
+    /* The mapping keeps the file open: */
+    *p_mapping_size = (size_t) status.st_size;
+    p_mapping = mmap(NULL, *p_mapping_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    return p_mapping == MAP_FAILED ? NULL : p_mapping;
+}
+
+void graph_image_unmap(void* p_mapping, size_t mapping_size)
+{
+    munmap(p_mapping, mapping_size);
+}
+#endif
+
+/*******************************************************************************
+* Checks that the image was written by a build like this one and fits in the  *
+* 'mapping_size' bytes of the file. Bounds the counts first, so that the      *
+* layout arithmetic cannot overflow.                                          *
+*******************************************************************************/
+static int check_header(const graph_image_header* p_header,
+                        size_t mapping_size,
+                        size_t* sizes,
+                        size_t* offsets)
+{
+    if (mapping_size < sizeof(*p_header) ||
+        memcmp(p_header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 ||
+        p_header->version != IMAGE_VERSION ||
+        p_header->byte_order != IMAGE_BYTE_ORDER ||
+        p_header->offset_size != sizeof(size_t) ||
+        p_header->vertex_id_size != sizeof(vertex_id_t))
+    {
+        return FALSE;
+    }
+
+    if (p_header->vertex_count >= mapping_size / sizeof(size_t) ||
+        p_header->edge_count >= mapping_size / sizeof(float) ||
+        p_header->child_byte_count >= mapping_size ||
+        p_header->parent_byte_count >= mapping_size)
+    {
+        return FALSE;
+    }
+
+    return image_layout(p_header, sizes, offsets) == p_header->image_size &&
+           p_header->image_size <= mapping_size;
+}
+
+static void attach_adjacency(compressed_adjacency* p_adjacency,
+                             unsigned char* p_image,
+                             const size_t* offsets,
+                             int byte_offsets,
+                             int edge_offsets,
+                             int weights,
+                             int bytes,
+                             size_t byte_count)
+{
+    p_adjacency->byte_offsets = (size_t*)(p_image + offsets[byte_offsets]);
+    p_adjacency->edge_offsets = (size_t*)(p_image + offsets[edge_offsets]);
+    p_adjacency->weights = (float*)(p_image + offsets[weights]);
+    p_adjacency->bytes = p_image + offsets[bytes];
+    p_adjacency->byte_count = byte_count;
+}
+
+/*******************************************************************************
+* Checks the offsets of a mapped adjacency before a search follows them: both *
+* arrays start at zero, never decrease and end at the byte and the edge       *
+* counts, and every neighbor of a vertex has at least one byte.               *
+*******************************************************************************/
+static int check_adjacency(const compressed_adjacency* p_adjacency,
+                           size_t vertex_count,
+                           size_t edge_count)
+{
+    const size_t* byte_offsets = p_adjacency->byte_offsets;
+    const size_t* edge_offsets = p_adjacency->edge_offsets;
+    size_t i;
+
+    if (byte_offsets[0] != 0 ||
+        edge_offsets[0] != 0 ||
+        byte_offsets[vertex_count] != p_adjacency->byte_count ||
+        edge_offsets[vertex_count] != edge_count)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        if (byte_offsets[i + 1] < byte_offsets[i] ||
+            edge_offsets[i + 1] < edge_offsets[i] ||
+            edge_offsets[i + 1] - edge_offsets[i] >
+            byte_offsets[i + 1] - byte_offsets[i])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* compressed_graph_find() searches the vertex IDs by bisection: */
+static int check_vertex_ids(const compressed_graph* p_compressed)
+{
+    const vertex_id_t* vertex_ids = p_compressed->vertex_ids;
+    size_t i;
+
+    for (i = 1; vertex_ids && i < p_compressed->vertex_count; ++i)
+    {
+        if (vertex_ids[i - 1] >= vertex_ids[i])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+Graph* graph_image_map(const char* file_name, int* p_return_status)
+{
+    graph_image_header* p_header;
+    compressed_graph* p_compressed;
+    Graph* p_graph;
+    unsigned char* p_image;
+    size_t sizes[SECTION_COUNT];
+    size_t offsets[SECTION_COUNT];
+    size_t mapping_size = 0;
+
+    p_image = map_file(file_name, &mapping_size);
+    p_header = (graph_image_header*) p_image;
+
+    if (!p_image)
+    {
+        if (p_return_status)
+        {
+            *p_return_status = RETURN_STATUS_IO_ERROR;
+        }
+
+        return NULL;
+    }
+
+    if (!check_header(p_header, mapping_size, sizes, offsets))
+    {
+        graph_image_unmap(p_image, mapping_size);
+
+        if (p_return_status)
+        {
+            *p_return_status = RETURN_STATUS_NO_GRAPH;
+        }
+
+        return NULL;
+    }
+
+    p_compressed = allocator_calloc(1, sizeof(*p_compressed));
+    p_graph = allocator_malloc(sizeof(Graph));
+
+    if (!p_compressed || !p_graph)
+    {
+        allocator_free(p_compressed);
+        allocator_free(p_graph);
+        graph_image_unmap(p_image, mapping_size);
+
+        if (p_return_status)
+        {
+            *p_return_status = RETURN_STATUS_NO_MEMORY;
+        }
+
+        return NULL;
+    }
+
+    p_compressed->p_mapping = p_image;
+    p_compressed->mapping_size = mapping_size;
+    p_compressed->vertex_count = p_header->vertex_count;
+    p_compressed->edge_count = p_header->edge_count;
+    p_compressed->vertex_ids =
+            p_header->dense ?
+            NULL :
+            (vertex_id_t*)(p_image + offsets[SECTION_VERTEX_IDS]);
+
+    attach_adjacency(&p_compressed->children,
+                     p_image,
+                     offsets,
+                     SECTION_CHILD_BYTE_OFFSETS,
+                     SECTION_CHILD_EDGE_OFFSETS,
+                     SECTION_CHILD_WEIGHTS,
+                     SECTION_CHILD_BYTES,
+                     p_header->child_byte_count);
+
+    attach_adjacency(&p_compressed->parents,
+                     p_image,
+                     offsets,
+                     SECTION_PARENT_BYTE_OFFSETS,
+                     SECTION_PARENT_EDGE_OFFSETS,
+                     SECTION_PARENT_WEIGHTS,
+                     SECTION_PARENT_BYTES,
+                     p_header->parent_byte_count);
+
+    p_graph->p_nodes = NULL;
+    p_graph->p_arena = NULL;
+    p_graph->p_compressed = p_compressed;
+    p_graph->mod_count = 0;
+    p_graph->p_scc_index = NULL;
+
+    if (!check_vertex_ids(p_compressed) ||
+        !check_adjacency(&p_compressed->children,
+                         p_compressed->vertex_count,
+                         p_compressed->edge_count) ||
+        !check_adjacency(&p_compressed->parents,
+                         p_compressed->vertex_count,
+                         p_compressed->edge_count))
+    {
+        freeGraph(p_graph);
+        allocator_free(p_graph);
+
+        if (p_return_status)
+        {
+            *p_return_status = RETURN_STATUS_NO_GRAPH;
+        }
+
+        return NULL;
+    }
+
+    if (p_return_status)
+    {
+        *p_return_status = RETURN_STATUS_OK;
+    }
+
+    return p_graph;
+}
@@ -0,0 +1,42 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IMAGE_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IMAGE_H
+
+#include "graph.h"
+#include <stdlib.h>
+
+/*******************************************************************************
+* A graph image is the compressed adjacency of a graph laid out flat in a     *
+* file, so that processes map it instead of building the graph. The mapping   *
+* is read-only and shared: however many processes map an image, its pages     *
+* are in memory once, and no process ever writes to them. Each process keeps  *
+* only a small Graph header and its own search state.                         *
+*                                                                             *
+* An image on a tmpfs such as /dev/shm is a named shared memory segment that  *
+* unrelated processes open by its path. The image holds IDs and offsets in    *
+* the native byte order and type sizes, and a process built with other ones   *
+* refuses it.                                                                 *
+*******************************************************************************/
+
+/*******************************************************************************
+* Writes the adjacency of 'p_graph', which need not be compressed, as an      *
+* image to 'file_name'. The image goes to a temporary file that is then       *
+* renamed, so processes that map the old image keep it and later ones get     *
+* the new. Returns RETURN_STATUS_IO_ERROR if the file cannot be written.      *
+*******************************************************************************/
+int graph_image_save(Graph* p_graph, const char* file_name);
+
+/*******************************************************************************
+* Maps the image in 'file_name' and returns a compressed, read-only graph     *
+* over it, or NULL with '*p_return_status' set to RETURN_STATUS_IO_ERROR if   *
+* the file cannot be mapped and to RETURN_STATUS_NO_GRAPH if it is not an     *
+* image of this build or is corrupt: the vertex IDs must be sorted and the    *
+* offsets of both adjacencies must never decrease and stay within the byte    *
+* and the edge counts. Free the graph with freeGraph() and allocator_free()   *
+* as any other; that unmaps the image.                                        *
+* Weight updates return RETURN_STATUS_READ_ONLY_GRAPH.                        *
+*******************************************************************************/
+Graph* graph_image_map(const char* file_name, int* p_return_status);
+
+void graph_image_unmap(void* p_mapping, size_t mapping_size);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IMAGE_H */
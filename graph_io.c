@@ -0,0 +1,236 @@
+#include "graph_io.h"
+#include "allocator.h"
+#include "graph.h"
+#include "graph_vertex_map.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LINE_CAPACITY 256
+
+static Graph* fail(Graph* p_graph, int return_status, int* p_return_status)
+{
+    if (p_graph)
+    {
+        freeGraph(p_graph);
+        allocator_free(p_graph);
+    }
+
+    if (p_return_status)
+    {
+        *p_return_status = return_status;
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Parses the DIMACS graph in 'p_file'. Sets '*p_return_status' to             *
+* RETURN_STATUS_NO_GRAPH if the input is malformed.                           *
+*******************************************************************************/
+Graph* graph_io_read_dimacs(FILE* p_file, int* p_return_status)
+{
+    char line[LINE_CAPACITY];
+    char* p_cursor;
+    char* p_end;
+    unsigned long vertex_count;
+    unsigned long i;
+    unsigned long tail_vertex_id;
+    unsigned long head_vertex_id;
+    double weight;
+    Graph* p_graph = allocator_malloc(sizeof(Graph));
+
+    if (!p_graph)
+    {
+        return fail(NULL, RETURN_STATUS_NO_MEMORY, p_return_status);
+    }
+
+    if (initGraph(p_graph) != RETURN_STATUS_OK)
+    {
+        return fail(p_graph, RETURN_STATUS_NO_MEMORY, p_return_status);
+    }
+
+    while (fgets(line, sizeof(line), p_file))
+    {
+        if (line[0] == 'a')
+        {
+            tail_vertex_id = strtoul(line + 1, &p_end, 10);
+            p_cursor = p_end;
+            head_vertex_id = strtoul(p_cursor, &p_end, 10);
+            p_cursor = p_end;
+            weight = strtod(p_cursor, &p_end);
+
+            if (p_end == p_cursor)
+            {
+                return fail(p_graph, RETURN_STATUS_NO_GRAPH, p_return_status);
+            }
+
+            if (addEdge(p_graph,
+                        (vertex_id_t) tail_vertex_id,
+                        (vertex_id_t) head_vertex_id,
+                        (weight_t) weight) != RETURN_STATUS_OK)
+            {
+                return fail(p_graph, RETURN_STATUS_NO_MEMORY, p_return_status);
+            }
+        }
+        else if (line[0] == 'p')
+        {
+            p_cursor = line + 1;
+
+            while (*p_cursor == ' ' || *p_cursor == '\t')
+            {
+                ++p_cursor;
+            }
+
+            /* Skip the problem type, usually "sp": */
+            while (*p_cursor && *p_cursor != ' ' && *p_cursor != '\t')
+            {
+                ++p_cursor;
+            }
+
+            vertex_count = strtoul(p_cursor, &p_end, 10);
+
+            if (p_end == p_cursor)
+            {
+                return fail(p_graph, RETURN_STATUS_NO_GRAPH, p_return_status);
+            }
+
+            for (i = 1; i <= vertex_count; ++i)
+            {
+                if (!addVertex(p_graph, (vertex_id_t) i))
+                {
+                    return fail(p_graph,
+                                RETURN_STATUS_NO_MEMORY,
+                                p_return_status);
+                }
+            }
+        }
+    }
+
+    if (ferror(p_file))
+    {
+        return fail(p_graph, RETURN_STATUS_NO_GRAPH, p_return_status);
+    }
+
+    if (p_return_status)
+    {
+        *p_return_status = RETURN_STATUS_OK;
+    }
+
+    return p_graph;
+}
+
+Graph* graph_io_load_dimacs(const char* file_name, int* p_return_status)
+{
+    Graph* p_graph;
+    FILE* p_file = fopen(file_name, "r");
+
+    if (!p_file)
+    {
+        return fail(NULL, RETURN_STATUS_NO_GRAPH, p_return_status);
+    }
+
+    p_graph = graph_io_read_dimacs(p_file, p_return_status);
+    fclose(p_file);
+    return p_graph;
+}
+
+static int compare_vertex_ids(const void* p_a, const void* p_b)
+{
+    vertex_id_t a = *(const vertex_id_t*) p_a;
+    vertex_id_t b = *(const vertex_id_t*) p_b;
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* Returns the DIMACS number of 'vertex_id', its rank from 1 in 'vertex_ids': */
+static unsigned long dimacs_number(const vertex_id_t* vertex_ids,
+                                   size_t vertex_count,
+                                   vertex_id_t vertex_id)
+{
+    const vertex_id_t* p_vertex_id = bsearch(&vertex_id,
+                                             vertex_ids,
+                                             vertex_count,
+                                             sizeof(vertex_id_t),
+                                             compare_vertex_ids);
+
+    return (unsigned long)(p_vertex_id - vertex_ids) + 1;
+}
+
+/*******************************************************************************
+* Writes 'p_graph' as DIMACS. Works for both the hash map and the compressed  *
+* representation. DIMACS numbers the vertices 1 to n, so the vertex with the  *
+* k-th smallest ID is written as k; a graph whose IDs are already 1 to n is   *
+* written as it is. Returns RETURN_STATUS_NO_MEMORY if the IDs cannot be      *
+* sorted and RETURN_STATUS_IO_ERROR if the file cannot be written.            *
+*******************************************************************************/
+int graph_io_write_dimacs(Graph* p_graph, FILE* p_file)
+{
+    graph_vertex_map_entry* p_entry;
+    compressed_graph* p_compressed = p_graph->p_compressed;
+    graph_edge_cursor cursor;
+    vertex_id_t* vertex_ids;
+    vertex_id_t head_vertex_id;
+    weight_t weight;
+    size_t vertex_count;
+    size_t edge_count = 0;
+    size_t i;
+
+    vertex_count = p_compressed ? p_compressed->vertex_count :
+                                  p_graph->p_nodes->size;
+    vertex_ids = allocator_malloc(sizeof(vertex_id_t) * (vertex_count + 1));
+
+    if (!vertex_ids)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    if (p_compressed)
+    {
+        edge_count = p_compressed->edge_count;
+
+        for (i = 0; i < vertex_count; ++i)
+        {
+            vertex_ids[i] = p_compressed->vertex_ids ?
+                            p_compressed->vertex_ids[i] :
+                            (vertex_id_t) i;
+        }
+    }
+    else
+    {
+        for (p_entry = p_graph->p_nodes->head, i = 0;
+             p_entry;
+             p_entry = p_entry->next, ++i)
+        {
+            vertex_ids[i] = p_entry->vertex_id;
+            edge_count += p_entry->vertex->p_children->size;
+        }
+
+        qsort(vertex_ids,
+              vertex_count,
+              sizeof(vertex_id_t),
+              compare_vertex_ids);
+    }
+
+    fprintf(p_file,
+            "p sp %lu %lu\n",
+            (unsigned long) vertex_count,
+            (unsigned long) edge_count);
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        graph_children_cursor(p_graph, vertex_ids[i], &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &head_vertex_id, &weight))
+        {
+            fprintf(p_file,
+                    "a %lu %lu %.17g\n",
+                    (unsigned long) i + 1,
+                    dimacs_number(vertex_ids, vertex_count, head_vertex_id),
+                    (double) weight);
+        }
+    }
+
+    allocator_free(vertex_ids);
+    return ferror(p_file) ? RETURN_STATUS_IO_ERROR : RETURN_STATUS_OK;
+}
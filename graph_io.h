@@ -0,0 +1,24 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IO_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IO_H
+
+#include "graph.h"
+#include <stdio.h>
+
+/*******************************************************************************
+* Reads and writes graphs in the DIMACS shortest path format:                 *
+*                                                                             *
+*     c <comment>                                                             *
+*     p sp <vertex count> <arc count>                                         *
+*     a <tail> <head> <weight>                                                *
+*                                                                             *
+* Vertex IDs are kept as they appear in the file; the 'p' line adds the       *
+* vertices 1, 2, ..., n so that isolated vertices are not lost. Writing       *
+* renumbers the vertices 1 to n in the order of their IDs.                    *
+*******************************************************************************/
+Graph* graph_io_read_dimacs(FILE* p_file, int* p_return_status);
+
+Graph* graph_io_load_dimacs(const char* file_name, int* p_return_status);
+
+int graph_io_write_dimacs(Graph* p_graph, FILE* p_file);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_IO_H */
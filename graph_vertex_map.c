@@ -1,12 +1,43 @@
 #include "graph_vertex_map.h"
+#include "allocator.h"
 #include "util.h"
 #include <stdlib.h>
 
+static void* graph_vertex_map_malloc(arena* p_arena, size_t size)
+{
+    return p_arena ? arena_malloc(p_arena, size) : allocator_malloc(size);
+}
+
+static void* graph_vertex_map_calloc(arena* p_arena,
+                                     size_t count,
+                                     size_t size)
+{
+    return p_arena ?
+           arena_calloc(p_arena, count, size) :
+           allocator_calloc(count, size);
+}
+
+static void graph_vertex_map_release(arena* p_arena,
+                                     void* p_memory,
+                                     size_t size)
+{
+    if (p_arena)
+    {
+        arena_release(p_arena, p_memory, size);
+    }
+    else
+    {
+        allocator_free(p_memory);
+    }
+}
+
 graph_vertex_map_entry*
-graph_vertex_map_entry_alloc(size_t vertex_id,
+graph_vertex_map_entry_alloc(arena* p_arena,
+                             vertex_id_t vertex_id,
                              struct GraphVertex* vertex)
 {
-    graph_vertex_map_entry* entry = malloc(sizeof(*entry));
+    graph_vertex_map_entry* entry =
+            graph_vertex_map_malloc(p_arena, sizeof(*entry));
 
     if (!entry)
     {
@@ -63,9 +94,10 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 }
 
 graph_vertex_map* graph_vertex_map_alloc(size_t initial_capacity,
-                                         float load_factor)
+                                         float load_factor,
+                                         arena* p_arena)
 {
-    graph_vertex_map* map = malloc(sizeof(*map));
+    graph_vertex_map* map = graph_vertex_map_malloc(p_arena, sizeof(*map));
 
     if (!map)
     {
@@ -80,8 +112,10 @@ graph_vertex_map* graph_vertex_map_alloc(size_t initial_capacity,
     map->size = 0;
     map->head = NULL;
     map->tail = NULL;
-    map->table = calloc(initial_capacity,
-                        sizeof(graph_vertex_map_entry*));
+    map->p_arena = p_arena;
+    map->table = graph_vertex_map_calloc(p_arena,
+                                         initial_capacity,
+                                         sizeof(graph_vertex_map_entry*));
 
     map->mask = initial_capacity - 1;
     map->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -104,8 +138,9 @@ static int ensure_capacity(graph_vertex_map* map)
 
     new_capacity = 2 * map->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity,
-                       sizeof(graph_vertex_map_entry*));
+    new_table = graph_vertex_map_calloc(map->p_arena,
+                                        new_capacity,
+                                        sizeof(graph_vertex_map_entry*));
 
     if (!new_table)
     {
@@ -120,7 +155,10 @@ static int ensure_capacity(graph_vertex_map* map)
         new_table[index] = entry;
     }
 
-    free(map->table);
+    graph_vertex_map_release(map->p_arena,
+                             map->table,
+                             map->table_capacity *
+                             sizeof(graph_vertex_map_entry*));
 
     map->table = new_table;
     map->table_capacity = new_capacity;
@@ -131,7 +169,7 @@ static int ensure_capacity(graph_vertex_map* map)
 }
 
 int graph_vertex_map_put(graph_vertex_map* map,
-                         size_t vertex_id,
+                         vertex_id_t vertex_id,
                          struct GraphVertex* vertex)
 {
     size_t index;
@@ -162,7 +200,7 @@ int graph_vertex_map_put(graph_vertex_map* map,
     /* Recompute the index since it is possibly changed by
        'ensure_capacity' */
     index = hash_value & map->mask;
-    entry = graph_vertex_map_entry_alloc(vertex_id, vertex);
+    entry = graph_vertex_map_entry_alloc(map->p_arena, vertex_id, vertex);
 
     if (!entry) {
         return RETURN_STATUS_NO_MEMORY;
@@ -188,7 +226,7 @@ int graph_vertex_map_put(graph_vertex_map* map,
     return RETURN_STATUS_OK;
 }
 
-int graph_vertex_map_contains_key(graph_vertex_map* map, size_t vertex_id)
+int graph_vertex_map_contains_key(graph_vertex_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     graph_vertex_map_entry* entry;
@@ -212,7 +250,7 @@ int graph_vertex_map_contains_key(graph_vertex_map* map, size_t vertex_id)
 }
 
 struct GraphVertex* graph_vertex_map_get(graph_vertex_map* map,
-                                  size_t vertex_id)
+                                  vertex_id_t vertex_id)
 {
     size_t index;
     graph_vertex_map_entry* p_entry;
@@ -236,7 +274,7 @@ struct GraphVertex* graph_vertex_map_get(graph_vertex_map* map,
 }
 
 void graph_vertex_map_remove(graph_vertex_map* map,
-                             size_t vertex_id)
+                             vertex_id_t vertex_id)
 {
     size_t index;
     graph_vertex_map_entry* prev_entry;
@@ -287,7 +325,9 @@ void graph_vertex_map_remove(graph_vertex_map* map,
             }
 
             map->size--;
-            free(current_entry);
+            graph_vertex_map_release(map->p_arena,
+                                     current_entry,
+                                     sizeof(*current_entry));
             return;
         }
 
@@ -295,7 +335,7 @@ void graph_vertex_map_remove(graph_vertex_map* map,
     }
 }
 
-static void graph_vertex_map_clear(graph_vertex_map* map)
+void graph_vertex_map_clear(graph_vertex_map* map)
 {
     graph_vertex_map_entry* entry;
     graph_vertex_map_entry* next_entry;
@@ -312,7 +352,7 @@ static void graph_vertex_map_clear(graph_vertex_map* map)
     {
         index = entry->vertex_id & map->mask;
         next_entry = entry->next;
-        free(entry);
+        graph_vertex_map_release(map->p_arena, entry, sizeof(*entry));
         entry = next_entry;
         map->table[index] = NULL;
     }
@@ -322,6 +362,13 @@ static void graph_vertex_map_clear(graph_vertex_map* map)
     map->tail = NULL;
 }
 
+size_t graph_vertex_map_memory_usage(graph_vertex_map* map)
+{
+    return sizeof(*map) +
+           sizeof(graph_vertex_map_entry*) * map->table_capacity +
+           sizeof(graph_vertex_map_entry) * map->size;
+}
+
 void graph_vertex_map_free(graph_vertex_map* map)
 {
     if (!map)
@@ -330,8 +377,12 @@ void graph_vertex_map_free(graph_vertex_map* map)
     }
 
     graph_vertex_map_clear(map);
-    free(map->table);
-    free(map);
+    graph_vertex_map_release(map->p_arena,
+                             map->table,
+                             map->table_capacity *
+                             sizeof(graph_vertex_map_entry*));
+
+    graph_vertex_map_release(map->p_arena, map, sizeof(*map));
 }
 
 /******************************************************************************
@@ -340,7 +391,7 @@ Graph vertex map iterator facilities:
 graph_vertex_map_iterator*
 graph_vertex_map_iterator_alloc(graph_vertex_map* map)
 {
-    graph_vertex_map_iterator* p_ret = malloc(sizeof(*p_ret));
+    graph_vertex_map_iterator* p_ret = allocator_malloc(sizeof(*p_ret));
 
     if (!p_ret)
     {
@@ -359,7 +410,7 @@ int graph_vertex_map_iterator_has_next(
 
 void graph_vertex_map_iterator_next(
         graph_vertex_map_iterator* iterator,
-        size_t* vertex_id_pointer,
+        vertex_id_t* vertex_id_pointer,
         struct GraphVertex** vertex_pointer)
 {
     *vertex_id_pointer = iterator->next_entry->vertex_id;
@@ -1,11 +1,13 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_VERTEX_MAP_H
 #define	COM_GITHUB_CODERODDE_BIDIR_SEARCH_GRAPH_VERTEX_MAP_H
 
+#include "arena.h"
 #include "graph.h"
+#include "util.h"
 #include <stdlib.h>
 
 typedef struct graph_vertex_map_entry {
-    size_t                         vertex_id;
+    vertex_id_t                    vertex_id;
     struct GraphVertex*            vertex;
     struct graph_vertex_map_entry* chain_next;
     struct graph_vertex_map_entry* prev;
@@ -21,6 +23,7 @@ typedef struct graph_vertex_map {
     size_t                   max_allowed_size;
     size_t                   mask;
     float                    load_factor;
+    arena*                   p_arena; /* NULL if the map uses malloc. */
 } graph_vertex_map;
 
 typedef struct graph_vertex_map_iterator {
@@ -29,18 +32,23 @@ typedef struct graph_vertex_map_iterator {
 
 graph_vertex_map* graph_vertex_map_alloc(
         size_t initial_capacity,
-        float load_factor);
+        float load_factor,
+        arena* p_arena);
 
 int graph_vertex_map_put(graph_vertex_map* map,
-                         size_t vertex_id,
+                         vertex_id_t vertex_id,
                          struct GraphVertex* vertex);
 
-int graph_vertex_map_contains_key(graph_vertex_map* map, size_t vertex_id);
+int graph_vertex_map_contains_key(graph_vertex_map* map, vertex_id_t vertex_id);
 
 struct GraphVertex* graph_vertex_map_get(graph_vertex_map * map,
-                                         size_t vertex_id);
+                                         vertex_id_t vertex_id);
 
-void graph_vertex_map_remove(graph_vertex_map* map, size_t vertex_id);
+void graph_vertex_map_remove(graph_vertex_map* map, vertex_id_t vertex_id);
+
+size_t graph_vertex_map_memory_usage(graph_vertex_map* map);
+
+void graph_vertex_map_clear(graph_vertex_map* map);
 
 void graph_vertex_map_free(graph_vertex_map* map);
 
@@ -55,7 +63,7 @@ int graph_vertex_map_iterator_has_next
 
 void graph_vertex_map_iterator_next(
         graph_vertex_map_iterator* iterator,
-        size_t* key_pointer,
+        vertex_id_t* key_pointer,
         struct GraphVertex** value_pointer);
 
 void graph_vertex_map_iterator_remove(graph_vertex_map_iterator* iterator);
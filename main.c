@@ -47,8 +47,8 @@ static size_t intrand() {
 double get_path_length(vertex_list* path,
                        Graph* graph) {
     size_t i;
-    size_t vertex_id_1;
-    size_t vertex_id_2;
+    vertex_id_t vertex_id_1;
+    vertex_id_t vertex_id_2;
     double length = 0.0;
 
     for (i = 0; i < vertex_list_size(path) - 1; ++i) {
@@ -71,12 +71,13 @@ void buildGraph() {
     size_t id2;
     size_t edge;
     double weight;
-    size_t source_vertex_id = 0;
-    size_t target_vertex_id = 0;
+    vertex_id_t source_vertex_id = 0;
+    vertex_id_t target_vertex_id = 0;
     clock_t milliseconds_a;
     clock_t milliseconds_b;
     vertex_list* path;
     vertex_list* path_2;
+    vertex_list* path_3;
     int rs = -1;
     unsigned random_seed;
     initGraph(p_graph);
@@ -148,10 +149,34 @@ void buildGraph() {
 
     printf("Result status: %d\n", rs);
 
-    printf("Algorithms agree: %d\n", paths_are_equal(path, path_2));
+    printf("Algorithms agree: %d\n\n", paths_are_equal(path, path_2));
+    puts("--- Bidirectional Dijkstra on the compressed graph:");
+
+    milliseconds_a = milliseconds();
+    compressGraph(p_graph);
+    milliseconds_b = milliseconds();
+
+    printf("Compressed the graph in %ld milliseconds.\n",
+           (milliseconds_b - milliseconds_a));
+
+    milliseconds_a = milliseconds();
+    path_3 = find_shortest_path(p_graph,
+                                source_vertex_id,
+                                target_vertex_id,
+                                &rs);
+
+    milliseconds_b = milliseconds();
+
+    printf("Path length: %f\n", get_path_length(path_3, p_graph));
+    printf("Duration: %ld milliseconds.\n",
+           (milliseconds_b - milliseconds_a));
+
+    printf("Result status: %d\n", rs);
+    printf("Algorithms agree: %d\n", paths_are_equal(path, path_3));
 
     vertex_list_free(path);
     vertex_list_free(path_2);
+    vertex_list_free(path_3);
 
     freeGraph(p_graph);
     return p_graph;
@@ -0,0 +1,33 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "monotonic_clock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+double monotonic_clock_seconds(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+}
+#else
+#include <time.h>
+
+double monotonic_clock_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+#endif
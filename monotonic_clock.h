@@ -0,0 +1,11 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_MONOTONIC_CLOCK_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_MONOTONIC_CLOCK_H
+
+/*******************************************************************************
+* Returns the seconds elapsed since an arbitrary fixed point in the past. The *
+* clock never jumps with changes to the wall clock time, so differences of    *
+* two readings are safe to use for timeouts and timings.                      *
+*******************************************************************************/
+double monotonic_clock_seconds(void);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_MONOTONIC_CLOCK_H */
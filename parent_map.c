@@ -1,12 +1,13 @@
 #include "parent_map.h"
+#include "allocator.h"
 #include "util.h"
 #include <stdlib.h>
 
 static parent_map_entry*
-parent_map_entry_alloc(size_t vertex_id,
-                       size_t predecessor_vertex_id)
+parent_map_entry_alloc(vertex_id_t vertex_id,
+                       vertex_id_t predecessor_vertex_id)
 {
-    parent_map_entry* entry = malloc(sizeof(*entry));
+    parent_map_entry* entry = allocator_malloc(sizeof(*entry));
 
     if (!entry)
     {
@@ -58,7 +59,7 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 parent_map* parent_map_alloc(size_t initial_capacity,
                              float load_factor)
 {
-    parent_map* map = malloc(sizeof(*map));
+    parent_map* map = allocator_malloc(sizeof(*map));
 
     if (!map)
     {
@@ -73,7 +74,7 @@ parent_map* parent_map_alloc(size_t initial_capacity,
     map->size = 0;
     map->head = NULL;
     map->tail = NULL;
-    map->table = calloc(initial_capacity, sizeof(parent_map_entry*));
+    map->table = allocator_calloc(initial_capacity, sizeof(parent_map_entry*));
 
     map->mask = initial_capacity - 1;
     map->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -96,7 +97,7 @@ static int ensure_capacity(parent_map* map)
 
     new_capacity = 2 * map->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(parent_map_entry*));
+    new_table = allocator_calloc(new_capacity, sizeof(parent_map_entry*));
 
     if (!new_table)
     {
@@ -111,7 +112,7 @@ static int ensure_capacity(parent_map* map)
         new_table[index] = entry;
     }
 
-    free(map->table);
+    allocator_free(map->table);
 
     map->table = new_table;
     map->table_capacity = new_capacity;
@@ -123,8 +124,8 @@ static int ensure_capacity(parent_map* map)
 
 int parent_map_put(
         parent_map* map,
-        size_t vertex_id,
-        size_t predecessor_vertex_id)
+        vertex_id_t vertex_id,
+        vertex_id_t predecessor_vertex_id)
 {
     size_t index;
     size_t hash_value;
@@ -179,7 +180,30 @@ int parent_map_put(
     return RETURN_STATUS_OK;
 }
 
-size_t parent_map_get(parent_map* map, size_t vertex_id)
+int parent_map_contains_vertex_id(parent_map* map, vertex_id_t vertex_id)
+{
+    size_t index;
+    parent_map_entry* entry;
+
+    if (!map)
+    {
+        return 0;
+    }
+
+    index = vertex_id & map->mask;
+
+    for (entry = map->table[index]; entry; entry = entry->chain_next)
+    {
+        if (vertex_id == entry->vertex_id)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+vertex_id_t parent_map_get(parent_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     parent_map_entry* p_entry;
@@ -203,7 +227,14 @@ size_t parent_map_get(parent_map* map, size_t vertex_id)
     return 0; /* Compiler, shut up! */
 }
 
-static void parent_map_clear(parent_map* map)
+size_t parent_map_memory_usage(parent_map* map)
+{
+    return sizeof(*map) +
+           sizeof(parent_map_entry*) * map->table_capacity +
+           sizeof(parent_map_entry) * map->size;
+}
+
+void parent_map_clear(parent_map* map)
 {
     parent_map_entry* entry;
     parent_map_entry* next_entry;
@@ -220,7 +251,7 @@ static void parent_map_clear(parent_map* map)
     {
         index = entry->vertex_id & map->mask;
         next_entry = entry->next;
-        free(entry);
+        allocator_free(entry);
         entry = next_entry;
         map->table[index] = NULL;
     }
@@ -238,6 +269,6 @@ void parent_map_free(parent_map* map)
     }
 
     parent_map_clear(map);
-    free(map->table);
-    free(map);
+    allocator_free(map->table);
+    allocator_free(map);
 }
\ No newline at end of file
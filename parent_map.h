@@ -1,11 +1,12 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_PARENT_MAP_H
 #define	COM_GITHUB_CODERODDE_BIDIR_SEARCH_PARENT_MAP_H
 
+#include "util.h"
 #include <stdlib.h>
 
 typedef struct parent_map_entry {
-    size_t vertex_id;
-    size_t predecessor_vertex_id;
+    vertex_id_t vertex_id;
+    vertex_id_t predecessor_vertex_id;
     struct parent_map_entry* chain_next;
     struct parent_map_entry* prev;
     struct parent_map_entry* next;
@@ -26,10 +27,16 @@ parent_map* parent_map_alloc(size_t initial_capacity,
                              float load_factor);
 
 int parent_map_put(parent_map* map,
-                   size_t vertex_id,
-                   size_t predecessor_vertex_id);
+                   vertex_id_t vertex_id,
+                   vertex_id_t predecessor_vertex_id);
 
-size_t parent_map_get(parent_map* map, size_t vertex_id);
+int parent_map_contains_vertex_id(parent_map* map, vertex_id_t vertex_id);
+
+vertex_id_t parent_map_get(parent_map* map, vertex_id_t vertex_id);
+
+size_t parent_map_memory_usage(parent_map* map);
+
+void parent_map_clear(parent_map* map);
 
 void parent_map_free(parent_map* map);
 
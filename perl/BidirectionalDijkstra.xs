@@ -0,0 +1,694 @@
+#define PERL_NO_GET_CONTEXT
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+/* perl.h defines these as well; util.h has its own: */
+#undef TRUE
+#undef FALSE
+
+#include "algorithm.h"
+#include "allocator.h"
+#include "graph.h"
+#include "graph_image.h"
+#include "graph_io.h"
+#include "query_batch.h"
+#include "query_executor.h"
+#include "vertex_list.h"
+
+#define MY_CXT_KEY "BidirectionalDijkstra::_guts" XS_VERSION
+
+#ifndef G_LIST
+#define G_LIST G_ARRAY
+#endif
+
+/*******************************************************************************
+* The state of each Perl interpreter: the search containers, kept between     *
+* calls so that a query allocates nothing but its path, and the status of     *
+* the last call.                                                              *
+*******************************************************************************/
+typedef struct my_cxt_t {
+    search_workspace* p_workspace;
+    int               last_status;
+} my_cxt_t;
+
+START_MY_CXT
+
+/* Copies a path straight out of the ring buffer of the list: */
+static SV* path_to_sv(pTHX_ vertex_list* p_path)
+{
+    AV* p_av = newAV();
+    size_t i;
+
+    if (p_path->size > 0)
+    {
+        av_extend(p_av, (SSize_t) p_path->size - 1);
+
+        for (i = 0; i < p_path->size; ++i)
+        {
+            AvARRAY(p_av)[i] = newSVuv(
+                    (UV) p_path->storage[(p_path->head + i) & p_path->mask]);
+        }
+
+        AvFILLp(p_av) = (SSize_t) p_path->size - 1;
+    }
+
+    return newRV_noinc((SV*) p_av);
+}
+
+/*******************************************************************************
+* Runs one query with the workspace of the interpreter. Returns a new         *
+* reference to the array of the path, or NULL if there is none.               *
+*******************************************************************************/
+static SV* search(pTHX_ Graph* p_graph,
+                  vertex_id_t source_vertex_id,
+                  vertex_id_t target_vertex_id,
+                  int unidirectional)
+{
+    dMY_CXT;
+    search_options options;
+    vertex_list* p_path;
+    SV* p_result;
+
+    /* Without a workspace the search allocates its own containers: */
+    if (!MY_CXT.p_workspace)
+    {
+        MY_CXT.p_workspace = search_workspace_alloc();
+    }
+
+    search_options_init(&options);
+    options.p_workspace = MY_CXT.p_workspace;
+
+    p_path = unidirectional ?
+             find_shortest_path_2_ex(p_graph,
+                                     source_vertex_id,
+                                     target_vertex_id,
+                                     &options,
+                                     &MY_CXT.last_status) :
+             find_shortest_path_ex(p_graph,
+                                   source_vertex_id,
+                                   target_vertex_id,
+                                   &options,
+                                   &MY_CXT.last_status);
+
+    if (!p_path)
+    {
+        return NULL;
+    }
+
+    p_result = path_to_sv(aTHX_ p_path);
+    vertex_list_free(p_path);
+    return p_result;
+}
+
+/* An executor and the graph it searches, which it keeps alive: */
+typedef struct bidir_executor {
+    query_executor* p_executor;
+    SV*             p_graph;
+} bidir_executor;
+
+/*******************************************************************************
+* The query_callback of the executor; runs in dispatch() on the thread of the *
+* interpreter. 'p_user_data' is the Perl callback, which gets the path (undef *
+* if none) and the status. A callback that dies is reported as a warning, so  *
+* that the other callbacks of the dispatch still run.                         *
+*******************************************************************************/
+static void call_perl(vertex_list* p_path,
+                      int return_status,
+                      void* p_user_data)
+{
+    dTHX;
+    dSP;
+    SV* p_callback = p_user_data;
+
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+    EXTEND(SP, 2);
+    PUSHs(p_path ? sv_2mortal(path_to_sv(aTHX_ p_path)) : &PL_sv_undef);
+    PUSHs(sv_2mortal(newSViv(return_status)));
+    PUTBACK;
+    call_sv(p_callback, G_DISCARD | G_EVAL);
+
+    if (SvTRUE(ERRSV))
+    {
+        warn("BidirectionalDijkstra::Executor callback died: %" SVf,
+             SVfARG(ERRSV));
+    }
+
+    FREETMPS;
+    LEAVE;
+    SvREFCNT_dec(p_callback);
+
+    if (p_path)
+    {
+        vertex_list_free(p_path);
+    }
+}
+
+/*******************************************************************************
+* Runs the pairs on 'thread_count' workers with query_batch_run(), ordered    *
+* longest first by 'p_costs' if it is an array reference, and appends the     *
+* paths and the statuses to the arrays. The workers have workspaces of their  *
+* own, not the one of the interpreter. Returns FALSE if the batch cannot      *
+* start.                                                                      *
+*******************************************************************************/
+static int run_batch(pTHX_ Graph* p_graph,
+                      AV* p_pairs,
+                      SSize_t pair_count,
+                      int unidirectional,
+                      UV thread_count,
+                      SV* p_costs,
+                      AV* p_paths,
+                      AV* p_statuses)
+{
+    query_batch_item* items;
+    AV* p_cost_av = NULL;
+    SV** p_cost;
+    SSize_t i;
+    int flags = unidirectional ? QUERY_BATCH_UNIDIRECTIONAL : 0;
+
+    if (p_costs && SvROK(p_costs) && SvTYPE(SvRV(p_costs)) == SVt_PVAV)
+    {
+        p_cost_av = (AV*) SvRV(p_costs);
+        flags |= QUERY_BATCH_LONGEST_FIRST;
+    }
+
+    Newxz(items, pair_count + 1, query_batch_item);
+
+    for (i = 0; i < pair_count; ++i)
+    {
+        items[i].source_vertex_id =
+                (vertex_id_t) SvUV(*av_fetch(p_pairs, 2 * i, 0));
+        items[i].target_vertex_id =
+                (vertex_id_t) SvUV(*av_fetch(p_pairs, 2 * i + 1, 0));
+
+        if (p_cost_av && (p_cost = av_fetch(p_cost_av, i, 0)))
+        {
+            items[i].cost = SvNV(*p_cost);
+        }
+    }
+
+    if (query_batch_run(p_graph,
+                        items,
+                        (size_t) pair_count,
+                        (size_t) thread_count,
+                        flags,
+                        NULL) != RETURN_STATUS_OK)
+    {
+        Safefree(items);
+        return FALSE;
+    }
+
+    for (i = 0; i < pair_count; ++i)
+    {
+        if (items[i].p_path)
+        {
+            av_push(p_paths, path_to_sv(aTHX_ items[i].p_path));
+            vertex_list_free(items[i].p_path);
+        }
+        else
+        {
+            av_push(p_paths, newSV(0));
+        }
+
+        av_push(p_statuses, newSViv(items[i].return_status));
+    }
+
+    Safefree(items);
+    return TRUE;
+}
+
+static void set_status(pTHX_ int return_status)
+{
+    dMY_CXT;
+    MY_CXT.last_status = return_status;
+}
+
+MODULE = BidirectionalDijkstra  PACKAGE = BidirectionalDijkstra
+
+PROTOTYPES: DISABLE
+
+BOOT:
+{
+    HV* p_stash = gv_stashpv("BidirectionalDijkstra", GV_ADD);
+    MY_CXT_INIT;
+    MY_CXT.p_workspace = NULL;
+    MY_CXT.last_status = RETURN_STATUS_OK;
+
+    newCONSTSUB(p_stash, "STATUS_OK", newSViv(RETURN_STATUS_OK));
+    newCONSTSUB(p_stash, "STATUS_NO_MEMORY",
+                newSViv(RETURN_STATUS_NO_MEMORY));
+    newCONSTSUB(p_stash, "STATUS_NO_PATH", newSViv(RETURN_STATUS_NO_PATH));
+    newCONSTSUB(p_stash, "STATUS_NO_GRAPH", newSViv(RETURN_STATUS_NO_GRAPH));
+    newCONSTSUB(p_stash, "STATUS_NO_SOURCE_VERTEX",
+                newSViv(RETURN_STATUS_NO_SOURCE_VERTEX));
+    newCONSTSUB(p_stash, "STATUS_NO_TARGET_VERTEX",
+                newSViv(RETURN_STATUS_NO_TARGET_VERTEX));
+    newCONSTSUB(p_stash, "STATUS_READ_ONLY_GRAPH",
+                newSViv(RETURN_STATUS_READ_ONLY_GRAPH));
+    newCONSTSUB(p_stash, "STATUS_NO_EDGE", newSViv(RETURN_STATUS_NO_EDGE));
+    newCONSTSUB(p_stash, "STATUS_CANCELLED", newSViv(RETURN_STATUS_CANCELLED));
+    newCONSTSUB(p_stash, "STATUS_QUEUE_FULL",
+                newSViv(RETURN_STATUS_QUEUE_FULL));
+    newCONSTSUB(p_stash, "STATUS_IO_ERROR", newSViv(RETURN_STATUS_IO_ERROR));
+}
+
+void
+CLONE(...)
+    CODE:
+        MY_CXT_CLONE;
+        /* The new interpreter allocates its own on its first query: */
+        MY_CXT.p_workspace = NULL;
+        MY_CXT.last_status = RETURN_STATUS_OK;
+
+int
+last_status()
+    CODE:
+        dMY_CXT;
+        RETVAL = MY_CXT.last_status;
+    OUTPUT:
+        RETVAL
+
+void
+_free_workspace()
+    CODE:
+        dMY_CXT;
+        search_workspace_free(MY_CXT.p_workspace);
+        MY_CXT.p_workspace = NULL;
+
+MODULE = BidirectionalDijkstra  PACKAGE = BidirectionalDijkstra::Graph
+
+Graph*
+new(class)
+        const char* class
+    CODE:
+        PERL_UNUSED_VAR(class);
+        RETVAL = allocGraph();
+
+        if (!RETVAL)
+        {
+            croak("cannot allocate a graph");
+        }
+    OUTPUT:
+        RETVAL
+
+Graph*
+load_dimacs(class, file_name)
+        const char* class
+        const char* file_name
+    PREINIT:
+        int return_status = RETURN_STATUS_OK;
+    CODE:
+        PERL_UNUSED_VAR(class);
+        RETVAL = graph_io_load_dimacs(file_name, &return_status);
+
+        if (!RETVAL)
+        {
+            croak("cannot load %s (status %d)", file_name, return_status);
+        }
+    OUTPUT:
+        RETVAL
+
+Graph*
+map_image(class, file_name)
+        const char* class
+        const char* file_name
+    PREINIT:
+        int return_status = RETURN_STATUS_OK;
+    CODE:
+        PERL_UNUSED_VAR(class);
+        RETVAL = graph_image_map(file_name, &return_status);
+
+        if (!RETVAL)
+        {
+            croak("cannot map %s (status %d)", file_name, return_status);
+        }
+    OUTPUT:
+        RETVAL
+
+bool
+save_image(p_graph, file_name)
+        Graph* p_graph
+        const char* file_name
+    PREINIT:
+        int return_status;
+    CODE:
+        return_status = graph_image_save(p_graph, file_name);
+        set_status(aTHX_ return_status);
+        RETVAL = return_status == RETURN_STATUS_OK;
+    OUTPUT:
+        RETVAL
+
+void
+DESTROY(p_graph)
+        Graph* p_graph
+    CODE:
+        freeGraph(p_graph);
+        allocator_free(p_graph);
+
+bool
+add_vertex(p_graph, vertex_id)
+        Graph* p_graph
+        vertex_id_t vertex_id
+    CODE:
+        RETVAL = addVertex(p_graph, vertex_id) != NULL;
+        set_status(aTHX_ RETVAL ? RETURN_STATUS_OK :
+                                  p_graph->p_compressed ?
+                                  RETURN_STATUS_READ_ONLY_GRAPH :
+                                  RETURN_STATUS_NO_MEMORY);
+    OUTPUT:
+        RETVAL
+
+bool
+has_vertex(p_graph, vertex_id)
+        Graph* p_graph
+        vertex_id_t vertex_id
+    CODE:
+        RETVAL = hasVertex(p_graph, vertex_id) ? TRUE : FALSE;
+    OUTPUT:
+        RETVAL
+
+bool
+remove_vertex(p_graph, vertex_id)
+        Graph* p_graph
+        vertex_id_t vertex_id
+    CODE:
+        /* removeVertex() leaves a compressed graph as it is: */
+        RETVAL = !p_graph->p_compressed;
+        set_status(aTHX_ RETVAL ? RETURN_STATUS_OK :
+                                  RETURN_STATUS_READ_ONLY_GRAPH);
+
+        if (RETVAL)
+        {
+            removeVertex(p_graph, vertex_id);
+        }
+    OUTPUT:
+        RETVAL
+
+bool
+add_edge(p_graph, tail_vertex_id, head_vertex_id, weight)
+        Graph* p_graph
+        vertex_id_t tail_vertex_id
+        vertex_id_t head_vertex_id
+        weight_t weight
+    PREINIT:
+        int return_status;
+    CODE:
+        return_status = addEdge(p_graph,
+                                tail_vertex_id,
+                                head_vertex_id,
+                                weight);
+        set_status(aTHX_ return_status);
+        RETVAL = return_status == RETURN_STATUS_OK;
+    OUTPUT:
+        RETVAL
+
+bool
+remove_edge(p_graph, tail_vertex_id, head_vertex_id)
+        Graph* p_graph
+        vertex_id_t tail_vertex_id
+        vertex_id_t head_vertex_id
+    CODE:
+        RETVAL = !p_graph->p_compressed;
+        set_status(aTHX_ RETVAL ? RETURN_STATUS_OK :
+                                  RETURN_STATUS_READ_ONLY_GRAPH);
+
+        if (RETVAL)
+        {
+            removeEdge(p_graph, tail_vertex_id, head_vertex_id);
+        }
+    OUTPUT:
+        RETVAL
+
+bool
+has_edge(p_graph, tail_vertex_id, head_vertex_id)
+        Graph* p_graph
+        vertex_id_t tail_vertex_id
+        vertex_id_t head_vertex_id
+    CODE:
+        RETVAL = hasEdge(p_graph, tail_vertex_id, head_vertex_id) ?
+                 TRUE :
+                 FALSE;
+    OUTPUT:
+        RETVAL
+
+SV*
+edge_weight(p_graph, tail_vertex_id, head_vertex_id)
+        Graph* p_graph
+        vertex_id_t tail_vertex_id
+        vertex_id_t head_vertex_id
+    CODE:
+        RETVAL = hasEdge(p_graph, tail_vertex_id, head_vertex_id) ?
+                 newSVnv((NV) getEdgeWeight(p_graph,
+                                            tail_vertex_id,
+                                            head_vertex_id)) :
+                 &PL_sv_undef;
+    OUTPUT:
+        RETVAL
+
+bool
+compress(p_graph)
+        Graph* p_graph
+    PREINIT:
+        int return_status;
+    CODE:
+        return_status = compressGraph(p_graph);
+        set_status(aTHX_ return_status);
+        RETVAL = return_status == RETURN_STATUS_OK;
+    OUTPUT:
+        RETVAL
+
+bool
+build_scc_index(p_graph)
+        Graph* p_graph
+    PREINIT:
+        int return_status;
+    CODE:
+        return_status = graph_build_scc_index(p_graph);
+        set_status(aTHX_ return_status);
+        RETVAL = return_status == RETURN_STATUS_OK;
+    OUTPUT:
+        RETVAL
+
+UV
+memory_usage(p_graph)
+        Graph* p_graph
+    CODE:
+        RETVAL = (UV) graph_memory_usage(p_graph, NULL);
+    OUTPUT:
+        RETVAL
+
+SV*
+find_shortest_path(p_graph, source_vertex_id, target_vertex_id)
+        Graph* p_graph
+        vertex_id_t source_vertex_id
+        vertex_id_t target_vertex_id
+    CODE:
+        RETVAL = search(aTHX_ p_graph,
+                        source_vertex_id,
+                        target_vertex_id,
+                        FALSE);
+
+        if (!RETVAL)
+        {
+            XSRETURN_UNDEF;
+        }
+    OUTPUT:
+        RETVAL
+
+SV*
+find_shortest_path_2(p_graph, source_vertex_id, target_vertex_id)
+        Graph* p_graph
+        vertex_id_t source_vertex_id
+        vertex_id_t target_vertex_id
+    CODE:
+        RETVAL = search(aTHX_ p_graph,
+                        source_vertex_id,
+                        target_vertex_id,
+                        TRUE);
+
+        if (!RETVAL)
+        {
+            XSRETURN_UNDEF;
+        }
+    OUTPUT:
+        RETVAL
+
+void
+find_shortest_paths(p_graph, p_pairs, unidirectional = 0, threads = 1, costs = NULL)
+        Graph* p_graph
+        AV* p_pairs
+        int unidirectional
+        UV threads
+        SV* costs
+    PREINIT:
+        AV* p_paths;
+        AV* p_statuses;
+        SV** p_source;
+        SV** p_target;
+        SV* p_path;
+        SSize_t pair_count;
+        SSize_t i;
+        dMY_CXT;
+    PPCODE:
+        if ((av_len(p_pairs) + 1) % 2 != 0)
+        {
+            croak("find_shortest_paths takes [source, target, ...] pairs");
+        }
+
+        pair_count = (av_len(p_pairs) + 1) / 2;
+        p_paths = newAV();
+        p_statuses = newAV();
+
+        if (pair_count > 0)
+        {
+            av_extend(p_paths, pair_count - 1);
+            av_extend(p_statuses, pair_count - 1);
+        }
+
+        /* Check every pair before any of them runs: */
+        for (i = 0; i < pair_count; ++i)
+        {
+            p_source = av_fetch(p_pairs, 2 * i, 0);
+            p_target = av_fetch(p_pairs, 2 * i + 1, 0);
+
+            if (!p_source || !p_target)
+            {
+                SvREFCNT_dec((SV*) p_paths);
+                SvREFCNT_dec((SV*) p_statuses);
+                croak("find_shortest_paths: pair %ld is incomplete", (long) i);
+            }
+        }
+
+        if (threads > 1 || (costs && SvROK(costs)))
+        {
+            if (!run_batch(aTHX_ p_graph, p_pairs, pair_count, unidirectional,
+                           threads, costs, p_paths, p_statuses))
+            {
+                SvREFCNT_dec((SV*) p_paths);
+                SvREFCNT_dec((SV*) p_statuses);
+                croak("find_shortest_paths: cannot start the batch");
+            }
+        }
+        else
+        {
+            for (i = 0; i < pair_count; ++i)
+            {
+                p_source = av_fetch(p_pairs, 2 * i, 0);
+                p_target = av_fetch(p_pairs, 2 * i + 1, 0);
+                p_path = search(aTHX_ p_graph,
+                                (vertex_id_t) SvUV(*p_source),
+                                (vertex_id_t) SvUV(*p_target),
+                                unidirectional);
+
+                av_push(p_paths, p_path ? p_path : newSV(0));
+                av_push(p_statuses, newSViv(MY_CXT.last_status));
+            }
+        }
+
+        mXPUSHs(newRV_noinc((SV*) p_paths));
+
+        if (GIMME_V == G_LIST)
+        {
+            mXPUSHs(newRV_noinc((SV*) p_statuses));
+        }
+        else
+        {
+            SvREFCNT_dec((SV*) p_statuses);
+        }
+
+MODULE = BidirectionalDijkstra  PACKAGE = BidirectionalDijkstra::Executor
+
+bidir_executor*
+new(class, graph, thread_count = 2, max_pending = 0)
+        const char* class
+        SV* graph
+        UV thread_count
+        UV max_pending
+    PREINIT:
+        Graph* p_graph;
+    CODE:
+        PERL_UNUSED_VAR(class);
+
+        if (!SvROK(graph) ||
+            !sv_derived_from(graph, "BidirectionalDijkstra::Graph"))
+        {
+            croak("graph is not a BidirectionalDijkstra::Graph");
+        }
+
+        p_graph = INT2PTR(Graph*, SvIV(SvRV(graph)));
+        Newx(RETVAL, 1, bidir_executor);
+        RETVAL->p_executor = query_executor_alloc(p_graph,
+                                                  (size_t) thread_count,
+                                                  (size_t) max_pending);
+
+        if (!RETVAL->p_executor)
+        {
+            Safefree(RETVAL);
+            croak("cannot start the executor");
+        }
+
+        RETVAL->p_graph = SvREFCNT_inc_simple_NN(SvRV(graph));
+    OUTPUT:
+        RETVAL
+
+void
+DESTROY(p_executor)
+        bidir_executor* p_executor
+    CODE:
+        /* Runs the callbacks of the queries still pending: */
+        query_executor_free(p_executor->p_executor);
+        SvREFCNT_dec(p_executor->p_graph);
+        Safefree(p_executor);
+
+bool
+submit(p_executor, source_vertex_id, target_vertex_id, callback)
+        bidir_executor* p_executor
+        vertex_id_t source_vertex_id
+        vertex_id_t target_vertex_id
+        SV* callback
+    PREINIT:
+        SV* p_callback;
+        int return_status;
+    CODE:
+        p_callback = newSVsv(callback);
+        return_status = query_submit(p_executor->p_executor,
+                                     source_vertex_id,
+                                     target_vertex_id,
+                                     call_perl,
+                                     p_callback);
+        set_status(aTHX_ return_status);
+
+        if (return_status != RETURN_STATUS_OK)
+        {
+            SvREFCNT_dec(p_callback);
+        }
+
+        RETVAL = return_status == RETURN_STATUS_OK;
+    OUTPUT:
+        RETVAL
+
+int
+fd(p_executor)
+        bidir_executor* p_executor
+    CODE:
+        RETVAL = query_executor_fd(p_executor->p_executor);
+    OUTPUT:
+        RETVAL
+
+UV
+dispatch(p_executor)
+        bidir_executor* p_executor
+    CODE:
+        RETVAL = (UV) query_executor_dispatch(p_executor->p_executor);
+    OUTPUT:
+        RETVAL
+
+UV
+pending(p_executor)
+        bidir_executor* p_executor
+    CODE:
+        RETVAL = (UV) query_executor_pending(p_executor->p_executor);
+    OUTPUT:
+        RETVAL
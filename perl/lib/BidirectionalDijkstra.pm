@@ -0,0 +1,183 @@
+package BidirectionalDijkstra;
+
+use strict;
+use warnings;
+
+our $VERSION = '0.01';
+
+require XSLoader;
+XSLoader::load('BidirectionalDijkstra', $VERSION);
+
+END { _free_workspace() }
+
+package BidirectionalDijkstra::Graph;
+
+# A graph belongs to the interpreter that made it; threads get none:
+sub CLONE_SKIP { 1 }
+
+package BidirectionalDijkstra::Executor;
+
+sub CLONE_SKIP { 1 }
+
+1;
+
+__END__
+
+=head1 NAME
+
+BidirectionalDijkstra - shortest paths with bidirectional Dijkstra
+
+=head1 SYNOPSIS
+
+    use BidirectionalDijkstra;
+
+    my $graph = BidirectionalDijkstra::Graph->new;
+    $graph->add_vertex($_) for 1 .. 3;
+    $graph->add_edge(1, 2, 1.5);
+    $graph->add_edge(2, 3, 2.0);
+
+    my $path = $graph->find_shortest_path(1, 3);   # [1, 2, 3]
+
+    unless (defined $graph->find_shortest_path(3, 1)) {
+        print "no path\n"
+            if BidirectionalDijkstra::last_status()
+               == BidirectionalDijkstra::STATUS_NO_PATH;
+    }
+
+    # Many queries in one call: a flat list of source/target pairs.
+    my ($paths, $statuses) = $graph->find_shortest_paths([1, 3, 2, 3]);
+
+=head1 DESCRIPTION
+
+A binding of the C library in the parent directory. Build the library and
+the module with
+
+    perl Makefile.PL && make
+
+which runs C<make libbidir.a> at the top level first. Set C<COMPACT=1> in
+the environment for the 32-bit build, and run C<make clean> at the top level
+when switching.
+
+Each interpreter keeps one set of search containers alive across calls, so
+a query allocates only its path. Paths come back as array references of
+vertex IDs, from source to target.
+
+=head1 FUNCTIONS
+
+=over 4
+
+=item BidirectionalDijkstra::last_status()
+
+The status of the last call that reports one; compare with the
+C<BidirectionalDijkstra::STATUS_*> constants.
+
+=back
+
+=head1 GRAPH METHODS
+
+=over 4
+
+=item new, load_dimacs($file)
+
+Class methods making an empty graph or reading a DIMACS file.
+
+=item map_image($file), save_image($file)
+
+C<save_image> writes the graph as an image, a flat file that
+C<map_image> maps read-only as a compressed graph instead of building it.
+Every process mapping the same image shares its pages, so a preforking
+server should map the image once before forking, or in each worker; the
+pages never diverge because no process writes to them. An image under
+F</dev/shm> lives in shared memory only. Saving replaces the file
+atomically, so workers pick up a new image by mapping it again.
+
+=item add_vertex, has_vertex, remove_vertex
+
+=item add_edge($tail, $head, $weight), has_edge, remove_edge, edge_weight
+
+C<add_vertex>, C<remove_vertex>, C<add_edge> and C<remove_edge> return
+false and set the status if they fail; on a compressed or mapped graph the
+status is C<STATUS_READ_ONLY_GRAPH>. C<edge_weight> returns undef if there
+is no edge.
+
+=item compress, build_scc_index
+
+Make the graph read-only and compact, or index its components so that
+unreachable queries fail at once.
+
+=item memory_usage
+
+The bytes held by the graph in the memory of the process; a mapped image
+is not counted.
+
+=item find_shortest_path($source, $target)
+
+=item find_shortest_path_2($source, $target)
+
+The bidirectional and the unidirectional search. Return the path, or undef
+with the reason in C<last_status>.
+
+=item find_shortest_paths(\@pairs, $unidirectional, $threads, \@costs)
+
+Runs a query for each source/target pair of the flat array. Returns a
+reference to the array of the paths, with undef where there is none, and in
+list context also a reference to the array of the statuses.
+
+With C<$threads> above 1 the queries run on that many threads, which steal
+queries from each other once their own share is done. C<\@costs> holds an
+estimate for each pair, such as how long it took last time; the most
+expensive pairs then start first, so that one slow query does not finish
+long after the others. The call returns when every query is done.
+
+=back
+
+=head1 EXECUTOR
+
+Runs queries on worker threads without blocking the caller, for event
+loops:
+
+    my $executor = BidirectionalDijkstra::Executor->new($graph, 4);
+
+    $executor->submit(1, 3, sub {
+        my ($path, $status) = @_;
+        ...
+    });
+
+    # With AnyEvent:
+    my $watcher = AnyEvent->io(fh => $executor->fd, poll => 'r',
+                               cb => sub { $executor->dispatch });
+
+=over 4
+
+=item new($graph, $threads = 2, $max_pending = 0)
+
+Starts the workers. The executor keeps the graph alive; do not change the
+graph while it runs, which is easiest to ensure by compressing it first.
+With C<$max_pending> set, no more queries than that wait for a worker.
+
+=item submit($source, $target, \&callback)
+
+Queues a bidirectional search and returns true, or false with
+C<STATUS_QUEUE_FULL> or C<STATUS_NO_MEMORY> in C<last_status>, in which
+case the callback is not called.
+
+=item fd
+
+A file descriptor that is readable while finished queries wait.
+
+=item dispatch
+
+Calls the callbacks of the finished queries with the path (undef if none)
+and the status, and returns their number. Never blocks. A callback that
+dies only warns.
+
+=item pending
+
+The queries submitted whose callbacks have not run yet.
+
+=back
+
+Destroying the executor cancels the queries still waiting, with
+C<STATUS_CANCELLED>, and runs every callback not yet run.
+
+=cut
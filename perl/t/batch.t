@@ -0,0 +1,68 @@
+use strict;
+use warnings;
+use Test::More;
+use BidirectionalDijkstra;
+
+# A 10 x 10 grid with edges to the right and down, so that there is no path
+# back up or left:
+my $side = 10;
+my $graph = BidirectionalDijkstra::Graph->new;
+
+for my $row (0 .. $side - 1) {
+    for my $column (0 .. $side - 1) {
+        my $vertex = $row * $side + $column;
+        $graph->add_vertex($vertex);
+        $graph->add_edge($vertex, $vertex + 1, 1 + $row % 3)
+            if $column + 1 < $side;
+        $graph->add_edge($vertex, $vertex + $side, 1 + $column % 2)
+            if $row + 1 < $side;
+    }
+}
+
+my @pairs;
+my @costs;
+
+for my $i (0 .. 199) {
+    push @pairs, ($i * 37) % 100, ($i * 53 + 11) % 100;
+    push @costs, $i % 7;
+}
+
+my ($expected, $expected_statuses) = $graph->find_shortest_paths(\@pairs);
+is(scalar @$expected, 200, 'a path per pair');
+is(scalar @$expected_statuses, 200, 'a status per pair');
+
+for my $i (0 .. 199) {
+    my $status = $expected_statuses->[$i];
+
+    if (defined $expected->[$i]) {
+        is($status, BidirectionalDijkstra::STATUS_OK, "status of pair $i");
+    }
+    else {
+        is($status, BidirectionalDijkstra::STATUS_NO_PATH, "no path $i");
+    }
+}
+
+for my $threads (1, 2, 4) {
+    my ($paths, $statuses) =
+            $graph->find_shortest_paths(\@pairs, 0, $threads, \@costs);
+    is_deeply($statuses, $expected_statuses, "statuses on $threads threads");
+    is_deeply($paths, $expected, "paths on $threads threads");
+}
+
+my ($paths, $statuses) = $graph->find_shortest_paths(\@pairs, 1, 3);
+is_deeply($statuses, $expected_statuses, 'unidirectional statuses');
+
+for my $i (0 .. 199) {
+    next unless defined $expected->[$i];
+
+    # Equal lengths may take different routes; the ends must match:
+    is($paths->[$i][0], $pairs[2 * $i], "unidirectional source $i");
+    is($paths->[$i][-1], $pairs[2 * $i + 1], "unidirectional target $i");
+}
+
+my $only_paths = $graph->find_shortest_paths([0, 99]);
+is($only_paths->[0][-1], 99, 'scalar context returns the paths');
+
+ok(!eval { $graph->find_shortest_paths([0]); 1 }, 'odd pair list dies');
+
+done_testing;
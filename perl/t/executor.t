@@ -0,0 +1,98 @@
+use strict;
+use warnings;
+use Test::More;
+use BidirectionalDijkstra;
+
+my $count = 300;
+my $graph = BidirectionalDijkstra::Graph->new;
+$graph->add_vertex($_) for 0 .. $count - 1;
+$graph->add_edge($_, $_ + 1, 1.0) for 0 .. $count - 2;
+ok($graph->compress, 'compress');
+
+sub wait_for {
+    my ($executor) = @_;
+
+    while ($executor->pending > 0) {
+        my $bits = '';
+        vec($bits, $executor->fd, 1) = 1;
+        select($bits, undef, undef, 0.1);
+        $executor->dispatch;
+    }
+}
+
+my $executor = BidirectionalDijkstra::Executor->new($graph, 3);
+my %calls;
+my $submitted = 0;
+
+for my $i (0 .. 49) {
+    my $source = $i;
+    my $target = ($i * 7) % $count;
+
+    $submitted++ if $executor->submit($source, $target, sub {
+        my ($path, $status) = @_;
+        $calls{$i}++;
+
+        my $expected = $graph->find_shortest_path($source, $target);
+        is_deeply($path, $expected, "path of query $i");
+        is($status, defined $expected ?
+                    BidirectionalDijkstra::STATUS_OK :
+                    BidirectionalDijkstra::STATUS_NO_PATH,
+           "status of query $i");
+    });
+}
+
+is($submitted, 50, 'every query is accepted');
+wait_for($executor);
+is(scalar keys %calls, 50, 'every callback ran');
+is(scalar(grep { $_ != 1 } values %calls), 0, 'each callback ran once');
+is($executor->dispatch, 0, 'nothing left to dispatch');
+
+my $full = BidirectionalDijkstra::Executor->new($graph, 1, 1);
+my $accepted = 0;
+my $rejected = 0;
+my $delivered = 0;
+
+for my $i (1 .. 20) {
+    if ($full->submit(0, $count - 1, sub { $delivered++ })) {
+        $accepted++;
+    }
+    else {
+        $rejected++;
+        is(BidirectionalDijkstra::last_status(),
+           BidirectionalDijkstra::STATUS_QUEUE_FULL, "queue full $i");
+    }
+}
+
+cmp_ok($accepted, '>=', 1, 'the bounded queue accepts a query');
+undef $full;
+is($delivered, $accepted, 'destroying runs every accepted callback');
+
+my $cancelled = BidirectionalDijkstra::Executor->new($graph, 1);
+my %statuses;
+
+for my $i (1 .. 200) {
+    $cancelled->submit(0, $count - 1, sub { $statuses{$_[1]}++ });
+}
+
+undef $cancelled;
+my $total = 0;
+$total += $_ for values %statuses;
+is($total, 200, 'destroying runs the callbacks of waiting queries');
+is(scalar(grep {
+       $_ != BidirectionalDijkstra::STATUS_OK &&
+       $_ != BidirectionalDijkstra::STATUS_CANCELLED
+   } keys %statuses), 0, 'waiting queries are cancelled');
+
+my $warning = '';
+{
+    local $SIG{__WARN__} = sub { $warning .= $_[0] };
+    my $dying = BidirectionalDijkstra::Executor->new($graph, 1);
+    my $after = 0;
+    $dying->submit(0, 1, sub { die "boom\n" });
+    $dying->submit(0, 2, sub { $after++ });
+    wait_for($dying);
+    is($after, 1, 'a dying callback does not stop the others');
+}
+like($warning, qr/boom/, 'a dying callback warns');
+
+done_testing;
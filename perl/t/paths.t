@@ -0,0 +1,43 @@
+use strict;
+use warnings;
+use Test::More;
+use BidirectionalDijkstra;
+
+my $graph = BidirectionalDijkstra::Graph->new;
+ok($graph->add_vertex($_), "add_vertex $_") for 1 .. 5;
+ok($graph->add_edge(1, 2, 1.0), 'add_edge');
+$graph->add_edge(2, 3, 1.0);
+$graph->add_edge(1, 3, 5.0);
+$graph->add_edge(3, 4, 2.0);
+
+is_deeply($graph->find_shortest_path(1, 4), [1, 2, 3, 4], 'bidirectional');
+is_deeply($graph->find_shortest_path_2(1, 4), [1, 2, 3, 4], 'unidirectional');
+is(BidirectionalDijkstra::last_status(), BidirectionalDijkstra::STATUS_OK,
+   'status of a path');
+is_deeply($graph->find_shortest_path(2, 2), [2], 'source is the target');
+
+is($graph->find_shortest_path(4, 1), undef, 'no path');
+is(BidirectionalDijkstra::last_status(), BidirectionalDijkstra::STATUS_NO_PATH,
+   'status of no path');
+is($graph->find_shortest_path(9, 1), undef, 'no source');
+is(BidirectionalDijkstra::last_status(),
+   BidirectionalDijkstra::STATUS_NO_SOURCE_VERTEX, 'status of no source');
+is($graph->find_shortest_path(1, 9), undef, 'no target');
+is(BidirectionalDijkstra::last_status(),
+   BidirectionalDijkstra::STATUS_NO_TARGET_VERTEX, 'status of no target');
+
+is($graph->edge_weight(1, 3), 5.0, 'edge_weight');
+is($graph->edge_weight(3, 1), undef, 'edge_weight without an edge');
+ok($graph->remove_edge(2, 3), 'remove_edge');
+ok(!$graph->has_edge(2, 3), 'the edge is gone');
+is_deeply($graph->find_shortest_path(1, 4), [1, 3, 4], 'path after removal');
+ok($graph->remove_vertex(3), 'remove_vertex');
+ok(!$graph->has_vertex(3), 'the vertex is gone');
+is($graph->find_shortest_path(1, 4), undef, 'no path after removal');
+
+ok($graph->build_scc_index, 'build_scc_index');
+is($graph->find_shortest_path(4, 1), undef, 'indexed graph, no path');
+is(BidirectionalDijkstra::last_status(), BidirectionalDijkstra::STATUS_NO_PATH,
+   'indexed graph, status of no path');
+
+done_testing;
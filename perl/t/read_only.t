@@ -0,0 +1,63 @@
+use strict;
+use warnings;
+use Test::More;
+use File::Temp qw(tempdir);
+use BidirectionalDijkstra;
+
+sub build {
+    my $graph = BidirectionalDijkstra::Graph->new;
+    $graph->add_vertex($_) for 1 .. 4;
+    $graph->add_edge(1, 2, 1.0);
+    $graph->add_edge(2, 3, 1.0);
+    $graph->add_edge(3, 4, 1.0);
+    return $graph;
+}
+
+sub check_read_only {
+    my ($graph, $name) = @_;
+    my $read_only = BidirectionalDijkstra::STATUS_READ_ONLY_GRAPH;
+
+    ok(!$graph->add_vertex(9), "$name: add_vertex of a new vertex fails");
+    is(BidirectionalDijkstra::last_status(), $read_only,
+       "$name: add_vertex of a new vertex");
+    ok(!$graph->add_vertex(1), "$name: add_vertex of a vertex fails");
+    is(BidirectionalDijkstra::last_status(), $read_only,
+       "$name: add_vertex of a vertex");
+    ok(!$graph->add_edge(1, 3, 1.0), "$name: add_edge fails");
+    is(BidirectionalDijkstra::last_status(), $read_only, "$name: add_edge");
+    ok(!$graph->remove_vertex(2), "$name: remove_vertex fails");
+    is(BidirectionalDijkstra::last_status(), $read_only,
+       "$name: remove_vertex");
+    ok(!$graph->remove_edge(1, 2), "$name: remove_edge fails");
+    is(BidirectionalDijkstra::last_status(), $read_only,
+       "$name: remove_edge");
+
+    ok($graph->has_vertex(2), "$name: the vertex is still there");
+    ok($graph->has_edge(1, 2), "$name: the edge is still there");
+    ok(!$graph->has_vertex(9), "$name: no vertex was added");
+    is_deeply($graph->find_shortest_path(1, 4), [1, 2, 3, 4],
+              "$name: the path is unchanged");
+}
+
+my $compressed = build();
+ok($compressed->compress, 'compress');
+check_read_only($compressed, 'compressed');
+
+my $directory = tempdir(CLEANUP => 1);
+my $file = "$directory/graph.img";
+ok(build()->save_image($file), 'save_image');
+is(BidirectionalDijkstra::last_status(), BidirectionalDijkstra::STATUS_OK,
+   'status of save_image');
+check_read_only(BidirectionalDijkstra::Graph->map_image($file), 'mapped');
+
+ok(!build()->save_image("$directory/missing/graph.img"),
+   'save_image into a missing directory fails');
+is(BidirectionalDijkstra::last_status(),
+   BidirectionalDijkstra::STATUS_IO_ERROR, 'status of a failed save_image');
+
+my $graph = build();
+ok($graph->add_vertex(1), 'add_vertex of a vertex of a mutable graph');
+is(BidirectionalDijkstra::last_status(), BidirectionalDijkstra::STATUS_OK,
+   'status of add_vertex of a vertex');
+
+done_testing;
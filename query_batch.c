@@ -0,0 +1,362 @@
+#include "query_batch.h"
+#include "allocator.h"
+#include "algorithm.h"
+#include "graph.h"
+#include "monotonic_clock.h"
+#include "util.h"
+#include "vertex_list.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* The queries left to a worker: 'indices[front]' to 'indices[back - 1]'.      *
+* 'work' is their total cost, or their number without                         *
+* QUERY_BATCH_LONGEST_FIRST; thieves compare it to pick a victim.             *
+*******************************************************************************/
+typedef struct batch_deque {
+    pthread_mutex_t lock;
+    size_t*         indices;
+    size_t          front;
+    size_t          back;
+    double          work;
+} batch_deque;
+
+typedef struct batch_worker {
+    pthread_t         thread;
+    struct batch_run* p_run;
+    batch_deque       deque;
+    double            busy_seconds;
+    size_t            steals;
+} batch_worker;
+
+typedef struct batch_run {
+    Graph*            p_graph;
+    query_batch_item* items;
+    int               flags;
+    batch_worker*     workers;
+    size_t            worker_count;
+} batch_run;
+
+/* An item and its cost, sorted by decreasing cost: */
+typedef struct batch_order {
+    double cost;
+    size_t index;
+} batch_order;
+
+static int compare_orders(const void* p_a, const void* p_b)
+{
+    const batch_order* p_order_a = p_a;
+    const batch_order* p_order_b = p_b;
+
+    if (p_order_a->cost != p_order_b->cost)
+    {
+        return p_order_a->cost < p_order_b->cost ? 1 : -1;
+    }
+
+    /* Equal costs keep the order of the batch: */
+    return p_order_a->index < p_order_b->index ? -1 : 1;
+}
+
+static double item_work(batch_run* p_run, size_t index)
+{
+    return p_run->flags & QUERY_BATCH_LONGEST_FIRST ?
+           p_run->items[index].cost :
+           1.0;
+}
+
+/* Takes the next query of the worker's own deque: */
+static int take_own(batch_worker* p_worker, size_t* p_index)
+{
+    batch_deque* p_deque = &p_worker->deque;
+    int taken = FALSE;
+
+    pthread_mutex_lock(&p_deque->lock);
+
+    if (p_deque->front < p_deque->back)
+    {
+        *p_index = p_deque->indices[p_deque->front++];
+        p_deque->work -= item_work(p_worker->p_run, *p_index);
+        taken = TRUE;
+    }
+
+    pthread_mutex_unlock(&p_deque->lock);
+    return taken;
+}
+
+/*******************************************************************************
+* Takes a query from the deque with the most work left. Without costs it      *
+* takes the last one, which its owner would have reached last; with           *
+* QUERY_BATCH_LONGEST_FIRST it takes the first, the most expensive one still  *
+* waiting, since an expensive query stuck behind a slow one sets the          *
+* makespan. Returns FALSE once every deque is empty; nothing is added to them *
+* during a run, so the worker is then done.                                   *
+*******************************************************************************/
+static int steal(batch_worker* p_thief, size_t* p_index)
+{
+    batch_run* p_run = p_thief->p_run;
+    batch_deque* p_victim;
+    batch_deque* p_deque;
+    double most_work;
+    size_t i;
+    int taken;
+
+    for (;;)
+    {
+        p_victim = NULL;
+        most_work = -1.0;
+
+        for (i = 0; i < p_run->worker_count; ++i)
+        {
+            p_deque = &p_run->workers[i].deque;
+
+            if (p_deque == &p_thief->deque)
+            {
+                continue;
+            }
+
+            pthread_mutex_lock(&p_deque->lock);
+
+            if (p_deque->front < p_deque->back && p_deque->work > most_work)
+            {
+                p_victim = p_deque;
+                most_work = p_deque->work;
+            }
+
+            pthread_mutex_unlock(&p_deque->lock);
+        }
+
+        if (!p_victim)
+        {
+            return FALSE;
+        }
+
+        taken = FALSE;
+        pthread_mutex_lock(&p_victim->lock);
+
+        /* The victim or another thief may have emptied it meanwhile: */
+        if (p_victim->front < p_victim->back)
+        {
+            *p_index = p_run->flags & QUERY_BATCH_LONGEST_FIRST ?
+                       p_victim->indices[p_victim->front++] :
+                       p_victim->indices[--p_victim->back];
+            p_victim->work -= item_work(p_run, *p_index);
+            taken = TRUE;
+        }
+
+        pthread_mutex_unlock(&p_victim->lock);
+
+        if (taken)
+        {
+            ++p_thief->steals;
+            return TRUE;
+        }
+    }
+}
+
+static void* run_worker(void* p_argument)
+{
+    batch_worker* p_worker = p_argument;
+    batch_run* p_run = p_worker->p_run;
+    search_options options;
+    query_batch_item* p_item;
+    size_t index;
+    double start;
+
+    search_options_init(&options);
+
+    /* Without a workspace the queries allocate their own containers: */
+    options.p_workspace = search_workspace_alloc();
+
+    while (take_own(p_worker, &index) ||
+           (!(p_run->flags & QUERY_BATCH_STATIC) && steal(p_worker, &index)))
+    {
+        p_item = &p_run->items[index];
+        start = monotonic_clock_seconds();
+
+        p_item->p_path = p_run->flags & QUERY_BATCH_UNIDIRECTIONAL ?
+                         find_shortest_path_2_ex(p_run->p_graph,
+                                                 p_item->source_vertex_id,
+                                                 p_item->target_vertex_id,
+                                                 &options,
+                                                 &p_item->return_status) :
+                         find_shortest_path_ex(p_run->p_graph,
+                                               p_item->source_vertex_id,
+                                               p_item->target_vertex_id,
+                                               &options,
+                                               &p_item->return_status);
+
+        p_item->seconds = monotonic_clock_seconds() - start;
+        p_worker->busy_seconds += p_item->seconds;
+    }
+
+    search_workspace_free(options.p_workspace);
+    return NULL;
+}
+
+/*******************************************************************************
+* Fills the deques. Worker 'w' gets 'count / worker_count' queries, one more  *
+* if 'w' is below the remainder, stored from 'offset' on in 'indices'. The    *
+* static split gives it a contiguous slice of the order; the others deal the  *
+* order like cards, so that each deque gets a share of the expensive queries. *
+*******************************************************************************/
+static void deal(batch_run* p_run,
+                 const batch_order* order,
+                 size_t count,
+                 size_t* indices)
+{
+    size_t worker_count = p_run->worker_count;
+    size_t offset = 0;
+    size_t size;
+    size_t w;
+    size_t j;
+    batch_deque* p_deque;
+
+    for (w = 0; w < worker_count; ++w)
+    {
+        size = count / worker_count + (w < count % worker_count ? 1 : 0);
+        p_deque = &p_run->workers[w].deque;
+        p_deque->indices = indices + offset;
+        p_deque->front = 0;
+        p_deque->back = size;
+        p_deque->work = 0.0;
+
+        for (j = 0; j < size; ++j)
+        {
+            p_deque->indices[j] = p_run->flags & QUERY_BATCH_STATIC ?
+                                  order[offset + j].index :
+                                  order[j * worker_count + w].index;
+            p_deque->work += item_work(p_run, p_deque->indices[j]);
+        }
+
+        offset += size;
+    }
+}
+
+int query_batch_run(Graph* p_graph,
+                    query_batch_item* items,
+                    size_t count,
+                    size_t thread_count,
+                    int flags,
+                    query_batch_stats* p_stats)
+{
+    batch_run run;
+    batch_order* order;
+    size_t* indices;
+    size_t started;
+    size_t i;
+    double start;
+
+    if (!p_graph)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    if (thread_count == 0)
+    {
+        thread_count = 1;
+    }
+
+    /* A worker without a query would only look for one to steal: */
+    if (thread_count > count && count > 0)
+    {
+        thread_count = count;
+    }
+
+    start = monotonic_clock_seconds();
+    order = allocator_malloc(sizeof(batch_order) * (count + 1));
+    indices = allocator_malloc(sizeof(size_t) * (count + 1));
+    run.workers = allocator_malloc(sizeof(batch_worker) * thread_count);
+
+    if (!order || !indices || !run.workers)
+    {
+        allocator_free(order);
+        allocator_free(indices);
+        allocator_free(run.workers);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    run.p_graph = p_graph;
+    run.items = items;
+    run.flags = flags;
+    run.worker_count = thread_count;
+
+    for (i = 0; i < count; ++i)
+    {
+        items[i].p_path = NULL;
+        items[i].return_status = RETURN_STATUS_CANCELLED;
+        items[i].seconds = 0.0;
+        order[i].cost = items[i].cost;
+        order[i].index = i;
+    }
+
+    if ((flags & QUERY_BATCH_LONGEST_FIRST) && !(flags & QUERY_BATCH_STATIC))
+    {
+        qsort(order, count, sizeof(batch_order), compare_orders);
+    }
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        run.workers[i].p_run = &run;
+        run.workers[i].busy_seconds = 0.0;
+        run.workers[i].steals = 0;
+        pthread_mutex_init(&run.workers[i].deque.lock, NULL);
+    }
+
+    deal(&run, order, count, indices);
+    allocator_free(order);
+
+    /* The calling thread is worker 0: */
+    for (started = 1; started < thread_count; ++started)
+    {
+        if (pthread_create(&run.workers[started].thread,
+                           NULL,
+                           run_worker,
+                           &run.workers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    run_worker(&run.workers[0]);
+
+    /* Without stealing, the slices of the missing workers fall to worker 0: */
+    for (i = started; i < thread_count; ++i)
+    {
+        run_worker(&run.workers[i]);
+        run.workers[0].busy_seconds += run.workers[i].busy_seconds;
+    }
+
+    for (i = 1; i < started; ++i)
+    {
+        pthread_join(run.workers[i].thread, NULL);
+    }
+
+    if (p_stats)
+    {
+        p_stats->wall_seconds = monotonic_clock_seconds() - start;
+        p_stats->max_busy_seconds = 0.0;
+        p_stats->total_busy_seconds = 0.0;
+        p_stats->steals = 0;
+        p_stats->worker_count = started;
+
+        for (i = 0; i < started; ++i)
+        {
+            if (run.workers[i].busy_seconds > p_stats->max_busy_seconds)
+            {
+                p_stats->max_busy_seconds = run.workers[i].busy_seconds;
+            }
+
+            p_stats->total_busy_seconds += run.workers[i].busy_seconds;
+            p_stats->steals += run.workers[i].steals;
+        }
+    }
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        pthread_mutex_destroy(&run.workers[i].deque.lock);
+    }
+
+    allocator_free(run.workers);
+    allocator_free(indices);
+    return RETURN_STATUS_OK;
+}
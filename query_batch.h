@@ -0,0 +1,60 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_BATCH_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_BATCH_H
+
+#include "graph.h"
+#include "vertex_list.h"
+#include <stdlib.h>
+
+/* Run the unidirectional search: */
+#define QUERY_BATCH_UNIDIRECTIONAL 1
+
+/* Start the queries with the largest 'cost' first: */
+#define QUERY_BATCH_LONGEST_FIRST  2
+
+/* Give each worker a contiguous slice and no stealing, to compare against: */
+#define QUERY_BATCH_STATIC         4
+
+/*******************************************************************************
+* One query of a batch. The caller fills in the vertices and, for             *
+* QUERY_BATCH_LONGEST_FIRST, an estimate of the cost in any unit, such as the *
+* time the query took the last time it ran. The batch fills in the rest; the  *
+* caller owns the path and frees it with vertex_list_free().                  *
+*******************************************************************************/
+typedef struct query_batch_item {
+    vertex_id_t  source_vertex_id;
+    vertex_id_t  target_vertex_id;
+    double       cost;
+    vertex_list* p_path;
+    int          return_status;
+    double       seconds;
+} query_batch_item;
+
+/* How the work spread over the workers: */
+typedef struct query_batch_stats {
+    double wall_seconds;
+    double max_busy_seconds;
+    double total_busy_seconds;
+    size_t steals;
+    size_t worker_count;
+} query_batch_stats;
+
+/*******************************************************************************
+* Runs the queries of 'items' on 'thread_count' workers, the calling thread   *
+* being one of them, and returns once all are done. The queries are dealt     *
+* round-robin to a deque per worker, which takes them from the front; a       *
+* worker whose deque is empty steals from the deque with the most work left,  *
+* so a few slow queries do not leave the other workers idle. With             *
+* QUERY_BATCH_LONGEST_FIRST the queries are sorted by decreasing cost before  *
+* they are dealt, so the slow ones start first and the cheap ones fill the    *
+* gaps at the end. QUERY_BATCH_STATIC ignores the costs. 'p_stats' may be     *
+* NULL. Returns RETURN_STATUS_NO_MEMORY if the deques cannot be allocated,    *
+* and RETURN_STATUS_OK otherwise, with the status of each query in its item.  *
+*******************************************************************************/
+int query_batch_run(Graph* p_graph,
+                    query_batch_item* items,
+                    size_t count,
+                    size_t thread_count,
+                    int flags,
+                    query_batch_stats* p_stats);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_BATCH_H */
@@ -0,0 +1,72 @@
+#include "query_context.h"
+#include "monotonic_clock.h"
+#include "util.h"
+
+/*******************************************************************************
+* The flag is set by one thread and polled by the search on another; the      *
+* search only needs to see it eventually, so relaxed accesses are enough.     *
+* Compilers without the GCC atomics fall back to volatile accesses, as in     *
+* query_metrics.c.                                                            *
+*******************************************************************************/
+#if defined(__GNUC__)
+#define LOAD_FLAG(P_FLAG) __atomic_load_n((P_FLAG), __ATOMIC_RELAXED)
+#define STORE_FLAG(P_FLAG, VALUE) \
+        __atomic_store_n((P_FLAG), (VALUE), __ATOMIC_RELAXED)
+#else
+#define LOAD_FLAG(P_FLAG) (*(volatile int*)(P_FLAG))
+#define STORE_FLAG(P_FLAG, VALUE) (*(volatile int*)(P_FLAG) = (VALUE))
+#endif
+
+/* Reading the clock costs tens of nanoseconds; settling a vertex, more: */
+static const size_t DEFAULT_CHECK_INTERVAL = 64;
+
+void query_context_init(query_context* p_context)
+{
+    p_context->deadline = 0.0;
+    STORE_FLAG(&p_context->cancelled, FALSE);
+    p_context->check_interval = DEFAULT_CHECK_INTERVAL;
+}
+
+/*******************************************************************************
+* Sets the deadline 'seconds' from now.                                       *
+*******************************************************************************/
+void query_context_set_timeout(query_context* p_context, double seconds)
+{
+    p_context->deadline = monotonic_clock_seconds() + seconds;
+}
+
+void query_context_cancel(query_context* p_context)
+{
+    STORE_FLAG(&p_context->cancelled, TRUE);
+}
+
+int query_context_check(query_context* p_context)
+{
+    if (LOAD_FLAG(&p_context->cancelled))
+    {
+        return RETURN_STATUS_CANCELLED;
+    }
+
+    if (p_context->deadline > 0.0 &&
+        monotonic_clock_seconds() >= p_context->deadline)
+    {
+        return RETURN_STATUS_DEADLINE_EXCEEDED;
+    }
+
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Checks the context if 'settled' is a multiple of the check interval, so     *
+* that the search pays for the clock only now and then.                       *
+*******************************************************************************/
+int query_context_poll(query_context* p_context, size_t settled)
+{
+    if (p_context->check_interval > 1 &&
+        settled % p_context->check_interval != 0)
+    {
+        return RETURN_STATUS_OK;
+    }
+
+    return query_context_check(p_context);
+}
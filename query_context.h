@@ -0,0 +1,30 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_CONTEXT_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_CONTEXT_H
+
+#include <stdlib.h>
+
+/*******************************************************************************
+* Lets the caller stop a running search. The search polls the context every   *
+* 'check_interval' settled vertices and gives up with                         *
+* RETURN_STATUS_CANCELLED once 'cancelled' is set, or with                    *
+* RETURN_STATUS_DEADLINE_EXCEEDED once the monotonic clock passes 'deadline'. *
+* query_context_cancel() may be called from any thread; 'cancelled' is only   *
+* accessed through relaxed atomics.                                           *
+*******************************************************************************/
+typedef struct query_context {
+    double deadline;       /* In monotonic_clock_seconds(), 0 if none. */
+    int    cancelled;
+    size_t check_interval;
+} query_context;
+
+void query_context_init(query_context* p_context);
+
+void query_context_set_timeout(query_context* p_context, double seconds);
+
+void query_context_cancel(query_context* p_context);
+
+int query_context_check(query_context* p_context);
+
+int query_context_poll(query_context* p_context, size_t settled);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_CONTEXT_H */
@@ -0,0 +1,427 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "query_executor.h"
+#include "allocator.h"
+#include "algorithm.h"
+#include "graph.h"
+#include "query_context.h"
+#include "util.h"
+#include "vertex_list.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+/* A submitted query, waiting, running or finished: */
+typedef struct query_job {
+    vertex_id_t       source_vertex_id;
+    vertex_id_t       target_vertex_id;
+    query_callback    callback;
+    void*             p_user_data;
+    vertex_list*      p_path;
+    int               return_status;
+    struct query_job* p_next;
+} query_job;
+
+typedef struct query_job_list {
+    query_job* p_head;
+    query_job* p_tail;
+    size_t     size;
+} query_job_list;
+
+typedef struct query_worker {
+    pthread_t              thread;
+    struct query_executor* p_executor;
+
+    /* Cancels the running query when the executor is freed: */
+    query_context          context;
+} query_worker;
+
+/*******************************************************************************
+* 'lock' guards the lists, the counts and 'closed'. Jobs go from 'waiting' to *
+* a worker, then to 'finished', then back to 'spare' once dispatched, so a    *
+* busy executor stops allocating them. On Linux both notifier descriptors are *
+* one eventfd; elsewhere they are the ends of a pipe.                         *
+*******************************************************************************/
+struct query_executor {
+    Graph*          p_graph;
+    pthread_mutex_t lock;
+    pthread_cond_t  work_available;
+    query_job_list  waiting;
+    query_job_list  finished;
+    query_job*      p_spare;
+    size_t          max_pending;
+    size_t          pending;
+    int             closed;
+    query_worker*   workers;
+    size_t          worker_count;
+    int             notifier[2];
+};
+
+static void list_init(query_job_list* p_list)
+{
+    p_list->p_head = NULL;
+    p_list->p_tail = NULL;
+    p_list->size = 0;
+}
+
+static void list_append(query_job_list* p_list, query_job* p_job)
+{
+    p_job->p_next = NULL;
+
+    if (p_list->p_tail)
+    {
+        p_list->p_tail->p_next = p_job;
+    }
+    else
+    {
+        p_list->p_head = p_job;
+    }
+
+    p_list->p_tail = p_job;
+    ++p_list->size;
+}
+
+static query_job* list_pop(query_job_list* p_list)
+{
+    query_job* p_job = p_list->p_head;
+
+    p_list->p_head = p_job->p_next;
+
+    if (!p_list->p_head)
+    {
+        p_list->p_tail = NULL;
+    }
+
+    --p_list->size;
+    return p_job;
+}
+
+static int open_notifier(int* notifier)
+{
+#ifdef __linux__
+    notifier[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    notifier[1] = notifier[0];
+    return notifier[0] >= 0;
+#else
+    if (pipe(notifier) != 0)
+    {
+        return FALSE;
+    }
+
+    fcntl(notifier[0], F_SETFL, fcntl(notifier[0], F_GETFL) | O_NONBLOCK);
+    fcntl(notifier[1], F_SETFL, fcntl(notifier[1], F_GETFL) | O_NONBLOCK);
+    return TRUE;
+#endif
+}
+
+static void close_notifier(int* notifier)
+{
+    close(notifier[0]);
+
+    if (notifier[1] != notifier[0])
+    {
+        close(notifier[1]);
+    }
+}
+
+/* Both are called with the lock held, so they cannot cross: */
+static void raise_notifier(int* notifier)
+{
+#ifdef __linux__
+    eventfd_write(notifier[1], 1);
+#else
+    char byte = 0;
+    ssize_t written = write(notifier[1], &byte, 1);
+    (void) written;
+#endif
+}
+
+static void clear_notifier(int* notifier)
+{
+#ifdef __linux__
+    eventfd_t value;
+    eventfd_read(notifier[0], &value);
+#else
+    char bytes[64];
+
+    while (read(notifier[0], bytes, sizeof(bytes)) > 0)
+    {
+    }
+#endif
+}
+
+static void finish_job(query_executor* p_executor, query_job* p_job)
+{
+    /* Only the first finished job makes the descriptor readable: */
+    if (p_executor->finished.size == 0)
+    {
+        raise_notifier(p_executor->notifier);
+    }
+
+    list_append(&p_executor->finished, p_job);
+}
+
+static void* run_worker(void* p_argument)
+{
+    query_worker* p_worker = p_argument;
+    query_executor* p_executor = p_worker->p_executor;
+    search_options options;
+    query_job* p_job;
+
+    search_options_init(&options);
+    options.p_context = &p_worker->context;
+
+    /* Without a workspace the queries allocate their own containers: */
+    options.p_workspace = search_workspace_alloc();
+
+    for (;;)
+    {
+        pthread_mutex_lock(&p_executor->lock);
+
+        while (p_executor->waiting.size == 0 && !p_executor->closed)
+        {
+            pthread_cond_wait(&p_executor->work_available, &p_executor->lock);
+        }
+
+        if (p_executor->closed)
+        {
+            pthread_mutex_unlock(&p_executor->lock);
+            break;
+        }
+
+        p_job = list_pop(&p_executor->waiting);
+
+        /* Under the lock, so that a cancellation is never lost: */
+        query_context_init(&p_worker->context);
+        pthread_mutex_unlock(&p_executor->lock);
+
+        p_job->p_path = find_shortest_path_ex(p_executor->p_graph,
+                                              p_job->source_vertex_id,
+                                              p_job->target_vertex_id,
+                                              &options,
+                                              &p_job->return_status);
+
+        pthread_mutex_lock(&p_executor->lock);
+        finish_job(p_executor, p_job);
+        pthread_mutex_unlock(&p_executor->lock);
+    }
+
+    search_workspace_free(options.p_workspace);
+    return NULL;
+}
+
+query_executor* query_executor_alloc(Graph* p_graph,
+                                     size_t thread_count,
+                                     size_t max_pending)
+{
+    query_executor* p_executor;
+
+    if (!p_graph || thread_count == 0)
+    {
+        return NULL;
+    }
+
+    p_executor = allocator_malloc(sizeof(*p_executor));
+
+    if (!p_executor)
+    {
+        return NULL;
+    }
+
+    p_executor->workers = allocator_malloc(sizeof(query_worker) *
+                                           thread_count);
+
+    if (!p_executor->workers || !open_notifier(p_executor->notifier))
+    {
+        allocator_free(p_executor->workers);
+        allocator_free(p_executor);
+        return NULL;
+    }
+
+    p_executor->p_graph = p_graph;
+    p_executor->p_spare = NULL;
+    p_executor->max_pending = max_pending;
+    p_executor->pending = 0;
+    p_executor->closed = FALSE;
+    p_executor->worker_count = 0;
+    list_init(&p_executor->waiting);
+    list_init(&p_executor->finished);
+    pthread_mutex_init(&p_executor->lock, NULL);
+    pthread_cond_init(&p_executor->work_available, NULL);
+
+    while (p_executor->worker_count < thread_count)
+    {
+        query_worker* p_worker =
+                &p_executor->workers[p_executor->worker_count];
+
+        p_worker->p_executor = p_executor;
+        query_context_init(&p_worker->context);
+
+        if (pthread_create(&p_worker->thread,
+                           NULL,
+                           run_worker,
+                           p_worker) != 0)
+        {
+            break;
+        }
+
+        ++p_executor->worker_count;
+    }
+
+    if (p_executor->worker_count == 0)
+    {
+        query_executor_free(p_executor);
+        return NULL;
+    }
+
+    return p_executor;
+}
+
+void query_executor_free(query_executor* p_executor)
+{
+    query_job* p_job;
+    size_t i;
+
+    if (!p_executor)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&p_executor->lock);
+    p_executor->closed = TRUE;
+
+    while (p_executor->waiting.size > 0)
+    {
+        p_job = list_pop(&p_executor->waiting);
+        p_job->p_path = NULL;
+        p_job->return_status = RETURN_STATUS_CANCELLED;
+        finish_job(p_executor, p_job);
+    }
+
+    for (i = 0; i < p_executor->worker_count; ++i)
+    {
+        query_context_cancel(&p_executor->workers[i].context);
+    }
+
+    pthread_cond_broadcast(&p_executor->work_available);
+    pthread_mutex_unlock(&p_executor->lock);
+
+    for (i = 0; i < p_executor->worker_count; ++i)
+    {
+        pthread_join(p_executor->workers[i].thread, NULL);
+    }
+
+    query_executor_dispatch(p_executor);
+
+    while (p_executor->p_spare)
+    {
+        p_job = p_executor->p_spare;
+        p_executor->p_spare = p_job->p_next;
+        allocator_free(p_job);
+    }
+
+    close_notifier(p_executor->notifier);
+    pthread_cond_destroy(&p_executor->work_available);
+    pthread_mutex_destroy(&p_executor->lock);
+    allocator_free(p_executor->workers);
+    allocator_free(p_executor);
+}
+
+int query_submit(query_executor* p_executor,
+                 vertex_id_t source_vertex_id,
+                 vertex_id_t target_vertex_id,
+                 query_callback callback,
+                 void* p_user_data)
+{
+    query_job* p_job;
+
+    pthread_mutex_lock(&p_executor->lock);
+
+    if (p_executor->max_pending &&
+        p_executor->waiting.size >= p_executor->max_pending)
+    {
+        pthread_mutex_unlock(&p_executor->lock);
+        return RETURN_STATUS_QUEUE_FULL;
+    }
+
+    p_job = p_executor->p_spare;
+
+    if (p_job)
+    {
+        p_executor->p_spare = p_job->p_next;
+    }
+    else if (!(p_job = allocator_malloc(sizeof(*p_job))))
+    {
+        pthread_mutex_unlock(&p_executor->lock);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    p_job->source_vertex_id = source_vertex_id;
+    p_job->target_vertex_id = target_vertex_id;
+    p_job->callback = callback;
+    p_job->p_user_data = p_user_data;
+    list_append(&p_executor->waiting, p_job);
+    ++p_executor->pending;
+    pthread_cond_signal(&p_executor->work_available);
+    pthread_mutex_unlock(&p_executor->lock);
+    return RETURN_STATUS_OK;
+}
+
+int query_executor_fd(query_executor* p_executor)
+{
+    return p_executor->notifier[0];
+}
+
+size_t query_executor_dispatch(query_executor* p_executor)
+{
+    query_job_list finished;
+    query_job* p_job;
+    size_t count;
+
+    pthread_mutex_lock(&p_executor->lock);
+    finished = p_executor->finished;
+    list_init(&p_executor->finished);
+    p_executor->pending -= finished.size;
+
+    if (finished.size > 0)
+    {
+        clear_notifier(p_executor->notifier);
+    }
+
+    pthread_mutex_unlock(&p_executor->lock);
+
+    /* Without the lock, so that a callback may submit more queries: */
+    for (p_job = finished.p_head; p_job; p_job = p_job->p_next)
+    {
+        p_job->callback(p_job->p_path,
+                        p_job->return_status,
+                        p_job->p_user_data);
+    }
+
+    count = finished.size;
+
+    if (count > 0)
+    {
+        pthread_mutex_lock(&p_executor->lock);
+        finished.p_tail->p_next = p_executor->p_spare;
+        p_executor->p_spare = finished.p_head;
+        pthread_mutex_unlock(&p_executor->lock);
+    }
+
+    return count;
+}
+
+size_t query_executor_pending(query_executor* p_executor)
+{
+    size_t pending;
+
+    pthread_mutex_lock(&p_executor->lock);
+    pending = p_executor->pending;
+    pthread_mutex_unlock(&p_executor->lock);
+    return pending;
+}
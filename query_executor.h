@@ -0,0 +1,67 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_EXECUTOR_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_EXECUTOR_H
+
+#include "graph.h"
+#include "vertex_list.h"
+#include <stdlib.h>
+
+/*******************************************************************************
+* Called with the path of a submitted query, or NULL and the reason in        *
+* 'return_status'. The callback owns the path and frees it with               *
+* vertex_list_free().                                                         *
+*******************************************************************************/
+typedef void (*query_callback)(vertex_list* p_path,
+                               int return_status,
+                               void* p_user_data);
+
+/*******************************************************************************
+* Runs queries on a pool of worker threads, for callers that must not block,  *
+* such as event loops. query_submit() only queues a query. Finished queries   *
+* wait until the owner calls query_executor_dispatch(), which runs their      *
+* callbacks on the calling thread. The descriptor from query_executor_fd()    *
+* becomes readable when finished queries are waiting, so an event loop        *
+* (epoll, poll, AnyEvent in Perl) watches it and dispatches when it fires.    *
+* Submit and dispatch from one thread, or serialize the calls.                *
+*******************************************************************************/
+typedef struct query_executor query_executor;
+
+/*******************************************************************************
+* Starts 'thread_count' workers, each with its own search workspace, over     *
+* 'p_graph', which must not change while the executor runs. At most           *
+* 'max_pending' queries wait for a worker; 0 means no limit.                  *
+*******************************************************************************/
+query_executor* query_executor_alloc(Graph* p_graph,
+                                     size_t thread_count,
+                                     size_t max_pending);
+
+/*******************************************************************************
+* Cancels the queries still waiting and stops the running ones, then runs     *
+* every callback not yet run, so each submitted query gets its callback       *
+* exactly once. Cancelled queries get RETURN_STATUS_CANCELLED.                *
+*******************************************************************************/
+void query_executor_free(query_executor* p_executor);
+
+/*******************************************************************************
+* Queues a bidirectional search. Returns RETURN_STATUS_QUEUE_FULL if          *
+* 'max_pending' queries are already waiting, in which case the callback will  *
+* not be called.                                                              *
+*******************************************************************************/
+int query_submit(query_executor* p_executor,
+                 vertex_id_t source_vertex_id,
+                 vertex_id_t target_vertex_id,
+                 query_callback callback,
+                 void* p_user_data);
+
+/* Readable while finished queries wait for query_executor_dispatch(): */
+int query_executor_fd(query_executor* p_executor);
+
+/*******************************************************************************
+* Runs the callbacks of the queries finished so far, in the order they        *
+* finished, and returns their number. Never blocks.                           *
+*******************************************************************************/
+size_t query_executor_dispatch(query_executor* p_executor);
+
+/* The queries submitted and not yet dispatched: */
+size_t query_executor_pending(query_executor* p_executor);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_EXECUTOR_H */
@@ -0,0 +1,448 @@
+#include "query_metrics.h"
+#include "allocator.h"
+#include "util.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Values below this many nanoseconds get a bucket each: */
+#define LINEAR_BUCKETS 64
+
+/* Buckets per power of two above the linear range: */
+#define SUB_BUCKETS 32
+
+/* The first nanosecond count that falls into the last bucket, 2^42: */
+#define LARGEST_VALUE 4398046511104.0
+
+/*******************************************************************************
+* A shard has a single writer, so a relaxed load and store are enough to      *
+* count; they only keep readers from seeing torn values. Compilers without    *
+* the GCC atomics fall back to volatile accesses, which give the same         *
+* guarantee for aligned words on the platforms they target.                   *
+*******************************************************************************/
+#if defined(__GNUC__)
+#define LOAD_COUNT(P_COUNT) __atomic_load_n((P_COUNT), __ATOMIC_RELAXED)
+#define STORE_COUNT(P_COUNT, VALUE) \
+        __atomic_store_n((P_COUNT), (VALUE), __ATOMIC_RELAXED)
+#define LOAD_SECONDS(P_SECONDS, P_VALUE) \
+        __atomic_load((P_SECONDS), (P_VALUE), __ATOMIC_RELAXED)
+#define STORE_SECONDS(P_SECONDS, P_VALUE) \
+        __atomic_store((P_SECONDS), (P_VALUE), __ATOMIC_RELAXED)
+#else
+#define LOAD_COUNT(P_COUNT) (*(volatile size_t*)(P_COUNT))
+#define STORE_COUNT(P_COUNT, VALUE) (*(volatile size_t*)(P_COUNT) = (VALUE))
+#define LOAD_SECONDS(P_SECONDS, P_VALUE) \
+        (*(P_VALUE) = *(volatile double*)(P_SECONDS))
+#define STORE_SECONDS(P_SECONDS, P_VALUE) \
+        (*(volatile double*)(P_SECONDS) = *(P_VALUE))
+#endif
+
+static const char* STATUS_NAMES[QUERY_METRICS_STATUSES] = {
+    "ok",
+    "no_path",
+    "no_source_vertex",
+    "no_target_vertex",
+    "no_vertices",
+    "no_memory",
+    "no_graph",
+    "bound_exceeded",
+    "cancelled",
+    "deadline_exceeded",
+    "other"
+};
+
+/* The upper bounds of the exported Prometheus buckets, in seconds: */
+static const double PROMETHEUS_BOUNDS[] = {
+    1e-6, 2.5e-6, 5e-6,
+    1e-5, 2.5e-5, 5e-5,
+    1e-4, 2.5e-4, 5e-4,
+    1e-3, 2.5e-3, 5e-3,
+    1e-2, 2.5e-2, 5e-2,
+    1e-1, 2.5e-1, 5e-1,
+    1.0,  2.5,    5.0,
+    10.0
+};
+
+#define PROMETHEUS_BOUND_COUNT \
+        (sizeof(PROMETHEUS_BOUNDS) / sizeof(PROMETHEUS_BOUNDS[0]))
+
+static const double PROMETHEUS_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+#define PROMETHEUS_QUANTILE_COUNT \
+        (sizeof(PROMETHEUS_QUANTILES) / sizeof(PROMETHEUS_QUANTILES[0]))
+
+static size_t status_index(int return_status)
+{
+    switch (return_status)
+    {
+        case RETURN_STATUS_OK:
+            return 0;
+
+        case RETURN_STATUS_NO_PATH:
+            return 1;
+
+        case RETURN_STATUS_NO_SOURCE_VERTEX:
+            return 2;
+
+        case RETURN_STATUS_NO_TARGET_VERTEX:
+            return 3;
+
+        case RETURN_STATUS_NO_SOURCE_VERTEX | RETURN_STATUS_NO_TARGET_VERTEX:
+            return 4;
+
+        case RETURN_STATUS_NO_MEMORY:
+            return 5;
+
+        case RETURN_STATUS_NO_GRAPH:
+            return 6;
+
+        case RETURN_STATUS_BOUND_EXCEEDED:
+            return 7;
+
+        case RETURN_STATUS_CANCELLED:
+            return 8;
+
+        case RETURN_STATUS_DEADLINE_EXCEEDED:
+            return 9;
+
+        default:
+            return 10;
+    }
+}
+
+static size_t bucket_index(double nanoseconds)
+{
+    int exponent;
+    size_t shift;
+    size_t mantissa;
+
+    if (nanoseconds < LINEAR_BUCKETS)
+    {
+        return nanoseconds > 0.0 ? (size_t) nanoseconds : 0;
+    }
+
+    if (nanoseconds >= LARGEST_VALUE)
+    {
+        return QUERY_METRICS_BUCKETS - 1;
+    }
+
+    /* 'nanoseconds' is in [2^(exponent - 1), 2^exponent): */
+    frexp(nanoseconds, &exponent);
+    shift = (size_t) exponent - 6;
+    mantissa = (size_t) ldexp(nanoseconds, -(int) shift);
+
+    return LINEAR_BUCKETS +
+           (shift - 1) * SUB_BUCKETS +
+           (mantissa - SUB_BUCKETS);
+}
+
+/* Returns the least value, in seconds, above every value of the bucket: */
+static double bucket_upper_bound(size_t index)
+{
+    size_t shift;
+    size_t mantissa;
+
+    if (index < LINEAR_BUCKETS)
+    {
+        return (double)(index + 1) * 1e-9;
+    }
+
+    shift = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 1;
+    mantissa = (index - LINEAR_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+    return ldexp((double)(mantissa + 1), (int) shift) * 1e-9;
+}
+
+/*******************************************************************************
+* Allocates the metrics for 'shard_count' threads. Each thread records into   *
+* the shard of its own index.                                                 *
+*******************************************************************************/
+query_metrics* query_metrics_alloc(size_t shard_count)
+{
+    query_metrics* p_metrics;
+
+    if (shard_count == 0)
+    {
+        return NULL;
+    }
+
+    p_metrics = allocator_malloc(sizeof(*p_metrics));
+
+    if (!p_metrics)
+    {
+        return NULL;
+    }
+
+    p_metrics->shards = allocator_calloc(shard_count,
+                                         sizeof(query_metrics_shard));
+
+    if (!p_metrics->shards)
+    {
+        allocator_free(p_metrics);
+        return NULL;
+    }
+
+    p_metrics->shard_count = shard_count;
+    return p_metrics;
+}
+
+void query_metrics_free(query_metrics* p_metrics)
+{
+    if (!p_metrics)
+    {
+        return;
+    }
+
+    allocator_free(p_metrics->shards);
+    allocator_free(p_metrics);
+}
+
+query_metrics_shard* query_metrics_get_shard(query_metrics* p_metrics,
+                                             size_t shard_index)
+{
+    return shard_index < p_metrics->shard_count ?
+           &p_metrics->shards[shard_index] :
+           NULL;
+}
+
+/*******************************************************************************
+* Counts one query. Must only be called by the thread owning 'p_shard'.       *
+*******************************************************************************/
+void query_metrics_record(query_metrics_shard* p_shard,
+                          double seconds,
+                          int return_status)
+{
+    query_metrics_snapshot* p_counters = &p_shard->counters;
+    size_t* p_bucket = &p_counters->counts[bucket_index(seconds * 1e9)];
+    size_t* p_status = &p_counters->status_counts[status_index(return_status)];
+    double sum_seconds = p_counters->sum_seconds + seconds;
+
+    STORE_COUNT(p_bucket, *p_bucket + 1);
+    STORE_COUNT(p_status, *p_status + 1);
+    STORE_COUNT(&p_counters->count, p_counters->count + 1);
+    STORE_SECONDS(&p_counters->sum_seconds, &sum_seconds);
+
+    if (seconds > p_counters->max_seconds)
+    {
+        STORE_SECONDS(&p_counters->max_seconds, &seconds);
+    }
+}
+
+void query_metrics_snapshot_init(query_metrics_snapshot* p_snapshot)
+{
+    memset(p_snapshot, 0, sizeof(*p_snapshot));
+}
+
+/*******************************************************************************
+* Sums the shards into '*p_snapshot'. Queries recorded while the snapshot is  *
+* being taken may be counted in some fields and not yet in others.            *
+*******************************************************************************/
+void query_metrics_snapshot_take(query_metrics* p_metrics,
+                                 query_metrics_snapshot* p_snapshot)
+{
+    query_metrics_snapshot* p_counters;
+    double seconds;
+    size_t shard;
+    size_t i;
+
+    query_metrics_snapshot_init(p_snapshot);
+
+    for (shard = 0; shard < p_metrics->shard_count; ++shard)
+    {
+        p_counters = &p_metrics->shards[shard].counters;
+
+        for (i = 0; i < QUERY_METRICS_BUCKETS; ++i)
+        {
+            p_snapshot->counts[i] += LOAD_COUNT(&p_counters->counts[i]);
+        }
+
+        for (i = 0; i < QUERY_METRICS_STATUSES; ++i)
+        {
+            p_snapshot->status_counts[i] +=
+                    LOAD_COUNT(&p_counters->status_counts[i]);
+        }
+
+        p_snapshot->count += LOAD_COUNT(&p_counters->count);
+        LOAD_SECONDS(&p_counters->sum_seconds, &seconds);
+        p_snapshot->sum_seconds += seconds;
+        LOAD_SECONDS(&p_counters->max_seconds, &seconds);
+
+        if (seconds > p_snapshot->max_seconds)
+        {
+            p_snapshot->max_seconds = seconds;
+        }
+    }
+}
+
+/*******************************************************************************
+* Adds '*p_other' to '*p_snapshot', for example to combine the metrics of     *
+* several graphs or processes.                                                *
+*******************************************************************************/
+void query_metrics_snapshot_merge(query_metrics_snapshot* p_snapshot,
+                                  const query_metrics_snapshot* p_other)
+{
+    size_t i;
+
+    for (i = 0; i < QUERY_METRICS_BUCKETS; ++i)
+    {
+        p_snapshot->counts[i] += p_other->counts[i];
+    }
+
+    for (i = 0; i < QUERY_METRICS_STATUSES; ++i)
+    {
+        p_snapshot->status_counts[i] += p_other->status_counts[i];
+    }
+
+    p_snapshot->count += p_other->count;
+    p_snapshot->sum_seconds += p_other->sum_seconds;
+
+    if (p_other->max_seconds > p_snapshot->max_seconds)
+    {
+        p_snapshot->max_seconds = p_other->max_seconds;
+    }
+}
+
+/*******************************************************************************
+* Returns the latency in seconds below which 'fraction' of the queries fall,  *
+* rounded up to the bucket boundary, or 0 if there are no queries.            *
+*******************************************************************************/
+double query_metrics_snapshot_percentile(
+        const query_metrics_snapshot* p_snapshot,
+        double fraction)
+{
+    size_t total = 0;
+    size_t seen = 0;
+    size_t i;
+    double rank;
+    double bound;
+
+    for (i = 0; i < QUERY_METRICS_BUCKETS; ++i)
+    {
+        total += p_snapshot->counts[i];
+    }
+
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    rank = fraction * (double) total;
+
+    for (i = 0; i < QUERY_METRICS_BUCKETS; ++i)
+    {
+        seen += p_snapshot->counts[i];
+
+        if (seen > 0 && (double) seen >= rank)
+        {
+            break;
+        }
+    }
+
+    if (i == QUERY_METRICS_BUCKETS)
+    {
+        i = QUERY_METRICS_BUCKETS - 1;
+    }
+
+    bound = bucket_upper_bound(i);
+    return bound < p_snapshot->max_seconds ? bound : p_snapshot->max_seconds;
+}
+
+const char* query_metrics_status_name(size_t status_index)
+{
+    return status_index < QUERY_METRICS_STATUSES ?
+           STATUS_NAMES[status_index] :
+           NULL;
+}
+
+/*******************************************************************************
+* Writes the snapshot in the Prometheus text exposition format:               *
+*                                                                             *
+*     <prefix>_queries_total{status="..."}         counter                    *
+*     <prefix>_query_duration_seconds              histogram                  *
+*     <prefix>_query_duration_quantile_seconds     gauge per quantile         *
+*                                                                             *
+* The histogram buckets are the HDR buckets folded into fixed bounds; a       *
+* bucket straddling a bound is counted in the next bound. Returns             *
+* RETURN_STATUS_IO_ERROR if the stream reports an error.                      *
+*******************************************************************************/
+int query_metrics_write_prometheus(const query_metrics_snapshot* p_snapshot,
+                                   const char* prefix,
+                                   FILE* p_file)
+{
+    size_t cumulative = 0;
+    size_t total = 0;
+    size_t bucket = 0;
+    size_t i;
+
+    /* Count from the buckets so that "+Inf" matches the last bucket: */
+    for (i = 0; i < QUERY_METRICS_BUCKETS; ++i)
+    {
+        total += p_snapshot->counts[i];
+    }
+
+    fprintf(p_file,
+            "# HELP %s_queries_total Shortest path queries by status.\n"
+            "# TYPE %s_queries_total counter\n",
+            prefix,
+            prefix);
+
+    for (i = 0; i < QUERY_METRICS_STATUSES; ++i)
+    {
+        fprintf(p_file,
+                "%s_queries_total{status=\"%s\"} %lu\n",
+                prefix,
+                STATUS_NAMES[i],
+                (unsigned long) p_snapshot->status_counts[i]);
+    }
+
+    fprintf(p_file,
+            "# HELP %s_query_duration_seconds Shortest path query latency.\n"
+            "# TYPE %s_query_duration_seconds histogram\n",
+            prefix,
+            prefix);
+
+    for (i = 0; i < PROMETHEUS_BOUND_COUNT; ++i)
+    {
+        while (bucket < QUERY_METRICS_BUCKETS &&
+               bucket_upper_bound(bucket) <= PROMETHEUS_BOUNDS[i])
+        {
+            cumulative += p_snapshot->counts[bucket++];
+        }
+
+        fprintf(p_file,
+                "%s_query_duration_seconds_bucket{le=\"%g\"} %lu\n",
+                prefix,
+                PROMETHEUS_BOUNDS[i],
+                (unsigned long) cumulative);
+    }
+
+    fprintf(p_file,
+            "%s_query_duration_seconds_bucket{le=\"+Inf\"} %lu\n"
+            "%s_query_duration_seconds_sum %.9g\n"
+            "%s_query_duration_seconds_count %lu\n",
+            prefix,
+            (unsigned long) total,
+            prefix,
+            p_snapshot->sum_seconds,
+            prefix,
+            (unsigned long) total);
+
+    fprintf(p_file,
+            "# HELP %s_query_duration_quantile_seconds "
+            "Shortest path query latency quantiles.\n"
+            "# TYPE %s_query_duration_quantile_seconds gauge\n",
+            prefix,
+            prefix);
+
+    for (i = 0; i < PROMETHEUS_QUANTILE_COUNT; ++i)
+    {
+        fprintf(p_file,
+                "%s_query_duration_quantile_seconds{quantile=\"%g\"} %.9g\n",
+                prefix,
+                PROMETHEUS_QUANTILES[i],
+                query_metrics_snapshot_percentile(p_snapshot,
+                                                  PROMETHEUS_QUANTILES[i]));
+    }
+
+    return ferror(p_file) ? RETURN_STATUS_IO_ERROR : RETURN_STATUS_OK;
+}
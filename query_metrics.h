@@ -0,0 +1,70 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_METRICS_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_METRICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* The latency histogram is log-linear like HdrHistogram: latencies below 64   *
+* ns have a bucket per nanosecond, and every power of two above that is split  *
+* into 32 buckets, so a bucket is never wider than 1/32 of its values. The    *
+* last bucket also takes everything from 2^42 ns (about 73 minutes) up.       *
+*******************************************************************************/
+#define QUERY_METRICS_BUCKETS 1216
+
+/* Queries are counted by status; see query_metrics_status_name(): */
+#define QUERY_METRICS_STATUSES 11
+
+typedef struct query_metrics_snapshot {
+    size_t counts[QUERY_METRICS_BUCKETS];
+    size_t status_counts[QUERY_METRICS_STATUSES];
+    size_t count;
+    double sum_seconds;
+    double max_seconds;
+} query_metrics_snapshot;
+
+/*******************************************************************************
+* The counters of one thread. Only the owning thread records into a shard,    *
+* so recording takes no locks and no atomic read-modify-write instructions;   *
+* snapshots read the shards concurrently.                                     *
+*******************************************************************************/
+typedef struct query_metrics_shard {
+    query_metrics_snapshot counters;
+    char                   padding[64]; /* Against false sharing. */
+} query_metrics_shard;
+
+typedef struct query_metrics {
+    query_metrics_shard* shards;
+    size_t               shard_count;
+} query_metrics;
+
+query_metrics* query_metrics_alloc(size_t shard_count);
+
+void query_metrics_free(query_metrics* p_metrics);
+
+query_metrics_shard* query_metrics_get_shard(query_metrics* p_metrics,
+                                             size_t shard_index);
+
+void query_metrics_record(query_metrics_shard* p_shard,
+                          double seconds,
+                          int return_status);
+
+void query_metrics_snapshot_init(query_metrics_snapshot* p_snapshot);
+
+void query_metrics_snapshot_take(query_metrics* p_metrics,
+                                 query_metrics_snapshot* p_snapshot);
+
+void query_metrics_snapshot_merge(query_metrics_snapshot* p_snapshot,
+                                  const query_metrics_snapshot* p_other);
+
+double query_metrics_snapshot_percentile(
+        const query_metrics_snapshot* p_snapshot,
+        double fraction);
+
+const char* query_metrics_status_name(size_t status_index);
+
+int query_metrics_write_prometheus(const query_metrics_snapshot* p_snapshot,
+                                   const char* prefix,
+                                   FILE* p_file);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_METRICS_H */
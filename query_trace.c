@@ -0,0 +1,204 @@
+#include "query_trace.h"
+#include "allocator.h"
+#include "monotonic_clock.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const size_t INITIAL_CAPACITY = 256;
+
+/* The search finishes a batch of expansions after this many vertices: */
+static const size_t DEFAULT_BATCH_SIZE = 64;
+
+query_trace* query_trace_alloc(size_t batch_size, size_t max_events)
+{
+    query_trace* p_trace = allocator_malloc(sizeof(*p_trace));
+
+    if (!p_trace)
+    {
+        return NULL;
+    }
+
+    p_trace->events = NULL;
+    p_trace->size = 0;
+    p_trace->capacity = 0;
+    p_trace->max_events = max_events;
+    p_trace->dropped = 0;
+    p_trace->batch_size = batch_size ? batch_size : DEFAULT_BATCH_SIZE;
+    p_trace->origin = monotonic_clock_seconds();
+    p_trace->thread_id = 0;
+    return p_trace;
+}
+
+void query_trace_free(query_trace* p_trace)
+{
+    if (!p_trace)
+    {
+        return;
+    }
+
+    allocator_free(p_trace->events);
+    allocator_free(p_trace);
+}
+
+void query_trace_clear(query_trace* p_trace)
+{
+    p_trace->size = 0;
+    p_trace->dropped = 0;
+}
+
+static query_trace_event* add_event(query_trace* p_trace,
+                                    const char* name,
+                                    char phase,
+                                    double start,
+                                    double duration)
+{
+    query_trace_event* p_event;
+    query_trace_event* p_events;
+    size_t capacity;
+
+    if (p_trace->max_events && p_trace->size == p_trace->max_events)
+    {
+        ++p_trace->dropped;
+        return NULL;
+    }
+
+    if (p_trace->size == p_trace->capacity)
+    {
+        capacity = p_trace->capacity ?
+                   2 * p_trace->capacity :
+                   INITIAL_CAPACITY;
+
+        p_events = allocator_realloc(p_trace->events,
+                                     capacity * sizeof(query_trace_event));
+
+        if (!p_events)
+        {
+            ++p_trace->dropped;
+            return NULL;
+        }
+
+        p_trace->events = p_events;
+        p_trace->capacity = capacity;
+    }
+
+    p_event = &p_trace->events[p_trace->size++];
+    p_event->name = name;
+    p_event->phase = phase;
+    p_event->start = start;
+    p_event->duration = duration;
+    p_event->arg_count = 0;
+    return p_event;
+}
+
+query_trace_event* query_trace_span(query_trace* p_trace,
+                                    const char* name,
+                                    double start,
+                                    double end)
+{
+    return add_event(p_trace, name, 'X', start, end - start);
+}
+
+query_trace_event* query_trace_instant(query_trace* p_trace,
+                                       const char* name,
+                                       double time)
+{
+    return add_event(p_trace, name, 'i', time, 0.0);
+}
+
+query_trace_event* query_trace_counter(query_trace* p_trace,
+                                       const char* name,
+                                       double time)
+{
+    return add_event(p_trace, name, 'C', time, 0.0);
+}
+
+void query_trace_event_arg(query_trace_event* p_event,
+                           const char* name,
+                           double value)
+{
+    if (!p_event || p_event->arg_count == QUERY_TRACE_ARGS)
+    {
+        return;
+    }
+
+    p_event->arg_names[p_event->arg_count] = name;
+    p_event->arg_values[p_event->arg_count] = value;
+    ++p_event->arg_count;
+}
+
+static void write_event(const query_trace* p_trace,
+                        const query_trace_event* p_event,
+                        FILE* p_file)
+{
+    size_t i;
+
+    /* The format counts time in microseconds: */
+    fprintf(p_file,
+            ",\n{\"name\":\"%s\",\"cat\":\"search\",\"ph\":\"%c\","
+            "\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+            p_event->name,
+            p_event->phase,
+            (p_event->start - p_trace->origin) * 1e6,
+            p_trace->thread_id);
+
+    if (p_event->phase == 'X')
+    {
+        fprintf(p_file, ",\"dur\":%.3f", p_event->duration * 1e6);
+    }
+    else if (p_event->phase == 'i')
+    {
+        fputs(",\"s\":\"t\"", p_file);
+    }
+
+    fputs(",\"args\":{", p_file);
+
+    for (i = 0; i < p_event->arg_count; ++i)
+    {
+        fprintf(p_file,
+                "%s\"%s\":%.15g",
+                i ? "," : "",
+                p_event->arg_names[i],
+                p_event->arg_values[i]);
+    }
+
+    fputs("}}", p_file);
+}
+
+int query_trace_write_chrome(query_trace* const* traces,
+                             size_t trace_count,
+                             FILE* p_file)
+{
+    size_t dropped = 0;
+    size_t i;
+    size_t j;
+
+    /* The metadata event goes first so that the others can lead with ','. */
+    fputs("{\"traceEvents\":[\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+          "\"args\":{\"name\":\"shortest path queries\"}}",
+          p_file);
+
+    for (i = 0; i < trace_count; ++i)
+    {
+        fprintf(p_file,
+                ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"name\":\"query thread %d\"}}",
+                traces[i]->thread_id,
+                traces[i]->thread_id);
+
+        for (j = 0; j < traces[i]->size; ++j)
+        {
+            write_event(traces[i], &traces[i]->events[j], p_file);
+        }
+
+        dropped += traces[i]->dropped;
+    }
+
+    fprintf(p_file,
+            "\n],\"displayTimeUnit\":\"ns\","
+            "\"otherData\":{\"dropped_events\":\"%lu\"}}\n",
+            (unsigned long) dropped);
+
+    return ferror(p_file) ? RETURN_STATUS_IO_ERROR : RETURN_STATUS_OK;
+}
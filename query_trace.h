@@ -0,0 +1,78 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_TRACE_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The most arguments an event carries: */
+#define QUERY_TRACE_ARGS 5
+
+/*******************************************************************************
+* One event of the Chrome trace event format: a span ('X') that lasts         *
+* 'duration' seconds, an instant ('i') or a counter sample ('C'). Times are   *
+* in monotonic_clock_seconds(). Names must outlive the trace; the library     *
+* only uses string literals.                                                  *
+*******************************************************************************/
+typedef struct query_trace_event {
+    const char* name;
+    char        phase;
+    double      start;
+    double      duration;
+    size_t      arg_count;
+    const char* arg_names[QUERY_TRACE_ARGS];
+    double      arg_values[QUERY_TRACE_ARGS];
+} query_trace_event;
+
+/*******************************************************************************
+* The timeline of the queries of one thread. A search given a trace in its    *
+* options records the whole query and, for the bidirectional search, the      *
+* setup, every 'batch_size' settled vertices, the meeting point updates, the  *
+* termination, the traceback and the cleanup. Once 'max_events' events are    *
+* held, further events are counted in 'dropped' instead.                      *
+*******************************************************************************/
+typedef struct query_trace {
+    query_trace_event* events;
+    size_t             size;
+    size_t             capacity;
+    size_t             max_events;  /* 0 for no limit. */
+    size_t             dropped;
+    size_t             batch_size;
+    double             origin;      /* The time shown as zero. */
+    int                thread_id;
+} query_trace;
+
+query_trace* query_trace_alloc(size_t batch_size, size_t max_events);
+
+void query_trace_free(query_trace* p_trace);
+
+void query_trace_clear(query_trace* p_trace);
+
+/* The event adders return NULL if the event was dropped: */
+query_trace_event* query_trace_span(query_trace* p_trace,
+                                    const char* name,
+                                    double start,
+                                    double end);
+
+query_trace_event* query_trace_instant(query_trace* p_trace,
+                                       const char* name,
+                                       double time);
+
+query_trace_event* query_trace_counter(query_trace* p_trace,
+                                       const char* name,
+                                       double time);
+
+/* Does nothing if 'p_event' is NULL or already has QUERY_TRACE_ARGS: */
+void query_trace_event_arg(query_trace_event* p_event,
+                           const char* name,
+                           double value);
+
+/*******************************************************************************
+* Writes the traces as one Chrome trace JSON document, which chrome://tracing *
+* and the Perfetto UI load. Each trace is shown as the thread of its          *
+* 'thread_id'.                                                                *
+*******************************************************************************/
+int query_trace_write_chrome(query_trace* const* traces,
+                             size_t trace_count,
+                             FILE* p_file);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_QUERY_TRACE_H */
@@ -0,0 +1,716 @@
+#include "scc_index.h"
+#include "allocator.h"
+#include "graph.h"
+#include "graph_vertex_map.h"
+#include "util.h"
+#include <stdlib.h>
+
+#define NO_VERTEX ((size_t) -1)
+#define UNVISITED ((size_t) -1)
+
+/* The state of one vertex on the explicit depth-first search stack: */
+typedef struct tarjan_frame {
+    size_t            vertex_index;
+    graph_edge_cursor cursor;
+} tarjan_frame;
+
+typedef struct dag_edge {
+    size_t tail;
+    size_t head;
+} dag_edge;
+
+static int compare_vertex_ids(const void* p_a, const void* p_b)
+{
+    vertex_id_t a = *(const vertex_id_t*) p_a;
+    vertex_id_t b = *(const vertex_id_t*) p_b;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int compare_dag_edges(const void* p_a, const void* p_b)
+{
+    const dag_edge* p_edge_a = p_a;
+    const dag_edge* p_edge_b = p_b;
+
+    if (p_edge_a->tail != p_edge_b->tail)
+    {
+        return p_edge_a->tail < p_edge_b->tail ? -1 : 1;
+    }
+
+    if (p_edge_a->head != p_edge_b->head)
+    {
+        return p_edge_a->head < p_edge_b->head ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static size_t find_vertex(scc_index* p_index, vertex_id_t vertex_id)
+{
+    size_t low = 0;
+    size_t high = p_index->vertex_count;
+    size_t middle;
+
+    if (!p_index->vertex_ids)
+    {
+        return vertex_id < p_index->vertex_count ?
+               (size_t) vertex_id :
+               NO_VERTEX;
+    }
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+
+        if (p_index->vertex_ids[middle] < vertex_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low < p_index->vertex_count &&
+           p_index->vertex_ids[low] == vertex_id ?
+           low :
+           NO_VERTEX;
+}
+
+static vertex_id_t get_vertex_id(scc_index* p_index, size_t index)
+{
+    return p_index->vertex_ids ?
+           p_index->vertex_ids[index] :
+           (vertex_id_t) index;
+}
+
+/*******************************************************************************
+* Assigns each vertex of the graph an index into the sorted ID array. Keeps   *
+* no array at all if the IDs are 0, 1, ..., n - 1.                            *
+*******************************************************************************/
+static int collect_vertex_ids(scc_index* p_index, Graph* p_graph)
+{
+    compressed_graph* p_compressed = p_graph->p_compressed;
+    graph_vertex_map_entry* p_entry;
+    size_t i;
+
+    if (p_compressed)
+    {
+        p_index->vertex_count = p_compressed->vertex_count;
+
+        if (!p_compressed->vertex_ids)
+        {
+            return RETURN_STATUS_OK;
+        }
+
+        p_index->vertex_ids =
+                allocator_malloc(sizeof(vertex_id_t) *
+                                 (p_index->vertex_count + 1));
+
+        if (!p_index->vertex_ids)
+        {
+            return RETURN_STATUS_NO_MEMORY;
+        }
+
+        for (i = 0; i < p_index->vertex_count; ++i)
+        {
+            p_index->vertex_ids[i] = p_compressed->vertex_ids[i];
+        }
+
+        return RETURN_STATUS_OK;
+    }
+
+    p_index->vertex_count = p_graph->p_nodes->size;
+    p_index->vertex_ids = allocator_malloc(sizeof(vertex_id_t) *
+                                           (p_index->vertex_count + 1));
+
+    if (!p_index->vertex_ids)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    i = 0;
+
+    for (p_entry = p_graph->p_nodes->head; p_entry; p_entry = p_entry->next)
+    {
+        p_index->vertex_ids[i++] = p_entry->vertex_id;
+    }
+
+    qsort(p_index->vertex_ids,
+          p_index->vertex_count,
+          sizeof(vertex_id_t),
+          compare_vertex_ids);
+
+    for (i = 0; i < p_index->vertex_count; ++i)
+    {
+        if (p_index->vertex_ids[i] != i)
+        {
+            return RETURN_STATUS_OK;
+        }
+    }
+
+    allocator_free(p_index->vertex_ids);
+    p_index->vertex_ids = NULL;
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Tarjan's algorithm with an explicit stack, so that long paths do not        *
+* overflow the call stack. A visited vertex without a component is exactly a  *
+* vertex on the component stack.                                              *
+*******************************************************************************/
+static int find_components(scc_index* p_index, Graph* p_graph)
+{
+    size_t n = p_index->vertex_count;
+    size_t* dfs_numbers = allocator_malloc(sizeof(size_t) * (n + 1));
+    size_t* lowlinks = allocator_malloc(sizeof(size_t) * (n + 1));
+    size_t* stack = allocator_malloc(sizeof(size_t) * (n + 1));
+    tarjan_frame* frames = allocator_malloc(sizeof(tarjan_frame) * (n + 1));
+    size_t stack_size = 0;
+    size_t depth;
+    size_t counter = 0;
+    size_t root;
+    size_t vertex_index;
+    size_t child_index;
+    size_t popped;
+    vertex_id_t child_vertex_id;
+    weight_t weight;
+    tarjan_frame* p_frame;
+
+    if (!dfs_numbers || !lowlinks || !stack || !frames)
+    {
+        allocator_free(dfs_numbers);
+        allocator_free(lowlinks);
+        allocator_free(stack);
+        allocator_free(frames);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (root = 0; root < n; ++root)
+    {
+        dfs_numbers[root] = UNVISITED;
+        p_index->components[root] = SCC_INDEX_NO_COMPONENT;
+    }
+
+    for (root = 0; root < n; ++root)
+    {
+        if (dfs_numbers[root] != UNVISITED)
+        {
+            continue;
+        }
+
+        dfs_numbers[root] = lowlinks[root] = counter++;
+        stack[stack_size++] = root;
+        frames[0].vertex_index = root;
+        graph_children_cursor(p_graph,
+                              get_vertex_id(p_index, root),
+                              &frames[0].cursor);
+        depth = 1;
+
+        while (depth > 0)
+        {
+            p_frame = &frames[depth - 1];
+            vertex_index = p_frame->vertex_index;
+
+            if (graph_edge_cursor_next(&p_frame->cursor,
+                                       &child_vertex_id,
+                                       &weight))
+            {
+                child_index = find_vertex(p_index, child_vertex_id);
+
+                if (dfs_numbers[child_index] == UNVISITED)
+                {
+                    dfs_numbers[child_index] = counter;
+                    lowlinks[child_index] = counter++;
+                    stack[stack_size++] = child_index;
+                    frames[depth].vertex_index = child_index;
+                    graph_children_cursor(p_graph,
+                                          child_vertex_id,
+                                          &frames[depth].cursor);
+                    ++depth;
+                }
+                else if (p_index->components[child_index] ==
+                         SCC_INDEX_NO_COMPONENT &&
+                         lowlinks[vertex_index] > dfs_numbers[child_index])
+                {
+                    lowlinks[vertex_index] = dfs_numbers[child_index];
+                }
+
+                continue;
+            }
+
+            /* All children done; 'vertex_index' may root a component: */
+            if (lowlinks[vertex_index] == dfs_numbers[vertex_index])
+            {
+                do
+                {
+                    popped = stack[--stack_size];
+                    p_index->components[popped] = p_index->component_count;
+                }
+                while (popped != vertex_index);
+
+                ++p_index->component_count;
+            }
+
+            if (--depth > 0 &&
+                lowlinks[frames[depth - 1].vertex_index] >
+                lowlinks[vertex_index])
+            {
+                lowlinks[frames[depth - 1].vertex_index] =
+                        lowlinks[vertex_index];
+            }
+        }
+    }
+
+    allocator_free(dfs_numbers);
+    allocator_free(lowlinks);
+    allocator_free(stack);
+    allocator_free(frames);
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Collects the edges between different components, drops the duplicates and   *
+* stores the rest as the condensation DAG.                                    *
+*******************************************************************************/
+static int build_condensation(scc_index* p_index, Graph* p_graph)
+{
+    graph_edge_cursor cursor;
+    vertex_id_t child_vertex_id;
+    weight_t weight;
+    dag_edge* edges;
+    size_t edge_count = 0;
+    size_t unique_count = 0;
+    size_t tail_component;
+    size_t head_component;
+    size_t i;
+    size_t pass;
+
+    edges = NULL;
+
+    /* The first pass counts the edges, the second one stores them: */
+    for (pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            edges = allocator_malloc(sizeof(dag_edge) * (edge_count + 1));
+
+            if (!edges)
+            {
+                return RETURN_STATUS_NO_MEMORY;
+            }
+
+            edge_count = 0;
+        }
+
+        for (i = 0; i < p_index->vertex_count; ++i)
+        {
+            tail_component = p_index->components[i];
+            graph_children_cursor(p_graph,
+                                  get_vertex_id(p_index, i),
+                                  &cursor);
+
+            while (graph_edge_cursor_next(&cursor, &child_vertex_id, &weight))
+            {
+                head_component =
+                        p_index->components[find_vertex(p_index,
+                                                        child_vertex_id)];
+
+                if (head_component == tail_component)
+                {
+                    continue;
+                }
+
+                if (edges)
+                {
+                    edges[edge_count].tail = tail_component;
+                    edges[edge_count].head = head_component;
+                }
+
+                ++edge_count;
+            }
+        }
+    }
+
+    qsort(edges, edge_count, sizeof(dag_edge), compare_dag_edges);
+
+    for (i = 0; i < edge_count; ++i)
+    {
+        if (unique_count == 0 ||
+            compare_dag_edges(&edges[unique_count - 1], &edges[i]) != 0)
+        {
+            edges[unique_count++] = edges[i];
+        }
+    }
+
+    p_index->dag_edge_count = unique_count;
+    p_index->dag_offsets =
+            allocator_calloc(p_index->component_count + 1, sizeof(size_t));
+    p_index->dag_heads = allocator_malloc(sizeof(size_t) * (unique_count + 1));
+
+    if (!p_index->dag_offsets || !p_index->dag_heads)
+    {
+        allocator_free(edges);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < unique_count; ++i)
+    {
+        ++p_index->dag_offsets[edges[i].tail + 1];
+        p_index->dag_heads[i] = edges[i].head;
+    }
+
+    for (i = 0; i < p_index->component_count; ++i)
+    {
+        p_index->dag_offsets[i + 1] += p_index->dag_offsets[i];
+    }
+
+    allocator_free(edges);
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Numbers the components in the post-order of a depth-first traversal of the  *
+* DAG, stores the numbers as the ranks of the label 'k' and derives the lows. *
+* Odd labels visit roots and successors in reverse so that the labels differ. *
+*******************************************************************************/
+static void build_label(scc_index* p_index,
+                        size_t k,
+                        size_t* stack,
+                        size_t* next_edges)
+{
+    size_t component_count = p_index->component_count;
+    size_t* ranks = p_index->label_ranks;
+    size_t* lows = p_index->label_lows;
+    size_t counter = 0;
+    size_t stack_size;
+    size_t root;
+    size_t component;
+    size_t successor;
+    size_t edge_index;
+    size_t i;
+
+    for (i = 0; i < component_count; ++i)
+    {
+        ranks[i * SCC_INDEX_LABELS + k] = UNVISITED;
+        next_edges[i] = 0;
+    }
+
+    for (i = 0; i < component_count; ++i)
+    {
+        root = k % 2 ? i : component_count - 1 - i;
+
+        if (ranks[root * SCC_INDEX_LABELS + k] != UNVISITED)
+        {
+            continue;
+        }
+
+        /* Mark as entered; the final rank is assigned on the way out: */
+        ranks[root * SCC_INDEX_LABELS + k] = 0;
+        stack[0] = root;
+        stack_size = 1;
+
+        while (stack_size > 0)
+        {
+            component = stack[stack_size - 1];
+
+            if (next_edges[component] < p_index->dag_offsets[component + 1] -
+                                         p_index->dag_offsets[component])
+            {
+                edge_index = k % 2 ?
+                             p_index->dag_offsets[component + 1] - 1 -
+                             next_edges[component] :
+                             p_index->dag_offsets[component] +
+                             next_edges[component];
+
+                ++next_edges[component];
+                successor = p_index->dag_heads[edge_index];
+
+                if (ranks[successor * SCC_INDEX_LABELS + k] == UNVISITED)
+                {
+                    ranks[successor * SCC_INDEX_LABELS + k] = 0;
+                    stack[stack_size++] = successor;
+                }
+
+                continue;
+            }
+
+            ranks[component * SCC_INDEX_LABELS + k] = counter++;
+            --stack_size;
+        }
+    }
+
+    /* Successors have lower numbers, so their lows are already known: */
+    for (component = 0; component < component_count; ++component)
+    {
+        lows[component * SCC_INDEX_LABELS + k] =
+                ranks[component * SCC_INDEX_LABELS + k];
+
+        for (edge_index = p_index->dag_offsets[component];
+             edge_index < p_index->dag_offsets[component + 1];
+             ++edge_index)
+        {
+            successor = p_index->dag_heads[edge_index];
+
+            if (lows[component * SCC_INDEX_LABELS + k] >
+                lows[successor * SCC_INDEX_LABELS + k])
+            {
+                lows[component * SCC_INDEX_LABELS + k] =
+                        lows[successor * SCC_INDEX_LABELS + k];
+            }
+        }
+    }
+}
+
+static int build_labels(scc_index* p_index)
+{
+    size_t component_count = p_index->component_count;
+    size_t* stack = allocator_malloc(sizeof(size_t) * (component_count + 1));
+    size_t* next_edges =
+            allocator_malloc(sizeof(size_t) * (component_count + 1));
+    size_t k;
+
+    p_index->label_ranks =
+            allocator_malloc(sizeof(size_t) *
+                             (component_count * SCC_INDEX_LABELS + 1));
+    p_index->label_lows =
+            allocator_malloc(sizeof(size_t) *
+                             (component_count * SCC_INDEX_LABELS + 1));
+
+    if (!stack || !next_edges ||
+        !p_index->label_ranks || !p_index->label_lows)
+    {
+        allocator_free(stack);
+        allocator_free(next_edges);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (k = 0; k < SCC_INDEX_LABELS; ++k)
+    {
+        build_label(p_index, k, stack, next_edges);
+    }
+
+    allocator_free(stack);
+    allocator_free(next_edges);
+    return RETURN_STATUS_OK;
+}
+
+/*******************************************************************************
+* Computes the components of 'p_graph' in O(V + E) time. The index describes  *
+* the graph as it is now; it does not follow later changes to the topology.   *
+*******************************************************************************/
+scc_index* scc_index_alloc(Graph* p_graph)
+{
+    scc_index* p_index;
+
+    if (!p_graph || (!p_graph->p_nodes && !p_graph->p_compressed))
+    {
+        return NULL;
+    }
+
+    p_index = allocator_calloc(1, sizeof(*p_index));
+
+    if (!p_index)
+    {
+        return NULL;
+    }
+
+    p_index->mod_count = p_graph->mod_count;
+
+    if (collect_vertex_ids(p_index, p_graph) != RETURN_STATUS_OK)
+    {
+        scc_index_free(p_index);
+        return NULL;
+    }
+
+    p_index->components =
+            allocator_malloc(sizeof(size_t) * (p_index->vertex_count + 1));
+
+    if (!p_index->components ||
+        find_components(p_index, p_graph) != RETURN_STATUS_OK ||
+        build_condensation(p_index, p_graph) != RETURN_STATUS_OK ||
+        build_labels(p_index) != RETURN_STATUS_OK)
+    {
+        scc_index_free(p_index);
+        return NULL;
+    }
+
+    return p_index;
+}
+
+void scc_index_free(scc_index* p_index)
+{
+    if (!p_index)
+    {
+        return;
+    }
+
+    allocator_free(p_index->vertex_ids);
+    allocator_free(p_index->components);
+    allocator_free(p_index->dag_offsets);
+    allocator_free(p_index->dag_heads);
+    allocator_free(p_index->label_ranks);
+    allocator_free(p_index->label_lows);
+    allocator_free(p_index);
+}
+
+size_t scc_index_memory_usage(scc_index* p_index)
+{
+    size_t vertices = p_index->vertex_count + 1;
+    size_t components = p_index->component_count + 1;
+    size_t labels = p_index->component_count * SCC_INDEX_LABELS + 1;
+
+    return sizeof(*p_index) +
+           (p_index->vertex_ids ? sizeof(vertex_id_t) * vertices : 0) +
+           sizeof(size_t) * vertices +
+           sizeof(size_t) * components +
+           sizeof(size_t) * (p_index->dag_edge_count + 1) +
+           2 * sizeof(size_t) * labels;
+}
+
+size_t scc_index_component(scc_index* p_index, vertex_id_t vertex_id)
+{
+    size_t index = find_vertex(p_index, vertex_id);
+    return index == NO_VERTEX ? SCC_INDEX_NO_COMPONENT :
+                                p_index->components[index];
+}
+
+/*******************************************************************************
+* Returns FALSE if some label of 'target' does not nest in the label of       *
+* 'source', which proves that 'source' does not reach 'target'.               *
+*******************************************************************************/
+static int labels_nest(scc_index* p_index, size_t source, size_t target)
+{
+    size_t k;
+
+    if (source < target)
+    {
+        return FALSE;
+    }
+
+    for (k = 0; k < SCC_INDEX_LABELS; ++k)
+    {
+        if (p_index->label_lows[source * SCC_INDEX_LABELS + k] >
+            p_index->label_lows[target * SCC_INDEX_LABELS + k] ||
+            p_index->label_ranks[source * SCC_INDEX_LABELS + k] <
+            p_index->label_ranks[target * SCC_INDEX_LABELS + k])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*******************************************************************************
+* Returns FALSE if the target is certainly not reachable from the source, and *
+* TRUE if it is or might be. Runs in O(log V) time.                           *
+*******************************************************************************/
+int scc_index_may_reach(scc_index* p_index,
+                        vertex_id_t source_vertex_id,
+                        vertex_id_t target_vertex_id)
+{
+    size_t source_component = scc_index_component(p_index, source_vertex_id);
+    size_t target_component = scc_index_component(p_index, target_vertex_id);
+
+    if (source_component == SCC_INDEX_NO_COMPONENT ||
+        target_component == SCC_INDEX_NO_COMPONENT)
+    {
+        return FALSE;
+    }
+
+    return source_component == target_component ||
+           labels_nest(p_index, source_component, target_component);
+}
+
+/*******************************************************************************
+* Decides exactly whether the target is reachable from the source. The labels *
+* settle most queries; the rest fall back to a depth-first search over the    *
+* DAG that skips every component whose labels rule the target out. If the     *
+* fallback cannot allocate its stack, returns FALSE with                      *
+* RETURN_STATUS_NO_MEMORY in '*p_return_status', which is RETURN_STATUS_OK    *
+* otherwise and may be NULL.                                                  *
+*******************************************************************************/
+int scc_index_reachable(scc_index* p_index,
+                        vertex_id_t source_vertex_id,
+                        vertex_id_t target_vertex_id,
+                        int* p_return_status)
+{
+    size_t source_component;
+    size_t target_component;
+    size_t component;
+    size_t successor;
+    size_t edge_index;
+    size_t stack_size;
+    size_t* stack;
+    unsigned char* visited;
+    int found = FALSE;
+
+    if (p_return_status)
+    {
+        *p_return_status = RETURN_STATUS_OK;
+    }
+
+    if (!scc_index_may_reach(p_index, source_vertex_id, target_vertex_id))
+    {
+        return FALSE;
+    }
+
+    source_component = scc_index_component(p_index, source_vertex_id);
+    target_component = scc_index_component(p_index, target_vertex_id);
+
+    if (source_component == target_component)
+    {
+        return TRUE;
+    }
+
+    stack = allocator_malloc(sizeof(size_t) *
+                             (p_index->component_count + 1));
+    visited = allocator_calloc(p_index->component_count + 1, 1);
+
+    if (!stack || !visited)
+    {
+        allocator_free(stack);
+        allocator_free(visited);
+
+        if (p_return_status)
+        {
+            *p_return_status = RETURN_STATUS_NO_MEMORY;
+        }
+
+        return FALSE;
+    }
+
+    stack[0] = source_component;
+    stack_size = 1;
+    visited[source_component] = TRUE;
+
+    while (stack_size > 0 && !found)
+    {
+        component = stack[--stack_size];
+
+        for (edge_index = p_index->dag_offsets[component];
+             edge_index < p_index->dag_offsets[component + 1];
+             ++edge_index)
+        {
+            successor = p_index->dag_heads[edge_index];
+
+            if (successor == target_component)
+            {
+                found = TRUE;
+                break;
+            }
+
+            if (!visited[successor] &&
+                labels_nest(p_index, successor, target_component))
+            {
+                visited[successor] = TRUE;
+                stack[stack_size++] = successor;
+            }
+        }
+    }
+
+    allocator_free(stack);
+    allocator_free(visited);
+    return found;
+}
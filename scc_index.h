@@ -0,0 +1,55 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_SCC_INDEX_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_SCC_INDEX_H
+
+#include "graph.h"
+#include "util.h"
+#include <stdlib.h>
+
+#define SCC_INDEX_NO_COMPONENT ((size_t) -1)
+#define SCC_INDEX_LABELS       2
+
+/*******************************************************************************
+* The strongly connected components of a graph and its condensation DAG.      *
+* Components are numbered in reverse topological order: an edge between two   *
+* different components always goes from a higher to a lower component, so a   *
+* vertex can reach only components with a number not greater than its own.    *
+* The DAG is stored in compressed sparse row form; the successors of          *
+* component 'c' are 'dag_heads[dag_offsets[c] .. dag_offsets[c + 1])'.        *
+*                                                                             *
+* Each component also carries SCC_INDEX_LABELS GRAIL interval labels          *
+* '[label_lows[i], label_ranks[i]]', 'i = c * SCC_INDEX_LABELS + k', where    *
+* the rank is the post-order number in the k-th depth-first traversal of the  *
+* DAG and the low is the least rank below the component. If 'c' reaches 'd',  *
+* every label of 'd' nests in the matching label of 'c'.                      *
+*******************************************************************************/
+typedef struct scc_index {
+    vertex_id_t* vertex_ids;     /* Sorted, NULL if the IDs are dense. */
+    size_t*      components;     /* Component of each vertex by index. */
+    size_t*      dag_offsets;
+    size_t*      dag_heads;
+    size_t*      label_ranks;
+    size_t*      label_lows;
+    size_t       vertex_count;
+    size_t       component_count;
+    size_t       dag_edge_count;
+    size_t       mod_count;      /* 'mod_count' of the graph when built. */
+} scc_index;
+
+scc_index* scc_index_alloc(Graph* p_graph);
+
+void scc_index_free(scc_index* p_index);
+
+size_t scc_index_memory_usage(scc_index* p_index);
+
+size_t scc_index_component(scc_index* p_index, vertex_id_t vertex_id);
+
+int scc_index_may_reach(scc_index* p_index,
+                        vertex_id_t source_vertex_id,
+                        vertex_id_t target_vertex_id);
+
+int scc_index_reachable(scc_index* p_index,
+                        vertex_id_t source_vertex_id,
+                        vertex_id_t target_vertex_id,
+                        int* p_return_status);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_SCC_INDEX_H */
@@ -0,0 +1,1123 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "algorithm.h"
+#include "graph.h"
+#include "graph_generator.h"
+#include "graph_image.h"
+#include "graph_io.h"
+#include "graph_spec.h"
+#include "graph_vertex_map.h"
+#include "monotonic_clock.h"
+#include "perf_counters.h"
+#include "query_batch.h"
+#include "query_metrics.h"
+#include "query_file.h"
+#include "query_trace.h"
+#include "scc_index.h"
+#include "util.h"
+#include "vertex_list.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALGORITHM_BIDIRECTIONAL  1
+#define ALGORITHM_UNIDIRECTIONAL 2
+#define ALGORITHM_COUNT          2
+
+/* Keeps a trace of a long run at a few tens of megabytes of JSON: */
+#define TRACE_MAX_EVENTS 250000
+
+static const char* ALGORITHM_NAMES[ALGORITHM_COUNT] = {
+    "bidirectional",
+    "unidirectional"
+};
+
+typedef struct bench_config {
+    const char*   graph_file;
+    const char*   graph_spec;
+    const char*   image_file;
+    const char*   save_file;
+    unsigned long seed;
+    const char*   query_file;
+    const char*   metrics_file;
+    const char*   trace_file;
+    size_t        query_count;
+    size_t        repetitions;
+    size_t        threads;
+    int           algorithms;
+    int           batch_mode;
+    int           compress;
+    int           scc_index;
+    int           memory;
+    int           perf;
+} bench_config;
+
+/* What one thread measured for one algorithm: */
+typedef struct bench_result {
+    double* latencies;
+    size_t  latency_count;
+    size_t  ok;
+    size_t  no_path;
+    size_t  other;
+
+    /* Peak bytes of the search containers summed over the queries, -M: */
+    double  heap_bytes;
+    double  distance_bytes;
+    double  parent_bytes;
+    double  closed_bytes;
+    size_t  max_bytes;
+
+    /* Hardware counts over all the queries and what they did, -P: */
+    double  counters[PERF_COUNTERS_COUNT];
+    double  settled;
+    double  relaxed;
+} bench_result;
+
+typedef struct bench_thread {
+    pthread_t    thread;
+    Graph*       p_graph;
+    query_set*   p_queries;
+    bench_config config;
+    bench_result results[ALGORITHM_COUNT];
+
+    /* Where the library records the queries of the thread; NULL if -m */
+    /* was not given:                                                  */
+    query_metrics_shard* shards[ALGORITHM_COUNT];
+
+    /* The timeline of the queries of the thread; NULL if -x was not given: */
+    query_trace* p_trace;
+
+    /* The counters that opened, and errno if none did: */
+    int          counter_opened[PERF_COUNTERS_COUNT];
+    int          perf_error;
+} bench_thread;
+
+static const char* USAGE_LINES[] = {
+    "  -g FILE        read the graph from a DIMACS file",
+    "  -G SPEC        generate the graph; SPEC is one of",
+    "                   uniform:V,E  grid:W,H[,DROP]  rmat:SCALE,E[,A,B,C]",
+    "                   geometric:N,RADIUS  er:N,P",
+    "  -I FILE        map the graph from an image written by -o",
+    "  -o FILE        write the graph as an image once it is built",
+    "  -s SEED        seed of the generators (default 1)",
+    "  -q FILE        read the queries from FILE",
+    "  -n COUNT       random queries if there is no -q (default 1000)",
+    "  -r REPS        run the query set REPS times (default 1)",
+    "  -t THREADS     query threads (default 1)",
+    "  -a ALGORITHMS  bidir, unidir or both (default bidir)",
+    "  -B MODE        run each repetition as one batch on the threads and",
+    "                   report its makespan; MODE is static, steal or lpt,",
+    "                   which orders by the latencies of the last repetition",
+    "  -c             compress the graph before querying",
+    "  -i             build the SCC index before querying",
+    "  -M             report the peak memory of the queries by structure",
+    "  -P             count hardware events around the queries (Linux)",
+    "  -m FILE        write the library metrics in Prometheus format",
+    "  -x FILE        write a Chrome trace of the queries (chrome://tracing)",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr,
+            "usage: %s (-g FILE | -G SPEC | -I FILE) [options]\n",
+            program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static int parse_algorithms(const char* text)
+{
+    if (strcmp(text, "bidir") == 0)
+    {
+        return ALGORITHM_BIDIRECTIONAL;
+    }
+
+    if (strcmp(text, "unidir") == 0)
+    {
+        return ALGORITHM_UNIDIRECTIONAL;
+    }
+
+    if (strcmp(text, "both") == 0)
+    {
+        return ALGORITHM_BIDIRECTIONAL | ALGORITHM_UNIDIRECTIONAL;
+    }
+
+    return 0;
+}
+
+/* The flags of query_batch_run() for a -B mode, or -1: */
+static int parse_batch_mode(const char* text)
+{
+    if (strcmp(text, "static") == 0)
+    {
+        return QUERY_BATCH_STATIC;
+    }
+
+    if (strcmp(text, "steal") == 0)
+    {
+        return 0;
+    }
+
+    if (strcmp(text, "lpt") == 0)
+    {
+        return QUERY_BATCH_LONGEST_FIRST;
+    }
+
+    return -1;
+}
+
+static int parse_arguments(int argc, char** argv, bench_config* p_config)
+{
+    int i;
+
+    memset(p_config, 0, sizeof(*p_config));
+    p_config->seed = 1;
+    p_config->query_count = 1000;
+    p_config->repetitions = 1;
+    p_config->threads = 1;
+    p_config->algorithms = ALGORITHM_BIDIRECTIONAL;
+    p_config->batch_mode = -1;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'c':
+                p_config->compress = TRUE;
+                continue;
+
+            case 'i':
+                p_config->scc_index = TRUE;
+                continue;
+
+            case 'M':
+                p_config->memory = TRUE;
+                continue;
+
+            case 'P':
+                p_config->perf = TRUE;
+                continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 'g':
+                p_config->graph_file = argv[i];
+                break;
+
+            case 'G':
+                p_config->graph_spec = argv[i];
+                break;
+
+            case 'I':
+                p_config->image_file = argv[i];
+                break;
+
+            case 'o':
+                p_config->save_file = argv[i];
+                break;
+
+            case 's':
+                p_config->seed = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'm':
+                p_config->metrics_file = argv[i];
+                break;
+
+            case 'x':
+                p_config->trace_file = argv[i];
+                break;
+
+            case 'q':
+                p_config->query_file = argv[i];
+                break;
+
+            case 'n':
+                p_config->query_count = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'r':
+                p_config->repetitions = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 't':
+                p_config->threads = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'a':
+                p_config->algorithms = parse_algorithms(argv[i]);
+                break;
+
+            case 'B':
+                p_config->batch_mode = parse_batch_mode(argv[i]);
+
+                if (p_config->batch_mode < 0)
+                {
+                    return FALSE;
+                }
+
+                break;
+
+            default:
+                return FALSE;
+        }
+    }
+
+    return (p_config->graph_file != NULL) +
+           (p_config->graph_spec != NULL) +
+           (p_config->image_file != NULL) == 1 &&
+           p_config->repetitions > 0 &&
+           p_config->threads > 0 &&
+           p_config->algorithms != 0;
+}
+
+static Graph* generate_graph(const char* spec,
+                             unsigned long seed,
+                             int* p_return_status)
+{
+    graph_generator_sink sink;
+    Graph* p_graph = allocGraph();
+
+    if (!p_graph)
+    {
+        *p_return_status = RETURN_STATUS_NO_MEMORY;
+        return NULL;
+    }
+
+    graph_generator_graph_sink(p_graph, &sink);
+    *p_return_status = graph_spec_generate(spec, seed, &sink);
+
+    if (*p_return_status != RETURN_STATUS_OK)
+    {
+        freeGraph(p_graph);
+        free(p_graph);
+        return NULL;
+    }
+
+    return p_graph;
+}
+
+static size_t graph_edge_count(Graph* p_graph)
+{
+    graph_vertex_map_entry* p_entry;
+    size_t edge_count = 0;
+
+    if (p_graph->p_compressed)
+    {
+        return p_graph->p_compressed->edge_count;
+    }
+
+    for (p_entry = p_graph->p_nodes->head; p_entry; p_entry = p_entry->next)
+    {
+        edge_count += p_entry->vertex->p_children->size;
+    }
+
+    return edge_count;
+}
+
+/* Prints where the bytes of the graph go: */
+static void print_graph_memory(const graph_memory* p_memory)
+{
+    const double mib = 1024.0 * 1024.0;
+
+    printf("graph memory: vertex map %.1f MiB, vertices %.1f MiB, "
+           "adjacency tables %.1f MiB (%.1f MiB slack), "
+           "adjacency entries %.1f MiB\n",
+           (double) p_memory->vertex_map / mib,
+           (double) p_memory->vertices / mib,
+           (double) p_memory->adjacency_tables / mib,
+           (double) p_memory->adjacency_slack / mib,
+           (double) p_memory->adjacency_entries / mib);
+
+    printf("              arena %.1f MiB, compressed %.1f MiB, "
+           "SCC index %.1f MiB, shared image %.1f MiB\n",
+           (double) p_memory->arena_reserved / mib,
+           (double) p_memory->compressed / mib,
+           (double) p_memory->scc_index / mib,
+           (double) p_memory->shared / mib);
+}
+
+static void* run_queries(void* p_argument)
+{
+    bench_thread* p_thread = p_argument;
+    query_set* p_queries = p_thread->p_queries;
+    bench_result* p_result;
+    vertex_list* p_path;
+    query* p_query;
+    double start;
+    size_t repetition;
+    size_t i;
+    search_options options;
+    search_stats stats;
+    perf_counters counters;
+    int algorithm;
+    int return_status;
+
+    search_options_init(&options);
+    options.p_trace = p_thread->p_trace;
+    options.p_stats = p_thread->config.memory || p_thread->config.perf ?
+                      &stats :
+                      NULL;
+
+    if (p_thread->config.perf)
+    {
+        if (perf_counters_open(&counters) == 0)
+        {
+            p_thread->perf_error = errno;
+        }
+
+        for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+        {
+            p_thread->counter_opened[i] = counters.fds[i] >= 0;
+        }
+    }
+
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        if (!(p_thread->config.algorithms & (1 << algorithm)))
+        {
+            continue;
+        }
+
+        p_result = &p_thread->results[algorithm];
+        options.p_metrics = p_thread->shards[algorithm];
+
+        /* Counting each query alone would add syscalls to its latency: */
+        if (p_thread->config.perf)
+        {
+            perf_counters_start(&counters);
+        }
+
+        for (repetition = 0;
+             repetition < p_thread->config.repetitions;
+             ++repetition)
+        {
+            for (i = 0; i < p_queries->size; ++i)
+            {
+                p_query = &p_queries->queries[i];
+                start = monotonic_clock_seconds();
+
+                p_path = algorithm == 0 ?
+                         find_shortest_path_ex(p_thread->p_graph,
+                                               p_query->source_vertex_id,
+                                               p_query->target_vertex_id,
+                                               &options,
+                                               &return_status) :
+                         find_shortest_path_2_ex(p_thread->p_graph,
+                                                 p_query->source_vertex_id,
+                                                 p_query->target_vertex_id,
+                                                 &options,
+                                                 &return_status);
+
+                p_result->latencies[p_result->latency_count++] =
+                        monotonic_clock_seconds() - start;
+
+                if (p_path)
+                {
+                    vertex_list_free(p_path);
+                }
+
+                if (p_thread->config.perf)
+                {
+                    p_result->settled += (double)(stats.settled_forward +
+                                                  stats.settled_backward);
+                    p_result->relaxed += (double) stats.edges_relaxed;
+                }
+
+                if (p_thread->config.memory)
+                {
+                    p_result->heap_bytes += (double) stats.heap_bytes;
+                    p_result->distance_bytes += (double) stats.distance_bytes;
+                    p_result->parent_bytes += (double) stats.parent_bytes;
+                    p_result->closed_bytes += (double) stats.closed_bytes;
+
+                    if (p_result->max_bytes < stats.bytes_allocated)
+                    {
+                        p_result->max_bytes = stats.bytes_allocated;
+                    }
+                }
+
+                if (return_status == RETURN_STATUS_OK)
+                {
+                    ++p_result->ok;
+                }
+                else if (return_status == RETURN_STATUS_NO_PATH)
+                {
+                    ++p_result->no_path;
+                }
+                else
+                {
+                    ++p_result->other;
+                }
+            }
+        }
+
+        if (p_thread->config.perf)
+        {
+            perf_counters_stop(&counters, p_result->counters);
+        }
+    }
+
+    if (p_thread->config.perf)
+    {
+        perf_counters_close(&counters);
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Runs the query set as one batch per repetition and reports how close each   *
+* comes to the ideal makespan, the busy time of all workers spread evenly.    *
+* In lpt mode the latencies of a repetition are the costs of the next; the    *
+* first has no costs and runs in the order of the set.                        *
+*******************************************************************************/
+static int run_batches(Graph* p_graph,
+                       query_set* p_queries,
+                       const bench_config* p_config)
+{
+    query_batch_item* items;
+    query_batch_stats stats;
+    size_t repetition;
+    size_t i;
+    size_t ok = 0;
+    int flags = p_config->batch_mode;
+
+    if (p_config->algorithms == ALGORITHM_UNIDIRECTIONAL)
+    {
+        flags |= QUERY_BATCH_UNIDIRECTIONAL;
+    }
+
+    items = calloc(p_queries->size + 1, sizeof(query_batch_item));
+
+    if (!items)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < p_queries->size; ++i)
+    {
+        items[i].source_vertex_id = p_queries->queries[i].source_vertex_id;
+        items[i].target_vertex_id = p_queries->queries[i].target_vertex_id;
+    }
+
+    printf("%-10s %9s %10s %10s %10s %10s %8s\n",
+           "batch", "queries", "wall_s", "ideal_s", "max_busy_s",
+           "efficiency", "steals");
+
+    for (repetition = 0; repetition < p_config->repetitions; ++repetition)
+    {
+        if (query_batch_run(p_graph,
+                            items,
+                            p_queries->size,
+                            p_config->threads,
+                            flags,
+                            &stats) != RETURN_STATUS_OK)
+        {
+            free(items);
+            return FALSE;
+        }
+
+        for (i = 0; i < p_queries->size; ++i)
+        {
+            ok += items[i].return_status == RETURN_STATUS_OK;
+            items[i].cost = items[i].seconds;
+
+            if (items[i].p_path)
+            {
+                vertex_list_free(items[i].p_path);
+            }
+        }
+
+        printf("%-10lu %9lu %10.4f %10.4f %10.4f %9.1f%% %8lu\n",
+               (unsigned long) repetition + 1,
+               (unsigned long) p_queries->size,
+               stats.wall_seconds,
+               stats.total_busy_seconds / (double) stats.worker_count,
+               stats.max_busy_seconds,
+               stats.wall_seconds > 0.0 ?
+               100.0 * stats.total_busy_seconds /
+               ((double) stats.worker_count * stats.wall_seconds) :
+               100.0,
+               (unsigned long) stats.steals);
+    }
+
+    printf("ok: %lu of %lu\n",
+           (unsigned long) ok,
+           (unsigned long) (p_queries->size * p_config->repetitions));
+
+    free(items);
+    return TRUE;
+}
+
+static int compare_doubles(const void* p_a, const void* p_b)
+{
+    double a = *(const double*) p_a;
+    double b = *(const double*) p_b;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static double percentile(double* sorted, size_t count, double fraction)
+{
+    size_t index = (size_t)(fraction * (double) count);
+    return sorted[index < count ? index : count - 1];
+}
+
+/*******************************************************************************
+* Merges the latencies of every thread for 'algorithm' and prints one line.   *
+*******************************************************************************/
+static void report(bench_thread* threads,
+                   size_t thread_count,
+                   int algorithm,
+                   double wall_seconds)
+{
+    size_t total = 0;
+    size_t ok = 0;
+    size_t no_path = 0;
+    size_t other = 0;
+    size_t i;
+    double sum = 0.0;
+    double* latencies;
+    bench_result* p_result;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        total += threads[i].results[algorithm].latency_count;
+    }
+
+    if (total == 0 || !(latencies = malloc(sizeof(double) * total)))
+    {
+        return;
+    }
+
+    total = 0;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        p_result = &threads[i].results[algorithm];
+        memcpy(latencies + total,
+               p_result->latencies,
+               sizeof(double) * p_result->latency_count);
+        total += p_result->latency_count;
+        ok += p_result->ok;
+        no_path += p_result->no_path;
+        other += p_result->other;
+    }
+
+    qsort(latencies, total, sizeof(double), compare_doubles);
+
+    for (i = 0; i < total; ++i)
+    {
+        sum += latencies[i];
+    }
+
+    printf("%-15s %9lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.0f"
+           " %8lu %8lu %8lu\n",
+           ALGORITHM_NAMES[algorithm],
+           (unsigned long) total,
+           1e6 * sum / (double) total,
+           1e6 * percentile(latencies, total, 0.50),
+           1e6 * percentile(latencies, total, 0.90),
+           1e6 * percentile(latencies, total, 0.99),
+           1e6 * latencies[total - 1],
+           (double) total / wall_seconds,
+           (unsigned long) ok,
+           (unsigned long) no_path,
+           (unsigned long) other);
+
+    free(latencies);
+}
+
+/*******************************************************************************
+* Prints the peak bytes of the search containers per query, on average by     *
+* structure and at most in total.                                             *
+*******************************************************************************/
+static void report_memory(bench_thread* threads,
+                          size_t thread_count,
+                          int algorithm)
+{
+    bench_result total;
+    bench_result* p_result;
+    size_t queries = 0;
+    size_t i;
+    double kib;
+
+    memset(&total, 0, sizeof(total));
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        p_result = &threads[i].results[algorithm];
+        queries += p_result->latency_count;
+        total.heap_bytes += p_result->heap_bytes;
+        total.distance_bytes += p_result->distance_bytes;
+        total.parent_bytes += p_result->parent_bytes;
+        total.closed_bytes += p_result->closed_bytes;
+
+        if (total.max_bytes < p_result->max_bytes)
+        {
+            total.max_bytes = p_result->max_bytes;
+        }
+    }
+
+    if (queries == 0)
+    {
+        return;
+    }
+
+    kib = 1024.0 * (double) queries;
+
+    printf("%-15s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+           ALGORITHM_NAMES[algorithm],
+           (total.heap_bytes +
+            total.distance_bytes +
+            total.parent_bytes +
+            total.closed_bytes) / kib,
+           (double) total.max_bytes / 1024.0,
+           total.heap_bytes / kib,
+           total.distance_bytes / kib,
+           total.parent_bytes / kib,
+           total.closed_bytes / kib);
+}
+
+/*******************************************************************************
+* Prints the hardware counts of the queries of all threads in total, per      *
+* settled vertex and per relaxed edge. Counters that did not open in every    *
+* thread are left out.                                                        *
+*******************************************************************************/
+static void report_counters(bench_thread* threads,
+                            size_t thread_count,
+                            int algorithm)
+{
+    double counters[PERF_COUNTERS_COUNT];
+    double settled = 0.0;
+    double relaxed = 0.0;
+    bench_result* p_result;
+    size_t i;
+    size_t j;
+    int opened;
+
+    memset(counters, 0, sizeof(counters));
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        p_result = &threads[i].results[algorithm];
+        settled += p_result->settled;
+        relaxed += p_result->relaxed;
+
+        for (j = 0; j < PERF_COUNTERS_COUNT; ++j)
+        {
+            counters[j] += p_result->counters[j];
+        }
+    }
+
+    printf("\n%s: %.0f vertices settled, %.0f edges relaxed\n",
+           ALGORITHM_NAMES[algorithm],
+           settled,
+           relaxed);
+
+    printf("%-15s %16s %12s %12s\n",
+           "counter", "total", "per_settled", "per_relaxed");
+
+    for (j = 0; j < PERF_COUNTERS_COUNT; ++j)
+    {
+        opened = TRUE;
+
+        for (i = 0; i < thread_count; ++i)
+        {
+            opened = opened && threads[i].counter_opened[j];
+        }
+
+        if (!opened)
+        {
+            printf("%-15s %16s\n", perf_counters_name(j), "n/a");
+            continue;
+        }
+
+        printf("%-15s %16.0f %12.2f %12.2f\n",
+               perf_counters_name(j),
+               counters[j],
+               settled > 0.0 ? counters[j] / settled : 0.0,
+               relaxed > 0.0 ? counters[j] / relaxed : 0.0);
+    }
+
+    /* Instructions per cycle: */
+    if (threads[0].counter_opened[0] && threads[0].counter_opened[1] &&
+        counters[0] > 0.0)
+    {
+        printf("%-15s %16.2f\n", "ipc", counters[1] / counters[0]);
+    }
+}
+
+/*******************************************************************************
+* Writes what the library recorded, one metric family per algorithm.          *
+*******************************************************************************/
+static int write_metrics(const char* file_name,
+                         int algorithms,
+                         query_metrics** metrics)
+{
+    query_metrics_snapshot* p_snapshot = malloc(sizeof(*p_snapshot));
+    char prefix[64];
+    int algorithm;
+    int written = TRUE;
+    FILE* p_file = fopen(file_name, "w");
+
+    if (!p_file || !p_snapshot)
+    {
+        free(p_snapshot);
+
+        if (p_file)
+        {
+            fclose(p_file);
+        }
+
+        return FALSE;
+    }
+
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        if (algorithms & (1 << algorithm))
+        {
+            query_metrics_snapshot_take(metrics[algorithm], p_snapshot);
+            sprintf(prefix, "bidir_%s", ALGORITHM_NAMES[algorithm]);
+
+            if (query_metrics_write_prometheus(p_snapshot, prefix, p_file) !=
+                RETURN_STATUS_OK)
+            {
+                written = FALSE;
+            }
+        }
+    }
+
+    free(p_snapshot);
+    return fclose(p_file) == 0 && written;
+}
+
+/*******************************************************************************
+* Writes the timelines of all threads into one trace.                         *
+*******************************************************************************/
+static int write_trace(const char* file_name,
+                       bench_thread* threads,
+                       size_t thread_count)
+{
+    query_trace** traces = malloc(sizeof(query_trace*) * thread_count);
+    size_t dropped = 0;
+    size_t i;
+    FILE* p_file = fopen(file_name, "w");
+
+    if (!p_file || !traces)
+    {
+        free(traces);
+
+        if (p_file)
+        {
+            fclose(p_file);
+        }
+
+        return FALSE;
+    }
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        traces[i] = threads[i].p_trace;
+        dropped += traces[i]->dropped;
+    }
+
+    if (dropped)
+    {
+        fprintf(stderr,
+                "the trace is full, dropped %lu events\n",
+                (unsigned long) dropped);
+    }
+
+    query_trace_write_chrome(traces, thread_count, p_file);
+    free(traces);
+    return fclose(p_file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    bench_config config;
+    bench_thread* threads;
+    graph_memory memory;
+    Graph* p_graph;
+    query_set* p_queries;
+    double start;
+    double build_seconds;
+    double wall_seconds[ALGORITHM_COUNT];
+    query_metrics* metrics[ALGORITHM_COUNT];
+    size_t i;
+    int algorithm;
+    int return_status = RETURN_STATUS_OK;
+
+    if (!parse_arguments(argc, argv, &config))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    start = monotonic_clock_seconds();
+    if (config.graph_file)
+    {
+        p_graph = graph_io_load_dimacs(config.graph_file, &return_status);
+    }
+    else if (config.image_file)
+    {
+        p_graph = graph_image_map(config.image_file, &return_status);
+    }
+    else
+    {
+        p_graph = generate_graph(config.graph_spec,
+                                 config.seed,
+                                 &return_status);
+    }
+
+    if (!p_graph)
+    {
+        fprintf(stderr, "cannot build the graph (status %d)\n", return_status);
+        return EXIT_FAILURE;
+    }
+
+    if (config.compress && compressGraph(p_graph) != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot compress the graph\n");
+        return EXIT_FAILURE;
+    }
+
+    if (config.scc_index &&
+        graph_build_scc_index(p_graph) != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot build the SCC index\n");
+        return EXIT_FAILURE;
+    }
+
+    build_seconds = monotonic_clock_seconds() - start;
+
+    if (config.save_file &&
+        graph_image_save(p_graph, config.save_file) != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot write the image %s\n", config.save_file);
+        return EXIT_FAILURE;
+    }
+
+    p_queries = config.query_file ?
+                query_set_load(config.query_file) :
+                query_set_random(p_graph, config.query_count, config.seed);
+
+    if (!p_queries)
+    {
+        fprintf(stderr, "cannot read the queries\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("graph: %lu vertices, %lu edges, %.1f MiB, built in %.3f s\n",
+           (unsigned long)(p_graph->p_compressed ?
+                           p_graph->p_compressed->vertex_count :
+                           p_graph->p_nodes->size),
+           (unsigned long) graph_edge_count(p_graph),
+           (double) graph_memory_usage(p_graph, &memory) /
+           (1024.0 * 1024.0),
+           build_seconds);
+
+    print_graph_memory(&memory);
+
+    printf("queries: %lu x %lu repetitions x %lu threads\n",
+           (unsigned long) p_queries->size,
+           (unsigned long) config.repetitions,
+           (unsigned long) config.threads);
+
+    if (config.batch_mode >= 0)
+    {
+        if (!run_batches(p_graph, p_queries, &config))
+        {
+            fprintf(stderr, "cannot run the batches\n");
+            return EXIT_FAILURE;
+        }
+
+        query_set_free(p_queries);
+        freeGraph(p_graph);
+        free(p_graph);
+        return EXIT_SUCCESS;
+    }
+
+    threads = calloc(config.threads, sizeof(bench_thread));
+
+    if (!threads)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        metrics[algorithm] = config.metrics_file ?
+                             query_metrics_alloc(config.threads) :
+                             NULL;
+
+        if (config.metrics_file && !metrics[algorithm])
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < config.threads; ++i)
+    {
+        threads[i].p_graph = p_graph;
+        threads[i].p_queries = p_queries;
+        threads[i].config = config;
+
+        for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+        {
+            threads[i].shards[algorithm] =
+                    metrics[algorithm] ?
+                    query_metrics_get_shard(metrics[algorithm], i) :
+                    NULL;
+        }
+
+        if (config.trace_file)
+        {
+            threads[i].p_trace = query_trace_alloc(0, TRACE_MAX_EVENTS);
+
+            if (!threads[i].p_trace)
+            {
+                return EXIT_FAILURE;
+            }
+
+            /* Let all threads share the first thread's time zero: */
+            threads[i].p_trace->origin = threads[0].p_trace->origin;
+            threads[i].p_trace->thread_id = (int) i;
+        }
+
+        for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+        {
+            threads[i].results[algorithm].latencies =
+                    malloc(sizeof(double) *
+                           (p_queries->size * config.repetitions + 1));
+
+            if (!threads[i].results[algorithm].latencies)
+            {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    /* Run the algorithms one after another so they do not compete: */
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        wall_seconds[algorithm] = 0.0;
+
+        if (!(config.algorithms & (1 << algorithm)))
+        {
+            continue;
+        }
+
+        start = monotonic_clock_seconds();
+
+        for (i = 0; i < config.threads; ++i)
+        {
+            threads[i].config.algorithms = 1 << algorithm;
+            pthread_create(&threads[i].thread, NULL, run_queries, &threads[i]);
+        }
+
+        for (i = 0; i < config.threads; ++i)
+        {
+            pthread_join(threads[i].thread, NULL);
+        }
+
+        wall_seconds[algorithm] = monotonic_clock_seconds() - start;
+    }
+
+    printf("%-15s %9s %10s %10s %10s %10s %10s %10s %8s %8s %8s\n",
+           "algorithm", "queries", "mean_us", "p50_us", "p90_us", "p99_us",
+           "max_us", "qps", "ok", "no_path", "other");
+
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        if (config.algorithms & (1 << algorithm))
+        {
+            report(threads, config.threads, algorithm, wall_seconds[algorithm]);
+        }
+    }
+
+    if (config.perf && threads[0].perf_error)
+    {
+        fprintf(stderr,
+                "cannot open the hardware counters: %s\n",
+                strerror(threads[0].perf_error));
+    }
+    else if (config.perf)
+    {
+        for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+        {
+            if (config.algorithms & (1 << algorithm))
+            {
+                report_counters(threads, config.threads, algorithm);
+            }
+        }
+    }
+
+    if (config.memory)
+    {
+        printf("\n%-15s %10s %10s %10s %10s %10s %10s\n",
+               "algorithm", "mean_KiB", "max_KiB", "heap_KiB",
+               "dist_KiB", "parent_KiB", "closed_KiB");
+
+        for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+        {
+            if (config.algorithms & (1 << algorithm))
+            {
+                report_memory(threads, config.threads, algorithm);
+            }
+        }
+    }
+
+    if (config.metrics_file &&
+        !write_metrics(config.metrics_file, config.algorithms, metrics))
+    {
+        fprintf(stderr, "cannot write %s\n", config.metrics_file);
+    }
+
+    if (config.trace_file &&
+        !write_trace(config.trace_file, threads, config.threads))
+    {
+        fprintf(stderr, "cannot write %s\n", config.trace_file);
+    }
+
+    for (i = 0; i < config.threads; ++i)
+    {
+        for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+        {
+            free(threads[i].results[algorithm].latencies);
+        }
+
+        query_trace_free(threads[i].p_trace);
+    }
+
+    for (algorithm = 0; algorithm < ALGORITHM_COUNT; ++algorithm)
+    {
+        query_metrics_free(metrics[algorithm]);
+    }
+
+    free(threads);
+    query_set_free(p_queries);
+    freeGraph(p_graph);
+    free(p_graph);
+    return EXIT_SUCCESS;
+}
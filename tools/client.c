@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "monotonic_clock.h"
+#include "query_file.h"
+#include "server_protocol.h"
+#include "util.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef struct client_config {
+    const char* socket_path;
+    const char* query_file;
+    size_t      batch;
+    size_t      depth;
+    int         distance_only;
+    int         unidirectional;
+    int         quiet;
+} client_config;
+
+static const char* USAGE_LINES[] = {
+    "  -s PATH   the Unix socket of the server",
+    "  -q FILE   the queries, one \"<source> <target>\" per line",
+    "  -b PAIRS  pairs per request (default 1)",
+    "  -p DEPTH  requests sent ahead of the answers (default 16)",
+    "  -d        ask for the distances only",
+    "  -u        use the unidirectional search",
+    "  -n        print only the totals",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s -s PATH -q FILE [options]\n", program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static int parse_arguments(int argc, char** argv, client_config* p_config)
+{
+    int i;
+
+    memset(p_config, 0, sizeof(*p_config));
+    p_config->batch = 1;
+    p_config->depth = 16;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'd':
+                p_config->distance_only = TRUE;
+                continue;
+
+            case 'u':
+                p_config->unidirectional = TRUE;
+                continue;
+
+            case 'n':
+                p_config->quiet = TRUE;
+                continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 's':
+                p_config->socket_path = argv[i];
+                break;
+
+            case 'q':
+                p_config->query_file = argv[i];
+                break;
+
+            case 'b':
+                p_config->batch = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'p':
+                p_config->depth = strtoul(argv[i], NULL, 10);
+                break;
+
+            default:
+                return FALSE;
+        }
+    }
+
+    return p_config->socket_path &&
+           p_config->query_file &&
+           p_config->batch > 0 &&
+           p_config->depth > 0;
+}
+
+static int connect_to(const char* path)
+{
+    struct sockaddr_un address;
+    int server;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    server = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (server >= 0 &&
+        connect(server, (struct sockaddr*) &address, sizeof(address)) != 0)
+    {
+        close(server);
+        return -1;
+    }
+
+    return server;
+}
+
+/*******************************************************************************
+* Sends the queries from 'first' on, at most 'batch' of them, in one request  *
+* whose ID is the index of its first query.                                   *
+*******************************************************************************/
+static int send_request(int server,
+                        const client_config* p_config,
+                        const query_set* p_queries,
+                        size_t first,
+                        server_buffer* p_buffer)
+{
+    size_t count = p_queries->size - first;
+    unsigned kind = p_config->distance_only ? SERVER_KIND_DISTANCE :
+                    p_config->batch == 1    ? SERVER_KIND_SINGLE :
+                                              SERVER_KIND_BATCH;
+    size_t i;
+    int ok;
+
+    if (count > p_config->batch)
+    {
+        count = p_config->batch;
+    }
+
+    server_buffer_begin_frame(p_buffer);
+    ok = server_buffer_put_u32(p_buffer, (unsigned long) first) &&
+         server_buffer_put_u8(p_buffer, kind) &&
+         server_buffer_put_u8(p_buffer,
+                              p_config->unidirectional ?
+                              SERVER_FLAG_UNIDIRECTIONAL :
+                              0) &&
+         server_buffer_put_u16(p_buffer, 0) &&
+         server_buffer_put_u32(p_buffer, (unsigned long) count);
+
+    for (i = first; ok && i < first + count; ++i)
+    {
+        ok = server_buffer_put_u64(
+                    p_buffer,
+                    (size_t) p_queries->queries[i].source_vertex_id) &&
+             server_buffer_put_u64(
+                    p_buffer,
+                    (size_t) p_queries->queries[i].target_vertex_id);
+    }
+
+    server_buffer_end_frame(p_buffer);
+    return ok && server_write_all(server, p_buffer->bytes, p_buffer->size);
+}
+
+/*******************************************************************************
+* Prints the answers in a response body, one query per line:                  *
+* "<source> <target> <status> <distance> <vertex>...". Returns FALSE if the   *
+* body is malformed or an error.                                              *
+*******************************************************************************/
+static int print_response(const client_config* p_config,
+                          const query_set* p_queries,
+                          const server_buffer* p_body)
+{
+    const unsigned char* p_bytes = p_body->bytes;
+    const unsigned char* p_end = p_body->bytes + p_body->size;
+    const query* p_query;
+    size_t first;
+    size_t count;
+    size_t vertex_count;
+    size_t i;
+    size_t j;
+
+    if (p_body->size < SERVER_HEADER_SIZE ||
+        p_bytes[4] == SERVER_KIND_ERROR)
+    {
+        return FALSE;
+    }
+
+    first = server_get_u32(p_bytes);
+    count = server_get_u32(p_bytes + 8);
+    p_bytes += SERVER_HEADER_SIZE;
+
+    if (first > p_queries->size || count > p_queries->size - first)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if ((size_t)(p_end - p_bytes) < SERVER_RESULT_SIZE)
+        {
+            return FALSE;
+        }
+
+        vertex_count = server_get_u32(p_bytes + 12);
+
+        if ((size_t)(p_end - p_bytes - SERVER_RESULT_SIZE) / 8 <
+            vertex_count)
+        {
+            return FALSE;
+        }
+
+        if (!p_config->quiet)
+        {
+            p_query = &p_queries->queries[first + i];
+            printf("%lu %lu %lu %.15g",
+                   (unsigned long) p_query->source_vertex_id,
+                   (unsigned long) p_query->target_vertex_id,
+                   server_get_u32(p_bytes),
+                   server_get_f64(p_bytes + 4));
+
+            for (j = 0; j < vertex_count; ++j)
+            {
+                printf(" %lu",
+                       (unsigned long) server_get_u64(p_bytes +
+                                                      SERVER_RESULT_SIZE +
+                                                      8 * j));
+            }
+
+            putchar('\n');
+        }
+
+        p_bytes += SERVER_RESULT_SIZE + 8 * vertex_count;
+    }
+
+    return TRUE;
+}
+
+int main(int argc, char** argv)
+{
+    client_config config;
+    query_set* p_queries;
+    server_buffer buffer;
+    size_t next = 0;
+    size_t in_flight = 0;
+    size_t requests = 0;
+    double start;
+    double seconds;
+    int server;
+    int ok = TRUE;
+
+    if (!parse_arguments(argc, argv, &config))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    p_queries = query_set_load(config.query_file);
+
+    if (!p_queries)
+    {
+        fprintf(stderr, "cannot read the queries\n");
+        return EXIT_FAILURE;
+    }
+
+    /* A server that hangs up shows as a failed write: */
+    signal(SIGPIPE, SIG_IGN);
+    server = connect_to(config.socket_path);
+
+    if (server < 0)
+    {
+        perror(config.socket_path);
+        return EXIT_FAILURE;
+    }
+
+    server_buffer_init(&buffer);
+    start = monotonic_clock_seconds();
+
+    /* Keep 'depth' requests in flight; the answers may come in any order. */
+    while (ok && (next < p_queries->size || in_flight > 0))
+    {
+        if (next < p_queries->size && in_flight < config.depth)
+        {
+            ok = send_request(server, &config, p_queries, next, &buffer);
+            next += config.batch < p_queries->size - next ?
+                    config.batch :
+                    p_queries->size - next;
+            ++in_flight;
+            ++requests;
+            continue;
+        }
+
+        ok = server_read_frame(server, &buffer, (size_t) -1) &&
+             print_response(&config, p_queries, &buffer);
+        --in_flight;
+    }
+
+    seconds = monotonic_clock_seconds() - start;
+    close(server);
+    server_buffer_free(&buffer);
+
+    if (!ok)
+    {
+        fprintf(stderr, "the server failed or sent a malformed response\n");
+        query_set_free(p_queries);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "%lu queries in %lu requests, %.3f s, %.0f queries/s\n",
+            (unsigned long) p_queries->size,
+            (unsigned long) requests,
+            seconds,
+            seconds > 0.0 ? (double) p_queries->size / seconds : 0.0);
+
+    query_set_free(p_queries);
+    return EXIT_SUCCESS;
+}
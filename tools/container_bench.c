@@ -0,0 +1,936 @@
+#include "dary_heap.h"
+#include "distance_map.h"
+#include "graph_generator.h"
+#include "graph_vertex_map.h"
+#include "monotonic_clock.h"
+#include "parent_map.h"
+#include "util.h"
+#include "vertex_list.h"
+#include "vertex_set.h"
+#include "weight_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The searches create their containers with the same parameters: */
+#define INITIAL_CAPACITY 1024
+#define LOAD_FACTOR      1.3f
+#define HEAP_DEGREE      4
+
+/* Clustered keys come in runs of this many consecutive IDs: */
+#define CLUSTER_LENGTH 64
+
+/* Unrelated streams for the keys that are present and absent: */
+#define HIT_SEED  0x9e3779b9UL
+#define MISS_SEED 0x7f4a7c15UL
+
+#define OPERATION_COUNT    7
+#define DISTRIBUTION_COUNT 3
+#define MAXIMUM_SIZES      32
+
+/*******************************************************************************
+* One container under test. Every operation works on a whole key array so     *
+* that the timed loop makes direct calls; it returns the number of            *
+* operations it did. An operation the container does not have is NULL.        *
+*******************************************************************************/
+typedef struct container_ops {
+    const char* name;
+    void*  (*alloc)       (void);
+    size_t (*insert)      (void* p_container, const vertex_id_t* keys,
+                           const weight_t* values, size_t count);
+    size_t (*lookup)      (void* p_container, const vertex_id_t* keys,
+                           size_t count);
+    size_t (*decrease_key)(void* p_container, const vertex_id_t* keys,
+                           const weight_t* values, size_t count);
+    size_t (*remove)      (void* p_container, const vertex_id_t* keys,
+                           size_t count);
+    size_t (*iterate)     (void* p_container);
+    void   (*clear)       (void* p_container);
+    void   (*free)        (void* p_container);
+} container_ops;
+
+static const char* OPERATION_NAMES[OPERATION_COUNT] = {
+    "insert",
+    "lookup_hit",
+    "lookup_miss",
+    "decrease_key",
+    "iterate",
+    "remove",
+    "clear"
+};
+
+static const char* DISTRIBUTION_NAMES[DISTRIBUTION_COUNT] = {
+    "sequential",
+    "random",
+    "clustered"
+};
+
+/* Any GraphVertex pointer will do as a value of the graph vertex map: */
+static char dummy_vertex;
+
+/*******************************************************************************
+* weight_map                                                                  *
+*******************************************************************************/
+static void* weight_map_bench_alloc(void)
+{
+    return weight_map_alloc(INITIAL_CAPACITY, LOAD_FACTOR, NULL);
+}
+
+static size_t weight_map_bench_insert(void* p_container,
+                                      const vertex_id_t* keys,
+                                      const weight_t* values,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        weight_map_put(p_container, keys[i], values[i]);
+    }
+
+    return count;
+}
+
+static size_t weight_map_bench_lookup(void* p_container,
+                                      const vertex_id_t* keys,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        weight_map_contains_key(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t weight_map_bench_remove(void* p_container,
+                                      const vertex_id_t* keys,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        weight_map_remove(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t weight_map_bench_iterate(void* p_container)
+{
+    weight_map_entry* p_entry;
+    size_t visited = 0;
+
+    for (p_entry = ((weight_map*) p_container)->head;
+         p_entry;
+         p_entry = p_entry->next)
+    {
+        ++visited;
+    }
+
+    return visited;
+}
+
+static void weight_map_bench_clear(void* p_container)
+{
+    weight_map_clear(p_container);
+}
+
+static void weight_map_bench_free(void* p_container)
+{
+    weight_map_free(p_container);
+}
+
+/*******************************************************************************
+* distance_map                                                                *
+*******************************************************************************/
+static void* distance_map_bench_alloc(void)
+{
+    return distance_map_alloc(INITIAL_CAPACITY, LOAD_FACTOR);
+}
+
+static size_t distance_map_bench_insert(void* p_container,
+                                        const vertex_id_t* keys,
+                                        const weight_t* values,
+                                        size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        distance_map_put(p_container, keys[i], values[i]);
+    }
+
+    return count;
+}
+
+static size_t distance_map_bench_lookup(void* p_container,
+                                        const vertex_id_t* keys,
+                                        size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        distance_map_contains_vertex_id(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t distance_map_bench_iterate(void* p_container)
+{
+    distance_map_entry* p_entry;
+    size_t visited = 0;
+
+    for (p_entry = ((distance_map*) p_container)->head;
+         p_entry;
+         p_entry = p_entry->next)
+    {
+        ++visited;
+    }
+
+    return visited;
+}
+
+static void distance_map_bench_clear(void* p_container)
+{
+    distance_map_clear(p_container);
+}
+
+static void distance_map_bench_free(void* p_container)
+{
+    distance_map_free(p_container);
+}
+
+/*******************************************************************************
+* parent_map                                                                  *
+*******************************************************************************/
+static void* parent_map_bench_alloc(void)
+{
+    return parent_map_alloc(INITIAL_CAPACITY, LOAD_FACTOR);
+}
+
+static size_t parent_map_bench_insert(void* p_container,
+                                      const vertex_id_t* keys,
+                                      const weight_t* values,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        parent_map_put(p_container, keys[i], keys[count - 1 - i]);
+    }
+
+    return count;
+}
+
+static size_t parent_map_bench_lookup(void* p_container,
+                                      const vertex_id_t* keys,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        parent_map_contains_vertex_id(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t parent_map_bench_iterate(void* p_container)
+{
+    parent_map_entry* p_entry;
+    size_t visited = 0;
+
+    for (p_entry = ((parent_map*) p_container)->head;
+         p_entry;
+         p_entry = p_entry->next)
+    {
+        ++visited;
+    }
+
+    return visited;
+}
+
+static void parent_map_bench_clear(void* p_container)
+{
+    parent_map_clear(p_container);
+}
+
+static void parent_map_bench_free(void* p_container)
+{
+    parent_map_free(p_container);
+}
+
+/*******************************************************************************
+* vertex_set                                                                  *
+*******************************************************************************/
+static void* vertex_set_bench_alloc(void)
+{
+    return vertex_set_alloc(INITIAL_CAPACITY, LOAD_FACTOR);
+}
+
+static size_t vertex_set_bench_insert(void* p_container,
+                                      const vertex_id_t* keys,
+                                      const weight_t* values,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        vertex_set_add(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t vertex_set_bench_lookup(void* p_container,
+                                      const vertex_id_t* keys,
+                                      size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        vertex_set_contains(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t vertex_set_bench_iterate(void* p_container)
+{
+    vertex_set_entry* p_entry;
+    size_t visited = 0;
+
+    for (p_entry = ((vertex_set*) p_container)->head;
+         p_entry;
+         p_entry = p_entry->next)
+    {
+        ++visited;
+    }
+
+    return visited;
+}
+
+static void vertex_set_bench_clear(void* p_container)
+{
+    vertex_set_clear(p_container);
+}
+
+static void vertex_set_bench_free(void* p_container)
+{
+    vertex_set_free(p_container);
+}
+
+/*******************************************************************************
+* graph_vertex_map                                                            *
+*******************************************************************************/
+static void* graph_vertex_map_bench_alloc(void)
+{
+    return graph_vertex_map_alloc(INITIAL_CAPACITY, LOAD_FACTOR, NULL);
+}
+
+static size_t graph_vertex_map_bench_insert(void* p_container,
+                                            const vertex_id_t* keys,
+                                            const weight_t* values,
+                                            size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        graph_vertex_map_put(p_container,
+                             keys[i],
+                             (struct GraphVertex*) &dummy_vertex);
+    }
+
+    return count;
+}
+
+static size_t graph_vertex_map_bench_lookup(void* p_container,
+                                            const vertex_id_t* keys,
+                                            size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        graph_vertex_map_get(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t graph_vertex_map_bench_remove(void* p_container,
+                                            const vertex_id_t* keys,
+                                            size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        graph_vertex_map_remove(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t graph_vertex_map_bench_iterate(void* p_container)
+{
+    graph_vertex_map_entry* p_entry;
+    size_t visited = 0;
+
+    for (p_entry = ((graph_vertex_map*) p_container)->head;
+         p_entry;
+         p_entry = p_entry->next)
+    {
+        ++visited;
+    }
+
+    return visited;
+}
+
+static void graph_vertex_map_bench_clear(void* p_container)
+{
+    graph_vertex_map_clear(p_container);
+}
+
+static void graph_vertex_map_bench_free(void* p_container)
+{
+    graph_vertex_map_free(p_container);
+}
+
+/*******************************************************************************
+* vertex_list                                                                 *
+*******************************************************************************/
+static void* vertex_list_bench_alloc(void)
+{
+    return vertex_list_alloc(INITIAL_CAPACITY);
+}
+
+static size_t vertex_list_bench_insert(void* p_container,
+                                       const vertex_id_t* keys,
+                                       const weight_t* values,
+                                       size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        vertex_list_push_back(p_container, keys[i]);
+    }
+
+    return count;
+}
+
+static size_t vertex_list_bench_iterate(void* p_container)
+{
+    size_t size = vertex_list_size(p_container);
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        vertex_list_get(p_container, i);
+    }
+
+    return size;
+}
+
+static void vertex_list_bench_clear(void* p_container)
+{
+    vertex_list_clear(p_container);
+}
+
+static void vertex_list_bench_free(void* p_container)
+{
+    vertex_list_free(p_container);
+}
+
+/*******************************************************************************
+* dary_heap; removing means extracting the minimum until the heap is empty.   *
+*******************************************************************************/
+static void* dary_heap_bench_alloc(void)
+{
+    return dary_heap_alloc(HEAP_DEGREE, INITIAL_CAPACITY, LOAD_FACTOR);
+}
+
+static size_t dary_heap_bench_insert(void* p_container,
+                                     const vertex_id_t* keys,
+                                     const weight_t* values,
+                                     size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        dary_heap_add(p_container, keys[i], values[i]);
+    }
+
+    return count;
+}
+
+static size_t dary_heap_bench_decrease_key(void* p_container,
+                                           const vertex_id_t* keys,
+                                           const weight_t* values,
+                                           size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        dary_heap_decrease_key(p_container, keys[i], values[i] / 2);
+    }
+
+    return count;
+}
+
+static size_t dary_heap_bench_remove(void* p_container,
+                                     const vertex_id_t* keys,
+                                     size_t count)
+{
+    size_t removed = 0;
+
+    while (dary_heap_size(p_container) > 0)
+    {
+        dary_heap_extract_min(p_container);
+        ++removed;
+    }
+
+    return removed;
+}
+
+static void dary_heap_bench_clear(void* p_container)
+{
+    dary_heap_clear(p_container);
+}
+
+static void dary_heap_bench_free(void* p_container)
+{
+    dary_heap_free(p_container);
+}
+
+static const container_ops CONTAINERS[] = {
+    {
+        "weight_map",
+        weight_map_bench_alloc,
+        weight_map_bench_insert,
+        weight_map_bench_lookup,
+        NULL,
+        weight_map_bench_remove,
+        weight_map_bench_iterate,
+        weight_map_bench_clear,
+        weight_map_bench_free
+    },
+    {
+        "distance_map",
+        distance_map_bench_alloc,
+        distance_map_bench_insert,
+        distance_map_bench_lookup,
+        NULL,
+        NULL,
+        distance_map_bench_iterate,
+        distance_map_bench_clear,
+        distance_map_bench_free
+    },
+    {
+        "parent_map",
+        parent_map_bench_alloc,
+        parent_map_bench_insert,
+        parent_map_bench_lookup,
+        NULL,
+        NULL,
+        parent_map_bench_iterate,
+        parent_map_bench_clear,
+        parent_map_bench_free
+    },
+    {
+        "vertex_set",
+        vertex_set_bench_alloc,
+        vertex_set_bench_insert,
+        vertex_set_bench_lookup,
+        NULL,
+        NULL,
+        vertex_set_bench_iterate,
+        vertex_set_bench_clear,
+        vertex_set_bench_free
+    },
+    {
+        "graph_vertex_map",
+        graph_vertex_map_bench_alloc,
+        graph_vertex_map_bench_insert,
+        graph_vertex_map_bench_lookup,
+        NULL,
+        graph_vertex_map_bench_remove,
+        graph_vertex_map_bench_iterate,
+        graph_vertex_map_bench_clear,
+        graph_vertex_map_bench_free
+    },
+    {
+        "vertex_list",
+        vertex_list_bench_alloc,
+        vertex_list_bench_insert,
+        NULL,
+        NULL,
+        NULL,
+        vertex_list_bench_iterate,
+        vertex_list_bench_clear,
+        vertex_list_bench_free
+    },
+    {
+        "dary_heap",
+        dary_heap_bench_alloc,
+        dary_heap_bench_insert,
+        NULL,
+        dary_heap_bench_decrease_key,
+        dary_heap_bench_remove,
+        NULL,
+        dary_heap_bench_clear,
+        dary_heap_bench_free
+    }
+};
+
+#define CONTAINER_COUNT (sizeof(CONTAINERS) / sizeof(CONTAINERS[0]))
+
+/*******************************************************************************
+* Fills 'keys' with 'count' IDs of the given distribution. The miss keys of   *
+* the sequential distribution follow the hit keys; for the other two they     *
+* come from another random stream and only rarely hit.                        *
+*******************************************************************************/
+static void make_keys(int distribution,
+                      vertex_id_t* keys,
+                      size_t count,
+                      size_t offset,
+                      unsigned long seed)
+{
+    size_t i;
+    vertex_id_t base = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        switch (distribution)
+        {
+            case 0:
+                keys[i] = (vertex_id_t)(offset + i);
+                break;
+
+            case 1:
+                keys[i] = (vertex_id_t) graph_generator_random(&seed);
+                break;
+
+            default:
+                if (i % CLUSTER_LENGTH == 0)
+                {
+                    base = (vertex_id_t) graph_generator_random(&seed);
+                }
+
+                keys[i] = base + (vertex_id_t)(i % CLUSTER_LENGTH);
+                break;
+        }
+    }
+}
+
+typedef struct measurement {
+    double best;
+    double total;
+    size_t operations;
+} measurement;
+
+static void record(measurement* p_measurement,
+                   double seconds,
+                   size_t operations)
+{
+    double per_operation = operations ? seconds / (double) operations : 0.0;
+
+    if (p_measurement->operations == 0 || per_operation < p_measurement->best)
+    {
+        p_measurement->best = per_operation;
+    }
+
+    p_measurement->total += per_operation;
+    p_measurement->operations = operations;
+}
+
+/*******************************************************************************
+* Runs one repetition of every operation of 'p_ops' on fresh containers.      *
+*******************************************************************************/
+static int run_once(const container_ops* p_ops,
+                    const vertex_id_t* hit_keys,
+                    const vertex_id_t* miss_keys,
+                    const weight_t* values,
+                    size_t size,
+                    measurement* measurements)
+{
+    void* p_container = p_ops->alloc();
+    double start;
+    size_t operations;
+
+    if (!p_container)
+    {
+        return FALSE;
+    }
+
+    start = monotonic_clock_seconds();
+    operations = p_ops->insert(p_container, hit_keys, values, size);
+    record(&measurements[0], monotonic_clock_seconds() - start, operations);
+
+    if (p_ops->lookup)
+    {
+        start = monotonic_clock_seconds();
+        operations = p_ops->lookup(p_container, hit_keys, size);
+        record(&measurements[1],
+               monotonic_clock_seconds() - start,
+               operations);
+
+        start = monotonic_clock_seconds();
+        operations = p_ops->lookup(p_container, miss_keys, size);
+        record(&measurements[2],
+               monotonic_clock_seconds() - start,
+               operations);
+    }
+
+    if (p_ops->decrease_key)
+    {
+        start = monotonic_clock_seconds();
+        operations = p_ops->decrease_key(p_container, hit_keys, values, size);
+        record(&measurements[3],
+               monotonic_clock_seconds() - start,
+               operations);
+    }
+
+    if (p_ops->iterate)
+    {
+        start = monotonic_clock_seconds();
+        operations = p_ops->iterate(p_container);
+        record(&measurements[4],
+               monotonic_clock_seconds() - start,
+               operations);
+    }
+
+    if (p_ops->remove)
+    {
+        start = monotonic_clock_seconds();
+        operations = p_ops->remove(p_container, hit_keys, size);
+        record(&measurements[5],
+               monotonic_clock_seconds() - start,
+               operations);
+
+        p_ops->insert(p_container, hit_keys, values, size);
+    }
+
+    /* Clearing costs per element, so report it per element too: */
+    start = monotonic_clock_seconds();
+    p_ops->clear(p_container);
+    record(&measurements[6], monotonic_clock_seconds() - start, size);
+
+    p_ops->free(p_container);
+    return TRUE;
+}
+
+static const char* USAGE_LINES[] = {
+    "  -s SIZES       comma separated element counts",
+    "                 (default 1000,10000,100000,1000000)",
+    "  -r REPS        repetitions; the best and the mean are reported",
+    "                 (default 5)",
+    "  -c CONTAINER   run only this container",
+    "  -o FILE        write the CSV to FILE instead of the standard output",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s [options]\n", program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static size_t parse_sizes(const char* text, size_t* sizes)
+{
+    size_t count = 0;
+    char* p_end;
+
+    while (*text && count < MAXIMUM_SIZES)
+    {
+        sizes[count] = strtoul(text, &p_end, 10);
+
+        if (p_end == text || sizes[count] == 0)
+        {
+            return 0;
+        }
+
+        ++count;
+        text = *p_end == ',' ? p_end + 1 : p_end;
+    }
+
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    size_t sizes[MAXIMUM_SIZES] = { 1000, 10000, 100000, 1000000 };
+    size_t size_count = 4;
+    size_t repetitions = 5;
+    size_t max_size = 0;
+    size_t container;
+    size_t size_index;
+    size_t repetition;
+    size_t i;
+    const char* only_container = NULL;
+    const char* output_file = NULL;
+    measurement measurements[OPERATION_COUNT];
+    vertex_id_t* hit_keys;
+    vertex_id_t* miss_keys;
+    weight_t* values;
+    unsigned long seed = 1;
+    FILE* p_output = stdout;
+    int distribution;
+    int operation;
+    int argi;
+
+    for (argi = 1; argi + 1 < argc; argi += 2)
+    {
+        if (strcmp(argv[argi], "-s") == 0)
+        {
+            size_count = parse_sizes(argv[argi + 1], sizes);
+        }
+        else if (strcmp(argv[argi], "-r") == 0)
+        {
+            repetitions = strtoul(argv[argi + 1], NULL, 10);
+        }
+        else if (strcmp(argv[argi], "-c") == 0)
+        {
+            only_container = argv[argi + 1];
+        }
+        else if (strcmp(argv[argi], "-o") == 0)
+        {
+            output_file = argv[argi + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argi != argc || size_count == 0 || repetitions == 0)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < size_count; ++i)
+    {
+        max_size = sizes[i] > max_size ? sizes[i] : max_size;
+    }
+
+    hit_keys = malloc(sizeof(vertex_id_t) * max_size);
+    miss_keys = malloc(sizeof(vertex_id_t) * max_size);
+    values = malloc(sizeof(weight_t) * max_size);
+
+    if (!hit_keys || !miss_keys || !values)
+    {
+        fprintf(stderr, "cannot allocate the keys\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < max_size; ++i)
+    {
+        values[i] = (weight_t)(1.0 + 1000.0 *
+                               graph_generator_uniform_real(&seed));
+    }
+
+    if (output_file && !(p_output = fopen(output_file, "w")))
+    {
+        fprintf(stderr, "cannot open %s\n", output_file);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(p_output,
+            "container,operation,distribution,size,operations,"
+            "best_ns_per_op,mean_ns_per_op\n");
+
+    for (container = 0; container < CONTAINER_COUNT; ++container)
+    {
+        if (only_container &&
+            strcmp(only_container, CONTAINERS[container].name) != 0)
+        {
+            continue;
+        }
+
+        for (distribution = 0;
+             distribution < DISTRIBUTION_COUNT;
+             ++distribution)
+        {
+            for (size_index = 0; size_index < size_count; ++size_index)
+            {
+                make_keys(distribution,
+                          hit_keys,
+                          sizes[size_index],
+                          0,
+                          HIT_SEED);
+                make_keys(distribution,
+                          miss_keys,
+                          sizes[size_index],
+                          sizes[size_index],
+                          MISS_SEED);
+
+                memset(measurements, 0, sizeof(measurements));
+
+                for (repetition = 0; repetition < repetitions; ++repetition)
+                {
+                    if (!run_once(&CONTAINERS[container],
+                                  hit_keys,
+                                  miss_keys,
+                                  values,
+                                  sizes[size_index],
+                                  measurements))
+                    {
+                        fprintf(stderr, "cannot allocate the container\n");
+                        return EXIT_FAILURE;
+                    }
+                }
+
+                for (operation = 0; operation < OPERATION_COUNT; ++operation)
+                {
+                    if (measurements[operation].operations == 0)
+                    {
+                        continue;
+                    }
+
+                    fprintf(p_output,
+                            "%s,%s,%s,%lu,%lu,%.2f,%.2f\n",
+                            CONTAINERS[container].name,
+                            OPERATION_NAMES[operation],
+                            DISTRIBUTION_NAMES[distribution],
+                            (unsigned long) sizes[size_index],
+                            (unsigned long)
+                                    measurements[operation].operations,
+                            1e9 * measurements[operation].best,
+                            1e9 * measurements[operation].total /
+                                  (double) repetitions);
+                }
+            }
+        }
+    }
+
+    if (output_file)
+    {
+        fclose(p_output);
+    }
+
+    free(hit_keys);
+    free(miss_keys);
+    free(values);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1835 @@
+#include "algorithm.h"
+#include "graph.h"
+#include "graph_generator.h"
+#include "graph_io.h"
+#include "monotonic_clock.h"
+#include "query_executor.h"
+#include "query_file.h"
+#include "util.h"
+#include "versioned_graph.h"
+#include "vertex_list.h"
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENGINE_COUNT 5
+
+/* Exit codes, so that a script can tell a wrong answer from a slow one: */
+#define EXIT_DISAGREEMENT 1
+#define EXIT_REGRESSION   2
+#define EXIT_USAGE        3
+
+#define LINE_CAPACITY 256
+
+/* Prints at most this many disagreements before only counting them: */
+#define MAXIMUM_REPORTS 20
+
+/* Weight updates passed to graph_update_weights() at a time: */
+#define UPDATE_BATCH 64
+
+/* Threads querying a versioned graph while it is updated: */
+#define VERSION_READERS 2
+
+/* Each query goes this many times to the executor that is freed at once: */
+#define CANCELLED_ROUNDS 10
+
+/*******************************************************************************
+* An engine is a search function together with the form of the graph it       *
+* runs on. Every engine answers every query; all answers must agree.          *
+*******************************************************************************/
+typedef vertex_list* (*search_function)(Graph* p_graph,
+                                        vertex_id_t source_vertex_id,
+                                        vertex_id_t target_vertex_id,
+                                        int* p_return_status);
+
+typedef vertex_list* (*search_function_ex)(Graph* p_graph,
+                                           vertex_id_t source_vertex_id,
+                                           vertex_id_t target_vertex_id,
+                                           const search_options* p_options,
+                                           int* p_return_status);
+
+#define GRAPH_HASHED     0
+#define GRAPH_COMPRESSED 1
+#define GRAPH_INDEXED    2
+#define GRAPH_FORMS      3
+
+typedef struct engine {
+    const char*     name;
+    search_function search;
+    int             graph_form;
+    double          seconds;
+    size_t          queries;
+} engine;
+
+static engine engines[ENGINE_COUNT] = {
+    { "bidirectional", find_shortest_path, GRAPH_HASHED, 0.0, 0 },
+    { "unidirectional", find_shortest_path_2, GRAPH_HASHED, 0.0, 0 },
+    { "bidirectional_compressed", find_shortest_path, GRAPH_COMPRESSED,
+      0.0, 0 },
+    { "unidirectional_compressed", find_shortest_path_2, GRAPH_COMPRESSED,
+      0.0, 0 },
+    { "bidirectional_scc", find_shortest_path, GRAPH_INDEXED, 0.0, 0 }
+};
+
+typedef struct difftest_config {
+    size_t        graph_count;
+    size_t        queries_per_graph;
+    size_t        max_vertices;
+    unsigned long seed;
+    double        epsilon;
+    double        threshold;
+    size_t        updates;
+    const char*   baseline_file;
+    const char*   output_file;
+} difftest_config;
+
+/* What an engine said about one query: */
+typedef struct answer {
+    int    return_status;
+    double length;
+} answer;
+
+/* A query submitted to an executor and what its callback got: */
+typedef struct executor_call {
+    Graph* p_graph;
+    query  query;
+    answer answer;
+    size_t calls;
+} executor_call;
+
+/*******************************************************************************
+* A thread that keeps pinning the current version of a versioned graph and    *
+* checking that both searches agree on it, until 'p_done' is set. It records  *
+* the first query that failed.                                                *
+*******************************************************************************/
+typedef struct version_reader {
+    pthread_t        thread;
+    versioned_graph* p_versioned_graph;
+    const query_set* p_queries;
+    size_t           first_query;
+    double           epsilon;
+    int*             p_done;
+    size_t           failures;
+    query            failed_query;
+} version_reader;
+
+static const char* USAGE_LINES[] = {
+    "  -n GRAPHS      random graphs to test (default 1000)",
+    "  -q QUERIES     queries per graph (default 20)",
+    "  -V VERTICES    most vertices per graph (default 300)",
+    "  -s SEED        first seed (default 1)",
+    "  -e EPSILON     relative tolerance of the path lengths",
+    "  -u UPDATES     versions published per graph under queries "
+    "(default 10)",
+    "  -b FILE        compare the timings with this baseline",
+    "  -T FRACTION    slowdown over the baseline that fails (default 0.2)",
+    "  -w FILE        write the timings as a baseline to FILE",
+    "exit status: 0 if all good, 1 on disagreement, 2 on a time regression",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s [options]\n", program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static int parse_arguments(int argc, char** argv, difftest_config* p_config)
+{
+    int i;
+
+    p_config->graph_count = 1000;
+    p_config->queries_per_graph = 20;
+    p_config->max_vertices = 300;
+    p_config->seed = 1;
+    /* Compressed graphs keep the weights as floats: */
+    p_config->epsilon = sizeof(weight_t) == sizeof(float) ? 1e-4 : 1e-6;
+    p_config->threshold = 0.2;
+    p_config->updates = 10;
+    p_config->baseline_file = NULL;
+    p_config->output_file = NULL;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-n") == 0)
+        {
+            p_config->graph_count = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            p_config->queries_per_graph = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-V") == 0)
+        {
+            p_config->max_vertices = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            p_config->seed = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            p_config->epsilon = strtod(argv[i + 1], NULL);
+        }
+        else if (strcmp(argv[i], "-u") == 0)
+        {
+            p_config->updates = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-b") == 0)
+        {
+            p_config->baseline_file = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-T") == 0)
+        {
+            p_config->threshold = strtod(argv[i + 1], NULL);
+        }
+        else if (strcmp(argv[i], "-w") == 0)
+        {
+            p_config->output_file = argv[i + 1];
+        }
+        else
+        {
+            return FALSE;
+        }
+    }
+
+    return i == argc && p_config->max_vertices >= 4;
+}
+
+/*******************************************************************************
+* Generates the graph of one seed. The kind and the size change from seed to  *
+* seed so that dense, sparse, power-law and planar graphs all get tested.     *
+*******************************************************************************/
+static Graph* generate_graph(unsigned long seed,
+                             size_t max_vertices,
+                             char* description)
+{
+    graph_generator_sink sink;
+    unsigned long state = seed;
+    size_t vertex_count;
+    size_t side;
+    size_t scale;
+    double radius;
+    int return_status;
+    Graph* p_graph = allocGraph();
+
+    /* 'description' has room for LINE_CAPACITY characters: */
+    if (!p_graph)
+    {
+        return NULL;
+    }
+
+    graph_generator_random(&state);
+    vertex_count = 4 + graph_generator_random(&state) % (max_vertices - 3);
+    graph_generator_graph_sink(p_graph, &sink);
+
+    switch (seed % 5)
+    {
+        case 0:
+            sprintf(description, "uniform:%lu,%lu",
+                    (unsigned long) vertex_count,
+                    (unsigned long)(3 * vertex_count));
+            return_status = graph_generator_uniform(vertex_count,
+                                                    3 * vertex_count,
+                                                    100.0,
+                                                    seed,
+                                                    &sink);
+            break;
+
+        case 1:
+            side = (size_t) sqrt((double) vertex_count);
+            sprintf(description, "grid:%lu,%lu,0.2",
+                    (unsigned long) side,
+                    (unsigned long) side);
+            return_status = graph_generator_grid(side, side, 0.2, seed, &sink);
+            break;
+
+        case 2:
+            for (scale = 2; ((size_t) 2 << scale) <= vertex_count; ++scale)
+            {
+            }
+
+            sprintf(description, "rmat:%lu,%lu",
+                    (unsigned long) scale,
+                    (unsigned long)(4 << scale));
+            return_status = graph_generator_rmat(scale,
+                                                 (size_t) 4 << scale,
+                                                 0.57,
+                                                 0.19,
+                                                 0.19,
+                                                 100.0,
+                                                 seed,
+                                                 &sink);
+            break;
+
+        case 3:
+            /* About seven neighbours each, so most pairs are connected: */
+            radius = 1.5 / sqrt((double) vertex_count);
+            sprintf(description, "geometric:%lu,%.3f",
+                    (unsigned long) vertex_count,
+                    radius);
+            return_status = graph_generator_geometric(vertex_count,
+                                                      radius,
+                                                      seed,
+                                                      &sink);
+            break;
+
+        default:
+            sprintf(description, "er:%lu,%.4f",
+                    (unsigned long) vertex_count,
+                    2.0 / (double) vertex_count);
+            return_status =
+                    graph_generator_erdos_renyi(vertex_count,
+                                                2.0 / (double) vertex_count,
+                                                100.0,
+                                                seed,
+                                                &sink);
+            break;
+    }
+
+    if (return_status != RETURN_STATUS_OK)
+    {
+        freeGraph(p_graph);
+        free(p_graph);
+        return NULL;
+    }
+
+    return p_graph;
+}
+
+/*******************************************************************************
+* Checks that 'p_path' leads from the source to the target over existing      *
+* arcs and returns its length, or -1 if it does not.                          *
+*******************************************************************************/
+static double path_length(Graph* p_graph,
+                          vertex_list* p_path,
+                          vertex_id_t source_vertex_id,
+                          vertex_id_t target_vertex_id)
+{
+    size_t size = vertex_list_size(p_path);
+    size_t i;
+    vertex_id_t tail_vertex_id;
+    vertex_id_t head_vertex_id;
+    double length = 0.0;
+
+    if (size == 0 ||
+        vertex_list_get(p_path, 0) != source_vertex_id ||
+        vertex_list_get(p_path, size - 1) != target_vertex_id)
+    {
+        return -1.0;
+    }
+
+    for (i = 0; i + 1 < size; ++i)
+    {
+        tail_vertex_id = vertex_list_get(p_path, i);
+        head_vertex_id = vertex_list_get(p_path, i + 1);
+
+        if (!hasEdge(p_graph, tail_vertex_id, head_vertex_id))
+        {
+            return -1.0;
+        }
+
+        length += getEdgeWeight(p_graph, tail_vertex_id, head_vertex_id);
+    }
+
+    return length;
+}
+
+/* Stores the length of 'p_path' in 'p_answer' and frees the path: */
+static void measure_path(Graph* p_graph,
+                         vertex_list* p_path,
+                         vertex_id_t source_vertex_id,
+                         vertex_id_t target_vertex_id,
+                         answer* p_answer)
+{
+    p_answer->length = 0.0;
+
+    if (p_path)
+    {
+        p_answer->length = path_length(p_graph,
+                                       p_path,
+                                       source_vertex_id,
+                                       target_vertex_id);
+        vertex_list_free(p_path);
+    }
+}
+
+static answer run_engine(engine* p_engine,
+                         Graph* p_graph,
+                         vertex_id_t source_vertex_id,
+                         vertex_id_t target_vertex_id)
+{
+    answer result;
+    vertex_list* p_path;
+    double start = monotonic_clock_seconds();
+
+    p_path = p_engine->search(p_graph,
+                              source_vertex_id,
+                              target_vertex_id,
+                              &result.return_status);
+
+    p_engine->seconds += monotonic_clock_seconds() - start;
+    ++p_engine->queries;
+    measure_path(p_graph,
+                 p_path,
+                 source_vertex_id,
+                 target_vertex_id,
+                 &result);
+    return result;
+}
+
+static int answers_agree(const answer* p_expected,
+                         const answer* p_actual,
+                         double epsilon)
+{
+    double scale;
+
+    if (p_expected->return_status != p_actual->return_status)
+    {
+        return FALSE;
+    }
+
+    if (p_expected->return_status != RETURN_STATUS_OK)
+    {
+        return TRUE;
+    }
+
+    if (p_expected->length < 0.0 || p_actual->length < 0.0)
+    {
+        return FALSE;
+    }
+
+    scale = p_expected->length > 1.0 ? p_expected->length : 1.0;
+    return fabs(p_expected->length - p_actual->length) <= epsilon * scale;
+}
+
+/*******************************************************************************
+* graph_reachable() on the graph of an engine must say TRUE exactly when the  *
+* engine found a path, and must not fail.                                     *
+*******************************************************************************/
+static int reachability_agrees(Graph* p_graph,
+                               vertex_id_t source_vertex_id,
+                               vertex_id_t target_vertex_id,
+                               const answer* p_answer)
+{
+    int return_status;
+    int reachable = graph_reachable(p_graph,
+                                    source_vertex_id,
+                                    target_vertex_id,
+                                    &return_status);
+
+    return return_status == RETURN_STATUS_OK &&
+           reachable == (p_answer->return_status == RETURN_STATUS_OK);
+}
+
+/*******************************************************************************
+* Runs every query on every engine and counts the disagreements in            *
+* '*p_disagreements'.                                                         *
+*******************************************************************************/
+static void check_queries(Graph* forms[],
+                          const query_set* p_queries,
+                          unsigned long seed,
+                          const char* description,
+                          double epsilon,
+                          size_t* p_disagreements)
+{
+    query* p_query;
+    answer answers[ENGINE_COUNT];
+    size_t query_index;
+    size_t i;
+    vertex_id_t source_vertex_id;
+    vertex_id_t target_vertex_id;
+
+    for (query_index = 0; query_index < p_queries->size; ++query_index)
+    {
+        p_query = &p_queries->queries[query_index];
+        source_vertex_id = p_query->source_vertex_id;
+        target_vertex_id = p_query->target_vertex_id;
+
+        for (i = 0; i < ENGINE_COUNT; ++i)
+        {
+            answers[i] = run_engine(&engines[i],
+                                    forms[engines[i].graph_form],
+                                    source_vertex_id,
+                                    target_vertex_id);
+        }
+
+        for (i = 1; i < ENGINE_COUNT; ++i)
+        {
+            if (answers_agree(&answers[0], &answers[i], epsilon))
+            {
+                continue;
+            }
+
+            if (++*p_disagreements <= MAXIMUM_REPORTS)
+            {
+                fprintf(stderr,
+                        "disagreement: seed %lu (%s), query %lu -> %lu: "
+                        "%s says status %d length %.17g, "
+                        "%s says status %d length %.17g\n",
+                        seed,
+                        description,
+                        (unsigned long) source_vertex_id,
+                        (unsigned long) target_vertex_id,
+                        engines[0].name,
+                        answers[0].return_status,
+                        answers[0].length,
+                        engines[i].name,
+                        answers[i].return_status,
+                        answers[i].length);
+            }
+        }
+
+        for (i = 0; i < ENGINE_COUNT; ++i)
+        {
+            if (reachability_agrees(forms[engines[i].graph_form],
+                                    source_vertex_id,
+                                    target_vertex_id,
+                                    &answers[i]))
+            {
+                continue;
+            }
+
+            if (++*p_disagreements <= MAXIMUM_REPORTS)
+            {
+                fprintf(stderr,
+                        "disagreement: seed %lu (%s), query %lu -> %lu: "
+                        "%s says status %d, graph_reachable() on its "
+                        "graph does not agree\n",
+                        seed,
+                        description,
+                        (unsigned long) source_vertex_id,
+                        (unsigned long) target_vertex_id,
+                        engines[i].name,
+                        answers[i].return_status);
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Gives a random weight to every arc leaving about one vertex in four:        *
+* through graph_update_weights() on the compressed form, in batches, and      *
+* through addEdge() on the hashed forms, after which all engines must still   *
+* agree. The weights do not change the topology, so the SCC index stays.      *
+*******************************************************************************/
+static int reweight_graph(Graph* forms[], unsigned long seed)
+{
+    Graph* p_compressed = forms[GRAPH_COMPRESSED];
+    graph_edge_cursor cursor;
+    vertex_id_t* vertex_ids;
+    vertex_id_t head_vertex_id;
+    weight_t weight;
+    size_t edge_ids[UPDATE_BATCH];
+    weight_t weights[UPDATE_BATCH];
+    size_t vertex_count;
+    size_t count = 0;
+    size_t i;
+    unsigned long state = seed;
+    int return_status = RETURN_STATUS_OK;
+
+    vertex_ids = graph_vertex_ids(p_compressed, &vertex_count);
+
+    if (!vertex_ids)
+    {
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; return_status == RETURN_STATUS_OK && i < vertex_count; ++i)
+    {
+        if (graph_generator_random(&state) % 4 != 0)
+        {
+            continue;
+        }
+
+        graph_children_cursor(p_compressed, vertex_ids[i], &cursor);
+
+        while (return_status == RETURN_STATUS_OK &&
+               graph_edge_cursor_next(&cursor, &head_vertex_id, &weight))
+        {
+            weight = (weight_t)(1 + graph_generator_random(&state) % 9900) /
+                     100;
+            return_status = graph_edge_id(p_compressed,
+                                          vertex_ids[i],
+                                          head_vertex_id,
+                                          &edge_ids[count]);
+
+            if (return_status != RETURN_STATUS_OK ||
+                (return_status = addEdge(forms[GRAPH_HASHED],
+                                         vertex_ids[i],
+                                         head_vertex_id,
+                                         weight)) != RETURN_STATUS_OK ||
+                (return_status = addEdge(forms[GRAPH_INDEXED],
+                                         vertex_ids[i],
+                                         head_vertex_id,
+                                         weight)) != RETURN_STATUS_OK)
+            {
+                break;
+            }
+
+            weights[count++] = weight;
+
+            if (count == UPDATE_BATCH)
+            {
+                return_status = graph_update_weights(p_compressed,
+                                                     edge_ids,
+                                                     weights,
+                                                     count);
+                count = 0;
+            }
+        }
+    }
+
+    if (return_status == RETURN_STATUS_OK && count > 0)
+    {
+        return_status = graph_update_weights(p_compressed,
+                                             edge_ids,
+                                             weights,
+                                             count);
+    }
+
+    free(vertex_ids);
+    return return_status;
+}
+
+static int compare_vertex_ids(const void* p_a, const void* p_b)
+{
+    vertex_id_t a = *(const vertex_id_t*) p_a;
+    vertex_id_t b = *(const vertex_id_t*) p_b;
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* Returns the rank from 1 of 'vertex_id' in the sorted 'vertex_ids': */
+static vertex_id_t rank_of(const vertex_id_t* vertex_ids,
+                           size_t vertex_count,
+                           vertex_id_t vertex_id)
+{
+    const vertex_id_t* p_vertex_id = bsearch(&vertex_id,
+                                             vertex_ids,
+                                             vertex_count,
+                                             sizeof(vertex_id_t),
+                                             compare_vertex_ids);
+
+    return (vertex_id_t)(p_vertex_id - vertex_ids) + 1;
+}
+
+/*******************************************************************************
+* Compares the graph read back from DIMACS with the one written, whose sorted *
+* IDs are 'vertex_ids': the vertex with the k-th smallest ID must have become *
+* k, with the same arcs and weights, and no vertex may be lost or added.      *
+* Returns what differs, or NULL.                                              *
+*******************************************************************************/
+static const char* compare_dimacs_copy(Graph* p_graph,
+                                       Graph* p_copy,
+                                       const vertex_id_t* vertex_ids,
+                                       size_t vertex_count,
+                                       const query_set* p_queries,
+                                       double epsilon)
+{
+    graph_edge_cursor cursor;
+    const query* p_query;
+    vertex_list* p_path;
+    answer original;
+    answer copy;
+    vertex_id_t tail_vertex_id;
+    vertex_id_t head_vertex_id;
+    weight_t weight;
+    size_t edge_count = 0;
+    size_t i;
+
+    if (p_copy->p_nodes->size != vertex_count)
+    {
+        return "the vertex count";
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        tail_vertex_id = (vertex_id_t)(i + 1);
+        graph_children_cursor(p_graph, vertex_ids[i], &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &head_vertex_id, &weight))
+        {
+            head_vertex_id = rank_of(vertex_ids, vertex_count, head_vertex_id);
+            ++edge_count;
+
+            if (!hasEdge(p_copy, tail_vertex_id, head_vertex_id) ||
+                getEdgeWeight(p_copy, tail_vertex_id, head_vertex_id) !=
+                weight)
+            {
+                return "an arc";
+            }
+        }
+
+        graph_children_cursor(p_copy, tail_vertex_id, &cursor);
+
+        while (graph_edge_cursor_next(&cursor, &head_vertex_id, &weight))
+        {
+            --edge_count;
+        }
+    }
+
+    if (edge_count != 0)
+    {
+        return "the arc count";
+    }
+
+    for (i = 0; i < p_queries->size; ++i)
+    {
+        p_query = &p_queries->queries[i];
+        p_path = find_shortest_path(p_graph,
+                                    p_query->source_vertex_id,
+                                    p_query->target_vertex_id,
+                                    &original.return_status);
+        measure_path(p_graph,
+                     p_path,
+                     p_query->source_vertex_id,
+                     p_query->target_vertex_id,
+                     &original);
+
+        tail_vertex_id = rank_of(vertex_ids,
+                                 vertex_count,
+                                 p_query->source_vertex_id);
+        head_vertex_id = rank_of(vertex_ids,
+                                 vertex_count,
+                                 p_query->target_vertex_id);
+        p_path = find_shortest_path(p_copy,
+                                    tail_vertex_id,
+                                    head_vertex_id,
+                                    &copy.return_status);
+        measure_path(p_copy, p_path, tail_vertex_id, head_vertex_id, &copy);
+
+        if (!answers_agree(&original, &copy, epsilon))
+        {
+            return "a shortest path";
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Writes 'p_graph' as DIMACS to a temporary file, reads it back and compares  *
+* the two. Counts a difference in '*p_disagreements' and returns              *
+* RETURN_STATUS_OK unless the round trip itself failed.                       *
+*******************************************************************************/
+static int check_dimacs_round_trip(Graph* p_graph,
+                                   const query_set* p_queries,
+                                   unsigned long seed,
+                                   const char* description,
+                                   double epsilon,
+                                   size_t* p_disagreements)
+{
+    FILE* p_file = tmpfile();
+    Graph* p_copy = NULL;
+    vertex_id_t* vertex_ids;
+    size_t vertex_count;
+    const char* p_difference;
+    int return_status;
+
+    if (!p_file)
+    {
+        return RETURN_STATUS_IO_ERROR;
+    }
+
+    return_status = graph_io_write_dimacs(p_graph, p_file);
+
+    if (return_status == RETURN_STATUS_OK)
+    {
+        rewind(p_file);
+        p_copy = graph_io_read_dimacs(p_file, &return_status);
+    }
+
+    fclose(p_file);
+    vertex_ids = p_copy ? graph_vertex_ids(p_graph, &vertex_count) : NULL;
+
+    if (!vertex_ids)
+    {
+        if (p_copy)
+        {
+            freeGraph(p_copy);
+            free(p_copy);
+        }
+
+        return return_status == RETURN_STATUS_OK ? RETURN_STATUS_NO_MEMORY :
+                                                   return_status;
+    }
+
+    qsort(vertex_ids, vertex_count, sizeof(vertex_id_t), compare_vertex_ids);
+    p_difference = compare_dimacs_copy(p_graph,
+                                       p_copy,
+                                       vertex_ids,
+                                       vertex_count,
+                                       p_queries,
+                                       epsilon);
+
+    if (p_difference && ++*p_disagreements <= MAXIMUM_REPORTS)
+    {
+        fprintf(stderr,
+                "disagreement: seed %lu (%s), the graph read back from "
+                "DIMACS differs in %s\n",
+                seed,
+                description,
+                p_difference);
+    }
+
+    free(vertex_ids);
+    freeGraph(p_copy);
+    free(p_copy);
+    return RETURN_STATUS_OK;
+}
+
+static void record_call(vertex_list* p_path,
+                        int return_status,
+                        void* p_user_data)
+{
+    executor_call* p_call = p_user_data;
+
+    ++p_call->calls;
+    p_call->answer.return_status = return_status;
+    measure_path(p_call->p_graph,
+                 p_path,
+                 p_call->query.source_vertex_id,
+                 p_call->query.target_vertex_id,
+                 &p_call->answer);
+}
+
+/* Waits on the descriptor of the executor and dispatches until it is idle: */
+static void dispatch_all(query_executor* p_executor)
+{
+    struct pollfd descriptor;
+
+    while (query_executor_pending(p_executor) > 0)
+    {
+        descriptor.fd = query_executor_fd(p_executor);
+        descriptor.events = POLLIN;
+        poll(&descriptor, 1, 100);
+        query_executor_dispatch(p_executor);
+    }
+}
+
+static int submit_calls(query_executor* p_executor,
+                        executor_call* calls,
+                        size_t begin,
+                        size_t end)
+{
+    size_t i;
+    int return_status = RETURN_STATUS_OK;
+
+    for (i = begin; return_status == RETURN_STATUS_OK && i < end; ++i)
+    {
+        return_status = query_submit(p_executor,
+                                     calls[i].query.source_vertex_id,
+                                     calls[i].query.target_vertex_id,
+                                     record_call,
+                                     &calls[i]);
+    }
+
+    return return_status;
+}
+
+/*******************************************************************************
+* Checks that every call ran exactly once and got the answer of the           *
+* synchronous search, or RETURN_STATUS_CANCELLED if 'cancellable'. Returns    *
+* the first call that did not, or NULL, and adds the cancelled calls to       *
+* '*p_cancelled'.                                                             *
+*******************************************************************************/
+static const executor_call* check_calls(const executor_call* calls,
+                                        size_t count,
+                                        const answer* expected,
+                                        size_t expected_count,
+                                        double epsilon,
+                                        int cancellable,
+                                        size_t* p_cancelled)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (calls[i].calls == 1 && cancellable &&
+            calls[i].answer.return_status == RETURN_STATUS_CANCELLED)
+        {
+            ++*p_cancelled;
+            continue;
+        }
+
+        if (calls[i].calls != 1 ||
+            !answers_agree(&expected[i % expected_count],
+                           &calls[i].answer,
+                           epsilon))
+        {
+            return &calls[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Runs the queries through query_executor: half of them, a dispatch, then the *
+* other half, each of which must be answered as the synchronous search        *
+* answers it, by exactly one callback. Then submits every query               *
+* CANCELLED_ROUNDS times to a single worker and frees the executor at once:   *
+* every callback must still run once, with the answer or with                 *
+* RETURN_STATUS_CANCELLED, counted in '*p_cancelled'.                         *
+*******************************************************************************/
+static int check_executor(Graph* p_graph,
+                          const query_set* p_queries,
+                          unsigned long seed,
+                          const char* description,
+                          double epsilon,
+                          size_t* p_disagreements,
+                          size_t* p_cancelled)
+{
+    query_executor* p_executor;
+    executor_call* calls;
+    const executor_call* p_failed;
+    answer* expected;
+    vertex_list* p_path;
+    size_t size = p_queries->size;
+    size_t i;
+    int return_status;
+
+    calls = malloc(sizeof(executor_call) * (CANCELLED_ROUNDS * size + 1));
+    expected = malloc(sizeof(answer) * (size + 1));
+
+    if (!calls || !expected)
+    {
+        free(calls);
+        free(expected);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (i = 0; i < CANCELLED_ROUNDS * size; ++i)
+    {
+        calls[i].p_graph = p_graph;
+        calls[i].query = p_queries->queries[i % size];
+        calls[i].calls = 0;
+
+        /* Not a status, so that a missing callback shows: */
+        calls[i].answer.return_status = -1;
+        calls[i].answer.length = 0.0;
+
+        if (i < size)
+        {
+            p_path = find_shortest_path(p_graph,
+                                        calls[i].query.source_vertex_id,
+                                        calls[i].query.target_vertex_id,
+                                        &expected[i].return_status);
+            measure_path(p_graph,
+                         p_path,
+                         calls[i].query.source_vertex_id,
+                         calls[i].query.target_vertex_id,
+                         &expected[i]);
+        }
+    }
+
+    p_executor = query_executor_alloc(p_graph, 2, 0);
+    return_status = p_executor ? RETURN_STATUS_OK : RETURN_STATUS_NO_MEMORY;
+
+    if (return_status == RETURN_STATUS_OK &&
+        (return_status = submit_calls(p_executor, calls, 0, size / 2)) ==
+        RETURN_STATUS_OK)
+    {
+        dispatch_all(p_executor);
+        return_status = submit_calls(p_executor, calls, size / 2, size);
+        dispatch_all(p_executor);
+    }
+
+    /* Every callback has run, so freeing must not run any again: */
+    query_executor_free(p_executor);
+    p_failed = check_calls(calls, size, expected, size, epsilon, FALSE, NULL);
+
+    if (return_status == RETURN_STATUS_OK)
+    {
+        for (i = 0; i < size; ++i)
+        {
+            calls[i].calls = 0;
+            calls[i].answer.return_status = -1;
+        }
+
+        p_executor = query_executor_alloc(p_graph, 1, 0);
+        return_status = p_executor ? submit_calls(p_executor,
+                                                  calls,
+                                                  0,
+                                                  CANCELLED_ROUNDS * size) :
+                                     RETURN_STATUS_NO_MEMORY;
+        query_executor_free(p_executor);
+
+        if (!p_failed)
+        {
+            p_failed = check_calls(calls,
+                                   CANCELLED_ROUNDS * size,
+                                   expected,
+                                   size,
+                                   epsilon,
+                                   TRUE,
+                                   p_cancelled);
+        }
+    }
+
+    if (return_status == RETURN_STATUS_OK && p_failed &&
+        ++*p_disagreements <= MAXIMUM_REPORTS)
+    {
+        fprintf(stderr,
+                "disagreement: seed %lu (%s), query %lu -> %lu: "
+                "the executor ran its callback %lu times, "
+                "with status %d length %.17g\n",
+                seed,
+                description,
+                (unsigned long) p_failed->query.source_vertex_id,
+                (unsigned long) p_failed->query.target_vertex_id,
+                (unsigned long) p_failed->calls,
+                p_failed->answer.return_status,
+                p_failed->answer.length);
+    }
+
+    free(calls);
+    free(expected);
+    return return_status;
+}
+
+/*******************************************************************************
+* Returns a copy of 'p_graph' whose weights are the integers 1 to 100, so     *
+* that path lengths add up exactly and the bounds can be checked to the unit. *
+*******************************************************************************/
+static Graph* integer_graph(Graph* p_graph)
+{
+    graph_edge_cursor cursor;
+    vertex_id_t* vertex_ids;
+    vertex_id_t head_vertex_id;
+    weight_t weight;
+    size_t vertex_count;
+    size_t i;
+    int return_status = RETURN_STATUS_OK;
+    Graph* p_copy = cloneGraph(p_graph);
+
+    vertex_ids = p_copy ? graph_vertex_ids(p_graph, &vertex_count) : NULL;
+
+    for (i = 0; vertex_ids && i < vertex_count; ++i)
+    {
+        graph_children_cursor(p_graph, vertex_ids[i], &cursor);
+
+        while (return_status == RETURN_STATUS_OK &&
+               graph_edge_cursor_next(&cursor, &head_vertex_id, &weight))
+        {
+            return_status = addEdge(p_copy,
+                                    vertex_ids[i],
+                                    head_vertex_id,
+                                    (weight_t)(floor((double) weight) + 1));
+        }
+    }
+
+    if (p_copy && (!vertex_ids || return_status != RETURN_STATUS_OK))
+    {
+        freeGraph(p_copy);
+        free(p_copy);
+        p_copy = NULL;
+    }
+
+    free(vertex_ids);
+    return p_copy;
+}
+
+/* Returns the status of a search within the bounds: */
+static int bounded_status(search_function_ex search,
+                          Graph* p_graph,
+                          const query* p_query,
+                          weight_t max_distance,
+                          size_t max_settled)
+{
+    search_options options;
+    vertex_list* p_path;
+    int return_status;
+
+    search_options_init(&options);
+    options.max_distance = max_distance;
+    options.max_settled = max_settled;
+    p_path = search(p_graph,
+                    p_query->source_vertex_id,
+                    p_query->target_vertex_id,
+                    &options,
+                    &return_status);
+
+    if (p_path)
+    {
+        vertex_list_free(p_path);
+    }
+
+    return return_status;
+}
+
+/*******************************************************************************
+* Checks one query of an integer weighted graph against its unbounded answer: *
+* of length 'distance' after settling 'settled' vertices. The search must     *
+* succeed within exactly that distance and that many settled vertices, and    *
+* fail with RETURN_STATUS_BOUND_EXCEEDED within one less. Returns the bounds  *
+* that broke this in '*p_max_distance' and '*p_max_settled', or FALSE.        *
+*******************************************************************************/
+static int bounds_disagree(search_function_ex search,
+                           Graph* p_graph,
+                           const query* p_query,
+                           weight_t distance,
+                           size_t settled,
+                           weight_t* p_max_distance,
+                           size_t* p_max_settled)
+{
+    *p_max_settled = 0;
+    *p_max_distance = distance;
+
+    if (bounded_status(search, p_graph, p_query, distance, 0) !=
+        RETURN_STATUS_OK)
+    {
+        return TRUE;
+    }
+
+    *p_max_distance = distance - 1;
+
+    if (distance >= 1 &&
+        bounded_status(search, p_graph, p_query, distance - 1, 0) !=
+        RETURN_STATUS_BOUND_EXCEEDED)
+    {
+        return TRUE;
+    }
+
+    *p_max_distance = WEIGHT_MAX;
+    *p_max_settled = settled;
+
+    if (bounded_status(search, p_graph, p_query, WEIGHT_MAX, settled) !=
+        RETURN_STATUS_OK)
+    {
+        return TRUE;
+    }
+
+    /* A budget of 0 means no limit: */
+    *p_max_settled = settled - 1;
+
+    return settled >= 2 &&
+           bounded_status(search, p_graph, p_query, WEIGHT_MAX, settled - 1) !=
+           RETURN_STATUS_BOUND_EXCEEDED;
+}
+
+/*******************************************************************************
+* Checks max_distance and max_settled of both searches on an integer weighted *
+* copy of 'p_graph' and on its compressed form, whose float weights hold the  *
+* integers exactly. Counts the failures in '*p_disagreements'.                *
+*******************************************************************************/
+static int check_bounds(Graph* p_graph,
+                        const query_set* p_queries,
+                        unsigned long seed,
+                        const char* description,
+                        size_t* p_disagreements)
+{
+    static const search_function_ex searches[2] = {
+        find_shortest_path_ex, find_shortest_path_2_ex
+    };
+    static const char* names[2] = { "bidirectional", "unidirectional" };
+
+    Graph* graphs[2];
+    const query* p_query;
+    search_options options;
+    search_stats stats;
+    vertex_list* p_path;
+    weight_t distance;
+    weight_t max_distance;
+    size_t max_settled;
+    size_t g;
+    size_t e;
+    size_t i;
+    int return_status;
+
+    graphs[0] = integer_graph(p_graph);
+    graphs[1] = graphs[0] ? cloneGraph(graphs[0]) : NULL;
+
+    if (!graphs[1] || compressGraph(graphs[1]) != RETURN_STATUS_OK)
+    {
+        for (g = 0; g < 2 && graphs[0]; ++g)
+        {
+            if (graphs[g])
+            {
+                freeGraph(graphs[g]);
+                free(graphs[g]);
+            }
+        }
+
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (g = 0; g < 2; ++g)
+    {
+        for (e = 0; e < 2; ++e)
+        {
+            for (i = 0; i < p_queries->size; ++i)
+            {
+                p_query = &p_queries->queries[i];
+                search_options_init(&options);
+
+                /* A query from a vertex to itself fills in no stats: */
+                memset(&stats, 0, sizeof(stats));
+                options.p_stats = &stats;
+                options.p_distance = &distance;
+                p_path = searches[e](graphs[g],
+                                     p_query->source_vertex_id,
+                                     p_query->target_vertex_id,
+                                     &options,
+                                     &return_status);
+
+                if (!p_path)
+                {
+                    continue;
+                }
+
+                vertex_list_free(p_path);
+
+                if (bounds_disagree(searches[e],
+                                    graphs[g],
+                                    p_query,
+                                    distance,
+                                    stats.settled_forward +
+                                    stats.settled_backward,
+                                    &max_distance,
+                                    &max_settled) &&
+                    ++*p_disagreements <= MAXIMUM_REPORTS)
+                {
+                    fprintf(stderr,
+                            "disagreement: seed %lu (%s), query %lu -> %lu: "
+                            "%s%s with max_distance %.17g max_settled %lu "
+                            "on a path of %.17g\n",
+                            seed,
+                            description,
+                            (unsigned long) p_query->source_vertex_id,
+                            (unsigned long) p_query->target_vertex_id,
+                            names[e],
+                            g == 1 ? "_compressed" : "",
+                            (double) max_distance,
+                            (unsigned long) max_settled,
+                            (double) distance);
+                }
+            }
+        }
+    }
+
+    for (g = 0; g < 2; ++g)
+    {
+        freeGraph(graphs[g]);
+        free(graphs[g]);
+    }
+
+    return RETURN_STATUS_OK;
+}
+
+/* Returns the status of a search under 'p_context': */
+static int context_status(search_function_ex search,
+                          Graph* p_graph,
+                          const query* p_query,
+                          query_context* p_context)
+{
+    search_options options;
+    vertex_list* p_path;
+    int return_status;
+
+    search_options_init(&options);
+    options.p_context = p_context;
+    p_path = search(p_graph,
+                    p_query->source_vertex_id,
+                    p_query->target_vertex_id,
+                    &options,
+                    &return_status);
+
+    if (p_path)
+    {
+        vertex_list_free(p_path);
+    }
+
+    return return_status;
+}
+
+/*******************************************************************************
+* Runs every query with a context cancelled beforehand and with one whose     *
+* deadline has passed, on every graph form and with both searches. The        *
+* context is polled before the first vertex is settled, so every query that   *
+* would search must stop with RETURN_STATUS_CANCELLED or                      *
+* RETURN_STATUS_DEADLINE_EXCEEDED. Queries answered up front, from a vertex   *
+* to itself or rejected by the SCC index, may keep their answer.              *
+*******************************************************************************/
+static void check_contexts(Graph* forms[],
+                           const query_set* p_queries,
+                           unsigned long seed,
+                           const char* description,
+                           size_t* p_disagreements)
+{
+    static const search_function_ex searches[2] = {
+        find_shortest_path_ex, find_shortest_path_2_ex
+    };
+    static const char* names[2] = { "bidirectional", "unidirectional" };
+
+    query_context contexts[2];
+    const query* p_query;
+    int expected[2];
+    int unbounded;
+    int actual;
+    size_t f;
+    size_t e;
+    size_t c;
+    size_t i;
+
+    query_context_init(&contexts[0]);
+    query_context_cancel(&contexts[0]);
+    expected[0] = RETURN_STATUS_CANCELLED;
+    query_context_init(&contexts[1]);
+    query_context_set_timeout(&contexts[1], -1.0);
+    expected[1] = RETURN_STATUS_DEADLINE_EXCEEDED;
+
+    for (f = 0; f < GRAPH_FORMS; ++f)
+    {
+        for (e = 0; e < 2; ++e)
+        {
+            for (i = 0; i < p_queries->size; ++i)
+            {
+                p_query = &p_queries->queries[i];
+                unbounded = context_status(searches[e],
+                                           forms[f],
+                                           p_query,
+                                           NULL);
+
+                for (c = 0; c < 2; ++c)
+                {
+                    actual = context_status(searches[e],
+                                            forms[f],
+                                            p_query,
+                                            &contexts[c]);
+
+                    if (actual == expected[c] ||
+                        (actual == unbounded &&
+                         (p_query->source_vertex_id ==
+                          p_query->target_vertex_id ||
+                          (f == GRAPH_INDEXED &&
+                           unbounded == RETURN_STATUS_NO_PATH))))
+                    {
+                        continue;
+                    }
+
+                    if (++*p_disagreements <= MAXIMUM_REPORTS)
+                    {
+                        fprintf(stderr,
+                                "disagreement: seed %lu (%s), query %lu -> "
+                                "%lu: %s on graph form %lu says status %d "
+                                "under a context that expects %d\n",
+                                seed,
+                                description,
+                                (unsigned long) p_query->source_vertex_id,
+                                (unsigned long) p_query->target_vertex_id,
+                                names[e],
+                                (unsigned long) f,
+                                actual,
+                                expected[c]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Runs both searches and graph_reachable() on one pinned version. A version   *
+* must not change or go away while it is pinned, and must keep the SCC index  *
+* it was published with.                                                      *
+*******************************************************************************/
+static int check_pinned_query(Graph* p_graph,
+                              const query* p_query,
+                              double epsilon)
+{
+    answer bidirectional;
+    answer unidirectional;
+    vertex_list* p_path;
+
+    p_path = find_shortest_path(p_graph,
+                                p_query->source_vertex_id,
+                                p_query->target_vertex_id,
+                                &bidirectional.return_status);
+    measure_path(p_graph,
+                 p_path,
+                 p_query->source_vertex_id,
+                 p_query->target_vertex_id,
+                 &bidirectional);
+
+    p_path = find_shortest_path_2(p_graph,
+                                  p_query->source_vertex_id,
+                                  p_query->target_vertex_id,
+                                  &unidirectional.return_status);
+    measure_path(p_graph,
+                 p_path,
+                 p_query->source_vertex_id,
+                 p_query->target_vertex_id,
+                 &unidirectional);
+
+    return graph_scc_index(p_graph) &&
+           answers_agree(&bidirectional, &unidirectional, epsilon) &&
+           reachability_agrees(p_graph,
+                               p_query->source_vertex_id,
+                               p_query->target_vertex_id,
+                               &bidirectional);
+}
+
+static void* run_version_reader(void* p_argument)
+{
+    version_reader* p_reader = p_argument;
+    const query* p_query;
+    Graph* p_graph;
+    size_t index = p_reader->first_query;
+    size_t slot;
+
+    /* Every reader checks at least one query, however fast the writer is: */
+    do
+    {
+        p_query = &p_reader->p_queries->queries[index++ %
+                                                p_reader->p_queries->size];
+        p_graph = versioned_graph_pin(p_reader->p_versioned_graph, &slot);
+
+        if (!p_graph || !check_pinned_query(p_graph,
+                                            p_query,
+                                            p_reader->epsilon))
+        {
+            if (p_reader->failures++ == 0)
+            {
+                p_reader->failed_query = *p_query;
+            }
+        }
+
+        versioned_graph_unpin(p_reader->p_versioned_graph, slot);
+    }
+    while (!__atomic_load_n(p_reader->p_done, __ATOMIC_SEQ_CST));
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Publishes 'updates' versions of a copy of 'p_graph' while VERSION_READERS   *
+* threads pin versions and query them. Each update takes a shortest path of   *
+* the draft and either removes its first arc or makes all its arcs heavier,   *
+* so the versions differ in topology and in weights. Every published version  *
+* must have an SCC index, and once the readers are gone reclaiming must free  *
+* every retired version. Counts the failures in '*p_disagreements' and        *
+* returns RETURN_STATUS_OK unless something could not be allocated.           *
+*******************************************************************************/
+static int check_versions(Graph* p_graph,
+                          const query_set* p_queries,
+                          unsigned long seed,
+                          const char* description,
+                          double epsilon,
+                          size_t updates,
+                          size_t* p_disagreements)
+{
+    version_reader readers[VERSION_READERS];
+    versioned_graph* p_versioned_graph;
+    const query* p_query;
+    vertex_list* p_path;
+    Graph* p_copy = cloneGraph(p_graph);
+    Graph* p_draft;
+    vertex_id_t tail_vertex_id;
+    vertex_id_t head_vertex_id;
+    size_t started;
+    size_t update;
+    size_t i;
+    int done = FALSE;
+    int search_status;
+    int return_status = RETURN_STATUS_OK;
+
+    if (!p_copy || graph_build_scc_index(p_copy) != RETURN_STATUS_OK ||
+        !(p_versioned_graph = versioned_graph_alloc(p_copy, VERSION_READERS)))
+    {
+        if (p_copy)
+        {
+            freeGraph(p_copy);
+            free(p_copy);
+        }
+
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    for (started = 0; started < VERSION_READERS; ++started)
+    {
+        readers[started].p_versioned_graph = p_versioned_graph;
+        readers[started].p_queries = p_queries;
+        readers[started].first_query = started;
+        readers[started].epsilon = epsilon;
+        readers[started].p_done = &done;
+        readers[started].failures = 0;
+
+        if (pthread_create(&readers[started].thread,
+                           NULL,
+                           run_version_reader,
+                           &readers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    for (update = 0; update < updates; ++update)
+    {
+        p_draft = versioned_graph_begin_update(p_versioned_graph);
+
+        if (!p_draft)
+        {
+            return_status = RETURN_STATUS_NO_MEMORY;
+            break;
+        }
+
+        p_query = &p_queries->queries[update % p_queries->size];
+        p_path = find_shortest_path(p_draft,
+                                    p_query->source_vertex_id,
+                                    p_query->target_vertex_id,
+                                    &search_status);
+
+        for (i = 0; p_path && i + 1 < vertex_list_size(p_path); ++i)
+        {
+            tail_vertex_id = vertex_list_get(p_path, i);
+            head_vertex_id = vertex_list_get(p_path, i + 1);
+
+            if (update % 2 == 1)
+            {
+                removeEdge(p_draft, tail_vertex_id, head_vertex_id);
+                break;
+            }
+
+            addEdge(p_draft,
+                    tail_vertex_id,
+                    head_vertex_id,
+                    2 * getEdgeWeight(p_draft,
+                                      tail_vertex_id,
+                                      head_vertex_id) + 1);
+        }
+
+        if (p_path)
+        {
+            vertex_list_free(p_path);
+        }
+
+        if ((return_status = versioned_graph_publish(p_versioned_graph)) !=
+            RETURN_STATUS_OK)
+        {
+            break;
+        }
+
+        /* Only this thread publishes, so the current version is stable: */
+        if (!graph_scc_index(p_versioned_graph->p_current) &&
+            ++*p_disagreements <= MAXIMUM_REPORTS)
+        {
+            fprintf(stderr,
+                    "disagreement: seed %lu (%s), version %lu was published "
+                    "without an SCC index\n",
+                    seed,
+                    description,
+                    (unsigned long)(update + 1));
+        }
+
+        versioned_graph_reclaim(p_versioned_graph);
+    }
+
+    __atomic_store_n(&done, TRUE, __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < started; ++i)
+    {
+        pthread_join(readers[i].thread, NULL);
+
+        if (readers[i].failures == 0)
+        {
+            continue;
+        }
+
+        *p_disagreements += readers[i].failures;
+
+        if (*p_disagreements - readers[i].failures < MAXIMUM_REPORTS)
+        {
+            fprintf(stderr,
+                    "disagreement: seed %lu (%s), query %lu -> %lu: "
+                    "a pinned version failed %lu checks\n",
+                    seed,
+                    description,
+                    (unsigned long) readers[i].failed_query.source_vertex_id,
+                    (unsigned long) readers[i].failed_query.target_vertex_id,
+                    (unsigned long) readers[i].failures);
+        }
+    }
+
+    versioned_graph_reclaim(p_versioned_graph);
+
+    if (p_versioned_graph->p_retired &&
+        ++*p_disagreements <= MAXIMUM_REPORTS)
+    {
+        fprintf(stderr,
+                "disagreement: seed %lu (%s), retired versions outlive "
+                "their readers\n",
+                seed,
+                description);
+    }
+
+    versioned_graph_free(p_versioned_graph);
+    return return_status;
+}
+
+/*******************************************************************************
+* Reads "<engine>,<mean microseconds>" lines and returns the number of        *
+* engines slower than their baseline by more than 'threshold'.                *
+*******************************************************************************/
+static int check_baseline(const char* file_name, double threshold)
+{
+    char line[LINE_CAPACITY];
+    char* p_comma;
+    double baseline;
+    double mean;
+    size_t i;
+    int regressions = 0;
+    FILE* p_file = fopen(file_name, "r");
+
+    if (!p_file)
+    {
+        fprintf(stderr, "cannot open the baseline %s\n", file_name);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), p_file))
+    {
+        p_comma = strchr(line, ',');
+
+        if (!p_comma)
+        {
+            continue;
+        }
+
+        *p_comma = '\0';
+        baseline = strtod(p_comma + 1, NULL);
+
+        for (i = 0; i < ENGINE_COUNT; ++i)
+        {
+            if (strcmp(line, engines[i].name) != 0 || engines[i].queries == 0)
+            {
+                continue;
+            }
+
+            mean = 1e6 * engines[i].seconds / (double) engines[i].queries;
+
+            if (mean > baseline * (1.0 + threshold))
+            {
+                fprintf(stderr,
+                        "regression: %s takes %.3f us per query, "
+                        "the baseline is %.3f us\n",
+                        engines[i].name,
+                        mean,
+                        baseline);
+                ++regressions;
+            }
+        }
+    }
+
+    fclose(p_file);
+    return regressions;
+}
+
+static int write_baseline(const char* file_name)
+{
+    size_t i;
+    FILE* p_file = fopen(file_name, "w");
+
+    if (!p_file)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < ENGINE_COUNT; ++i)
+    {
+        fprintf(p_file,
+                "%s,%.6f\n",
+                engines[i].name,
+                engines[i].queries ?
+                1e6 * engines[i].seconds / (double) engines[i].queries :
+                0.0);
+    }
+
+    fclose(p_file);
+    return TRUE;
+}
+
+int main(int argc, char** argv)
+{
+    difftest_config config;
+    Graph* forms[GRAPH_FORMS];
+    query_set* p_queries;
+    char description[LINE_CAPACITY];
+    size_t graph;
+    size_t i;
+    size_t disagreements = 0;
+    size_t cancelled = 0;
+    size_t total_queries = 0;
+    unsigned long seed;
+    int exit_status = EXIT_SUCCESS;
+
+    if (!parse_arguments(argc, argv, &config))
+    {
+        print_usage(argv[0]);
+        return EXIT_USAGE;
+    }
+
+    for (graph = 0; graph < config.graph_count; ++graph)
+    {
+        seed = config.seed + graph;
+        forms[GRAPH_HASHED] = generate_graph(seed,
+                                             config.max_vertices,
+                                             description);
+
+        if (!forms[GRAPH_HASHED] ||
+            !(forms[GRAPH_COMPRESSED] = cloneGraph(forms[GRAPH_HASHED])) ||
+            !(forms[GRAPH_INDEXED] = cloneGraph(forms[GRAPH_HASHED])) ||
+            compressGraph(forms[GRAPH_COMPRESSED]) != RETURN_STATUS_OK ||
+            graph_build_scc_index(forms[GRAPH_INDEXED]) != RETURN_STATUS_OK)
+        {
+            fprintf(stderr, "cannot build the graph of seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        p_queries = query_set_random(forms[GRAPH_HASHED],
+                                     config.queries_per_graph,
+                                     seed);
+
+        if (!p_queries)
+        {
+            fprintf(stderr, "cannot make the queries of seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        check_queries(forms,
+                      p_queries,
+                      seed,
+                      description,
+                      config.epsilon,
+                      &disagreements);
+
+        for (i = GRAPH_HASHED; i <= GRAPH_COMPRESSED; ++i)
+        {
+            if (check_dimacs_round_trip(forms[i],
+                                        p_queries,
+                                        seed,
+                                        description,
+                                        config.epsilon,
+                                        &disagreements) != RETURN_STATUS_OK)
+            {
+                fprintf(stderr,
+                        "cannot write and read back the graph of seed %lu\n",
+                        seed);
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (check_executor(forms[GRAPH_COMPRESSED],
+                           p_queries,
+                           seed,
+                           description,
+                           config.epsilon,
+                           &disagreements,
+                           &cancelled) != RETURN_STATUS_OK)
+        {
+            fprintf(stderr, "cannot run the executor on seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        if (check_bounds(forms[GRAPH_HASHED],
+                         p_queries,
+                         seed,
+                         description,
+                         &disagreements) != RETURN_STATUS_OK)
+        {
+            fprintf(stderr, "cannot bound the queries of seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        check_contexts(forms, p_queries, seed, description, &disagreements);
+
+        if (reweight_graph(forms, seed) != RETURN_STATUS_OK)
+        {
+            fprintf(stderr, "cannot reweight the graph of seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        strcat(description, ",reweighted");
+        check_queries(forms,
+                      p_queries,
+                      seed,
+                      description,
+                      config.epsilon,
+                      &disagreements);
+        total_queries += 2 * p_queries->size;
+
+        if (config.updates > 0 &&
+            check_versions(forms[GRAPH_HASHED],
+                           p_queries,
+                           seed,
+                           description,
+                           config.epsilon,
+                           config.updates,
+                           &disagreements) != RETURN_STATUS_OK)
+        {
+            fprintf(stderr, "cannot version the graph of seed %lu\n", seed);
+            return EXIT_FAILURE;
+        }
+
+        query_set_free(p_queries);
+
+        for (i = 0; i < GRAPH_FORMS; ++i)
+        {
+            freeGraph(forms[i]);
+            free(forms[i]);
+        }
+    }
+
+    /* A single worker cannot finish all of them before the free: */
+    if (config.graph_count > 0 && config.queries_per_graph > 0 &&
+        cancelled == 0)
+    {
+        fprintf(stderr, "disagreement: freeing an executor with queries "
+                        "waiting never cancelled one\n");
+        ++disagreements;
+    }
+
+    printf("%lu graphs, %lu queries, %lu disagreements\n",
+           (unsigned long) config.graph_count,
+           (unsigned long) total_queries,
+           (unsigned long) disagreements);
+
+    printf("%-26s %12s %12s\n", "engine", "total_ms", "mean_us");
+
+    for (i = 0; i < ENGINE_COUNT; ++i)
+    {
+        printf("%-26s %12.3f %12.3f\n",
+               engines[i].name,
+               1e3 * engines[i].seconds,
+               engines[i].queries ?
+               1e6 * engines[i].seconds / (double) engines[i].queries :
+               0.0);
+    }
+
+    if (config.output_file && !write_baseline(config.output_file))
+    {
+        fprintf(stderr, "cannot write %s\n", config.output_file);
+    }
+
+    if (disagreements > 0)
+    {
+        exit_status = EXIT_DISAGREEMENT;
+    }
+    else if (config.baseline_file &&
+             check_baseline(config.baseline_file, config.threshold) > 0)
+    {
+        exit_status = EXIT_REGRESSION;
+    }
+
+    return exit_status;
+}
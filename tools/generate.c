@@ -0,0 +1,103 @@
+#include "graph_generator.h"
+#include "graph_spec.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* USAGE_LINES[] = {
+    "  -G SPEC   the graph; SPEC is one of",
+    "              uniform:V,E  grid:W,H[,DROP]  rmat:SCALE,E[,A,B,C]",
+    "              geometric:N,RADIUS  er:N,P",
+    "  -s SEED   seed of the generator (default 1)",
+    "  -o FILE   write the DIMACS graph to FILE instead of the standard output",
+    "  -c FILE   write the DIMACS coordinates to FILE",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s -G SPEC [options]\n", program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    graph_generator_dimacs dimacs;
+    graph_generator_sink sink;
+    const char* spec = NULL;
+    const char* graph_file = NULL;
+    const char* coordinate_file = NULL;
+    unsigned long seed = 1;
+    int return_status;
+    int i;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-G") == 0)
+        {
+            spec = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            seed = strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            graph_file = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            coordinate_file = argv[i + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!spec || i != argc)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    dimacs.p_graph_file = graph_file ? fopen(graph_file, "w") : stdout;
+    dimacs.p_coordinate_file = coordinate_file ?
+                               fopen(coordinate_file, "w") :
+                               NULL;
+
+    if (!dimacs.p_graph_file || (coordinate_file && !dimacs.p_coordinate_file))
+    {
+        fprintf(stderr, "cannot open the output files\n");
+        return EXIT_FAILURE;
+    }
+
+    graph_generator_dimacs_sink(&dimacs, &sink);
+    return_status = graph_spec_generate(spec, seed, &sink);
+
+    if (graph_file)
+    {
+        fclose(dimacs.p_graph_file);
+    }
+
+    if (dimacs.p_coordinate_file)
+    {
+        fclose(dimacs.p_coordinate_file);
+    }
+
+    if (return_status != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot generate the graph (status %d)\n",
+                return_status);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "graph_spec.h"
+#include "graph_generator.h"
+#include "util.h"
+#include <stdio.h>
+#include <string.h>
+
+/* The arc weights of the generators without a geometry: */
+#define MAX_WEIGHT 100.0
+
+int graph_spec_generate(const char* spec,
+                        unsigned long seed,
+                        graph_generator_sink* p_sink)
+{
+    unsigned long first;
+    unsigned long second;
+    double real;
+    double a = 0.57;
+    double b = 0.19;
+    double c = 0.19;
+    int fields;
+
+    if (strncmp(spec, "uniform:", 8) == 0 &&
+        sscanf(spec + 8, "%lu,%lu", &first, &second) == 2)
+    {
+        return graph_generator_uniform(first,
+                                       second,
+                                       MAX_WEIGHT,
+                                       seed,
+                                       p_sink);
+    }
+
+    if (strncmp(spec, "grid:", 5) == 0)
+    {
+        real = 0.0;
+        fields = sscanf(spec + 5, "%lu,%lu,%lf", &first, &second, &real);
+
+        if (fields >= 2)
+        {
+            return graph_generator_grid(first, second, real, seed, p_sink);
+        }
+    }
+
+    if (strncmp(spec, "rmat:", 5) == 0)
+    {
+        fields = sscanf(spec + 5,
+                        "%lu,%lu,%lf,%lf,%lf",
+                        &first,
+                        &second,
+                        &a,
+                        &b,
+                        &c);
+
+        if (fields == 2 || fields == 5)
+        {
+            return graph_generator_rmat(first,
+                                        second,
+                                        a,
+                                        b,
+                                        c,
+                                        MAX_WEIGHT,
+                                        seed,
+                                        p_sink);
+        }
+    }
+
+    if (strncmp(spec, "geometric:", 10) == 0 &&
+        sscanf(spec + 10, "%lu,%lf", &first, &real) == 2)
+    {
+        return graph_generator_geometric(first, real, seed, p_sink);
+    }
+
+    if (strncmp(spec, "er:", 3) == 0 &&
+        sscanf(spec + 3, "%lu,%lf", &first, &real) == 2)
+    {
+        return graph_generator_erdos_renyi(first,
+                                           real,
+                                           MAX_WEIGHT,
+                                           seed,
+                                           p_sink);
+    }
+
+    return RETURN_STATUS_NO_GRAPH;
+}
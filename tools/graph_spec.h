@@ -0,0 +1,21 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_GRAPH_SPEC_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_GRAPH_SPEC_H
+
+#include "graph_generator.h"
+
+/*******************************************************************************
+* Runs the generator described by a command line specification:               *
+*                                                                             *
+*     uniform:V,E           V vertices, E uniformly random arcs               *
+*     grid:W,H[,DROP]       a W x H road-like grid                            *
+*     rmat:SCALE,E[,A,B,C]  2^SCALE vertices, E R-MAT arcs                    *
+*     geometric:N,RADIUS    N random points in the unit square                *
+*     er:N,P                G(N, P)                                           *
+*                                                                             *
+* Returns RETURN_STATUS_NO_GRAPH if the specification is malformed.           *
+*******************************************************************************/
+int graph_spec_generate(const char* spec,
+                        unsigned long seed,
+                        graph_generator_sink* p_sink);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_GRAPH_SPEC_H */
@@ -0,0 +1,202 @@
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* COUNTER_NAMES[PERF_COUNTERS_COUNT] = {
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses"
+};
+
+const char* perf_counters_name(size_t counter_index)
+{
+    return counter_index < PERF_COUNTERS_COUNT ?
+           COUNTER_NAMES[counter_index] :
+           "unknown";
+}
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* The value, then the times enabled and running, per PERF_FORMAT_TOTAL_*: */
+typedef struct counter_reading {
+    __u64 value;
+    __u64 time_enabled;
+    __u64 time_running;
+} counter_reading;
+
+static void describe_event(size_t counter_index,
+                           struct perf_event_attr* p_attr)
+{
+    memset(p_attr, 0, sizeof(*p_attr));
+    p_attr->size = sizeof(*p_attr);
+    p_attr->type = PERF_TYPE_HARDWARE;
+
+    switch (counter_index)
+    {
+        case 0:
+            p_attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+
+        case 1:
+            p_attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+
+        case 2:
+            p_attr->type = PERF_TYPE_HW_CACHE;
+            p_attr->config = PERF_COUNT_HW_CACHE_L1D |
+                             (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+
+        case 3:
+            p_attr->config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+
+        default:
+            p_attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+
+    p_attr->disabled = 1;
+    p_attr->exclude_kernel = 1;
+    p_attr->exclude_hv = 1;
+    p_attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                          PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+size_t perf_counters_open(perf_counters* p_counters)
+{
+    struct perf_event_attr attr;
+    size_t opened = 0;
+    size_t i;
+    int error = 0;
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        describe_event(i, &attr);
+
+        /* This thread, on any CPU: */
+        p_counters->fds[i] = (int) syscall(__NR_perf_event_open,
+                                           &attr,
+                                           0,
+                                           -1,
+                                           -1,
+                                           0UL);
+
+        if (p_counters->fds[i] >= 0)
+        {
+            ++opened;
+        }
+        else
+        {
+            error = errno;
+        }
+    }
+
+    if (opened == 0)
+    {
+        errno = error;
+    }
+
+    return opened;
+}
+
+void perf_counters_close(perf_counters* p_counters)
+{
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        if (p_counters->fds[i] >= 0)
+        {
+            close(p_counters->fds[i]);
+            p_counters->fds[i] = -1;
+        }
+    }
+}
+
+void perf_counters_start(perf_counters* p_counters)
+{
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        if (p_counters->fds[i] >= 0)
+        {
+            ioctl(p_counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(p_counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void perf_counters_stop(perf_counters* p_counters, double* values)
+{
+    counter_reading reading;
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        if (p_counters->fds[i] >= 0)
+        {
+            ioctl(p_counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        if (p_counters->fds[i] < 0 ||
+            read(p_counters->fds[i], &reading, sizeof(reading)) !=
+            (ssize_t) sizeof(reading) ||
+            reading.time_running == 0)
+        {
+            continue;
+        }
+
+        values[i] += (double) reading.value *
+                     ((double) reading.time_enabled /
+                      (double) reading.time_running);
+    }
+}
+
+#else /* !__linux__ */
+
+size_t perf_counters_open(perf_counters* p_counters)
+{
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTERS_COUNT; ++i)
+    {
+        p_counters->fds[i] = -1;
+    }
+
+    errno = ENOSYS;
+    return 0;
+}
+
+void perf_counters_close(perf_counters* p_counters)
+{
+    (void) p_counters;
+}
+
+void perf_counters_start(perf_counters* p_counters)
+{
+    (void) p_counters;
+}
+
+void perf_counters_stop(perf_counters* p_counters, double* values)
+{
+    (void) p_counters;
+    (void) values;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,37 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_PERF_COUNTERS_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_PERF_COUNTERS_H
+
+#include <stdlib.h>
+
+#define PERF_COUNTERS_COUNT 5
+
+/*******************************************************************************
+* Hardware event counters of the calling thread: cycles, instructions, L1     *
+* data cache read misses, last level cache misses and branch mispredictions,  *
+* in user space only. Uses perf_event_open(2) and needs Linux; elsewhere, in  *
+* most virtual machines, and with a strict perf_event_paranoid setting the    *
+* counters do not open. Each counter opens on its own, so a CPU lacking one   *
+* event still counts the others.                                              *
+*******************************************************************************/
+typedef struct perf_counters {
+    int fds[PERF_COUNTERS_COUNT]; /* -1 if the event did not open. */
+} perf_counters;
+
+/* Returns the number of counters that opened; 0 sets errno: */
+size_t perf_counters_open(perf_counters* p_counters);
+
+void perf_counters_close(perf_counters* p_counters);
+
+/* Zeroes and starts the counters: */
+void perf_counters_start(perf_counters* p_counters);
+
+/*******************************************************************************
+* Stops the counters and adds their counts to 'values'. A counter that did    *
+* not open adds nothing. Counts are scaled up for the time the kernel had a   *
+* counter switched out.                                                       *
+*******************************************************************************/
+void perf_counters_stop(perf_counters* p_counters, double* values);
+
+const char* perf_counters_name(size_t counter_index);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_PERF_COUNTERS_H */
@@ -0,0 +1,188 @@
+#include "query_file.h"
+#include "graph.h"
+#include "graph_generator.h"
+#include "graph_vertex_map.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LINE_CAPACITY 256
+
+query_set* query_set_alloc(void)
+{
+    query_set* p_set = malloc(sizeof(*p_set));
+
+    if (!p_set)
+    {
+        return NULL;
+    }
+
+    p_set->capacity = 64;
+    p_set->size = 0;
+    p_set->queries = malloc(sizeof(query) * p_set->capacity);
+
+    if (!p_set->queries)
+    {
+        free(p_set);
+        return NULL;
+    }
+
+    return p_set;
+}
+
+int query_set_add(query_set* p_set,
+                  vertex_id_t source_vertex_id,
+                  vertex_id_t target_vertex_id)
+{
+    query* p_new_queries;
+
+    if (p_set->size == p_set->capacity)
+    {
+        p_new_queries = realloc(p_set->queries,
+                                sizeof(query) * 2 * p_set->capacity);
+
+        if (!p_new_queries)
+        {
+            return RETURN_STATUS_NO_MEMORY;
+        }
+
+        p_set->queries = p_new_queries;
+        p_set->capacity *= 2;
+    }
+
+    p_set->queries[p_set->size].source_vertex_id = source_vertex_id;
+    p_set->queries[p_set->size].target_vertex_id = target_vertex_id;
+    ++p_set->size;
+    return RETURN_STATUS_OK;
+}
+
+query_set* query_set_load(const char* file_name)
+{
+    char line[LINE_CAPACITY];
+    char* p_cursor;
+    char* p_end;
+    unsigned long source_vertex_id;
+    unsigned long target_vertex_id;
+    query_set* p_set;
+    FILE* p_file = fopen(file_name, "r");
+
+    if (!p_file)
+    {
+        return NULL;
+    }
+
+    p_set = query_set_alloc();
+
+    while (p_set && fgets(line, sizeof(line), p_file))
+    {
+        p_cursor = line;
+
+        if (*p_cursor == 'c' || *p_cursor == '#')
+        {
+            continue;
+        }
+
+        if (*p_cursor == 'q')
+        {
+            ++p_cursor;
+        }
+
+        source_vertex_id = strtoul(p_cursor, &p_end, 10);
+
+        if (p_end == p_cursor)
+        {
+            continue;
+        }
+
+        p_cursor = p_end;
+        target_vertex_id = strtoul(p_cursor, &p_end, 10);
+
+        if (p_end == p_cursor ||
+            query_set_add(p_set,
+                          (vertex_id_t) source_vertex_id,
+                          (vertex_id_t) target_vertex_id) != RETURN_STATUS_OK)
+        {
+            query_set_free(p_set);
+            p_set = NULL;
+        }
+    }
+
+    fclose(p_file);
+    return p_set;
+}
+
+/*******************************************************************************
+* Draws 'count' source/target pairs uniformly from the vertices of 'p_graph'. *
+*******************************************************************************/
+query_set* query_set_random(Graph* p_graph,
+                            size_t count,
+                            unsigned long seed)
+{
+    size_t vertex_count;
+    size_t i;
+    vertex_id_t* vertex_ids = graph_vertex_ids(p_graph, &vertex_count);
+    query_set* p_set = vertex_ids && vertex_count ? query_set_alloc() : NULL;
+
+    for (i = 0; p_set && i < count; ++i)
+    {
+        if (query_set_add(p_set,
+                          vertex_ids[graph_generator_random(&seed) % vertex_count],
+                          vertex_ids[graph_generator_random(&seed) % vertex_count]) !=
+            RETURN_STATUS_OK)
+        {
+            query_set_free(p_set);
+            p_set = NULL;
+        }
+    }
+
+    free(vertex_ids);
+    return p_set;
+}
+
+void query_set_free(query_set* p_set)
+{
+    if (p_set)
+    {
+        free(p_set->queries);
+        free(p_set);
+    }
+}
+
+vertex_id_t* graph_vertex_ids(Graph* p_graph, size_t* p_count)
+{
+    compressed_graph* p_compressed = p_graph->p_compressed;
+    graph_vertex_map_entry* p_entry;
+    vertex_id_t* vertex_ids;
+    size_t i;
+
+    *p_count = p_compressed ? p_compressed->vertex_count :
+                              p_graph->p_nodes->size;
+
+    vertex_ids = malloc(sizeof(vertex_id_t) * (*p_count + 1));
+
+    if (!vertex_ids)
+    {
+        return NULL;
+    }
+
+    if (p_compressed)
+    {
+        for (i = 0; i < *p_count; ++i)
+        {
+            vertex_ids[i] = p_compressed->vertex_ids ?
+                            p_compressed->vertex_ids[i] :
+                            (vertex_id_t) i;
+        }
+
+        return vertex_ids;
+    }
+
+    i = 0;
+
+    for (p_entry = p_graph->p_nodes->head; p_entry; p_entry = p_entry->next)
+    {
+        vertex_ids[i++] = p_entry->vertex_id;
+    }
+
+    return vertex_ids;
+}
@@ -0,0 +1,40 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_QUERY_FILE_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_QUERY_FILE_H
+
+#include "graph.h"
+#include <stdlib.h>
+
+typedef struct query {
+    vertex_id_t source_vertex_id;
+    vertex_id_t target_vertex_id;
+} query;
+
+/*******************************************************************************
+* A list of source/target pairs. The file format has one query per line,      *
+* either "<source> <target>" or the DIMACS "q <source> <target>"; lines       *
+* starting with 'c' or '#' are comments.                                      *
+*******************************************************************************/
+typedef struct query_set {
+    query* queries;
+    size_t size;
+    size_t capacity;
+} query_set;
+
+query_set* query_set_alloc(void);
+
+int query_set_add(query_set* p_set,
+                  vertex_id_t source_vertex_id,
+                  vertex_id_t target_vertex_id);
+
+query_set* query_set_load(const char* file_name);
+
+query_set* query_set_random(Graph* p_graph,
+                            size_t count,
+                            unsigned long seed);
+
+void query_set_free(query_set* p_set);
+
+/* Returns all vertex IDs of 'p_graph' and stores their count: */
+vertex_id_t* graph_vertex_ids(Graph* p_graph, size_t* p_count);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_QUERY_FILE_H */
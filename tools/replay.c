@@ -0,0 +1,597 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "algorithm.h"
+#include "graph.h"
+#include "graph_io.h"
+#include "monotonic_clock.h"
+#include "query_metrics.h"
+#include "util.h"
+#include "vertex_list.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_CAPACITY 256
+
+/* A query that starts this much after its time counts as late: */
+#define LATE_SECONDS 0.001
+
+/* One line of the log: */
+typedef struct replay_record {
+    vertex_id_t source_vertex_id;
+    vertex_id_t target_vertex_id;
+    double      timestamp;        /* In seconds, from any origin. */
+} replay_record;
+
+typedef struct replay_log {
+    replay_record* records;
+    size_t         size;
+    size_t         capacity;
+} replay_log;
+
+typedef struct replay_config {
+    const char* graph_file;
+    const char* log_file;
+    const char* metrics_file;
+    double      speed;      /* 0 replays at full speed. */
+    size_t      workers;
+    int         unidirectional;
+    int         compress;
+    int         scc_index;
+} replay_config;
+
+/*******************************************************************************
+* What the workers share. They take the records in log order; 'next_record'   *
+* is guarded by 'lock'. A record is due 'start' plus its offset in the log,   *
+* divided by the speed.                                                       *
+*******************************************************************************/
+typedef struct replay_state {
+    Graph*           p_graph;
+    replay_log*      p_log;
+    replay_config    config;
+    pthread_mutex_t  lock;
+    size_t           next_record;
+    double           start;
+
+    /* Service time, and the time from when a query was due to its answer: */
+    query_metrics*   p_service;
+    query_metrics*   p_response;
+} replay_state;
+
+typedef struct replay_worker {
+    pthread_t     thread;
+    replay_state* p_state;
+    size_t        index;
+    size_t        late;
+    double        max_lateness;
+} replay_worker;
+
+static const char* USAGE_LINES[] = {
+    "  -g FILE     read the graph from a DIMACS file",
+    "  -l FILE     the log; one \"<source> <target> <timestamp>\" per line,",
+    "              the timestamp in seconds; '#' and 'c' start comments",
+    "  -p SPEED    keep the pacing of the log, SPEED times faster",
+    "              (default: as fast as possible)",
+    "  -w WORKERS  concurrent query threads (default 1)",
+    "  -u          use the unidirectional search",
+    "  -c          compress the graph before querying",
+    "  -i          build the SCC index before querying",
+    "  -m FILE     write the library metrics in Prometheus format",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s -g FILE -l FILE [options]\n", program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static int parse_arguments(int argc, char** argv, replay_config* p_config)
+{
+    int i;
+
+    memset(p_config, 0, sizeof(*p_config));
+    p_config->workers = 1;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'u':
+                p_config->unidirectional = TRUE;
+                continue;
+
+            case 'c':
+                p_config->compress = TRUE;
+                continue;
+
+            case 'i':
+                p_config->scc_index = TRUE;
+                continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 'g':
+                p_config->graph_file = argv[i];
+                break;
+
+            case 'l':
+                p_config->log_file = argv[i];
+                break;
+
+            case 'p':
+                p_config->speed = strtod(argv[i], NULL);
+
+                if (p_config->speed <= 0.0)
+                {
+                    return FALSE;
+                }
+
+                break;
+
+            case 'w':
+                p_config->workers = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'm':
+                p_config->metrics_file = argv[i];
+                break;
+
+            default:
+                return FALSE;
+        }
+    }
+
+    return p_config->graph_file &&
+           p_config->log_file &&
+           p_config->workers > 0;
+}
+
+static int replay_log_add(replay_log* p_log, const replay_record* p_record)
+{
+    replay_record* p_records;
+
+    if (p_log->size == p_log->capacity)
+    {
+        p_records = realloc(p_log->records,
+                            2 * p_log->capacity * sizeof(replay_record));
+
+        if (!p_records)
+        {
+            return RETURN_STATUS_NO_MEMORY;
+        }
+
+        p_log->records = p_records;
+        p_log->capacity *= 2;
+    }
+
+    p_log->records[p_log->size++] = *p_record;
+    return RETURN_STATUS_OK;
+}
+
+static void replay_log_free(replay_log* p_log)
+{
+    if (p_log)
+    {
+        free(p_log->records);
+        free(p_log);
+    }
+}
+
+/*******************************************************************************
+* Reads the log. A line without a timestamp is due at the same time as the    *
+* line before it. Returns NULL and prints the line number of the first        *
+* malformed line.                                                             *
+*******************************************************************************/
+static replay_log* replay_log_load(const char* file_name)
+{
+    char line[LINE_CAPACITY];
+    char* p_cursor;
+    char* p_end;
+    replay_record record;
+    replay_log* p_log;
+    double timestamp;
+    size_t line_number = 0;
+    FILE* p_file = fopen(file_name, "r");
+
+    if (!p_file)
+    {
+        return NULL;
+    }
+
+    p_log = malloc(sizeof(*p_log));
+
+    if (!p_log || !(p_log->records = malloc(64 * sizeof(replay_record))))
+    {
+        free(p_log);
+        fclose(p_file);
+        return NULL;
+    }
+
+    p_log->size = 0;
+    p_log->capacity = 64;
+    record.timestamp = 0.0;
+
+    while (p_log && fgets(line, sizeof(line), p_file))
+    {
+        ++line_number;
+        p_cursor = line;
+
+        while (*p_cursor == ' ' || *p_cursor == '\t')
+        {
+            ++p_cursor;
+        }
+
+        if (*p_cursor == 'c' || *p_cursor == '#' ||
+            *p_cursor == '\n' || *p_cursor == '\0')
+        {
+            continue;
+        }
+
+        record.source_vertex_id = (vertex_id_t) strtoul(p_cursor, &p_end, 10);
+
+        if (p_end != p_cursor)
+        {
+            p_cursor = p_end;
+            record.target_vertex_id =
+                    (vertex_id_t) strtoul(p_cursor, &p_end, 10);
+        }
+
+        if (p_end == p_cursor)
+        {
+            fprintf(stderr, "%s:%lu: malformed record\n",
+                    file_name,
+                    (unsigned long) line_number);
+            replay_log_free(p_log);
+            p_log = NULL;
+            break;
+        }
+
+        /* 'record' still holds the timestamp of the line before: */
+        p_cursor = p_end;
+        timestamp = strtod(p_cursor, &p_end);
+
+        if (p_end != p_cursor)
+        {
+            record.timestamp = timestamp;
+        }
+
+        if (replay_log_add(p_log, &record) != RETURN_STATUS_OK)
+        {
+            replay_log_free(p_log);
+            p_log = NULL;
+        }
+    }
+
+    fclose(p_file);
+    return p_log;
+}
+
+static void sleep_until(double deadline)
+{
+    struct timespec duration;
+    double seconds = deadline - monotonic_clock_seconds();
+
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+
+    duration.tv_sec = (time_t) seconds;
+    duration.tv_nsec = (long)((seconds - (double) duration.tv_sec) * 1e9);
+    nanosleep(&duration, NULL);
+}
+
+static void* run_worker(void* p_argument)
+{
+    replay_worker* p_worker = p_argument;
+    replay_state* p_state = p_worker->p_state;
+    replay_record* p_record;
+    vertex_list* p_path;
+    search_options options;
+    double due;
+    double started;
+    size_t index;
+    int return_status;
+
+    search_options_init(&options);
+    options.p_metrics = query_metrics_get_shard(p_state->p_service,
+                                                p_worker->index);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&p_state->lock);
+        index = p_state->next_record++;
+        pthread_mutex_unlock(&p_state->lock);
+
+        if (index >= p_state->p_log->size)
+        {
+            break;
+        }
+
+        p_record = &p_state->p_log->records[index];
+        due = p_state->start;
+
+        if (p_state->config.speed > 0.0)
+        {
+            due += (p_record->timestamp -
+                    p_state->p_log->records[0].timestamp) /
+                   p_state->config.speed;
+            sleep_until(due);
+        }
+
+        started = monotonic_clock_seconds();
+
+        if (started - due > LATE_SECONDS && p_state->config.speed > 0.0)
+        {
+            ++p_worker->late;
+
+            if (p_worker->max_lateness < started - due)
+            {
+                p_worker->max_lateness = started - due;
+            }
+        }
+
+        p_path = p_state->config.unidirectional ?
+                 find_shortest_path_2_ex(p_state->p_graph,
+                                         p_record->source_vertex_id,
+                                         p_record->target_vertex_id,
+                                         &options,
+                                         &return_status) :
+                 find_shortest_path_ex(p_state->p_graph,
+                                       p_record->source_vertex_id,
+                                       p_record->target_vertex_id,
+                                       &options,
+                                       &return_status);
+
+        query_metrics_record(query_metrics_get_shard(p_state->p_response,
+                                                     p_worker->index),
+                             monotonic_clock_seconds() - due,
+                             return_status);
+
+        if (p_path)
+        {
+            vertex_list_free(p_path);
+        }
+    }
+
+    return NULL;
+}
+
+static void print_latencies(const char* name,
+                            const query_metrics_snapshot* p_snapshot)
+{
+    printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+           name,
+           p_snapshot->count ?
+           1e6 * p_snapshot->sum_seconds / (double) p_snapshot->count :
+           0.0,
+           1e6 * query_metrics_snapshot_percentile(p_snapshot, 0.50),
+           1e6 * query_metrics_snapshot_percentile(p_snapshot, 0.90),
+           1e6 * query_metrics_snapshot_percentile(p_snapshot, 0.99),
+           1e6 * query_metrics_snapshot_percentile(p_snapshot, 0.999),
+           1e6 * p_snapshot->max_seconds);
+}
+
+static int write_metrics(const char* file_name,
+                         const query_metrics_snapshot* p_snapshot)
+{
+    FILE* p_file = fopen(file_name, "w");
+    int written;
+
+    if (!p_file)
+    {
+        return FALSE;
+    }
+
+    written = query_metrics_write_prometheus(p_snapshot,
+                                             "bidir_replay",
+                                             p_file) == RETURN_STATUS_OK;
+
+    /* fclose() flushes, so it can fail even after a clean write: */
+    return fclose(p_file) == 0 && written;
+}
+
+int main(int argc, char** argv)
+{
+    replay_config config;
+    replay_state state;
+    replay_worker* workers;
+    query_metrics_snapshot* p_service;
+    query_metrics_snapshot* p_response;
+    double wall_seconds;
+    double log_seconds;
+    double max_lateness = 0.0;
+    size_t late = 0;
+    size_t started = 0;
+    size_t i;
+    int return_status = RETURN_STATUS_OK;
+
+    if (!parse_arguments(argc, argv, &config))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    state.p_graph = graph_io_load_dimacs(config.graph_file, &return_status);
+
+    if (!state.p_graph)
+    {
+        fprintf(stderr, "cannot read %s (status %d)\n",
+                config.graph_file,
+                return_status);
+        return EXIT_FAILURE;
+    }
+
+    if (config.compress && compressGraph(state.p_graph) != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot compress the graph\n");
+        return EXIT_FAILURE;
+    }
+
+    if (config.scc_index &&
+        graph_build_scc_index(state.p_graph) != RETURN_STATUS_OK)
+    {
+        fprintf(stderr, "cannot build the SCC index\n");
+        return EXIT_FAILURE;
+    }
+
+    state.p_log = replay_log_load(config.log_file);
+
+    if (!state.p_log)
+    {
+        fprintf(stderr, "cannot read the log %s\n", config.log_file);
+        return EXIT_FAILURE;
+    }
+
+    if (state.p_log->size == 0)
+    {
+        fprintf(stderr, "the log %s is empty\n", config.log_file);
+        return EXIT_FAILURE;
+    }
+
+    log_seconds = state.p_log->records[state.p_log->size - 1].timestamp -
+                  state.p_log->records[0].timestamp;
+
+    state.p_service = query_metrics_alloc(config.workers);
+    state.p_response = query_metrics_alloc(config.workers);
+    workers = calloc(config.workers, sizeof(replay_worker));
+    p_service = malloc(sizeof(*p_service));
+    p_response = malloc(sizeof(*p_response));
+
+    if (!state.p_service || !state.p_response || !workers ||
+        !p_service || !p_response)
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("log: %lu queries over %.3f s; replaying ",
+           (unsigned long) state.p_log->size,
+           log_seconds);
+
+    if (config.speed > 0.0)
+    {
+        printf("at %gx the original pacing", config.speed);
+    }
+    else
+    {
+        printf("as fast as possible");
+    }
+
+    printf(" with %lu workers\n", (unsigned long) config.workers);
+
+    pthread_mutex_init(&state.lock, NULL);
+    state.start = monotonic_clock_seconds();
+
+    /* The workers share the log, so fewer of them still replay all of it: */
+    while (started < config.workers)
+    {
+        workers[started].p_state = &state;
+        workers[started].index = started;
+
+        if (pthread_create(&workers[started].thread,
+                           NULL,
+                           run_worker,
+                           &workers[started]) != 0)
+        {
+            break;
+        }
+
+        ++started;
+    }
+
+    if (started == 0)
+    {
+        fprintf(stderr, "cannot start the workers\n");
+        return EXIT_FAILURE;
+    }
+
+    if (started < config.workers)
+    {
+        fprintf(stderr, "started only %lu workers\n", (unsigned long) started);
+    }
+
+    for (i = 0; i < started; ++i)
+    {
+        pthread_join(workers[i].thread, NULL);
+        late += workers[i].late;
+
+        if (max_lateness < workers[i].max_lateness)
+        {
+            max_lateness = workers[i].max_lateness;
+        }
+    }
+
+    wall_seconds = monotonic_clock_seconds() - state.start;
+    pthread_mutex_destroy(&state.lock);
+
+    query_metrics_snapshot_take(state.p_service, p_service);
+    query_metrics_snapshot_take(state.p_response, p_response);
+
+    printf("replayed in %.3f s: %.0f queries/s, ok %lu, no path %lu, "
+           "other %lu\n",
+           wall_seconds,
+           (double) p_service->count / wall_seconds,
+           (unsigned long) p_service->status_counts[0],
+           (unsigned long) p_service->status_counts[1],
+           (unsigned long)(p_service->count -
+                           p_service->status_counts[0] -
+                           p_service->status_counts[1]));
+
+    if (config.speed > 0.0)
+    {
+        printf("late by more than %.0f ms: %lu queries, at most %.3f s\n",
+               1e3 * LATE_SECONDS,
+               (unsigned long) late,
+               max_lateness);
+    }
+
+    printf("%-12s %10s %10s %10s %10s %10s %10s\n",
+           "latency", "mean_us", "p50_us", "p90_us", "p99_us", "p999_us",
+           "max_us");
+
+    print_latencies("service", p_service);
+
+    /* At full speed every query is due at the start; only pacing gives */
+    /* the time from arrival to answer a meaning:                       */
+    if (config.speed > 0.0)
+    {
+        print_latencies("response", p_response);
+    }
+
+    if (config.metrics_file && !write_metrics(config.metrics_file, p_service))
+    {
+        fprintf(stderr, "cannot write %s\n", config.metrics_file);
+    }
+
+    free(p_service);
+    free(p_response);
+    free(workers);
+    query_metrics_free(state.p_service);
+    query_metrics_free(state.p_response);
+    replay_log_free(state.p_log);
+    freeGraph(state.p_graph);
+    free(state.p_graph);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,825 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "algorithm.h"
+#include "graph.h"
+#include "graph_image.h"
+#include "graph_io.h"
+#include "server_protocol.h"
+#include "util.h"
+#include "vertex_list.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* How often the accept loop looks for a stop signal, in milliseconds: */
+#define POLL_MILLISECONDS 200
+
+typedef struct server_config {
+    const char* graph_file;
+    const char* image_file;
+    const char* socket_path;
+    size_t      workers;
+    size_t      queue_capacity;
+    size_t      max_batch;
+    long        send_timeout;
+    int         compress;
+    int         scc_index;
+} server_config;
+
+struct server_state;
+
+/*******************************************************************************
+* A client. The reader thread holds one reference and every request queued or *
+* running holds one more; the last to let go closes the socket. Workers       *
+* answering requests of the same client take turns on 'write_lock', which     *
+* also guards 'broken': set once a write fails, after which the remaining     *
+* requests of the client are dropped unanswered.                              *
+*******************************************************************************/
+typedef struct server_connection {
+    int                       socket;
+    pthread_mutex_t           write_lock;
+    int                       broken;
+    size_t                    references;
+    struct server_state*      p_server;
+    struct server_connection* p_next;
+} server_connection;
+
+/* One request; 'pairs' holds the sources and the targets interleaved: */
+typedef struct server_job {
+    server_connection* p_connection;
+    unsigned long      id;
+    unsigned           kind;
+    unsigned           flags;
+    size_t             count;
+    vertex_id_t*       pairs;
+} server_job;
+
+/*******************************************************************************
+* What the threads share, all guarded by 'lock'. The job queue is a ring of   *
+* 'queue_capacity' slots; a reader finding it full waits, and so stops        *
+* reading its socket until the workers catch up. That pushes back on the      *
+* clients instead of buffering without bound.                                 *
+*******************************************************************************/
+typedef struct server_state {
+    Graph*             p_graph;
+    server_config      config;
+    pthread_mutex_t    lock;
+    pthread_cond_t     not_empty;
+    pthread_cond_t     not_full;
+    pthread_cond_t     idle;       /* The last connection went away. */
+    server_job**       jobs;
+    size_t             head;
+    size_t             size;
+    int                closed;
+    server_connection* p_connections;
+    size_t             connection_count;
+    size_t             requests;
+    size_t             queries;
+} server_state;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static const char* USAGE_LINES[] = {
+    "  -g FILE     read the graph from a DIMACS file",
+    "  -I FILE     map the graph from an image (see bench -o)",
+    "  -s PATH     the Unix socket to listen on",
+    "  -w WORKERS  query threads (default 4)",
+    "  -Q SIZE     requests queued before the readers wait (default 256)",
+    "  -b PAIRS    the most pairs in one request (default 4096)",
+    "  -T SECONDS  drop a client that takes longer to accept an answer",
+    "              (default 10)",
+    "  -c          compress the graph before serving",
+    "  -i          build the SCC index before serving",
+    NULL
+};
+
+static void print_usage(const char* program)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s (-g FILE | -I FILE) -s PATH [options]\n",
+            program);
+
+    for (i = 0; USAGE_LINES[i]; ++i)
+    {
+        fprintf(stderr, "%s\n", USAGE_LINES[i]);
+    }
+}
+
+static int parse_arguments(int argc, char** argv, server_config* p_config)
+{
+    int i;
+
+    memset(p_config, 0, sizeof(*p_config));
+    p_config->workers = 4;
+    p_config->queue_capacity = 256;
+    p_config->max_batch = 4096;
+    p_config->send_timeout = 10;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'c':
+                p_config->compress = TRUE;
+                continue;
+
+            case 'i':
+                p_config->scc_index = TRUE;
+                continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            return FALSE;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 'g':
+                p_config->graph_file = argv[i];
+                break;
+
+            case 'I':
+                p_config->image_file = argv[i];
+                break;
+
+            case 's':
+                p_config->socket_path = argv[i];
+                break;
+
+            case 'w':
+                p_config->workers = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'Q':
+                p_config->queue_capacity = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'b':
+                p_config->max_batch = strtoul(argv[i], NULL, 10);
+                break;
+
+            case 'T':
+                p_config->send_timeout = strtol(argv[i], NULL, 10);
+                break;
+
+            default:
+                return FALSE;
+        }
+    }
+
+    return (p_config->graph_file != NULL) !=
+           (p_config->image_file != NULL) &&
+           p_config->socket_path &&
+           p_config->workers > 0 &&
+           p_config->queue_capacity > 0 &&
+           p_config->max_batch > 0 &&
+           p_config->send_timeout > 0;
+}
+
+static void handle_stop(int signal_number)
+{
+    (void) signal_number;
+    stop_requested = 1;
+}
+
+static void free_job(server_job* p_job)
+{
+    free(p_job->pairs);
+    free(p_job);
+}
+
+/* Returns FALSE if the server is shutting down: */
+static int queue_push(server_state* p_state, server_job* p_job)
+{
+    size_t capacity = p_state->config.queue_capacity;
+
+    pthread_mutex_lock(&p_state->lock);
+
+    while (p_state->size == capacity && !p_state->closed)
+    {
+        pthread_cond_wait(&p_state->not_full, &p_state->lock);
+    }
+
+    if (p_state->closed)
+    {
+        pthread_mutex_unlock(&p_state->lock);
+        return FALSE;
+    }
+
+    p_state->jobs[(p_state->head + p_state->size) % capacity] = p_job;
+    ++p_state->size;
+    ++p_job->p_connection->references;
+    pthread_cond_signal(&p_state->not_empty);
+    pthread_mutex_unlock(&p_state->lock);
+    return TRUE;
+}
+
+/* Returns NULL once the queue is closed and empty: */
+static server_job* queue_pop(server_state* p_state)
+{
+    server_job* p_job = NULL;
+
+    pthread_mutex_lock(&p_state->lock);
+
+    while (p_state->size == 0 && !p_state->closed)
+    {
+        pthread_cond_wait(&p_state->not_empty, &p_state->lock);
+    }
+
+    if (p_state->size > 0)
+    {
+        p_job = p_state->jobs[p_state->head];
+        p_state->head = (p_state->head + 1) % p_state->config.queue_capacity;
+        --p_state->size;
+        pthread_cond_signal(&p_state->not_full);
+    }
+
+    pthread_mutex_unlock(&p_state->lock);
+    return p_job;
+}
+
+static void release_connection(server_connection* p_connection)
+{
+    server_state* p_state = p_connection->p_server;
+    server_connection** pp_link;
+    int last;
+
+    pthread_mutex_lock(&p_state->lock);
+    last = --p_connection->references == 0;
+
+    if (last)
+    {
+        for (pp_link = &p_state->p_connections;
+             *pp_link != p_connection;
+             pp_link = &(*pp_link)->p_next)
+        {
+        }
+
+        *pp_link = p_connection->p_next;
+
+        if (--p_state->connection_count == 0)
+        {
+            pthread_cond_broadcast(&p_state->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&p_state->lock);
+
+    if (last)
+    {
+        close(p_connection->socket);
+        pthread_mutex_destroy(&p_connection->write_lock);
+        free(p_connection);
+    }
+}
+
+/*******************************************************************************
+* A client that stops reading its answers would otherwise hold the worker     *
+* writing to it forever, and in time every worker. The send timeout of the    *
+* socket ends such a write; the connection is then shut down, which ends its  *
+* reader, and its other requests are dropped.                                 *
+*******************************************************************************/
+static int send_frame(server_connection* p_connection,
+                      const server_buffer* p_buffer)
+{
+    int sent = FALSE;
+
+    pthread_mutex_lock(&p_connection->write_lock);
+
+    if (!p_connection->broken)
+    {
+        sent = server_write_all(p_connection->socket,
+                                p_buffer->bytes,
+                                p_buffer->size);
+
+        if (!sent)
+        {
+            p_connection->broken = TRUE;
+            shutdown(p_connection->socket, SHUT_RDWR);
+        }
+    }
+
+    pthread_mutex_unlock(&p_connection->write_lock);
+    return sent;
+}
+
+static int connection_broken(server_connection* p_connection)
+{
+    int broken;
+
+    pthread_mutex_lock(&p_connection->write_lock);
+    broken = p_connection->broken;
+    pthread_mutex_unlock(&p_connection->write_lock);
+    return broken;
+}
+
+static void send_error(server_connection* p_connection, unsigned long id)
+{
+    server_buffer buffer;
+
+    server_buffer_init(&buffer);
+    server_buffer_begin_frame(&buffer);
+
+    if (server_buffer_put_u32(&buffer, id) &&
+        server_buffer_put_u8(&buffer, SERVER_KIND_ERROR) &&
+        server_buffer_put_u8(&buffer, 0) &&
+        server_buffer_put_u16(&buffer, 0) &&
+        server_buffer_put_u32(&buffer, 0))
+    {
+        server_buffer_end_frame(&buffer);
+        send_frame(p_connection, &buffer);
+    }
+
+    server_buffer_free(&buffer);
+}
+
+/*******************************************************************************
+* Decodes the request in 'p_body' into a new job, or returns NULL if it is    *
+* malformed or memory runs out.                                               *
+*******************************************************************************/
+static server_job* parse_request(server_connection* p_connection,
+                                 const server_buffer* p_body)
+{
+    const unsigned char* p_bytes = p_body->bytes;
+    size_t max_batch = p_connection->p_server->config.max_batch;
+    server_job* p_job;
+    size_t count;
+    size_t i;
+
+    if (p_body->size < SERVER_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    count = server_get_u32(p_bytes + 8);
+
+    if (count == 0 ||
+        count > max_batch ||
+        p_body->size != SERVER_HEADER_SIZE + SERVER_PAIR_SIZE * count ||
+        (p_bytes[4] == SERVER_KIND_SINGLE && count != 1) ||
+        (p_bytes[4] != SERVER_KIND_SINGLE &&
+         p_bytes[4] != SERVER_KIND_BATCH &&
+         p_bytes[4] != SERVER_KIND_DISTANCE))
+    {
+        return NULL;
+    }
+
+    p_job = malloc(sizeof(*p_job));
+
+    if (!p_job || !(p_job->pairs = malloc(2 * count * sizeof(vertex_id_t))))
+    {
+        free(p_job);
+        return NULL;
+    }
+
+    p_job->p_connection = p_connection;
+    p_job->id = server_get_u32(p_bytes);
+    p_job->kind = p_bytes[4];
+    p_job->flags = p_bytes[5];
+    p_job->count = count;
+    p_bytes += SERVER_HEADER_SIZE;
+
+    for (i = 0; i < 2 * count; ++i)
+    {
+        p_job->pairs[i] = (vertex_id_t) server_get_u64(p_bytes + 8 * i);
+    }
+
+    return p_job;
+}
+
+static void* run_reader(void* p_argument)
+{
+    server_connection* p_connection = p_argument;
+    server_state* p_state = p_connection->p_server;
+    server_buffer body;
+    server_job* p_job;
+    size_t max_size = SERVER_HEADER_SIZE +
+                      SERVER_PAIR_SIZE * p_state->config.max_batch;
+
+    server_buffer_init(&body);
+
+    while (server_read_frame(p_connection->socket, &body, max_size))
+    {
+        p_job = parse_request(p_connection, &body);
+
+        if (!p_job)
+        {
+            send_error(p_connection,
+                       body.size >= 4 ? server_get_u32(body.bytes) : 0);
+            break;
+        }
+
+        if (!queue_push(p_state, p_job))
+        {
+            free_job(p_job);
+            break;
+        }
+    }
+
+    server_buffer_free(&body);
+    release_connection(p_connection);
+    return NULL;
+}
+
+/*******************************************************************************
+* Runs the queries of 'p_job' and writes the response into 'p_buffer'.        *
+* Returns FALSE if the buffer cannot grow.                                    *
+*******************************************************************************/
+static int answer_job(server_state* p_state,
+                      server_job* p_job,
+                      const search_options* p_options,
+                      server_buffer* p_buffer)
+{
+    search_options options = *p_options;
+    vertex_list* p_path;
+    weight_t distance;
+    size_t vertex_count;
+    size_t i;
+    size_t j;
+    int return_status;
+    int ok;
+
+    /* The search reports the distance, so no answer walks its path: */
+    options.p_distance = &distance;
+
+    server_buffer_begin_frame(p_buffer);
+    ok = server_buffer_put_u32(p_buffer, p_job->id) &&
+         server_buffer_put_u8(p_buffer, p_job->kind) &&
+         server_buffer_put_u8(p_buffer, 0) &&
+         server_buffer_put_u16(p_buffer, 0) &&
+         server_buffer_put_u32(p_buffer, (unsigned long) p_job->count);
+
+    for (i = 0; ok && i < p_job->count; ++i)
+    {
+        p_path = p_job->flags & SERVER_FLAG_UNIDIRECTIONAL ?
+                 find_shortest_path_2_ex(p_state->p_graph,
+                                         p_job->pairs[2 * i],
+                                         p_job->pairs[2 * i + 1],
+                                         &options,
+                                         &return_status) :
+                 find_shortest_path_ex(p_state->p_graph,
+                                       p_job->pairs[2 * i],
+                                       p_job->pairs[2 * i + 1],
+                                       &options,
+                                       &return_status);
+
+        vertex_count = p_path && p_job->kind != SERVER_KIND_DISTANCE ?
+                       vertex_list_size(p_path) :
+                       0;
+
+        ok = server_buffer_put_u32(p_buffer, (unsigned long) return_status) &&
+             server_buffer_put_f64(p_buffer,
+                                   p_path ? (double) distance : -1.0) &&
+             server_buffer_put_u32(p_buffer, (unsigned long) vertex_count);
+
+        for (j = 0; ok && j < vertex_count; ++j)
+        {
+            ok = server_buffer_put_u64(p_buffer,
+                                       (size_t) vertex_list_get(p_path, j));
+        }
+
+        if (p_path)
+        {
+            vertex_list_free(p_path);
+        }
+    }
+
+    server_buffer_end_frame(p_buffer);
+    return ok;
+}
+
+static void* run_worker(void* p_argument)
+{
+    server_state* p_state = p_argument;
+    search_options options;
+    server_buffer buffer;
+    server_job* p_job;
+
+    search_options_init(&options);
+
+    /* Without a workspace the queries allocate their own containers: */
+    options.p_workspace = search_workspace_alloc();
+    server_buffer_init(&buffer);
+
+    while ((p_job = queue_pop(p_state)))
+    {
+        /* Skip the searches when nobody would read the answer: */
+        if (!connection_broken(p_job->p_connection))
+        {
+            if (answer_job(p_state, p_job, &options, &buffer))
+            {
+                send_frame(p_job->p_connection, &buffer);
+            }
+            else
+            {
+                send_error(p_job->p_connection, p_job->id);
+            }
+        }
+
+        pthread_mutex_lock(&p_state->lock);
+        ++p_state->requests;
+        p_state->queries += p_job->count;
+        pthread_mutex_unlock(&p_state->lock);
+
+        release_connection(p_job->p_connection);
+        free_job(p_job);
+    }
+
+    server_buffer_free(&buffer);
+    search_workspace_free(options.p_workspace);
+    return NULL;
+}
+
+/* Removes a socket left by an earlier run, but never any other file: */
+static void remove_stale_socket(const char* path)
+{
+    struct stat status;
+
+    if (stat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        unlink(path);
+    }
+}
+
+static int open_listener(const char* path)
+{
+    struct sockaddr_un address;
+    int listener;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "the socket path is too long\n");
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    remove_stale_socket(path);
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 ||
+        bind(listener, (struct sockaddr*) &address, sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0)
+    {
+        perror(path);
+
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+
+        return -1;
+    }
+
+    return listener;
+}
+
+static void install_signal_handlers(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = handle_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    /* A client that hangs up shows as a failed write, not a signal: */
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+}
+
+static int add_connection(server_state* p_state, int socket)
+{
+    server_connection* p_connection = malloc(sizeof(*p_connection));
+    struct timeval timeout;
+    pthread_attr_t attributes;
+    pthread_t thread;
+    int started;
+
+    if (!p_connection)
+    {
+        close(socket);
+        return FALSE;
+    }
+
+    timeout.tv_sec = p_state->config.send_timeout;
+    timeout.tv_usec = 0;
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    p_connection->socket = socket;
+    p_connection->broken = FALSE;
+    p_connection->references = 1;
+    p_connection->p_server = p_state;
+    pthread_mutex_init(&p_connection->write_lock, NULL);
+
+    pthread_mutex_lock(&p_state->lock);
+    p_connection->p_next = p_state->p_connections;
+    p_state->p_connections = p_connection;
+    ++p_state->connection_count;
+    pthread_mutex_unlock(&p_state->lock);
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    started = pthread_create(&thread,
+                             &attributes,
+                             run_reader,
+                             p_connection) == 0;
+    pthread_attr_destroy(&attributes);
+
+    if (!started)
+    {
+        release_connection(p_connection);
+    }
+
+    return started;
+}
+
+static void accept_connections(server_state* p_state, int listener)
+{
+    struct pollfd poll_entry;
+    int socket;
+
+    poll_entry.fd = listener;
+    poll_entry.events = POLLIN;
+
+    while (!stop_requested)
+    {
+        if (poll(&poll_entry, 1, POLL_MILLISECONDS) <= 0)
+        {
+            continue;
+        }
+
+        socket = accept(listener, NULL, NULL);
+
+        if (socket >= 0)
+        {
+            add_connection(p_state, socket);
+        }
+    }
+}
+
+/*******************************************************************************
+* Hangs up on every client, waits for the readers and the requests in flight  *
+* to let go of their connections, then stops the workers.                     *
+*******************************************************************************/
+static void shut_down(server_state* p_state,
+                      pthread_t* workers,
+                      size_t worker_count)
+{
+    server_connection* p_connection;
+    size_t i;
+
+    pthread_mutex_lock(&p_state->lock);
+
+    for (p_connection = p_state->p_connections;
+         p_connection;
+         p_connection = p_connection->p_next)
+    {
+        shutdown(p_connection->socket, SHUT_RDWR);
+    }
+
+    while (p_state->connection_count > 0)
+    {
+        pthread_cond_wait(&p_state->idle, &p_state->lock);
+    }
+
+    p_state->closed = TRUE;
+    pthread_cond_broadcast(&p_state->not_empty);
+    pthread_cond_broadcast(&p_state->not_full);
+    pthread_mutex_unlock(&p_state->lock);
+
+    for (i = 0; i < worker_count; ++i)
+    {
+        pthread_join(workers[i], NULL);
+    }
+}
+
+static Graph* load_graph(const server_config* p_config)
+{
+    int return_status = RETURN_STATUS_OK;
+    Graph* p_graph = p_config->graph_file ?
+                     graph_io_load_dimacs(p_config->graph_file,
+                                          &return_status) :
+                     graph_image_map(p_config->image_file, &return_status);
+
+    if (!p_graph)
+    {
+        fprintf(stderr, "cannot load the graph (status %d)\n", return_status);
+        return NULL;
+    }
+
+    if ((p_config->compress &&
+         compressGraph(p_graph) != RETURN_STATUS_OK) ||
+        (p_config->scc_index &&
+         graph_build_scc_index(p_graph) != RETURN_STATUS_OK))
+    {
+        fprintf(stderr, "cannot prepare the graph\n");
+        freeGraph(p_graph);
+        free(p_graph);
+        return NULL;
+    }
+
+    return p_graph;
+}
+
+int main(int argc, char** argv)
+{
+    server_state state;
+    pthread_t* workers;
+    size_t started = 0;
+    int listener;
+
+    if (!parse_arguments(argc, argv, &state.config))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    state.p_graph = load_graph(&state.config);
+
+    if (!state.p_graph)
+    {
+        return EXIT_FAILURE;
+    }
+
+    state.jobs = malloc(state.config.queue_capacity * sizeof(server_job*));
+    workers = malloc(state.config.workers * sizeof(pthread_t));
+
+    if (!state.jobs || !workers)
+    {
+        return EXIT_FAILURE;
+    }
+
+    state.head = 0;
+    state.size = 0;
+    state.closed = FALSE;
+    state.p_connections = NULL;
+    state.connection_count = 0;
+    state.requests = 0;
+    state.queries = 0;
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.not_empty, NULL);
+    pthread_cond_init(&state.not_full, NULL);
+    pthread_cond_init(&state.idle, NULL);
+
+    install_signal_handlers();
+    listener = open_listener(state.config.socket_path);
+
+    if (listener < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    while (started < state.config.workers &&
+           pthread_create(&workers[started], NULL, run_worker, &state) == 0)
+    {
+        ++started;
+    }
+
+    if (started == 0)
+    {
+        fprintf(stderr, "cannot start the workers\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "serving on %s with %lu workers\n",
+            state.config.socket_path,
+            (unsigned long) started);
+
+    accept_connections(&state, listener);
+    close(listener);
+    unlink(state.config.socket_path);
+    shut_down(&state, workers, started);
+
+    fprintf(stderr, "answered %lu requests, %lu queries\n",
+            (unsigned long) state.requests,
+            (unsigned long) state.queries);
+
+    pthread_cond_destroy(&state.idle);
+    pthread_cond_destroy(&state.not_full);
+    pthread_cond_destroy(&state.not_empty);
+    pthread_mutex_destroy(&state.lock);
+    free(workers);
+    free(state.jobs);
+    freeGraph(state.p_graph);
+    free(state.p_graph);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "server_protocol.h"
+#include "util.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define INITIAL_CAPACITY 256
+
+void server_buffer_init(server_buffer* p_buffer)
+{
+    p_buffer->bytes = NULL;
+    p_buffer->size = 0;
+    p_buffer->capacity = 0;
+}
+
+void server_buffer_free(server_buffer* p_buffer)
+{
+    free(p_buffer->bytes);
+    server_buffer_init(p_buffer);
+}
+
+static int reserve(server_buffer* p_buffer, size_t size)
+{
+    unsigned char* p_bytes;
+    size_t capacity = p_buffer->capacity ? p_buffer->capacity :
+                                           INITIAL_CAPACITY;
+
+    if (p_buffer->size + size <= p_buffer->capacity)
+    {
+        return TRUE;
+    }
+
+    while (capacity < p_buffer->size + size)
+    {
+        capacity *= 2;
+    }
+
+    p_bytes = realloc(p_buffer->bytes, capacity);
+
+    if (!p_bytes)
+    {
+        return FALSE;
+    }
+
+    p_buffer->bytes = p_bytes;
+    p_buffer->capacity = capacity;
+    return TRUE;
+}
+
+/* Writes the low 'size' bytes of 'value', lowest first; a 32-bit size_t */
+/* writes zeros for the high half of a u64:                              */
+static int put(server_buffer* p_buffer, size_t value, size_t size)
+{
+    size_t i;
+
+    if (!reserve(p_buffer, size))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < size; ++i)
+    {
+        p_buffer->bytes[p_buffer->size++] = (unsigned char)(value & 0xff);
+        value >>= 8;
+    }
+
+    return TRUE;
+}
+
+void server_buffer_begin_frame(server_buffer* p_buffer)
+{
+    p_buffer->size = 0;
+    put(p_buffer, 0, 4);
+}
+
+void server_buffer_end_frame(server_buffer* p_buffer)
+{
+    size_t body_size = p_buffer->size - 4;
+    size_t i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        p_buffer->bytes[i] = (unsigned char)((body_size >> (8 * i)) & 0xff);
+    }
+}
+
+int server_buffer_put_u8(server_buffer* p_buffer, unsigned value)
+{
+    return put(p_buffer, value, 1);
+}
+
+int server_buffer_put_u16(server_buffer* p_buffer, unsigned value)
+{
+    return put(p_buffer, value, 2);
+}
+
+int server_buffer_put_u32(server_buffer* p_buffer, unsigned long value)
+{
+    return put(p_buffer, (size_t) value, 4);
+}
+
+int server_buffer_put_u64(server_buffer* p_buffer, size_t value)
+{
+    return put(p_buffer, value, 8);
+}
+
+static int little_endian(void)
+{
+    unsigned value = 1;
+    return *(unsigned char*) &value == 1;
+}
+
+/* Copies the 8 bytes of a double between host and little-endian order: */
+static void swap_double(const unsigned char* p_source, unsigned char* p_target)
+{
+    size_t i;
+
+    for (i = 0; i < 8; ++i)
+    {
+        p_target[i] = little_endian() ? p_source[i] : p_source[7 - i];
+    }
+}
+
+int server_buffer_put_f64(server_buffer* p_buffer, double value)
+{
+    if (!reserve(p_buffer, sizeof(double)))
+    {
+        return FALSE;
+    }
+
+    swap_double((const unsigned char*) &value,
+                p_buffer->bytes + p_buffer->size);
+
+    p_buffer->size += sizeof(double);
+    return TRUE;
+}
+
+unsigned long server_get_u32(const unsigned char* p_bytes)
+{
+    return (unsigned long) p_bytes[0] |
+           (unsigned long) p_bytes[1] << 8 |
+           (unsigned long) p_bytes[2] << 16 |
+           (unsigned long) p_bytes[3] << 24;
+}
+
+size_t server_get_u64(const unsigned char* p_bytes)
+{
+    size_t value = 0;
+    size_t i;
+
+    for (i = 8; i > 0; --i)
+    {
+        value = (value << 8) | p_bytes[i - 1];
+    }
+
+    return value;
+}
+
+double server_get_f64(const unsigned char* p_bytes)
+{
+    double value;
+
+    swap_double(p_bytes, (unsigned char*) &value);
+    return value;
+}
+
+int server_read_all(int socket, void* p_bytes, size_t size)
+{
+    unsigned char* p_cursor = p_bytes;
+    ssize_t count;
+
+    while (size > 0)
+    {
+        count = read(socket, p_cursor, size);
+
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (count <= 0)
+        {
+            return FALSE;
+        }
+
+        p_cursor += count;
+        size -= (size_t) count;
+    }
+
+    return TRUE;
+}
+
+int server_write_all(int socket, const void* p_bytes, size_t size)
+{
+    const unsigned char* p_cursor = p_bytes;
+    ssize_t count;
+
+    while (size > 0)
+    {
+        count = write(socket, p_cursor, size);
+
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (count <= 0)
+        {
+            return FALSE;
+        }
+
+        p_cursor += count;
+        size -= (size_t) count;
+    }
+
+    return TRUE;
+}
+
+int server_read_frame(int socket, server_buffer* p_buffer, size_t max_size)
+{
+    unsigned char length[4];
+    size_t body_size;
+
+    if (!server_read_all(socket, length, sizeof(length)))
+    {
+        return FALSE;
+    }
+
+    body_size = server_get_u32(length);
+    p_buffer->size = 0;
+
+    if (body_size > max_size || !reserve(p_buffer, body_size))
+    {
+        return FALSE;
+    }
+
+    p_buffer->size = body_size;
+    return server_read_all(socket, p_buffer->bytes, body_size);
+}
@@ -0,0 +1,78 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_SERVER_PROTOCOL_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_SERVER_PROTOCOL_H
+
+#include <stdlib.h>
+
+/*******************************************************************************
+* The frames of the query server. Integers are little-endian, distances are   *
+* IEEE doubles sent as their bits in a u64. Every frame is a u32 holding the  *
+* length of the body that follows. A request body is                          *
+*                                                                             *
+*     u32 id, u8 kind, u8 flags, u16 zero, u32 count,                         *
+*     count times: u64 source, u64 target                                     *
+*                                                                             *
+* and the response to it is                                                   *
+*                                                                             *
+*     u32 id, u8 kind, u8 zero, u16 zero, u32 count,                          *
+*     count times: u32 status, f64 distance, u32 size, size times: u64 vertex *
+*                                                                             *
+* with the id and the kind of the request. A SINGLE request has one pair, a   *
+* BATCH request any number up to the limit of the server, and a DISTANCE      *
+* request any number whose answers carry no vertices. The status is one of    *
+* the RETURN_STATUS_* codes; the distance is -1 if there is no path. A client *
+* may send requests without waiting for the answers, which come back as they  *
+* finish, not necessarily in order. A malformed request gets a response of    *
+* kind ERROR and no results, and the server closes the connection; it closes  *
+* it without a response when a frame is longer than a full batch.             *
+*******************************************************************************/
+#define SERVER_KIND_SINGLE   1
+#define SERVER_KIND_BATCH    2
+#define SERVER_KIND_DISTANCE 3
+#define SERVER_KIND_ERROR    255
+
+/* Run the unidirectional search: */
+#define SERVER_FLAG_UNIDIRECTIONAL 1
+
+#define SERVER_HEADER_SIZE  12
+#define SERVER_PAIR_SIZE    16
+#define SERVER_RESULT_SIZE  16 /* Without the vertices. */
+
+/* A growing byte buffer a frame is built in: */
+typedef struct server_buffer {
+    unsigned char* bytes;
+    size_t         size;
+    size_t         capacity;
+} server_buffer;
+
+void server_buffer_init(server_buffer* p_buffer);
+
+void server_buffer_free(server_buffer* p_buffer);
+
+/* Starts a frame; server_buffer_end_frame() fills in its length: */
+void server_buffer_begin_frame(server_buffer* p_buffer);
+
+void server_buffer_end_frame(server_buffer* p_buffer);
+
+/* The put functions return FALSE if the buffer cannot grow: */
+int server_buffer_put_u8 (server_buffer* p_buffer, unsigned value);
+int server_buffer_put_u16(server_buffer* p_buffer, unsigned value);
+int server_buffer_put_u32(server_buffer* p_buffer, unsigned long value);
+int server_buffer_put_u64(server_buffer* p_buffer, size_t value);
+int server_buffer_put_f64(server_buffer* p_buffer, double value);
+
+unsigned long server_get_u32(const unsigned char* p_bytes);
+size_t        server_get_u64(const unsigned char* p_bytes);
+double        server_get_f64(const unsigned char* p_bytes);
+
+/* Retry on short transfers and signals; return FALSE on error or EOF: */
+int server_read_all (int socket, void* p_bytes, size_t size);
+int server_write_all(int socket, const void* p_bytes, size_t size);
+
+/*******************************************************************************
+* Reads one frame into 'p_buffer', which holds only its body afterwards.      *
+* Returns FALSE at the end of the stream, on an error, or if the body is      *
+* longer than 'max_size'.                                                     *
+*******************************************************************************/
+int server_read_frame(int socket, server_buffer* p_buffer, size_t max_size);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_TOOLS_SERVER_PROTOCOL_H */
@@ -1,6 +1,26 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_UTIL_H
 #define COM_GITHUB_CODERODDE_BIDIR_SEARCH_UTIL_H
 
+#include <float.h>
+#include <stddef.h>
+
+/*******************************************************************************
+* Vertex IDs and edge weights. Compiling with BIDIR_SEARCH_COMPACT_TYPES      *
+* (make COMPACT=1) switches to 32-bit IDs and single precision weights, which *
+* halves the size of every container entry on the search hot path. Use it     *
+* only when all vertex IDs fit in 32 bits.                                    *
+*******************************************************************************/
+#ifdef BIDIR_SEARCH_COMPACT_TYPES
+#include <stdint.h>
+typedef uint32_t vertex_id_t;
+typedef float    weight_t;
+#define WEIGHT_MAX FLT_MAX
+#else
+typedef size_t   vertex_id_t;
+typedef double   weight_t;
+#define WEIGHT_MAX DBL_MAX
+#endif
+
 /* todo: Anything better here? */
 #define RETURN_STATUS_OK                      0
 #define RETURN_STATUS_ADDING_DUPLICATE_VERTEX 1
@@ -12,6 +32,13 @@
 #define RETURN_STATUS_NO_MAP                  7
 #define RETURN_STATUS_NO_SOURCE_VERTEX        8
 #define RETURN_STATUS_NO_TARGET_VERTEX        16
+#define RETURN_STATUS_READ_ONLY_GRAPH         32
+#define RETURN_STATUS_NO_EDGE                 64
+#define RETURN_STATUS_BOUND_EXCEEDED          128
+#define RETURN_STATUS_CANCELLED               256
+#define RETURN_STATUS_DEADLINE_EXCEEDED       512
+#define RETURN_STATUS_QUEUE_FULL              1024
+#define RETURN_STATUS_IO_ERROR                2048
 
 #define FALSE 0
 #define TRUE 1
@@ -0,0 +1,290 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "versioned_graph.h"
+#include "allocator.h"
+#include "graph.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/* A reader slot holding this value is not pinning any version: */
+#define IDLE_EPOCH ((size_t) -1)
+
+static void release_graph(Graph* p_graph)
+{
+    freeGraph(p_graph);
+    allocator_free(p_graph);
+}
+
+/*******************************************************************************
+* Takes the ownership of 'p_graph'. At most 'reader_slots' queries may pin a  *
+* version at the same time.                                                   *
+*******************************************************************************/
+versioned_graph* versioned_graph_alloc(Graph* p_graph, size_t reader_slots)
+{
+    versioned_graph* p_versioned_graph;
+    size_t i;
+
+    if (!p_graph || reader_slots == 0)
+    {
+        return NULL;
+    }
+
+    p_versioned_graph = allocator_malloc(sizeof(*p_versioned_graph));
+
+    if (!p_versioned_graph)
+    {
+        return NULL;
+    }
+
+    p_versioned_graph->reader_epochs =
+            allocator_malloc(sizeof(size_t) * reader_slots);
+
+    if (!p_versioned_graph->reader_epochs)
+    {
+        allocator_free(p_versioned_graph);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&p_versioned_graph->writer_lock, NULL) != 0)
+    {
+        allocator_free(p_versioned_graph->reader_epochs);
+        allocator_free(p_versioned_graph);
+        return NULL;
+    }
+
+    for (i = 0; i < reader_slots; ++i)
+    {
+        p_versioned_graph->reader_epochs[i] = IDLE_EPOCH;
+    }
+
+    p_versioned_graph->p_current = p_graph;
+    p_versioned_graph->p_draft = NULL;
+    p_versioned_graph->epoch = 0;
+    p_versioned_graph->reader_slots = reader_slots;
+    p_versioned_graph->p_retired = NULL;
+
+    return p_versioned_graph;
+}
+
+/*******************************************************************************
+* Frees every version. No query may have a version pinned.                    *
+*******************************************************************************/
+void versioned_graph_free(versioned_graph* p_versioned_graph)
+{
+    versioned_graph_retired* p_retired;
+    versioned_graph_retired* p_next_retired;
+
+    if (!p_versioned_graph)
+    {
+        return;
+    }
+
+    for (p_retired = p_versioned_graph->p_retired;
+         p_retired;
+         p_retired = p_next_retired)
+    {
+        p_next_retired = p_retired->next;
+        release_graph(p_retired->p_graph);
+        allocator_free(p_retired);
+    }
+
+    if (p_versioned_graph->p_draft)
+    {
+        release_graph(p_versioned_graph->p_draft);
+    }
+
+    release_graph(p_versioned_graph->p_current);
+    pthread_mutex_destroy(&p_versioned_graph->writer_lock);
+    allocator_free(p_versioned_graph->reader_epochs);
+    allocator_free(p_versioned_graph);
+}
+
+/*******************************************************************************
+* Pins the current version for a query and stores the slot to pass to         *
+* versioned_graph_unpin() in '*p_slot'. The returned graph stays valid and    *
+* unchanged until it is unpinned. Returns NULL if all slots are taken.        *
+*******************************************************************************/
+Graph* versioned_graph_pin(versioned_graph* p_versioned_graph,
+                           size_t* p_slot)
+{
+    size_t i;
+    size_t expected;
+    size_t epoch = __atomic_load_n(&p_versioned_graph->epoch,
+                                   __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < p_versioned_graph->reader_slots; ++i)
+    {
+        expected = IDLE_EPOCH;
+
+        /* Announce the epoch before loading the version pointer, so that a */
+        /* writer retiring the version we are about to load sees us.        */
+        if (__atomic_compare_exchange_n(&p_versioned_graph->reader_epochs[i],
+                                        &expected,
+                                        epoch,
+                                        FALSE,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED))
+        {
+            *p_slot = i;
+            return __atomic_load_n(&p_versioned_graph->p_current,
+                                   __ATOMIC_SEQ_CST);
+        }
+    }
+
+    *p_slot = VERSIONED_GRAPH_NO_SLOT;
+    return NULL;
+}
+
+void versioned_graph_unpin(versioned_graph* p_versioned_graph, size_t slot)
+{
+    if (slot < p_versioned_graph->reader_slots)
+    {
+        __atomic_store_n(&p_versioned_graph->reader_epochs[slot],
+                         IDLE_EPOCH,
+                         __ATOMIC_RELEASE);
+    }
+}
+
+/*******************************************************************************
+* Starts an update: takes the writer lock and returns a private copy of the   *
+* current version on which addEdge(), removeEdge(), removeVertex() etc. may   *
+* be called freely. Finish with versioned_graph_publish() or                  *
+* versioned_graph_abort_update(). The copy has no SCC index; publishing       *
+* builds one if the current version has one.                                  *
+*******************************************************************************/
+Graph* versioned_graph_begin_update(versioned_graph* p_versioned_graph)
+{
+    pthread_mutex_lock(&p_versioned_graph->writer_lock);
+    p_versioned_graph->p_draft = cloneGraph(p_versioned_graph->p_current);
+
+    if (!p_versioned_graph->p_draft)
+    {
+        pthread_mutex_unlock(&p_versioned_graph->writer_lock);
+    }
+
+    return p_versioned_graph->p_draft;
+}
+
+/*******************************************************************************
+* Must be called with the writer lock held.                                   *
+*******************************************************************************/
+static size_t reclaim_locked(versioned_graph* p_versioned_graph)
+{
+    versioned_graph_retired** pp_retired;
+    versioned_graph_retired* p_retired;
+    size_t oldest_epoch = IDLE_EPOCH;
+    size_t reader_epoch;
+    size_t reclaimed = 0;
+    size_t i;
+
+    for (i = 0; i < p_versioned_graph->reader_slots; ++i)
+    {
+        reader_epoch = __atomic_load_n(&p_versioned_graph->reader_epochs[i],
+                                       __ATOMIC_SEQ_CST);
+
+        if (oldest_epoch > reader_epoch)
+        {
+            oldest_epoch = reader_epoch;
+        }
+    }
+
+    pp_retired = &p_versioned_graph->p_retired;
+
+    while (*pp_retired)
+    {
+        p_retired = *pp_retired;
+
+        /* Readers pinned in a later epoch loaded a newer version: */
+        if (p_retired->epoch < oldest_epoch)
+        {
+            *pp_retired = p_retired->next;
+            release_graph(p_retired->p_graph);
+            allocator_free(p_retired);
+            ++reclaimed;
+        }
+        else
+        {
+            pp_retired = &p_retired->next;
+        }
+    }
+
+    return reclaimed;
+}
+
+/*******************************************************************************
+* Makes the draft the current version, retires the previous one, frees the    *
+* versions no query can see any more and releases the writer lock. If the     *
+* current version has an SCC index, the draft gets a fresh one first, so that *
+* the queries on the new version keep rejecting unreachable targets up front; *
+* if that fails, the update is aborted.                                       *
+*******************************************************************************/
+int versioned_graph_publish(versioned_graph* p_versioned_graph)
+{
+    versioned_graph_retired* p_retired;
+    Graph* p_draft = p_versioned_graph->p_draft;
+    int rs;
+
+    if (!p_draft)
+    {
+        return RETURN_STATUS_NO_GRAPH;
+    }
+
+    if (p_versioned_graph->p_current->p_scc_index &&
+        !graph_scc_index(p_draft) &&
+        (rs = graph_build_scc_index(p_draft)) != RETURN_STATUS_OK)
+    {
+        versioned_graph_abort_update(p_versioned_graph);
+        return rs;
+    }
+
+    p_retired = allocator_malloc(sizeof(*p_retired));
+
+    if (!p_retired)
+    {
+        versioned_graph_abort_update(p_versioned_graph);
+        return RETURN_STATUS_NO_MEMORY;
+    }
+
+    p_retired->p_graph =
+            __atomic_exchange_n(&p_versioned_graph->p_current,
+                                p_versioned_graph->p_draft,
+                                __ATOMIC_SEQ_CST);
+
+    p_retired->epoch = __atomic_fetch_add(&p_versioned_graph->epoch,
+                                          1,
+                                          __ATOMIC_SEQ_CST);
+
+    p_retired->next = p_versioned_graph->p_retired;
+    p_versioned_graph->p_retired = p_retired;
+    p_versioned_graph->p_draft = NULL;
+
+    reclaim_locked(p_versioned_graph);
+    pthread_mutex_unlock(&p_versioned_graph->writer_lock);
+    return RETURN_STATUS_OK;
+}
+
+void versioned_graph_abort_update(versioned_graph* p_versioned_graph)
+{
+    if (p_versioned_graph->p_draft)
+    {
+        release_graph(p_versioned_graph->p_draft);
+        p_versioned_graph->p_draft = NULL;
+    }
+
+    pthread_mutex_unlock(&p_versioned_graph->writer_lock);
+}
+
+/*******************************************************************************
+* Frees the retired versions no query can see any more and returns their      *
+* count. Publishing does this too; call it to reclaim between updates.        *
+*******************************************************************************/
+size_t versioned_graph_reclaim(versioned_graph* p_versioned_graph)
+{
+    size_t reclaimed;
+
+    pthread_mutex_lock(&p_versioned_graph->writer_lock);
+    reclaimed = reclaim_locked(p_versioned_graph);
+    pthread_mutex_unlock(&p_versioned_graph->writer_lock);
+    return reclaimed;
+}
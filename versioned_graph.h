@@ -0,0 +1,49 @@
+#ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_VERSIONED_GRAPH_H
+#define COM_GITHUB_CODERODDE_BIDIR_SEARCH_VERSIONED_GRAPH_H
+
+#include "graph.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+#define VERSIONED_GRAPH_NO_SLOT ((size_t) -1)
+
+typedef struct versioned_graph_retired {
+    Graph*                          p_graph;
+    size_t                          epoch;
+    struct versioned_graph_retired* next;
+} versioned_graph_retired;
+
+/*******************************************************************************
+* A copy-on-write graph handle. Queries pin the current version and never     *
+* block; a single writer at a time mutates a private copy and publishes it.   *
+* Replaced versions are freed by epoch-based reclamation once no pinned       *
+* query can still see them.                                                   *
+*******************************************************************************/
+typedef struct versioned_graph {
+    Graph*                   p_current;
+    Graph*                   p_draft;
+    size_t                   epoch;
+    size_t*                  reader_epochs;
+    size_t                   reader_slots;
+    versioned_graph_retired* p_retired;
+    pthread_mutex_t          writer_lock;
+} versioned_graph;
+
+versioned_graph* versioned_graph_alloc(Graph* p_graph, size_t reader_slots);
+
+void versioned_graph_free(versioned_graph* p_versioned_graph);
+
+Graph* versioned_graph_pin(versioned_graph* p_versioned_graph,
+                           size_t* p_slot);
+
+void versioned_graph_unpin(versioned_graph* p_versioned_graph, size_t slot);
+
+Graph* versioned_graph_begin_update(versioned_graph* p_versioned_graph);
+
+int versioned_graph_publish(versioned_graph* p_versioned_graph);
+
+void versioned_graph_abort_update(versioned_graph* p_versioned_graph);
+
+size_t versioned_graph_reclaim(versioned_graph* p_versioned_graph);
+
+#endif /* COM_GITHUB_CODERODDE_BIDIR_SEARCH_VERSIONED_GRAPH_H */
@@ -1,3 +1,4 @@
+#include "allocator.h"
 #include "util.h"
 #include "vertex_list.h"
 #include <stdlib.h>
@@ -12,7 +13,7 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 {
     size_t ret = 1;
 
-    initial_capacity = max(initial_capacity, MINIMUM_CAPACITY);
+    initial_capacity = maxi(initial_capacity, MINIMUM_CAPACITY);
 
     while (ret < initial_capacity)
     {
@@ -24,7 +25,7 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 
 vertex_list* vertex_list_alloc(size_t initial_capacity)
 {
-    vertex_list* my_list = malloc(sizeof(*my_list));
+    vertex_list* my_list = allocator_malloc(sizeof(*my_list));
 
     if (!my_list)
     {
@@ -33,11 +34,11 @@ vertex_list* vertex_list_alloc(size_t initial_capacity)
 
     initial_capacity = fix_initial_capacity(initial_capacity);
 
-    my_list->storage = malloc(sizeof(size_t) * initial_capacity);
+    my_list->storage = allocator_malloc(sizeof(vertex_id_t) * initial_capacity);
 
     if (!my_list->storage)
     {
-        free(my_list);
+        allocator_free(my_list);
         return NULL;
     }
 
@@ -51,7 +52,7 @@ vertex_list* vertex_list_alloc(size_t initial_capacity)
 
 static int ensure_capacity_before_add(vertex_list* my_list)
 {
-    size_t* new_table;
+    vertex_id_t* new_table;
     size_t i;
     size_t new_capacity;
 
@@ -61,7 +62,7 @@ static int ensure_capacity_before_add(vertex_list* my_list)
     }
 
     new_capacity = 2 * my_list->capacity;
-    new_table = malloc(sizeof(size_t) * new_capacity);
+    new_table = allocator_malloc(sizeof(vertex_id_t) * new_capacity);
 
     if (!new_table)
     {
@@ -73,7 +74,7 @@ static int ensure_capacity_before_add(vertex_list* my_list)
         new_table[i] = my_list->storage[(my_list->head + i) & my_list->mask];
     }
 
-    free(my_list->storage);
+    allocator_free(my_list->storage);
 
     my_list->storage = new_table;
     my_list->capacity = new_capacity;
@@ -83,7 +84,7 @@ static int ensure_capacity_before_add(vertex_list* my_list)
     return TRUE;
 }
 
-int vertex_list_push_front(vertex_list* my_list, size_t vertex_id)
+int vertex_list_push_front(vertex_list* my_list, vertex_id_t vertex_id)
 {
     if (!ensure_capacity_before_add(my_list))
     {
@@ -97,7 +98,7 @@ int vertex_list_push_front(vertex_list* my_list, size_t vertex_id)
     return RETURN_STATUS_OK;
 }
 
-int vertex_list_push_back(vertex_list* my_list, size_t vertex_id)
+int vertex_list_push_back(vertex_list* my_list, vertex_id_t vertex_id)
 {
     if (!ensure_capacity_before_add(my_list))
     {
@@ -116,7 +117,7 @@ size_t vertex_list_size(vertex_list* my_list)
     return my_list->size;
 }
 
-size_t vertex_list_get(vertex_list* my_list, size_t index)
+vertex_id_t vertex_list_get(vertex_list* my_list, size_t index)
 {
     return my_list->storage[(my_list->head + index) & my_list->mask];
 }
@@ -130,6 +131,6 @@ void vertex_list_clear(vertex_list* my_list)
 void vertex_list_free(vertex_list* my_list)
 {
     vertex_list_clear(my_list);
-    free(my_list->storage);
-    free(my_list);
+    allocator_free(my_list->storage);
+    allocator_free(my_list);
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include "vertex_set.h"
+#include "allocator.h"
 #include <stdlib.h>
 
-static vertex_set_entry* vertex_set_entry_alloc(size_t vertex_id)
+static vertex_set_entry* vertex_set_entry_alloc(vertex_id_t vertex_id)
 {
-    vertex_set_entry* entry = malloc(sizeof(*entry));
+    vertex_set_entry* entry = allocator_malloc(sizeof(*entry));
 
     if (!entry)
     {
@@ -61,7 +62,7 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 vertex_set* vertex_set_alloc(size_t initial_capacity,
                              float load_factor)
 {
-    vertex_set* set = malloc(sizeof(*set));
+    vertex_set* set = allocator_malloc(sizeof(*set));
 
     if (!set)
     {
@@ -77,8 +78,8 @@ vertex_set* vertex_set_alloc(size_t initial_capacity,
     set->mod_count = 0;
     set->head = NULL;
     set->tail = NULL;
-    set->table = calloc(initial_capacity,
-                        sizeof(vertex_set_entry*));
+    set->table = allocator_calloc(initial_capacity,
+                                  sizeof(vertex_set_entry*));
 
     set->mask = initial_capacity - 1;
     set->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -101,7 +102,7 @@ static int ensure_capacity(vertex_set* set)
 
     new_capacity = 2 * set->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(vertex_set_entry*));
+    new_table = allocator_calloc(new_capacity, sizeof(vertex_set_entry*));
 
     if (!new_table)
     {
@@ -116,7 +117,7 @@ static int ensure_capacity(vertex_set* set)
         new_table[index] = entry;
     }
 
-    free(set->table);
+    allocator_free(set->table);
 
     set->table = new_table;
     set->table_capacity = new_capacity;
@@ -126,7 +127,7 @@ static int ensure_capacity(vertex_set* set)
     return RETURN_STATUS_OK;
 }
 
-int vertex_set_add(vertex_set* set, size_t vertex_id)
+int vertex_set_add(vertex_set* set, vertex_id_t vertex_id)
 {
     size_t index;
     size_t hash_value;
@@ -173,7 +174,7 @@ int vertex_set_add(vertex_set* set, size_t vertex_id)
     return RETURN_STATUS_OK;
 }
 
-int vertex_set_contains(vertex_set* set, size_t vertex_id)
+int vertex_set_contains(vertex_set* set, vertex_id_t vertex_id)
 {
     size_t index;
     vertex_set_entry* p_entry;
@@ -194,18 +195,31 @@ size_t vertex_set_size(vertex_set* p_set) {
     return p_set->size;
 }
 
-static void vertex_set_clear(vertex_set* set)
+size_t vertex_set_memory_usage(vertex_set* p_set)
+{
+    return sizeof(*p_set) +
+           sizeof(vertex_set_entry*) * p_set->table_capacity +
+           sizeof(vertex_set_entry) * p_set->size;
+}
+
+void vertex_set_clear(vertex_set* set)
 {
     vertex_set_entry* entry;
     vertex_set_entry* next_entry;
     size_t index;
+
+    if (!set)
+    {
+        return;
+    }
+
     entry = set->head;
 
     while (entry)
     {
         index = entry->vertex_id & set->mask;
         next_entry = entry->next;
-        free(entry);
+        allocator_free(entry);
         entry = next_entry;
         set->table[index] = NULL;
     }
@@ -224,6 +238,6 @@ void vertex_set_free(vertex_set* set)
     }
 
     vertex_set_clear(set);
-    free(set->table);
-    free(set);
+    allocator_free(set->table);
+    allocator_free(set);
 }
\ No newline at end of file
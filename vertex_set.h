@@ -5,7 +5,7 @@
 #include <stdlib.h>
 
 typedef struct vertex_set_entry {
-    size_t vertex_id;
+    vertex_id_t vertex_id;
     struct vertex_set_entry* chain_next;
     struct vertex_set_entry* prev;
     struct vertex_set_entry* next;
@@ -27,12 +27,16 @@ vertex_set* vertex_set_alloc
         (size_t initial_capacity,
          float load_factor);
 
-int vertex_set_add(vertex_set* p_set, size_t vertex_id);
+int vertex_set_add(vertex_set* p_set, vertex_id_t vertex_id);
 
-int vertex_set_contains(vertex_set* p_set, size_t vertex_id);
+int vertex_set_contains(vertex_set* p_set, vertex_id_t vertex_id);
 
 size_t vertex_set_size(vertex_set* p_set);
 
+size_t vertex_set_memory_usage(vertex_set* p_set);
+
+void vertex_set_clear(vertex_set* p_set);
+
 void vertex_set_free(vertex_set* p_set);
 
 #endif	/* COM_GITHUB_CODERODDE_BIDIR_SEARCH_VERTEX_SET_H */
\ No newline at end of file
@@ -1,12 +1,38 @@
 #include "weight_map.h"
+#include "allocator.h"
 #include "util.h"
 #include <stdlib.h>
 
+static void* weight_map_malloc(arena* p_arena, size_t size)
+{
+    return p_arena ? arena_malloc(p_arena, size) : allocator_malloc(size);
+}
+
+static void* weight_map_calloc(arena* p_arena, size_t count, size_t size)
+{
+    return p_arena ?
+           arena_calloc(p_arena, count, size) :
+           allocator_calloc(count, size);
+}
+
+static void weight_map_release(arena* p_arena, void* p_memory, size_t size)
+{
+    if (p_arena)
+    {
+        arena_release(p_arena, p_memory, size);
+    }
+    else
+    {
+        allocator_free(p_memory);
+    }
+}
+
 static weight_map_entry*
-weight_map_entry_alloc(size_t vertex_id,
-                       double weight)
+weight_map_entry_alloc(arena* p_arena,
+                       vertex_id_t vertex_id,
+                       weight_t weight)
 {
-    weight_map_entry* entry = malloc(sizeof(*entry));
+    weight_map_entry* entry = weight_map_malloc(p_arena, sizeof(*entry));
 
     if (!entry)
     {
@@ -64,9 +90,10 @@ static size_t fix_initial_capacity(size_t initial_capacity)
 
 weight_map* weight_map_alloc(
         size_t initial_capacity,
-        float load_factor)
+        float load_factor,
+        arena* p_arena)
 {
-    weight_map* map = malloc(sizeof(*map));
+    weight_map* map = weight_map_malloc(p_arena, sizeof(*map));
 
     if (!map)
     {
@@ -81,8 +108,10 @@ weight_map* weight_map_alloc(
     map->size = 0;
     map->head = NULL;
     map->tail = NULL;
-    map->table = calloc(initial_capacity,
-                        sizeof(weight_map_entry*));
+    map->p_arena = p_arena;
+    map->table = weight_map_calloc(p_arena,
+                                   initial_capacity,
+                                   sizeof(weight_map_entry*));
 
     map->mask = initial_capacity - 1;
     map->max_allowed_size = (size_t)(initial_capacity * load_factor);
@@ -105,7 +134,9 @@ static int ensure_capacity(weight_map* map)
 
     new_capacity = 2 * map->table_capacity;
     new_mask = new_capacity - 1;
-    new_table = calloc(new_capacity, sizeof(weight_map_entry*));
+    new_table = weight_map_calloc(map->p_arena,
+                                  new_capacity,
+                                  sizeof(weight_map_entry*));
 
     if (!new_table)
     {
@@ -120,7 +151,9 @@ static int ensure_capacity(weight_map* map)
         new_table[index] = entry;
     }
 
-    free(map->table);
+    weight_map_release(map->p_arena,
+                       map->table,
+                       map->table_capacity * sizeof(weight_map_entry*));
 
     map->table = new_table;
     map->table_capacity = new_capacity;
@@ -129,7 +162,7 @@ static int ensure_capacity(weight_map* map)
     return RETURN_STATUS_OK;
 }
 
-int weight_map_put(weight_map* map, size_t vertex_id, double weight)
+int weight_map_put(weight_map* map, vertex_id_t vertex_id, weight_t weight)
 {
     size_t index;
     size_t hash_value;
@@ -158,7 +191,7 @@ int weight_map_put(weight_map* map, size_t vertex_id, double weight)
 
     /* Recompute the index since it is possibly changed by 'ensure_capacity' */
     index = hash_value & map->mask;
-    entry = weight_map_entry_alloc(vertex_id, weight);
+    entry = weight_map_entry_alloc(map->p_arena, vertex_id, weight);
 
     if (!entry) {
         return RETURN_STATUS_NO_MEMORY;
@@ -184,7 +217,7 @@ int weight_map_put(weight_map* map, size_t vertex_id, double weight)
     return RETURN_STATUS_OK;
 }
 
-int weight_map_contains_key(weight_map* map, size_t vertex_id)
+int weight_map_contains_key(weight_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     weight_map_entry* entry;
@@ -207,7 +240,7 @@ int weight_map_contains_key(weight_map* map, size_t vertex_id)
     return 0;
 }
 
-double weight_map_get(weight_map* map, size_t vertex_id)
+weight_t weight_map_get(weight_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     weight_map_entry* p_entry;
@@ -231,7 +264,7 @@ double weight_map_get(weight_map* map, size_t vertex_id)
     return -1.0;
 }
 
-void weight_map_remove(weight_map* map, size_t vertex_id)
+void weight_map_remove(weight_map* map, vertex_id_t vertex_id)
 {
     size_t index;
     weight_map_entry* prev_entry;
@@ -280,7 +313,9 @@ void weight_map_remove(weight_map* map, size_t vertex_id)
             }
 
             map->size--;
-            free(current_entry);
+            weight_map_release(map->p_arena,
+                               current_entry,
+                               sizeof(*current_entry));
             return;
         }
 
@@ -305,7 +340,7 @@ void weight_map_clear(weight_map* map)
     {
         index = entry->vertex_id & map->mask;
         next_entry = entry->next;
-        free(entry);
+        weight_map_release(map->p_arena, entry, sizeof(*entry));
         entry = next_entry;
         map->table[index] = NULL;
     }
@@ -320,6 +355,13 @@ size_t weight_map_size(weight_map* map)
     return map->size;
 }
 
+size_t weight_map_memory_usage(weight_map* map)
+{
+    return sizeof(*map) +
+           sizeof(weight_map_entry*) * map->table_capacity +
+           sizeof(weight_map_entry) * map->size;
+}
+
 void weight_map_free(weight_map* map)
 {
     if (!map)
@@ -328,8 +370,11 @@ void weight_map_free(weight_map* map)
     }
 
     weight_map_clear(map);
-    free(map->table);
-    free(map);
+    weight_map_release(map->p_arena,
+                       map->table,
+                       map->table_capacity * sizeof(weight_map_entry*));
+
+    weight_map_release(map->p_arena, map, sizeof(*map));
 }
 
 weight_map_iterator*
@@ -342,7 +387,7 @@ weight_map_iterator_alloc(weight_map* map)
         return NULL;
     }
 
-    p_ret = malloc(sizeof(*p_ret));
+    p_ret = allocator_malloc(sizeof(*p_ret));
 
     if (!p_ret)
     {
@@ -374,12 +419,12 @@ void weight_map_iterator_free(weight_map_iterator* iterator)
 
     iterator->map = NULL;
     iterator->entry = NULL;
-    free(iterator);
+    allocator_free(iterator);
 }
 
 void weight_map_iterator_visit(weight_map_iterator* p_iterator,
-                               size_t* p_vertex_id,
-                               double* p_weight) {
+                               vertex_id_t* p_vertex_id,
+                               weight_t* p_weight) {
     *p_vertex_id = p_iterator->entry->vertex_id;
     *p_weight = p_iterator->entry->weight;
 }
@@ -1,11 +1,13 @@
 #ifndef COM_GITHUB_CODERODDE_BIDIR_SEARCH_WEIGHT_MAP_H
 #define COM_GITHUB_CODERODDE_BIDIR_SEARCH_WEIGHT_MAP_H
 
+#include "arena.h"
+#include "util.h"
 #include <stdlib.h>
 
 typedef struct weight_map_entry {
-    size_t            vertex_id;
-    double            weight;
+    vertex_id_t              vertex_id;
+    weight_t                 weight;
     struct weight_map_entry* chain_next;
     struct weight_map_entry* prev;
     struct weight_map_entry* next;
@@ -20,6 +22,7 @@ typedef struct weight_map {
     size_t            max_allowed_size;
     size_t            mask;
     float             load_factor;
+    arena*            p_arena; /* NULL if the map uses malloc. */
 } weight_map;
 
 typedef struct weight_map_iterator {
@@ -28,15 +31,18 @@ typedef struct weight_map_iterator {
 } weight_map_iterator;
 
 weight_map* weight_map_alloc(size_t initial_capacity,
-                             float load_factor);
+                             float load_factor,
+                             arena* p_arena);
 
-int weight_map_put(weight_map* map, size_t vertex_id, double weight);
+int weight_map_put(weight_map* map, vertex_id_t vertex_id, weight_t weight);
 
-int weight_map_contains_key(weight_map* map, size_t vertex_id);
+int weight_map_contains_key(weight_map* map, vertex_id_t vertex_id);
 
-double weight_map_get(weight_map* map, size_t vertex_id);
+weight_t weight_map_get(weight_map* map, vertex_id_t vertex_id);
 
-void weight_map_remove(weight_map* map, size_t vertex_id);
+size_t weight_map_memory_usage(weight_map* map);
+
+void weight_map_remove(weight_map* map, vertex_id_t vertex_id);
 
 void weight_map_clear(weight_map* map);
 
@@ -51,8 +57,8 @@ int weight_map_iterator_has_next
 void weight_map_iterator_next(weight_map_iterator* iterator);
 
 void weight_map_iterator_visit(weight_map_iterator* p_iterator,
-                               size_t* p_vertex_id,
-                               double* p_weight);
+                               vertex_id_t* p_vertex_id,
+                               weight_t* p_weight);
 
 void weight_map_iterator_remove(weight_map_iterator* p_iterator);
 